@@ -105,6 +105,39 @@ typedef struct VmafContext VmafContext;
  */
 int vmaf_init(VmafContext **vmaf, VmafConfiguration cfg);
 
+/**
+ * Limit the memory used by feature extractors running on `n_threads`
+ * threads. Each feature extractor uses up to one set of buffers per thread,
+ * fewer if they do not fit into the budget, but always at least one.
+ * Has no effect when `n_threads` is 0.
+ *
+ * @param vmaf       The VMAF context allocated with `vmaf_init()`.
+ *
+ * @param mem_budget Approximate number of bytes the feature extractors
+ *                   may allocate. 0: no limit (default).
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_set_mem_budget(VmafContext *vmaf, uint64_t mem_budget);
+
+/**
+ * Run the feature extractors of `dst` on the threads of `src`, so that
+ * several contexts scored side by side, e.g. one per distorted video of
+ * the same reference, share one set of `n_threads` threads. Both contexts
+ * should be initialized with the same `n_threads` > 0. Must be called
+ * before `dst` reads any pictures. Flushing or closing either context
+ * waits for all work queued on the shared threads.
+ *
+ * @param dst The VMAF context giving up its own threads.
+ *
+ * @param src The VMAF context whose threads are shared.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_share_thread_pool(VmafContext *dst, VmafContext *src);
+
 /**
  * Register feature extractors required by a specific `VmafModel`.
  * This may be called multiple times using different models.
@@ -200,6 +233,63 @@ int vmaf_import_feature_score(VmafContext *vmaf, const char *feature_name,
 int vmaf_read_pictures(VmafContext *vmaf, VmafPicture *ref, VmafPicture *dist,
                        unsigned index);
 
+/**
+ * Read one reference picture and `cnt` distorted pictures, each scored
+ * against the reference in its own `VmafContext`. This is equivalent to
+ * calling `vmaf_read_pictures()` once per context with the same reference,
+ * except that feature extractors compute reference-only intermediates once
+ * and share them between all contexts.
+ * Takes ownership of `ref` and of all `cnt` pictures in `dist`.
+ *
+ * When you're done reading pictures call this function again with both `ref`
+ * and `dist` set to NULL to flush all contexts.
+ *
+ * @param vmaf  Array of `cnt` VMAF contexts allocated with `vmaf_init()`,
+ *              one per distorted picture.
+ *
+ * @param cnt   Number of contexts and distorted pictures.
+ *
+ * @param ref   Reference picture.
+ *
+ * @param dist  Array of `cnt` distorted pictures.
+ *
+ * @param index Picture index.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_read_pictures_multi(VmafContext **vmaf, unsigned cnt,
+                             VmafPicture *ref, VmafPicture *dist,
+                             unsigned index);
+
+/**
+ * Merge the per-frame feature scores of `src` in the range
+ * [`index_low`, `index_high`] into `dst`. This is used to score a title in
+ * chunks, each chunk in its own `VmafContext`, and to combine the chunks
+ * into a single context for pooling and output. `dst` does not need to have
+ * any feature extractors registered, and counts every index up to
+ * `index_high` as a read picture. `src` should be flushed.
+ *
+ * Temporal features depend on neighbouring pictures. For exact scores at
+ * chunk boundaries each chunk should also read the picture before and the
+ * picture after its range, and only that range should be merged.
+ *
+ * @param dst        The VMAF context receiving the scores.
+ *
+ * @param src        The VMAF context holding the scores of one chunk.
+ *
+ * @param index_low  First picture index to merge.
+ *
+ * @param index_high Last picture index to merge.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ *         -ENOTSUP if `src` holds aggregate metrics (e.g. `apsnr`), which
+ *         can not be split into chunks.
+ */
+int vmaf_merge_feature_scores(VmafContext *dst, VmafContext *src,
+                              unsigned index_low, unsigned index_high);
+
 /**
  * Predict VMAF score at specific index.
  *
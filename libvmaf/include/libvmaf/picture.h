@@ -48,8 +48,123 @@ typedef struct VmafPicture {
 int vmaf_picture_alloc(VmafPicture *pic, enum VmafPixelFormat pix_fmt,
                        unsigned bpc, unsigned w, unsigned h);
 
+/**
+ * Wrap externally owned planes, e.g. decoder output, in a picture without
+ * copying them. The picture is reference counted like one allocated with
+ * `vmaf_picture_alloc()`; `release_picture` is called once the last
+ * reference is dropped, which may happen on a libvmaf worker thread.
+ *
+ * libvmaf never writes to the planes, and never reads beyond the first
+ * `w` samples of a row, so planes do not need any padding. Vector code
+ * uses unaligned loads, so planes do not need any alignment either.
+ * Planes aligned to 32 bytes, with strides which are a multiple of 32
+ * bytes, as allocated by `vmaf_picture_alloc()`, are read fastest.
+ *
+ * @param pic             Picture to initialize.
+ *
+ * @param pix_fmt         Pixel format, determines the plane dimensions.
+ *
+ * @param bpc             Bitdepth, 8 <= `bpc` <= 16. Samples with
+ *                        `bpc` > 8 are read as `uint16_t`, so their plane
+ *                        pointers and strides must be a multiple of 2.
+ *
+ * @param w               Luma width.
+ *
+ * @param h               Luma height.
+ *
+ * @param data            Plane pointers, only `data[0]` is used for
+ *                        `VMAF_PIX_FMT_YUV400P`.
+ *
+ * @param stride          Plane strides in bytes, at least the width of the
+ *                        plane times the size of a sample.
+ *
+ * @param cookie          Passed to `release_picture`.
+ *
+ * @param release_picture Called with the picture and `cookie` when the last
+ *                        reference is dropped, the planes may be freed or
+ *                        reused from then on.
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_picture_wrap(VmafPicture *pic, enum VmafPixelFormat pix_fmt,
+                      unsigned bpc, unsigned w, unsigned h,
+                      void *const data[3], const ptrdiff_t stride[3],
+                      void *cookie,
+                      int (*release_picture)(VmafPicture *pic, void *cookie));
+
 int vmaf_picture_unref(VmafPicture *pic);
 
+typedef struct VmafPicturePool VmafPicturePool;
+
+/**
+ * Create a pool of pictures with a fixed geometry. Pictures are fetched
+ * from the pool instead of being allocated with `vmaf_picture_alloc()`,
+ * and go back to the pool when their last reference is dropped, so their
+ * buffers are allocated once and recycled.
+ *
+ * @param pool    The pool to create.
+ *
+ * @param pix_fmt Pixel format of the pictures.
+ *
+ * @param bpc     Bitdepth of the pictures, 8 <= `bpc` <= 16.
+ *
+ * @param w       Luma width of the pictures.
+ *
+ * @param h       Luma height of the pictures.
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_picture_pool_init(VmafPicturePool **pool,
+                           enum VmafPixelFormat pix_fmt, unsigned bpc,
+                           unsigned w, unsigned h);
+
+/**
+ * Fetch a picture from the pool, or allocate a new one if all pictures are
+ * in use. The picture has the same layout as one from `vmaf_picture_alloc()`
+ * but a recycled picture is not cleared, so all samples have to be written.
+ * Release it with `vmaf_picture_unref()`, or hand it to libvmaf, which does.
+ * Pictures may be released from any thread.
+ *
+ * @param pool Pool created with `vmaf_picture_pool_init()`.
+ *
+ * @param pic  Picture to initialize.
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_picture_pool_fetch(VmafPicturePool *pool, VmafPicture *pic);
+
+/**
+ * Close a pool. Pictures which are still in use stay valid, the pool is
+ * freed once the last of them is released.
+ *
+ * @param pool Pool created with `vmaf_picture_pool_init()`.
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_picture_pool_close(VmafPicturePool *pool);
+
+/**
+ * Copy planar sample data into a picture allocated with `vmaf_picture_alloc()`
+ * or fetched with `vmaf_picture_pool_fetch()`.
+ * When `bpc` is lower than `pic->bpc`, samples are promoted by left shifting
+ * them by the difference in bitdepth.
+ *
+ * @param pic    Destination picture, allocated with `vmaf_picture_alloc()`
+ *               or fetched with `vmaf_picture_pool_fetch()`.
+ *
+ * @param data   Source plane pointers, one per plane of `pic`.
+ *
+ * @param stride Source plane strides, in bytes.
+ *
+ * @param bpc    Bitdepth of the source samples, 8 <= `bpc` <= `pic->bpc`.
+ *               Samples with `bpc` > 8 are read as `uint16_t`.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_picture_import_planes(VmafPicture *pic, const void *const data[3],
+                               const ptrdiff_t stride[3], unsigned bpc);
+
 #ifdef __cplusplus
 }
 #endif
@@ -23,6 +23,8 @@ enum CpuFlags {
     VMAF_ARM_CPU_FLAG_NEON = 1 << 0,
 };
 
+#define VMAF_CPU_FLAG_CNT 1 /* number of CpuFlags */
+
 unsigned vmaf_get_cpu_flags_arm(void);
 
 #endif /* __VMAF_SRC_ARM_CPU_H__ */
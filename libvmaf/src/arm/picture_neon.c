@@ -0,0 +1,66 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <arm_neon.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "arm/picture_neon.h"
+
+void picture_import_u8_neon(uint16_t *dst, ptrdiff_t dst_stride,
+                            const uint8_t *src, ptrdiff_t src_stride,
+                            unsigned w, unsigned h, unsigned shift)
+{
+    const int16x8_t count = vdupq_n_s16(shift);
+    const unsigned w16 = w & ~15u;
+
+    for (unsigned i = 0; i < h; i++) {
+        unsigned j = 0;
+        for (; j < w16; j += 16) {
+            uint8x16_t s = vld1q_u8(src + j);
+            vst1q_u16(dst + j, vshlq_u16(vmovl_u8(vget_low_u8(s)), count));
+            vst1q_u16(dst + j + 8, vshlq_u16(vmovl_high_u8(s), count));
+        }
+        for (; j < w; j++)
+            dst[j] = src[j] << shift;
+        dst += dst_stride / sizeof(*dst);
+        src += src_stride;
+    }
+}
+
+void picture_import_u16_neon(uint16_t *dst, ptrdiff_t dst_stride,
+                             const uint16_t *src, ptrdiff_t src_stride,
+                             unsigned w, unsigned h, unsigned shift)
+{
+    const int16x8_t count = vdupq_n_s16(shift);
+    const unsigned w16 = w & ~15u;
+
+    for (unsigned i = 0; i < h; i++) {
+        unsigned j = 0;
+        for (; j < w16; j += 16) {
+            uint16x8_t s0 = vld1q_u16(src + j);
+            uint16x8_t s1 = vld1q_u16(src + j + 8);
+            vst1q_u16(dst + j, vshlq_u16(s0, count));
+            vst1q_u16(dst + j + 8, vshlq_u16(s1, count));
+        }
+        for (; j < w; j++)
+            dst[j] = src[j] << shift;
+        dst += dst_stride / sizeof(*dst);
+        src += src_stride / sizeof(*src);
+    }
+}
@@ -29,6 +29,8 @@ extern "C" {
 #include "x86/cpu.h"
 #elif ARCH_AARCH64
 #include "arm/cpu.h"
+#else
+#define VMAF_CPU_FLAG_CNT 0
 #endif
 
 void vmaf_init_cpu(void);
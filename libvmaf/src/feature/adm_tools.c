@@ -24,10 +24,17 @@
 #include "config.h"
 #endif
 
+#include "cpu.h"
 #include "mem.h"
 #include "adm_options.h"
 #include "adm_tools.h"
 
+#if ARCH_X86
+#include "x86/adm_tools_avx2.h"
+#elif ARCH_AARCH64
+#include "arm64/adm_tools_neon.h"
+#endif
+
 #ifndef M_PI
 #define M_PI 3.1415926535897932384626433832795028841971693993751
 #endif
@@ -58,21 +65,10 @@ static const float dwt2_db2_coeffs_hi_s[4] = { -0.129409522550921, -0.2241438680
 static const double dwt2_db2_coeffs_lo_d[4] = { 0.482962913144690, 0.836516303737469, 0.224143868041857, -0.129409522550921 };
 static const double dwt2_db2_coeffs_hi_d[4] = { -0.129409522550921, -0.224143868041857, 0.836516303737469, -0.482962913144690 };
 
-#ifndef FLOAT_ONE_BY_30
-#define FLOAT_ONE_BY_30	0.0333333351
-#endif
-
-#ifndef FLOAT_ONE_BY_15
-#define FLOAT_ONE_BY_15 0.0666666701
-#endif
-
-float adm_sum_cube_s(const float *x, int w, int h, int stride, double border_factor)
+static float adm_sum_cube_accum_s(const float *x, int left, int top, int right,
+                                  int bottom, int stride)
 {
     int px_stride = stride / sizeof(float);
-    int left   = w * border_factor - 0.5;
-    int top    = h * border_factor - 0.5;
-    int right  = w - left;
-    int bottom = h - top;
 
     int i, j;
 
@@ -91,6 +87,28 @@ float adm_sum_cube_s(const float *x, int w, int h, int stride, double border_fac
         accum += accum_inner;
     }
 
+    return accum;
+}
+
+float adm_sum_cube_s(const float *x, int w, int h, int stride, double border_factor)
+{
+    int left   = w * border_factor - 0.5;
+    int top    = h * border_factor - 0.5;
+    int right  = w - left;
+    int bottom = h - top;
+
+    float (*sum_cube_accum)(const float *x, int left, int top, int right,
+                            int bottom, int stride) = adm_sum_cube_accum_s;
+#if ARCH_X86
+    if (vmaf_get_cpu_flags() & VMAF_X86_CPU_FLAG_AVX2)
+        sum_cube_accum = adm_sum_cube_accum_s_avx2;
+#elif ARCH_AARCH64
+    if (vmaf_get_cpu_flags() & VMAF_ARM_CPU_FLAG_NEON)
+        sum_cube_accum = adm_sum_cube_accum_s_neon;
+#endif
+
+    float accum = sum_cube_accum(x, left, top, right, bottom, stride);
+
     return powf(accum, 1.0f / 3.0f) + powf((bottom - top) * (right - left) / 32.0f, 1.0f / 3.0f);
 }
 
@@ -128,6 +146,22 @@ void adm_decouple_s(const adm_dwt_band_t_s *ref, const adm_dwt_band_t_s *dis,
 		bottom = h;
 	}
 
+#ifdef ADM_OPT_AVOID_ATAN
+#if ARCH_X86
+	if ((vmaf_get_cpu_flags() & VMAF_X86_CPU_FLAG_AVX2) && right - left >= 8) {
+		adm_decouple_s_avx2(ref, dis, r, a, left, top, right, bottom,
+		                    ref_stride, dis_stride, r_stride, a_stride, adm_enhn_gain_limit);
+		return;
+	}
+#elif ARCH_AARCH64
+	if ((vmaf_get_cpu_flags() & VMAF_ARM_CPU_FLAG_NEON) && right - left >= 4) {
+		adm_decouple_s_neon(ref, dis, r, a, left, top, right, bottom,
+		                    ref_stride, dis_stride, r_stride, a_stride, adm_enhn_gain_limit);
+		return;
+	}
+#endif
+#endif
+
 	float oh, ov, od, th, tv, td;
 	float kh, kv, kd, rst_h, rst_v, rst_d;
 #ifdef ADM_OPT_AVOID_ATAN
@@ -273,6 +307,18 @@ void adm_csf_s(const adm_dwt_band_t_s *src, const adm_dwt_band_t_s *dst, const a
 		bottom = h;
 	}
 
+#if ARCH_X86
+	if ((vmaf_get_cpu_flags() & VMAF_X86_CPU_FLAG_AVX2) && right - left >= 8) {
+		adm_csf_s_avx2(src, dst, flt, rfactor, left, top, right, bottom, src_stride, dst_stride);
+		return;
+	}
+#elif ARCH_AARCH64
+	if ((vmaf_get_cpu_flags() & VMAF_ARM_CPU_FLAG_NEON) && right - left >= 4) {
+		adm_csf_s_neon(src, dst, flt, rfactor, left, top, right, bottom, src_stride, dst_stride);
+		return;
+	}
+#endif
+
 	int i, j, theta, src_offset, dst_offset;
 	float dst_val;
 
@@ -294,37 +340,18 @@ void adm_csf_s(const adm_dwt_band_t_s *src, const adm_dwt_band_t_s *dst, const a
 	}
 }
 
-/* Combination of adm_csf_s and adm_sum_cube_s for csf_o based den_scale */
-float adm_csf_den_scale_s(const adm_dwt_band_t_s *src, int orig_h, int scale,
-                          int w, int h, int src_stride, double border_factor,
-                          double adm_norm_view_dist, int adm_ref_display_height, int adm_csf_mode)
+static void adm_csf_den_scale_accum_s(const adm_dwt_band_t_s *src, const float rfactor[3],
+                                      int left, int top, int right, int bottom,
+                                      int src_stride, float accum[3])
 {
-	(void)adm_csf_mode;
-	(void)orig_h;
-
-	float *src_h = src->band_h, *src_v = src->band_v, *src_d = src->band_d;
+	const float *src_h, *src_v, *src_d;
 
 	int src_px_stride = src_stride / sizeof(float);
 
-	// for ADM: scales goes from 0 to 3 but in noise floor paper, it goes from
-	// 1 to 4 (from finest scale to coarsest scale).
-	// TODO: we will add more CSF functions here
-	float factor1, factor2;
-	factor1 = 1.0f / dwt_quant_step(&dwt_7_9_YCbCr_threshold[0], scale, 1, adm_norm_view_dist, adm_ref_display_height);
-	factor2 = 1.0f / dwt_quant_step(&dwt_7_9_YCbCr_threshold[0], scale, 2, adm_norm_view_dist, adm_ref_display_height);
-	float rfactor[3] = { factor1, factor1, factor2 };
-
 	float accum_h = 0, accum_v = 0, accum_d = 0;
 	float accum_inner_h, accum_inner_v, accum_inner_d;
-	float den_scale_h, den_scale_v, den_scale_d;
 
 	float val;
-	
-	/* The computation of the denominator scales is not required for the regions which lie outside the frame borders */
-	int left = w * border_factor - 0.5;
-	int top = h * border_factor - 0.5;
-	int right = w - left;
-	int bottom = h - top;
 
 	int i, j;
 
@@ -354,14 +381,97 @@ float adm_csf_den_scale_s(const adm_dwt_band_t_s *src, int orig_h, int scale,
 
 	}
 
-	den_scale_h = powf(accum_h, 1.0f / 3.0f) + powf((bottom - top) * (right - left) / 32.0f, 1.0f / 3.0f);
-	den_scale_v = powf(accum_v, 1.0f / 3.0f) + powf((bottom - top) * (right - left) / 32.0f, 1.0f / 3.0f);
-	den_scale_d = powf(accum_d, 1.0f / 3.0f) + powf((bottom - top) * (right - left) / 32.0f, 1.0f / 3.0f);
+	accum[0] = accum_h;
+	accum[1] = accum_v;
+	accum[2] = accum_d;
+}
+
+/* Combination of adm_csf_s and adm_sum_cube_s for csf_o based den_scale */
+float adm_csf_den_scale_s(const adm_dwt_band_t_s *src, int orig_h, int scale,
+                          int w, int h, int src_stride, double border_factor,
+                          double adm_norm_view_dist, int adm_ref_display_height, int adm_csf_mode)
+{
+	(void)adm_csf_mode;
+	(void)orig_h;
+
+	// for ADM: scales goes from 0 to 3 but in noise floor paper, it goes from
+	// 1 to 4 (from finest scale to coarsest scale).
+	// TODO: we will add more CSF functions here
+	float factor1, factor2;
+	factor1 = 1.0f / dwt_quant_step(&dwt_7_9_YCbCr_threshold[0], scale, 1, adm_norm_view_dist, adm_ref_display_height);
+	factor2 = 1.0f / dwt_quant_step(&dwt_7_9_YCbCr_threshold[0], scale, 2, adm_norm_view_dist, adm_ref_display_height);
+	float rfactor[3] = { factor1, factor1, factor2 };
+
+	float accum[3];
+	float den_scale_h, den_scale_v, den_scale_d;
+
+	/* The computation of the denominator scales is not required for the regions which lie outside the frame borders */
+	int left = w * border_factor - 0.5;
+	int top = h * border_factor - 0.5;
+	int right = w - left;
+	int bottom = h - top;
+
+	void (*den_scale_accum)(const adm_dwt_band_t_s *src, const float rfactor[3],
+	                        int left, int top, int right, int bottom,
+	                        int src_stride, float accum[3]) = adm_csf_den_scale_accum_s;
+#if ARCH_X86
+	if (vmaf_get_cpu_flags() & VMAF_X86_CPU_FLAG_AVX2)
+		den_scale_accum = adm_csf_den_scale_accum_s_avx2;
+#elif ARCH_AARCH64
+	if (vmaf_get_cpu_flags() & VMAF_ARM_CPU_FLAG_NEON)
+		den_scale_accum = adm_csf_den_scale_accum_s_neon;
+#endif
+
+	den_scale_accum(src, rfactor, left, top, right, bottom, src_stride, accum);
+
+	den_scale_h = powf(accum[0], 1.0f / 3.0f) + powf((bottom - top) * (right - left) / 32.0f, 1.0f / 3.0f);
+	den_scale_v = powf(accum[1], 1.0f / 3.0f) + powf((bottom - top) * (right - left) / 32.0f, 1.0f / 3.0f);
+	den_scale_d = powf(accum[2], 1.0f / 3.0f) + powf((bottom - top) * (right - left) / 32.0f, 1.0f / 3.0f);
 
 	return(den_scale_h + den_scale_v + den_scale_d);
 
 }
 
+/* The terms of adm_cm_s for row i and columns start_col to end_col - 1, away from the frame borders */
+static void adm_cm_row_s(const adm_dwt_band_t_s *src, const adm_dwt_band_t_s *csf_f,
+                         const adm_dwt_band_t_s *csf_a, const float rfactor[3],
+                         int i, int start_col, int end_col,
+                         int src_stride, int csf_stride, float accum[3])
+{
+	const float *angles[3] = { csf_a->band_h, csf_a->band_v, csf_a->band_d };
+	const float *flt_angles[3] = { csf_f->band_h, csf_f->band_v, csf_f->band_d };
+
+	int src_px_stride = src_stride / sizeof(float);
+	int csf_px_stride = csf_stride / sizeof(float);
+
+	float xh, xv, xd, thr;
+	float val;
+	int j;
+
+	for (j = start_col; j < end_col; ++j) {
+		xh = src->band_h[i * src_px_stride + j] * rfactor[0];
+		xv = src->band_v[i * src_px_stride + j] * rfactor[1];
+		xd = src->band_d[i * src_px_stride + j] * rfactor[2];
+		// w and h are only used at the borders
+		ADM_CM_THRESH_S_I_J(angles, flt_angles, csf_px_stride, &thr, 0, 0, i, j);
+
+		xh = fabsf(xh) - thr;
+		xv = fabsf(xv) - thr;
+		xd = fabsf(xd) - thr;
+
+		xh = xh < 0.0f ? 0.0f : xh;
+		xv = xv < 0.0f ? 0.0f : xv;
+		xd = xd < 0.0f ? 0.0f : xd;
+
+		val = (xh * xh * xh);
+		accum[0] += val;
+		val = (xv * xv * xv);
+		accum[1] += val;
+		val = (xd * xd * xd);
+		accum[2] += val;
+	}
+}
+
 float adm_cm_s(const adm_dwt_band_t_s *src, const adm_dwt_band_t_s *csf_f,
                const adm_dwt_band_t_s *csf_a, int w, int h, int src_stride,
                int flt_stride, int csf_a_stride, double border_factor, int scale,
@@ -487,53 +597,28 @@ float adm_cm_s(const adm_dwt_band_t_s *src, const adm_dwt_band_t_s *csf_f,
 	accum_v += accum_inner_v;
 	accum_d += accum_inner_d;
 
-	if ((left > 0) && (right <= (w - 1))) /* Completely within frame */
-	{
-		for (i = start_row; i < end_row; ++i) {
-			accum_inner_h = 0;
-			accum_inner_v = 0;
-			accum_inner_d = 0;
-		for (j = start_col; j < end_col; ++j) {
-				xh = src->band_h[i * src_px_stride + j] * rfactor[0];
-				xv = src->band_v[i * src_px_stride + j] * rfactor[1];
-				xd = src->band_d[i * src_px_stride + j] * rfactor[2];
-				ADM_CM_THRESH_S_I_J(angles, flt_angles, csf_px_stride, &thr, w, h, i, j);
-
-			xh = fabsf(xh) - thr;
-			xv = fabsf(xv) - thr;
-			xd = fabsf(xd) - thr;
-
-			xh = xh < 0.0f ? 0.0f : xh;
-			xv = xv < 0.0f ? 0.0f : xv;
-			xd = xd < 0.0f ? 0.0f : xd;
+	void (*cm_row)(const adm_dwt_band_t_s *src, const adm_dwt_band_t_s *csf_f,
+	               const adm_dwt_band_t_s *csf_a, const float rfactor[3],
+	               int i, int start_col, int end_col,
+	               int src_stride, int csf_stride, float accum[3]) = adm_cm_row_s;
+#if ARCH_X86
+	if (vmaf_get_cpu_flags() & VMAF_X86_CPU_FLAG_AVX2)
+		cm_row = adm_cm_row_s_avx2;
+#elif ARCH_AARCH64
+	if (vmaf_get_cpu_flags() & VMAF_ARM_CPU_FLAG_NEON)
+		cm_row = adm_cm_row_s_neon;
+#endif
 
-			val = (xh * xh * xh);
-			accum_inner_h += val;
-			val = (xv * xv * xv);
-			accum_inner_v += val;
-			val = (xd * xd * xd);
-			accum_inner_d += val;
+	for (i = start_row; i < end_row; ++i) {
+		float accum_inner[3] = { 0, 0, 0 };
 
-		}
-			accum_h += accum_inner_h;
-			accum_v += accum_inner_v;
-			accum_d += accum_inner_d;
-	}
-	}
-	else if ((left <= 0) && (right <= (w - 1))) /* Right border within frame, left outside */
-	{
-		for (i = start_row; i < end_row; ++i) {
-			accum_inner_h = 0;
-			accum_inner_v = 0;
-			accum_inner_d = 0;
-
-			/* j = 0 */
+		/* j = 0, if the left border is outside the frame */
+		if (left <= 0) {
 			xh = src->band_h[i * src_px_stride] * rfactor[0];
 			xv = src->band_v[i * src_px_stride] * rfactor[1];
 			xd = src->band_d[i * src_px_stride] * rfactor[2];
 			ADM_CM_THRESH_S_I_0(angles, flt_angles, csf_px_stride, &thr, w, h, i, 0);
 
-
 			xh = fabsf(xh) - thr;
 			xv = fabsf(xv) - thr;
 			xd = fabsf(xd) - thr;
@@ -543,70 +628,19 @@ float adm_cm_s(const adm_dwt_band_t_s *src, const adm_dwt_band_t_s *csf_f,
 			xd = xd < 0.0f ? 0.0f : xd;
 
 			val = (xh * xh * xh);
-			accum_inner_h += val;
+			accum_inner[0] += val;
 			val = (xv * xv * xv);
-			accum_inner_v += val;
+			accum_inner[1] += val;
 			val = (xd * xd * xd);
-			accum_inner_d += val;
-
-			/* j within frame */
-			for (j = start_col; j < end_col; ++j) {
-				xh = src->band_h[i * src_px_stride + j] * rfactor[0];
-				xv = src->band_v[i * src_px_stride + j] * rfactor[1];
-				xd = src->band_d[i * src_px_stride + j] * rfactor[2];
-				ADM_CM_THRESH_S_I_J(angles, flt_angles, csf_px_stride, &thr, w, h, i, j);
-
-				xh = fabsf(xh) - thr;
-				xv = fabsf(xv) - thr;
-				xd = fabsf(xd) - thr;
-
-				xh = xh < 0.0f ? 0.0f : xh;
-				xv = xv < 0.0f ? 0.0f : xv;
-				xd = xd < 0.0f ? 0.0f : xd;
-
-				val = (xh * xh * xh);
-				accum_inner_h += val;
-				val = (xv * xv * xv);
-				accum_inner_v += val;
-				val = (xd * xd * xd);
-				accum_inner_d += val;
-
-			}
-	accum_h += accum_inner_h;
-	accum_v += accum_inner_v;
-	accum_d += accum_inner_d;
+			accum_inner[2] += val;
 		}
-	}
-	else if ((left > 0) && (right > (w - 1))) /* Left border within frame, right outside */
-	{
-		for (i = start_row; i < end_row; ++i) {
-			accum_inner_h = 0;
-			accum_inner_v = 0;
-			accum_inner_d = 0;
-			/* j within frame */
-			for (j = start_col; j < end_col; ++j) {
-				xh = src->band_h[i * src_px_stride + j] * rfactor[0];
-				xv = src->band_v[i * src_px_stride + j] * rfactor[1];
-				xd = src->band_d[i * src_px_stride + j] * rfactor[2];
-				ADM_CM_THRESH_S_I_J(angles, flt_angles, csf_px_stride, &thr, w, h, i, j);
-
-				xh = fabsf(xh) - thr;
-				xv = fabsf(xv) - thr;
-				xd = fabsf(xd) - thr;
-
-				xh = xh < 0.0f ? 0.0f : xh;
-				xv = xv < 0.0f ? 0.0f : xv;
-				xd = xd < 0.0f ? 0.0f : xd;
-
-				val = (xh * xh * xh);
-				accum_inner_h += val;
-				val = (xv * xv * xv);
-				accum_inner_v += val;
-				val = (xd * xd * xd);
-				accum_inner_d += val;
 
-			}
-			/* j = w-1 */
+		/* j within frame */
+		cm_row(src, csf_f, csf_a, rfactor, i, start_col, end_col,
+		       src_stride, csf_a_stride, accum_inner);
+
+		/* j = w-1, if the right border is outside the frame */
+		if (right > (w - 1)) {
 			xh = src->band_h[i * src_px_stride + w - 1] * rfactor[0];
 			xv = src->band_v[i * src_px_stride + w - 1] * rfactor[1];
 			xd = src->band_d[i * src_px_stride + w - 1] * rfactor[2];
@@ -621,93 +655,16 @@ float adm_cm_s(const adm_dwt_band_t_s *src, const adm_dwt_band_t_s *csf_f,
 			xd = xd < 0.0f ? 0.0f : xd;
 
 			val = (xh * xh * xh);
-			accum_inner_h += val;
+			accum_inner[0] += val;
 			val = (xv * xv * xv);
-			accum_inner_v += val;
+			accum_inner[1] += val;
 			val = (xd * xd * xd);
-			accum_inner_d += val;
-
-			accum_h += accum_inner_h;
-			accum_v += accum_inner_v;
-			accum_d += accum_inner_d;
+			accum_inner[2] += val;
 		}
-	}
-	else /* Both borders outside frame */
-	{
-		for (i = start_row; i < end_row; ++i) {
-			accum_inner_h = 0;
-			accum_inner_v = 0;
-			accum_inner_d = 0;
 
-			/* j = 0 */
-			xh = src->band_h[i * src_px_stride] * rfactor[0];
-			xv = src->band_v[i * src_px_stride] * rfactor[1];
-			xd = src->band_d[i * src_px_stride] * rfactor[2];
-			ADM_CM_THRESH_S_I_0(angles, flt_angles, csf_px_stride, &thr, w, h, i, 0);
-
-			xh = fabsf(xh) - thr;
-			xv = fabsf(xv) - thr;
-			xd = fabsf(xd) - thr;
-
-			xh = xh < 0.0f ? 0.0f : xh;
-			xv = xv < 0.0f ? 0.0f : xv;
-			xd = xd < 0.0f ? 0.0f : xd;
-
-			val = (xh * xh * xh);
-			accum_inner_h += val;
-			val = (xv * xv * xv);
-			accum_inner_v += val;
-			val = (xd * xd * xd);
-			accum_inner_d += val;
-
-			/* j within frame */
-			for (j = start_col; j < end_col; ++j) {
-				xh = src->band_h[i * src_px_stride + j] * rfactor[0];
-				xv = src->band_v[i * src_px_stride + j] * rfactor[1];
-				xd = src->band_d[i * src_px_stride + j] * rfactor[2];
-				ADM_CM_THRESH_S_I_J(angles, flt_angles, csf_px_stride, &thr, w, h, i, j);
-
-				xh = fabsf(xh) - thr;
-				xv = fabsf(xv) - thr;
-				xd = fabsf(xd) - thr;
-
-				xh = xh < 0.0f ? 0.0f : xh;
-				xv = xv < 0.0f ? 0.0f : xv;
-				xd = xd < 0.0f ? 0.0f : xd;
-
-				val = (xh * xh * xh);
-				accum_inner_h += val;
-				val = (xv * xv * xv);
-				accum_inner_v += val;
-				val = (xd * xd * xd);
-				accum_inner_d += val;
-
-			}
-			/* j = w-1 */
-			xh = src->band_h[i * src_px_stride + w - 1] * rfactor[0];
-			xv = src->band_v[i * src_px_stride + w - 1] * rfactor[1];
-			xd = src->band_d[i * src_px_stride + w - 1] * rfactor[2];
-			ADM_CM_THRESH_S_I_W_M_1(angles, flt_angles, csf_px_stride, &thr, w, h, i, (w - 1));
-
-		xh = fabsf(xh) - thr;
-		xv = fabsf(xv) - thr;
-		xd = fabsf(xd) - thr;
-
-		xh = xh < 0.0f ? 0.0f : xh;
-		xv = xv < 0.0f ? 0.0f : xv;
-		xd = xd < 0.0f ? 0.0f : xd;
-
-		val = (xh * xh * xh);
-		accum_inner_h += val;
-		val = (xv * xv * xv);
-		accum_inner_v += val;
-		val = (xd * xd * xd);
-		accum_inner_d += val;
-
-			accum_h += accum_inner_h;
-			accum_v += accum_inner_v;
-			accum_d += accum_inner_d;
-	}
+		accum_h += accum_inner[0];
+		accum_v += accum_inner[1];
+		accum_d += accum_inner[2];
 	}
 	accum_inner_h = 0;
 	accum_inner_v = 0;
@@ -855,6 +812,18 @@ void adm_dwt2_s(const float *src, const adm_dwt_band_t_s *dst, int **ind_y, int
 	const float *filter_lo = dwt2_db2_coeffs_lo_s;
 	const float *filter_hi = dwt2_db2_coeffs_hi_s;
 
+#if ARCH_X86
+	if ((vmaf_get_cpu_flags() & VMAF_X86_CPU_FLAG_AVX2) && w >= 8) {
+		adm_dwt2_s_avx2(filter_lo, filter_hi, src, dst, ind_y, ind_x, w, h, src_stride, dst_stride);
+		return;
+	}
+#elif ARCH_AARCH64
+	if ((vmaf_get_cpu_flags() & VMAF_ARM_CPU_FLAG_NEON) && w >= 4) {
+		adm_dwt2_s_neon(filter_lo, filter_hi, src, dst, ind_y, ind_x, w, h, src_stride, dst_stride);
+		return;
+	}
+#endif
+
 	int src_px_stride = src_stride / sizeof(float);
 	int dst_px_stride = dst_stride / sizeof(float);
 
@@ -28,6 +28,14 @@
 #ifndef ADM_TOOLS_H_
 #define ADM_TOOLS_H_
 
+#ifndef FLOAT_ONE_BY_30
+#define FLOAT_ONE_BY_30	0.0333333351
+#endif
+
+#ifndef FLOAT_ONE_BY_15
+#define FLOAT_ONE_BY_15 0.0666666701
+#endif
+
 // i = 0, j = 0: indices y: 1,0,1, x: 1,0,1
 #define ADM_CM_THRESH_S_0_0(angles,flt_angles,src_px_stride,accum,w,h,i,j) \
 { \
@@ -0,0 +1,479 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <arm_neon.h>
+#include <math.h>
+#include <stddef.h>
+
+#include "mem.h"
+#include "feature/adm_options.h"
+#include "feature/adm_tools.h"
+#include "feature/arm64/adm_tools_neon.h"
+
+/*
+ * These follow the scalar code in adm_tools.c operation for operation, with
+ * the double precision steps the scalar code gets from its double constants
+ * and from adm_enhn_gain_limit. Reductions vectorize the per pixel terms only
+ * and keep summing them one at a time.
+ *
+ * Element-wise kernels finish a row with one more vector ending at the last
+ * column, so they need at least 4 columns.
+ */
+
+// (float)(c * x), with the product in double precision
+static inline float32x4_t mul_pd_ps(float32x4_t x, float64x2_t c)
+{
+    const float64x2_t lo = vmulq_f64(c, vcvt_f64_f32(vget_low_f32(x)));
+    const float64x2_t hi = vmulq_f64(c, vcvt_high_f64_f32(x));
+    return vcvt_high_f32_f64(vcvt_f32_f64(lo), hi);
+}
+
+// (float)(sum + c * x), with the product and the sum in double precision
+static inline float32x4_t add_mul_pd_ps(float32x4_t sum, float32x4_t x,
+                                        float64x2_t c)
+{
+    const float64x2_t lo =
+        vaddq_f64(vcvt_f64_f32(vget_low_f32(sum)),
+                  vmulq_f64(c, vcvt_f64_f32(vget_low_f32(x))));
+    const float64x2_t hi =
+        vaddq_f64(vcvt_high_f64_f32(sum), vmulq_f64(c, vcvt_high_f64_f32(x)));
+    return vcvt_high_f32_f64(vcvt_f32_f64(lo), hi);
+}
+
+static inline float32x4_t cube_ps(float32x4_t x)
+{
+    return vmulq_f32(vmulq_f32(x, x), x);
+}
+
+// x < 0.0f ? 0.0f : x
+static inline float32x4_t clip_below_zero(float32x4_t x)
+{
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    return vbslq_f32(vcltq_f32(x, zero), zero, x);
+}
+
+static inline float32x4_t dwt2_tap_ps(const float32x4_t f[4], float32x4_t s0,
+                                      float32x4_t s1, float32x4_t s2,
+                                      float32x4_t s3)
+{
+    float32x4_t accum = vdupq_n_f32(0.0f);
+    accum = vaddq_f32(accum, vmulq_f32(f[0], s0));
+    accum = vaddq_f32(accum, vmulq_f32(f[1], s1));
+    accum = vaddq_f32(accum, vmulq_f32(f[2], s2));
+    accum = vaddq_f32(accum, vmulq_f32(f[3], s3));
+    return accum;
+}
+
+static inline float dwt2_tap_s(const float *f, float s0, float s1, float s2,
+                               float s3)
+{
+    float accum = 0;
+    accum += f[0] * s0;
+    accum += f[1] * s1;
+    accum += f[2] * s2;
+    accum += f[3] * s3;
+    return accum;
+}
+
+static inline void dwt2_v_neon(const float32x4_t lo[4], const float32x4_t hi[4],
+                               const float *s0, const float *s1,
+                               const float *s2, const float *s3,
+                               float *tmplo, float *tmphi, int j)
+{
+    const float32x4_t a0 = vld1q_f32(s0 + j);
+    const float32x4_t a1 = vld1q_f32(s1 + j);
+    const float32x4_t a2 = vld1q_f32(s2 + j);
+    const float32x4_t a3 = vld1q_f32(s3 + j);
+    vst1q_f32(tmplo + j, dwt2_tap_ps(lo, a0, a1, a2, a3));
+    vst1q_f32(tmphi + j, dwt2_tap_ps(hi, a0, a1, a2, a3));
+}
+
+// outputs j to j + 3, away from the borders: taps 2j - 1 to 2j + 8
+static inline void dwt2_h_neon(const float32x4_t lo[4], const float32x4_t hi[4],
+                               const float *tmplo, const float *tmphi,
+                               const adm_dwt_band_t_s *row, int j)
+{
+    float32x4x2_t s01 = vld2q_f32(tmplo + 2 * j - 1);
+    float32x4x2_t s23 = vld2q_f32(tmplo + 2 * j + 1);
+    vst1q_f32(row->band_a + j,
+              dwt2_tap_ps(lo, s01.val[0], s01.val[1], s23.val[0], s23.val[1]));
+    vst1q_f32(row->band_v + j,
+              dwt2_tap_ps(hi, s01.val[0], s01.val[1], s23.val[0], s23.val[1]));
+
+    s01 = vld2q_f32(tmphi + 2 * j - 1);
+    s23 = vld2q_f32(tmphi + 2 * j + 1);
+    vst1q_f32(row->band_h + j,
+              dwt2_tap_ps(lo, s01.val[0], s01.val[1], s23.val[0], s23.val[1]));
+    vst1q_f32(row->band_d + j,
+              dwt2_tap_ps(hi, s01.val[0], s01.val[1], s23.val[0], s23.val[1]));
+}
+
+static inline void dwt2_h_s(const float *filter_lo, const float *filter_hi,
+                            const float *tmplo, const float *tmphi,
+                            int **ind_x, const adm_dwt_band_t_s *row, int j)
+{
+    const int j0 = ind_x[0][j];
+    const int j1 = ind_x[1][j];
+    const int j2 = ind_x[2][j];
+    const int j3 = ind_x[3][j];
+    row->band_a[j] = dwt2_tap_s(filter_lo, tmplo[j0], tmplo[j1], tmplo[j2], tmplo[j3]);
+    row->band_v[j] = dwt2_tap_s(filter_hi, tmplo[j0], tmplo[j1], tmplo[j2], tmplo[j3]);
+    row->band_h[j] = dwt2_tap_s(filter_lo, tmphi[j0], tmphi[j1], tmphi[j2], tmphi[j3]);
+    row->band_d[j] = dwt2_tap_s(filter_hi, tmphi[j0], tmphi[j1], tmphi[j2], tmphi[j3]);
+}
+
+void adm_dwt2_s_neon(const float *filter_lo, const float *filter_hi,
+                     const float *src, const adm_dwt_band_t_s *dst,
+                     int **ind_y, int **ind_x, int w, int h,
+                     int src_stride, int dst_stride)
+{
+    const int src_px_stride = src_stride / sizeof(float);
+    const int dst_px_stride = dst_stride / sizeof(float);
+    const float32x4_t lo[4] = {
+        vdupq_n_f32(filter_lo[0]), vdupq_n_f32(filter_lo[1]),
+        vdupq_n_f32(filter_lo[2]), vdupq_n_f32(filter_lo[3]),
+    };
+    const float32x4_t hi[4] = {
+        vdupq_n_f32(filter_hi[0]), vdupq_n_f32(filter_hi[1]),
+        vdupq_n_f32(filter_hi[2]), vdupq_n_f32(filter_hi[3]),
+    };
+
+    // outputs 1 to inner_end - 1 read taps 2j - 1 to 2j + 2 without mirroring
+    const int half_w = (w + 1) / 2;
+    const int inner_end = (w - 1) / 2;
+
+    float *tmplo = aligned_malloc(ALIGN_CEIL(sizeof(float) * w), MAX_ALIGN);
+    float *tmphi = aligned_malloc(ALIGN_CEIL(sizeof(float) * w), MAX_ALIGN);
+
+    for (int i = 0; i < (h + 1) / 2; ++i) {
+        /* Vertical pass. */
+        const float *s0 = src + ind_y[0][i] * src_px_stride;
+        const float *s1 = src + ind_y[1][i] * src_px_stride;
+        const float *s2 = src + ind_y[2][i] * src_px_stride;
+        const float *s3 = src + ind_y[3][i] * src_px_stride;
+
+        for (int j = 0; j < w; j += 4) {
+            if (j + 4 > w)
+                j = w - 4;
+            dwt2_v_neon(lo, hi, s0, s1, s2, s3, tmplo, tmphi, j);
+        }
+
+        /* Horizontal pass (lo and hi). */
+        const adm_dwt_band_t_s row = {
+            .band_a = dst->band_a + i * dst_px_stride,
+            .band_v = dst->band_v + i * dst_px_stride,
+            .band_h = dst->band_h + i * dst_px_stride,
+            .band_d = dst->band_d + i * dst_px_stride,
+        };
+
+        int j = 1;
+        if (inner_end - j >= 4) {
+            for (; j < inner_end; j += 4) {
+                if (j + 4 > inner_end)
+                    j = inner_end - 4;
+                dwt2_h_neon(lo, hi, tmplo, tmphi, &row, j);
+            }
+        }
+        dwt2_h_s(filter_lo, filter_hi, tmplo, tmphi, ind_x, &row, 0);
+        for (; j < half_w; ++j)
+            dwt2_h_s(filter_lo, filter_hi, tmplo, tmphi, ind_x, &row, j);
+    }
+
+    aligned_free(tmplo);
+    aligned_free(tmphi);
+}
+
+// the clipped gain k * o, raised to at most adm_enhn_gain_limit * k * o
+// where the angle test passes
+static inline float32x4_t decouple_rst_neon(float32x4_t o, float32x4_t t,
+                                            uint32x4_t angle_flag,
+                                            float64x2_t gain_limit)
+{
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+
+    float32x4_t k = vdivq_f32(t, vaddq_f32(o, vdupq_n_f32(1e-30f)));
+    k = vbslq_f32(vcltq_f32(k, zero), zero, vbslq_f32(vcgtq_f32(k, one), one, k));
+    float32x4_t rst = vmulq_f32(k, o);
+
+    float32x4_t x = mul_pd_ps(rst, gain_limit);
+    uint32x4_t m = vandq_u32(angle_flag, vcgtq_f32(rst, zero));
+    rst = vbslq_f32(m, vbslq_f32(vcltq_f32(x, t), x, t), rst);
+    x = mul_pd_ps(rst, gain_limit);
+    m = vandq_u32(angle_flag, vcltq_f32(rst, zero));
+    rst = vbslq_f32(m, vbslq_f32(vcgtq_f32(x, t), x, t), rst);
+    return rst;
+}
+
+static inline void decouple_neon(const float *ref_h, const float *ref_v,
+                                 const float *ref_d, const float *dis_h,
+                                 const float *dis_v, const float *dis_d,
+                                 float *r_h, float *r_v, float *r_d,
+                                 float *a_h, float *a_v, float *a_d,
+                                 float32x4_t cos_1deg_sq, float64x2_t gain_limit,
+                                 int j)
+{
+    const float32x4_t oh = vld1q_f32(ref_h + j);
+    const float32x4_t ov = vld1q_f32(ref_v + j);
+    const float32x4_t od = vld1q_f32(ref_d + j);
+    const float32x4_t th = vld1q_f32(dis_h + j);
+    const float32x4_t tv = vld1q_f32(dis_v + j);
+    const float32x4_t td = vld1q_f32(dis_d + j);
+
+    const float32x4_t ot_dp = vaddq_f32(vmulq_f32(oh, th), vmulq_f32(ov, tv));
+    const float32x4_t o_mag_sq = vaddq_f32(vmulq_f32(oh, oh), vmulq_f32(ov, ov));
+    const float32x4_t t_mag_sq = vaddq_f32(vmulq_f32(th, th), vmulq_f32(tv, tv));
+    const uint32x4_t angle_flag = vandq_u32(
+        vcgeq_f32(ot_dp, vdupq_n_f32(0.0f)),
+        vcgeq_f32(vmulq_f32(ot_dp, ot_dp),
+                  vmulq_f32(vmulq_f32(cos_1deg_sq, o_mag_sq), t_mag_sq)));
+
+    const float32x4_t rst_h = decouple_rst_neon(oh, th, angle_flag, gain_limit);
+    const float32x4_t rst_v = decouple_rst_neon(ov, tv, angle_flag, gain_limit);
+    const float32x4_t rst_d = decouple_rst_neon(od, td, angle_flag, gain_limit);
+
+    vst1q_f32(r_h + j, rst_h);
+    vst1q_f32(r_v + j, rst_v);
+    vst1q_f32(r_d + j, rst_d);
+    vst1q_f32(a_h + j, vsubq_f32(th, rst_h));
+    vst1q_f32(a_v + j, vsubq_f32(tv, rst_v));
+    vst1q_f32(a_d + j, vsubq_f32(td, rst_d));
+}
+
+void adm_decouple_s_neon(const adm_dwt_band_t_s *ref, const adm_dwt_band_t_s *dis,
+                         const adm_dwt_band_t_s *r, const adm_dwt_band_t_s *a,
+                         int left, int top, int right, int bottom,
+                         int ref_stride, int dis_stride, int r_stride, int a_stride,
+                         double adm_enhn_gain_limit)
+{
+    const float cos_1deg_sq_s = cos(1.0 * M_PI / 180.0) * cos(1.0 * M_PI / 180.0);
+    const float32x4_t cos_1deg_sq = vdupq_n_f32(cos_1deg_sq_s);
+    const float64x2_t gain_limit = vdupq_n_f64(adm_enhn_gain_limit);
+
+    const int ref_px_stride = ref_stride / sizeof(float);
+    const int dis_px_stride = dis_stride / sizeof(float);
+    const int r_px_stride = r_stride / sizeof(float);
+    const int a_px_stride = a_stride / sizeof(float);
+
+    for (int i = top; i < bottom; ++i) {
+        const float *ref_h = ref->band_h + i * ref_px_stride;
+        const float *ref_v = ref->band_v + i * ref_px_stride;
+        const float *ref_d = ref->band_d + i * ref_px_stride;
+        const float *dis_h = dis->band_h + i * dis_px_stride;
+        const float *dis_v = dis->band_v + i * dis_px_stride;
+        const float *dis_d = dis->band_d + i * dis_px_stride;
+        float *r_h = r->band_h + i * r_px_stride;
+        float *r_v = r->band_v + i * r_px_stride;
+        float *r_d = r->band_d + i * r_px_stride;
+        float *a_h = a->band_h + i * a_px_stride;
+        float *a_v = a->band_v + i * a_px_stride;
+        float *a_d = a->band_d + i * a_px_stride;
+
+        for (int j = left; j < right; j += 4) {
+            if (j + 4 > right)
+                j = right - 4;
+            decouple_neon(ref_h, ref_v, ref_d, dis_h, dis_v, dis_d, r_h, r_v, r_d,
+                          a_h, a_v, a_d, cos_1deg_sq, gain_limit, j);
+        }
+    }
+}
+
+void adm_csf_s_neon(const adm_dwt_band_t_s *src, const adm_dwt_band_t_s *dst,
+                    const adm_dwt_band_t_s *flt, const float rfactor[3],
+                    int left, int top, int right, int bottom,
+                    int src_stride, int dst_stride)
+{
+    const float *src_angles[3] = { src->band_h, src->band_v, src->band_d };
+    float *dst_angles[3] = { dst->band_h, dst->band_v, dst->band_d };
+    float *flt_angles[3] = { flt->band_h, flt->band_v, flt->band_d };
+
+    const int src_px_stride = src_stride / sizeof(float);
+    const int dst_px_stride = dst_stride / sizeof(float);
+    const float64x2_t one_by_30 = vdupq_n_f64(FLOAT_ONE_BY_30);
+
+    for (int theta = 0; theta < 3; ++theta) {
+        const float32x4_t factor = vdupq_n_f32(rfactor[theta]);
+
+        for (int i = top; i < bottom; ++i) {
+            const float *src_ptr = src_angles[theta] + i * src_px_stride;
+            float *dst_ptr = dst_angles[theta] + i * dst_px_stride;
+            float *flt_ptr = flt_angles[theta] + i * dst_px_stride;
+
+            for (int j = left; j < right; j += 4) {
+                if (j + 4 > right)
+                    j = right - 4;
+                const float32x4_t dst_val = vmulq_f32(factor, vld1q_f32(src_ptr + j));
+                vst1q_f32(dst_ptr + j, dst_val);
+                vst1q_f32(flt_ptr + j, mul_pd_ps(vabsq_f32(dst_val), one_by_30));
+            }
+        }
+    }
+}
+
+// the serial float sums of the scalar code, fed 4 terms at a time
+static inline void accum_ps(float *accum, float32x4_t x)
+{
+    *accum += vgetq_lane_f32(x, 0);
+    *accum += vgetq_lane_f32(x, 1);
+    *accum += vgetq_lane_f32(x, 2);
+    *accum += vgetq_lane_f32(x, 3);
+}
+
+void adm_csf_den_scale_accum_s_neon(const adm_dwt_band_t_s *src,
+                                    const float rfactor[3],
+                                    int left, int top, int right, int bottom,
+                                    int src_stride, float accum[3])
+{
+    const int src_px_stride = src_stride / sizeof(float);
+    const float32x4_t factor_h = vdupq_n_f32(rfactor[0]);
+    const float32x4_t factor_v = vdupq_n_f32(rfactor[1]);
+    const float32x4_t factor_d = vdupq_n_f32(rfactor[2]);
+
+    float accum_h = 0, accum_v = 0, accum_d = 0;
+
+    for (int i = top; i < bottom; ++i) {
+        const float *src_h = src->band_h + i * src_px_stride;
+        const float *src_v = src->band_v + i * src_px_stride;
+        const float *src_d = src->band_d + i * src_px_stride;
+        float accum_inner_h = 0, accum_inner_v = 0, accum_inner_d = 0;
+
+        int j;
+        for (j = left; j + 4 <= right; j += 4) {
+            const float32x4_t h = vabsq_f32(vmulq_f32(factor_h, vld1q_f32(src_h + j)));
+            const float32x4_t v = vabsq_f32(vmulq_f32(factor_v, vld1q_f32(src_v + j)));
+            const float32x4_t d = vabsq_f32(vmulq_f32(factor_d, vld1q_f32(src_d + j)));
+            accum_ps(&accum_inner_h, cube_ps(h));
+            accum_ps(&accum_inner_v, cube_ps(v));
+            accum_ps(&accum_inner_d, cube_ps(d));
+        }
+        for (; j < right; ++j) {
+            const float h = fabsf(rfactor[0] * src_h[j]);
+            const float v = fabsf(rfactor[1] * src_v[j]);
+            const float d = fabsf(rfactor[2] * src_d[j]);
+            accum_inner_h += h * h * h;
+            accum_inner_v += v * v * v;
+            accum_inner_d += d * d * d;
+        }
+
+        accum_h += accum_inner_h;
+        accum_v += accum_inner_v;
+        accum_d += accum_inner_d;
+    }
+
+    accum[0] = accum_h;
+    accum[1] = accum_v;
+    accum[2] = accum_d;
+}
+
+void adm_cm_row_s_neon(const adm_dwt_band_t_s *src, const adm_dwt_band_t_s *csf_f,
+                       const adm_dwt_band_t_s *csf_a, const float rfactor[3],
+                       int i, int start_col, int end_col,
+                       int src_stride, int csf_stride, float accum[3])
+{
+    const float *angles[3] = { csf_a->band_h, csf_a->band_v, csf_a->band_d };
+    const float *flt_angles[3] = { csf_f->band_h, csf_f->band_v, csf_f->band_d };
+
+    const int src_px_stride = src_stride / sizeof(float);
+    const int csf_px_stride = csf_stride / sizeof(float);
+    const float *src_h = src->band_h + i * src_px_stride;
+    const float *src_v = src->band_v + i * src_px_stride;
+    const float *src_d = src->band_d + i * src_px_stride;
+
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t factor_h = vdupq_n_f32(rfactor[0]);
+    const float32x4_t factor_v = vdupq_n_f32(rfactor[1]);
+    const float32x4_t factor_d = vdupq_n_f32(rfactor[2]);
+    const float64x2_t one_by_15 = vdupq_n_f64(FLOAT_ONE_BY_15);
+    float accum_h = accum[0], accum_v = accum[1], accum_d = accum[2];
+
+    int j;
+    for (j = start_col; j + 4 <= end_col; j += 4) {
+        float32x4_t thr = zero;
+        for (int theta = 0; theta < 3; ++theta) {
+            const float *src_ptr = angles[theta] + i * csf_px_stride + j;
+            const float *flt_ptr = flt_angles[theta] + (i - 1) * csf_px_stride + j;
+            float32x4_t sum = zero;
+            sum = vaddq_f32(sum, vld1q_f32(flt_ptr - 1));
+            sum = vaddq_f32(sum, vld1q_f32(flt_ptr));
+            sum = vaddq_f32(sum, vld1q_f32(flt_ptr + 1));
+            flt_ptr += csf_px_stride;
+            sum = vaddq_f32(sum, vld1q_f32(flt_ptr - 1));
+            sum = add_mul_pd_ps(sum, vabsq_f32(vld1q_f32(src_ptr)), one_by_15);
+            sum = vaddq_f32(sum, vld1q_f32(flt_ptr + 1));
+            flt_ptr += csf_px_stride;
+            sum = vaddq_f32(sum, vld1q_f32(flt_ptr - 1));
+            sum = vaddq_f32(sum, vld1q_f32(flt_ptr));
+            sum = vaddq_f32(sum, vld1q_f32(flt_ptr + 1));
+            thr = vaddq_f32(thr, sum);
+        }
+
+        float32x4_t xh = vmulq_f32(vld1q_f32(src_h + j), factor_h);
+        float32x4_t xv = vmulq_f32(vld1q_f32(src_v + j), factor_v);
+        float32x4_t xd = vmulq_f32(vld1q_f32(src_d + j), factor_d);
+        xh = clip_below_zero(vsubq_f32(vabsq_f32(xh), thr));
+        xv = clip_below_zero(vsubq_f32(vabsq_f32(xv), thr));
+        xd = clip_below_zero(vsubq_f32(vabsq_f32(xd), thr));
+        accum_ps(&accum_h, cube_ps(xh));
+        accum_ps(&accum_v, cube_ps(xv));
+        accum_ps(&accum_d, cube_ps(xd));
+    }
+
+    for (; j < end_col; ++j) {
+        float thr;
+        // w and h are only used at the borders
+        ADM_CM_THRESH_S_I_J(angles, flt_angles, csf_px_stride, &thr, 0, 0, i, j);
+
+        float xh = fabsf(src_h[j] * rfactor[0]) - thr;
+        float xv = fabsf(src_v[j] * rfactor[1]) - thr;
+        float xd = fabsf(src_d[j] * rfactor[2]) - thr;
+        xh = xh < 0.0f ? 0.0f : xh;
+        xv = xv < 0.0f ? 0.0f : xv;
+        xd = xd < 0.0f ? 0.0f : xd;
+        accum_h += xh * xh * xh;
+        accum_v += xv * xv * xv;
+        accum_d += xd * xd * xd;
+    }
+
+    accum[0] = accum_h;
+    accum[1] = accum_v;
+    accum[2] = accum_d;
+}
+
+float adm_sum_cube_accum_s_neon(const float *x, int left, int top, int right,
+                                int bottom, int stride)
+{
+    const int px_stride = stride / sizeof(float);
+    float accum = 0;
+
+    for (int i = top; i < bottom; ++i) {
+        const float *x_row = x + i * px_stride;
+        float accum_inner = 0;
+
+        int j;
+        for (j = left; j + 4 <= right; j += 4)
+            accum_ps(&accum_inner, cube_ps(vabsq_f32(vld1q_f32(x_row + j))));
+        for (; j < right; ++j) {
+            const float val = fabsf(x_row[j]);
+            accum_inner += val * val * val;
+        }
+
+        accum += accum_inner;
+    }
+
+    return accum;
+}
@@ -0,0 +1,53 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef ARM64_ADM_TOOLS_NEON_H_
+#define ARM64_ADM_TOOLS_NEON_H_
+
+#include "feature/adm_tools.h"
+
+void adm_dwt2_s_neon(const float *filter_lo, const float *filter_hi,
+                     const float *src, const adm_dwt_band_t_s *dst,
+                     int **ind_y, int **ind_x, int w, int h,
+                     int src_stride, int dst_stride);
+
+void adm_decouple_s_neon(const adm_dwt_band_t_s *ref, const adm_dwt_band_t_s *dis,
+                         const adm_dwt_band_t_s *r, const adm_dwt_band_t_s *a,
+                         int left, int top, int right, int bottom,
+                         int ref_stride, int dis_stride, int r_stride, int a_stride,
+                         double adm_enhn_gain_limit);
+
+void adm_csf_s_neon(const adm_dwt_band_t_s *src, const adm_dwt_band_t_s *dst,
+                    const adm_dwt_band_t_s *flt, const float rfactor[3],
+                    int left, int top, int right, int bottom,
+                    int src_stride, int dst_stride);
+
+void adm_csf_den_scale_accum_s_neon(const adm_dwt_band_t_s *src,
+                                    const float rfactor[3],
+                                    int left, int top, int right, int bottom,
+                                    int src_stride, float accum[3]);
+
+void adm_cm_row_s_neon(const adm_dwt_band_t_s *src, const adm_dwt_band_t_s *csf_f,
+                       const adm_dwt_band_t_s *csf_a, const float rfactor[3],
+                       int i, int start_col, int end_col,
+                       int src_stride, int csf_stride, float accum[3]);
+
+float adm_sum_cube_accum_s_neon(const float *x, int left, int top, int right,
+                                int bottom, int stride);
+
+#endif /* ARM64_ADM_TOOLS_NEON_H_ */
@@ -0,0 +1,236 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <arm_neon.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "feature/arm64/cambi_neon.h"
+
+void cambi_increment_range_neon(uint16_t *arr, int left, int right) {
+    const uint16x8_t ones = vdupq_n_u16(1);
+    int col = left;
+    for (; col + 7 < right; col += 8) {
+        vst1q_u16(&arr[col], vaddq_u16(vld1q_u16(&arr[col]), ones));
+    }
+    for (; col < right; col++) {
+        arr[col]++;
+    }
+}
+
+void cambi_decrement_range_neon(uint16_t *arr, int left, int right) {
+    const uint16x8_t ones = vdupq_n_u16(1);
+    int col = left;
+    for (; col + 7 < right; col += 8) {
+        vst1q_u16(&arr[col], vsubq_u16(vld1q_u16(&arr[col]), ones));
+    }
+    for (; col < right; col++) {
+        arr[col]--;
+    }
+}
+
+void get_derivative_data_for_row_neon(const uint16_t *image_data, uint16_t *derivative_buffer, int width, int height, int row, int stride) {
+    const uint16_t *curr = &image_data[row * stride];
+    // For the last row, we only compute horizontal derivatives
+    if (row == height - 1) {
+        int col = 0;
+        for (; col + 7 < width - 1; col += 8) {
+            const uint16x8_t horiz = vceqq_u16(vld1q_u16(&curr[col]), vld1q_u16(&curr[col + 1]));
+            vst1q_u16(&derivative_buffer[col], vshrq_n_u16(horiz, 15));
+        }
+        for (; col < width - 1; col++) {
+            derivative_buffer[col] = (curr[col] == curr[col + 1]);
+        }
+        derivative_buffer[width - 1] = 1;
+    }
+    else {
+        const uint16_t *next = &image_data[(row + 1) * stride];
+        int col = 0;
+        for (; col + 7 < width - 1; col += 8) {
+            const uint16x8_t vals = vld1q_u16(&curr[col]);
+            const uint16x8_t horiz = vceqq_u16(vals, vld1q_u16(&curr[col + 1]));
+            const uint16x8_t vert = vceqq_u16(vals, vld1q_u16(&next[col]));
+            vst1q_u16(&derivative_buffer[col], vshrq_n_u16(vandq_u16(horiz, vert), 15));
+        }
+        for (; col < width; col++) {
+            bool horizontal_derivative = (col == width - 1 || curr[col] == curr[col + 1]);
+            bool vertical_derivative = curr[col] == next[col];
+            derivative_buffer[col] = horizontal_derivative && vertical_derivative;
+        }
+    }
+}
+
+static float c_value_pixel(const uint16_t *histograms, uint16_t value, const int *diff_weights,
+                           const int *diffs, uint16_t num_diffs, const uint16_t *tvi_thresholds, int histogram_col, int histogram_width) {
+    uint16_t p_0 = histograms[value * histogram_width + histogram_col];
+    float val, c_value = 0.0;
+    for (uint16_t d = 0; d < num_diffs; d++) {
+        if (value <= tvi_thresholds[d]) {
+            uint16_t p_1 = histograms[(value + diffs[num_diffs + d + 1]) * histogram_width + histogram_col];
+            uint16_t p_2 = histograms[(value + diffs[num_diffs - d - 1]) * histogram_width + histogram_col];
+            if (p_1 > p_2) {
+                val = (float)(diff_weights[d] * p_0 * p_1) / (p_1 + p_0);
+            }
+            else {
+                val = (float)(diff_weights[d] * p_0 * p_2) / (p_2 + p_0);
+            }
+
+            if (val > c_value) {
+                c_value = val;
+            }
+        }
+    }
+
+    return c_value;
+}
+
+static inline uint32x4_t widen_mask(uint16x4_t mask) {
+    return vreinterpretq_u32_s32(vmovl_s16(vreinterpret_s16_u16(mask)));
+}
+
+/* Four columns at a time. The histogram reads are per-lane gathers, the
+ * arithmetic follows c_value_pixel() step by step: the larger neighbour count
+ * is the one the scalar branch picks, the product is formed in integers and
+ * converted once, and a NaN from an empty 0/0 bin never replaces c_value. */
+void calculate_c_values_row_neon(float *c_values, const uint16_t *histograms, const uint16_t *image,
+                                 const uint16_t *mask, int row, int width, ptrdiff_t stride,
+                                 const uint16_t num_diffs, const uint16_t *tvi_for_diff,
+                                 const int *diff_weights, const int *all_diffs) {
+    const uint16_t *image_row = &image[row * stride];
+    const uint16_t *mask_row = &mask[row * stride];
+    float *c_values_row = &c_values[row * width];
+
+    int col = 0;
+    for (; col + 3 < width; col += 4) {
+        const uint16x4_t mask_val = vld1_u16(&mask_row[col]);
+        if (!vget_lane_u64(vreinterpret_u64_u16(mask_val), 0)) continue;
+
+        const uint16x4_t value = vadd_u16(vld1_u16(&image_row[col]), vdup_n_u16(num_diffs));
+        uint16_t v[4], p[4];
+        vst1_u16(v, value);
+        for (int k = 0; k < 4; k++) {
+            p[k] = histograms[v[k] * width + col + k];
+        }
+        const uint32x4_t p_0 = vmovl_u16(vld1_u16(p));
+
+        float32x4_t c_value = vdupq_n_f32(0.0f);
+        for (uint16_t d = 0; d < num_diffs; d++) {
+            const uint16x4_t in_tvi = vcle_u16(value, vdup_n_u16(tvi_for_diff[d]));
+            if (!vget_lane_u64(vreinterpret_u64_u16(in_tvi), 0)) continue;
+
+            uint16_t p_1[4], p_2[4];
+            const int diff_1 = all_diffs[num_diffs + d + 1];
+            const int diff_2 = all_diffs[num_diffs - d - 1];
+            for (int k = 0; k < 4; k++) {
+                p_1[k] = histograms[(v[k] + diff_1) * width + col + k];
+                p_2[k] = histograms[(v[k] + diff_2) * width + col + k];
+            }
+            const uint32x4_t p_max = vmovl_u16(vmax_u16(vld1_u16(p_1), vld1_u16(p_2)));
+            const uint32x4_t num = vmulq_u32(vmulq_n_u32(p_0, diff_weights[d]), p_max);
+            const float32x4_t val = vdivq_f32(vcvtq_f32_u32(num), vcvtq_f32_u32(vaddq_u32(p_max, p_0)));
+
+            const uint32x4_t update = vandq_u32(widen_mask(in_tvi), vcgtq_f32(val, c_value));
+            c_value = vbslq_f32(update, val, c_value);
+        }
+
+        const uint32x4_t in_mask = widen_mask(vtst_u16(mask_val, mask_val));
+        vst1q_f32(&c_values_row[col], vbslq_f32(in_mask, c_value, vld1q_f32(&c_values_row[col])));
+    }
+    for (; col < width; col++) {
+        if (mask_row[col]) {
+            c_values_row[col] = c_value_pixel(
+                histograms, image_row[col] + num_diffs, diff_weights, all_diffs, num_diffs, tvi_for_diff, col, width
+            );
+        }
+    }
+}
+
+void anti_dithering_row_neon(uint16_t *row, const uint16_t *next_row, int width) {
+    int col = 0;
+    for (; col + 8 < width; col += 8) {
+        uint16x8_t sum = vaddq_u16(vld1q_u16(&row[col]), vld1q_u16(&row[col + 1]));
+        sum = vaddq_u16(sum, vld1q_u16(&next_row[col]));
+        sum = vaddq_u16(sum, vld1q_u16(&next_row[col + 1]));
+        vst1q_u16(&row[col], vshrq_n_u16(sum, 2));
+    }
+    for (; col < width - 1; col++) {
+        row[col] = (row[col] + row[col + 1] + next_row[col] + next_row[col + 1]) >> 2;
+    }
+    row[width - 1] = (row[width - 1] + next_row[width - 1]) >> 1;
+}
+
+static inline uint16_t min3(uint16_t a, uint16_t b, uint16_t c) {
+    if (a <= b && a <= c) return a;
+    if (b <= c) return b;
+    return c;
+}
+
+static inline uint16_t mode3(uint16_t a, uint16_t b, uint16_t c) {
+    if (a == b || a == c) return a;
+    if (b == c) return b;
+    return min3(a, b, c);
+}
+
+void mode3_row_neon(uint16_t *dst, const uint16_t *a, const uint16_t *b, const uint16_t *c, int width) {
+    int col = 0;
+    for (; col + 7 < width; col += 8) {
+        const uint16x8_t va = vld1q_u16(&a[col]);
+        const uint16x8_t vb = vld1q_u16(&b[col]);
+        const uint16x8_t vc = vld1q_u16(&c[col]);
+        // the minimum, unless two of the values agree
+        uint16x8_t result = vminq_u16(vminq_u16(va, vb), vc);
+        result = vbslq_u16(vceqq_u16(vb, vc), vb, result);
+        const uint16x8_t a_is_mode = vorrq_u16(vceqq_u16(va, vb), vceqq_u16(va, vc));
+        vst1q_u16(&dst[col], vbslq_u16(a_is_mode, va, result));
+    }
+    for (; col < width; col++) {
+        dst[col] = mode3(a[col], b[col], c[col]);
+    }
+}
+
+void decimate_row_neon(uint16_t *dst, const uint16_t *src, int width) {
+    int col = 0;
+    // src holds at least 2 * width - 1 values, the last load ends at 2 * col + 15
+    for (; col + 8 < width; col += 8) {
+        vst1q_u16(&dst[col], vld2q_u16(&src[2 * col]).val[0]);
+    }
+    for (; col < width; col++) {
+        dst[col] = src[col << 1];
+    }
+}
+
+void spatial_mask_row_neon(uint16_t *mask_row, const uint16_t *column_sums, int width,
+                           uint16_t window, uint16_t mask_index) {
+    const uint16x8_t index = vdupq_n_u16(mask_index);
+    int col = 0;
+    for (; col + 7 < width; col += 8) {
+        uint16x8_t sum = vld1q_u16(&column_sums[col]);
+        for (int k = 1; k < window; k++) {
+            sum = vaddq_u16(sum, vld1q_u16(&column_sums[col + k]));
+        }
+        vst1q_u16(&mask_row[col], vshrq_n_u16(vcgtq_u16(sum, index), 15));
+    }
+    for (; col < width; col++) {
+        unsigned sum = 0;
+        for (int k = 0; k < window; k++) {
+            sum += column_sums[col + k];
+        }
+        mask_row[col] = (sum > mask_index);
+    }
+}
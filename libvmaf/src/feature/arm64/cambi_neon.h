@@ -0,0 +1,45 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef ARM64_CAMBI_H_
+#define ARM64_CAMBI_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+void cambi_increment_range_neon(uint16_t *arr, int left, int right);
+
+void cambi_decrement_range_neon(uint16_t *arr, int left, int right);
+
+void get_derivative_data_for_row_neon(const uint16_t *image_data, uint16_t *derivative_buffer, int width, int height, int row, int stride);
+
+void calculate_c_values_row_neon(float *c_values, const uint16_t *histograms, const uint16_t *image,
+                                 const uint16_t *mask, int row, int width, ptrdiff_t stride,
+                                 const uint16_t num_diffs, const uint16_t *tvi_for_diff,
+                                 const int *diff_weights, const int *all_diffs);
+
+void anti_dithering_row_neon(uint16_t *row, const uint16_t *next_row, int width);
+
+void mode3_row_neon(uint16_t *dst, const uint16_t *a, const uint16_t *b, const uint16_t *c, int width);
+
+void decimate_row_neon(uint16_t *dst, const uint16_t *src, int width);
+
+void spatial_mask_row_neon(uint16_t *mask_row, const uint16_t *column_sums, int width,
+                           uint16_t window, uint16_t mask_index);
+
+#endif /* ARM64_CAMBI_H_ */
@@ -0,0 +1,251 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <arm_neon.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "feature/integer_motion.h"
+#include "feature/arm64/motion_neon.h"
+
+/* The 5-tap filter sums to 65536, so every accumulator below fits in 32 bits
+ * and the rounding shifts match the C code exactly. */
+
+static inline void mirrored_rows(int i, int height, int rows[5])
+{
+    const int radius = filter_width / 2;
+
+    // MIRROR | ЯOЯЯIM
+    for (int k = 0; k < filter_width; ++k) {
+        int i_tap = i - radius + k;
+        if (i_tap < 0)
+            i_tap = -i_tap;
+        else if (i_tap >= height)
+            i_tap = height - (i_tap - height + 1);
+        rows[k] = i_tap;
+    }
+}
+
+static inline uint32x4_t y_filter_lo(uint16x8_t s0, uint16x8_t s1,
+                                     uint16x8_t s2, uint16x8_t s3,
+                                     uint16x8_t s4)
+{
+    uint32x4_t accum = vmull_n_u16(vget_low_u16(s0), filter[0]);
+    accum = vmlal_n_u16(accum, vget_low_u16(s1), filter[1]);
+    accum = vmlal_n_u16(accum, vget_low_u16(s2), filter[2]);
+    accum = vmlal_n_u16(accum, vget_low_u16(s3), filter[3]);
+    return vmlal_n_u16(accum, vget_low_u16(s4), filter[4]);
+}
+
+static inline uint32x4_t y_filter_hi(uint16x8_t s0, uint16x8_t s1,
+                                     uint16x8_t s2, uint16x8_t s3,
+                                     uint16x8_t s4)
+{
+    uint32x4_t accum = vmull_high_n_u16(s0, filter[0]);
+    accum = vmlal_high_n_u16(accum, s1, filter[1]);
+    accum = vmlal_high_n_u16(accum, s2, filter[2]);
+    accum = vmlal_high_n_u16(accum, s3, filter[3]);
+    return vmlal_high_n_u16(accum, s4, filter[4]);
+}
+
+void y_convolution_8_neon(void *src, uint16_t *dst, unsigned width,
+                          unsigned height, ptrdiff_t src_stride,
+                          ptrdiff_t dst_stride, unsigned inp_size_bits)
+{
+    (void) inp_size_bits;
+    const uint8_t *s = src;
+    const unsigned w8 = width & ~7u;
+
+    for (unsigned i = 0; i < height; i++) {
+        int rows[5];
+        mirrored_rows(i, height, rows);
+        const uint8_t *r0 = s + rows[0] * src_stride;
+        const uint8_t *r1 = s + rows[1] * src_stride;
+        const uint8_t *r2 = s + rows[2] * src_stride;
+        const uint8_t *r3 = s + rows[3] * src_stride;
+        const uint8_t *r4 = s + rows[4] * src_stride;
+        uint16_t *d = dst + i * dst_stride;
+
+        unsigned j = 0;
+        for (; j < w8; j += 8) {
+            const uint16x8_t s0 = vmovl_u8(vld1_u8(r0 + j));
+            const uint16x8_t s1 = vmovl_u8(vld1_u8(r1 + j));
+            const uint16x8_t s2 = vmovl_u8(vld1_u8(r2 + j));
+            const uint16x8_t s3 = vmovl_u8(vld1_u8(r3 + j));
+            const uint16x8_t s4 = vmovl_u8(vld1_u8(r4 + j));
+            const uint32x4_t lo = y_filter_lo(s0, s1, s2, s3, s4);
+            const uint32x4_t hi = y_filter_hi(s0, s1, s2, s3, s4);
+            vst1q_u16(d + j, vcombine_u16(vrshrn_n_u32(lo, 8),
+                                          vrshrn_n_u32(hi, 8)));
+        }
+        for (; j < width; j++) {
+            const uint32_t accum = filter[0] * r0[j] + filter[1] * r1[j] +
+                                   filter[2] * r2[j] + filter[3] * r3[j] +
+                                   filter[4] * r4[j];
+            d[j] = (accum + 128) >> 8;
+        }
+    }
+}
+
+void y_convolution_16_neon(void *src, uint16_t *dst, unsigned width,
+                           unsigned height, ptrdiff_t src_stride,
+                           ptrdiff_t dst_stride, unsigned inp_size_bits)
+{
+    const uint16_t *s = src;
+    const unsigned w8 = width & ~7u;
+    const uint32_t add_before_shift = 1u << (inp_size_bits - 1);
+    const int32x4_t shift = vdupq_n_s32(-(int) inp_size_bits);
+
+    for (unsigned i = 0; i < height; i++) {
+        int rows[5];
+        mirrored_rows(i, height, rows);
+        const uint16_t *r0 = s + rows[0] * src_stride;
+        const uint16_t *r1 = s + rows[1] * src_stride;
+        const uint16_t *r2 = s + rows[2] * src_stride;
+        const uint16_t *r3 = s + rows[3] * src_stride;
+        const uint16_t *r4 = s + rows[4] * src_stride;
+        uint16_t *d = dst + i * dst_stride;
+
+        unsigned j = 0;
+        for (; j < w8; j += 8) {
+            const uint16x8_t s0 = vld1q_u16(r0 + j);
+            const uint16x8_t s1 = vld1q_u16(r1 + j);
+            const uint16x8_t s2 = vld1q_u16(r2 + j);
+            const uint16x8_t s3 = vld1q_u16(r3 + j);
+            const uint16x8_t s4 = vld1q_u16(r4 + j);
+            const uint32x4_t lo =
+                vrshlq_u32(y_filter_lo(s0, s1, s2, s3, s4), shift);
+            const uint32x4_t hi =
+                vrshlq_u32(y_filter_hi(s0, s1, s2, s3, s4), shift);
+            vst1q_u16(d + j, vcombine_u16(vmovn_u32(lo), vmovn_u32(hi)));
+        }
+        for (; j < width; j++) {
+            const uint32_t accum = filter[0] * r0[j] + filter[1] * r1[j] +
+                                   filter[2] * r2[j] + filter[3] * r3[j] +
+                                   filter[4] * r4[j];
+            d[j] = (accum + add_before_shift) >> inp_size_bits;
+        }
+    }
+}
+
+void x_convolution_16_neon(const uint16_t *src, uint16_t *dst, unsigned width,
+                           unsigned height, ptrdiff_t src_stride,
+                           ptrdiff_t dst_stride)
+{
+    const unsigned radius = filter_width / 2;
+    const unsigned left_edge = radius;
+    const unsigned right_edge = width - (filter_width - radius);
+    const unsigned shift_add_round = 32768;
+
+    for (unsigned i = 0; i < height; ++i) {
+        const uint16_t *s = src + i * src_stride;
+        uint16_t *d = dst + i * dst_stride;
+
+        for (unsigned j = 0; j < left_edge; j++) {
+            d[j] = (edge_16(true, src, width, height, src_stride, i, j) +
+                    shift_add_round) >> 16;
+        }
+
+        unsigned j = left_edge;
+        for (; j + 8 <= right_edge; j += 8) {
+            const uint16_t *p = s + j - radius;
+            const uint16x8_t s0 = vld1q_u16(p + 0);
+            const uint16x8_t s1 = vld1q_u16(p + 1);
+            const uint16x8_t s2 = vld1q_u16(p + 2);
+            const uint16x8_t s3 = vld1q_u16(p + 3);
+            const uint16x8_t s4 = vld1q_u16(p + 4);
+            const uint32x4_t lo = y_filter_lo(s0, s1, s2, s3, s4);
+            const uint32x4_t hi = y_filter_hi(s0, s1, s2, s3, s4);
+            vst1q_u16(d + j, vcombine_u16(vrshrn_n_u32(lo, 16),
+                                          vrshrn_n_u32(hi, 16)));
+        }
+        for (; j < right_edge; j++) {
+            const uint16_t *p = s + j - radius;
+            const uint32_t accum = filter[0] * p[0] + filter[1] * p[1] +
+                                   filter[2] * p[2] + filter[3] * p[3] +
+                                   filter[4] * p[4];
+            d[j] = (accum + shift_add_round) >> 16;
+        }
+
+        for (j = right_edge; j < width; j++) {
+            d[j] = (edge_16(true, src, width, height, src_stride, i, j) +
+                    shift_add_round) >> 16;
+        }
+    }
+}
+
+uint64_t sad_16_neon(const uint16_t *a, ptrdiff_t a_stride,
+                     const uint16_t *b, ptrdiff_t b_stride,
+                     unsigned w, unsigned h)
+{
+    const unsigned w8 = w & ~7u;
+    uint64_t sad = 0;
+
+    for (unsigned i = 0; i < h; i++) {
+        uint32x4_t sad_row = vdupq_n_u32(0);
+        unsigned j = 0;
+        for (; j < w8; j += 8)
+            sad_row = vpadalq_u16(sad_row, vabdq_u16(vld1q_u16(a + j),
+                                                     vld1q_u16(b + j)));
+
+        // the row sum wraps like the 32-bit inner sum of the C code
+        uint32_t inner_sad = vaddvq_u32(sad_row);
+        for (; j < w; j++)
+            inner_sad += abs(a[j] - b[j]);
+        sad += inner_sad;
+
+        a += a_stride;
+        b += b_stride;
+    }
+
+    return sad;
+}
+
+void sad_pair_16_neon(const uint16_t *a, const uint16_t *b, const uint16_t *c,
+                      ptrdiff_t stride, unsigned w, unsigned h,
+                      uint64_t *sad_b, uint64_t *sad_c)
+{
+    const unsigned w8 = w & ~7u;
+    *sad_b = 0;
+    *sad_c = 0;
+
+    for (unsigned i = 0; i < h; i++) {
+        uint32x4_t sad_row_b = vdupq_n_u32(0);
+        uint32x4_t sad_row_c = vdupq_n_u32(0);
+        unsigned j = 0;
+        for (; j < w8; j += 8) {
+            const uint16x8_t va = vld1q_u16(a + j);
+            sad_row_b = vpadalq_u16(sad_row_b, vabdq_u16(va, vld1q_u16(b + j)));
+            sad_row_c = vpadalq_u16(sad_row_c, vabdq_u16(va, vld1q_u16(c + j)));
+        }
+
+        uint32_t inner_sad_b = vaddvq_u32(sad_row_b);
+        uint32_t inner_sad_c = vaddvq_u32(sad_row_c);
+        for (; j < w; j++) {
+            inner_sad_b += abs(a[j] - b[j]);
+            inner_sad_c += abs(a[j] - c[j]);
+        }
+        *sad_b += inner_sad_b;
+        *sad_c += inner_sad_c;
+
+        a += stride;
+        b += stride;
+        c += stride;
+    }
+}
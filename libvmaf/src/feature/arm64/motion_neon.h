@@ -0,0 +1,45 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef ARM64_MOTION_H_
+#define ARM64_MOTION_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+void y_convolution_8_neon(void *src, uint16_t *dst, unsigned width,
+                          unsigned height, ptrdiff_t src_stride,
+                          ptrdiff_t dst_stride, unsigned inp_size_bits);
+
+void y_convolution_16_neon(void *src, uint16_t *dst, unsigned width,
+                           unsigned height, ptrdiff_t src_stride,
+                           ptrdiff_t dst_stride, unsigned inp_size_bits);
+
+void x_convolution_16_neon(const uint16_t *src, uint16_t *dst, unsigned width,
+                           unsigned height, ptrdiff_t src_stride,
+                           ptrdiff_t dst_stride);
+
+uint64_t sad_16_neon(const uint16_t *a, ptrdiff_t a_stride,
+                     const uint16_t *b, ptrdiff_t b_stride,
+                     unsigned w, unsigned h);
+
+void sad_pair_16_neon(const uint16_t *a, const uint16_t *b, const uint16_t *c,
+                      ptrdiff_t stride, unsigned w, unsigned h,
+                      uint64_t *sad_b, uint64_t *sad_c);
+
+#endif /* ARM64_MOTION_H_ */
@@ -0,0 +1,78 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <arm_neon.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "feature/arm64/picture_copy_neon.h"
+
+void picture_copy_u8_neon(float *dst, ptrdiff_t dst_stride,
+                          const uint8_t *src, ptrdiff_t src_stride,
+                          unsigned w, unsigned h, float scale, float offset)
+{
+    (void) scale;
+
+    const float32x4_t o = vdupq_n_f32(offset);
+    const unsigned w16 = w & ~15u;
+
+    for (unsigned i = 0; i < h; i++) {
+        unsigned j = 0;
+        for (; j < w16; j += 16) {
+            const uint8x16_t s = vld1q_u8(src + j);
+            const uint16x8_t lo = vmovl_u8(vget_low_u8(s));
+            const uint16x8_t hi = vmovl_u8(vget_high_u8(s));
+            vst1q_f32(dst + j + 0,
+                      vaddq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo))), o));
+            vst1q_f32(dst + j + 4,
+                      vaddq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(lo))), o));
+            vst1q_f32(dst + j + 8,
+                      vaddq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi))), o));
+            vst1q_f32(dst + j + 12,
+                      vaddq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(hi))), o));
+        }
+        for (; j < w; j++)
+            dst[j] = (float) src[j] + offset;
+        dst += dst_stride / sizeof(float);
+        src += src_stride;
+    }
+}
+
+void picture_copy_u16_neon(float *dst, ptrdiff_t dst_stride,
+                           const uint16_t *src, ptrdiff_t src_stride,
+                           unsigned w, unsigned h, float scale, float offset)
+{
+    const float32x4_t o = vdupq_n_f32(offset);
+    const unsigned w8 = w & ~7u;
+
+    for (unsigned i = 0; i < h; i++) {
+        unsigned j = 0;
+        for (; j < w8; j += 8) {
+            const uint16x8_t s = vld1q_u16(src + j);
+            // the product is exact, a fused multiply-add rounds the same way
+            const float32x4_t lo = vcvtq_f32_u32(vmovl_u16(vget_low_u16(s)));
+            const float32x4_t hi = vcvtq_f32_u32(vmovl_u16(vget_high_u16(s)));
+            vst1q_f32(dst + j + 0, vfmaq_n_f32(o, lo, scale));
+            vst1q_f32(dst + j + 4, vfmaq_n_f32(o, hi, scale));
+        }
+        for (; j < w; j++)
+            dst[j] = (float) src[j] * scale + offset;
+        dst += dst_stride / sizeof(float);
+        src += src_stride / 2;
+    }
+}
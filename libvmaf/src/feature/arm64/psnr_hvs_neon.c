@@ -0,0 +1,392 @@
+/*
+Copyright 2001-2012 Xiph.Org and contributors.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+- Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+- Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <arm_neon.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "feature/common/macros.h"
+#include "feature/arm64/psnr_hvs_neon.h"
+
+/*
+ * NEON version of calc_psnrhvs() in third_party/xiph/psnr_hvs.c, organized
+ * like the AVX2 version: the rows of an 8x8 block are split in two halves of
+ * four 32-bit lanes, every per coefficient term is computed with the same
+ * single precision operations as the scalar code, and the terms are summed
+ * in the scalar order, so the result is bit-exact. No fused multiply-add is
+ * used for the same reason.
+ */
+
+#define DCT_RSHIFT1(a) \
+    vshrq_n_s32(vaddq_s32(vreinterpretq_s32_u32( \
+        vshrq_n_u32(vreinterpretq_u32_s32(a), 31)), a), 1)
+
+#define DCT_MUL(a, c, s) \
+    vshrq_n_s32(vaddq_s32(vmulq_n_s32(a, c), vdupq_n_s32(1 << ((s) - 1))), s)
+
+static FORCE_INLINE inline void od_bin_fdct8_neon(int32x4_t x[8])
+{
+    int32x4_t t0 = x[0];
+    int32x4_t t4 = x[1];
+    int32x4_t t2 = x[2];
+    int32x4_t t6 = x[3];
+    int32x4_t t7 = x[4];
+    int32x4_t t3 = x[5];
+    int32x4_t t5 = x[6];
+    int32x4_t t1 = x[7];
+    int32x4_t t1h, t4h, t6h;
+
+    t1 = vsubq_s32(t0, t1);
+    t1h = DCT_RSHIFT1(t1);
+    t0 = vsubq_s32(t0, t1h);
+    t4 = vaddq_s32(t4, t5);
+    t4h = DCT_RSHIFT1(t4);
+    t5 = vsubq_s32(t5, t4h);
+    t3 = vsubq_s32(t2, t3);
+    t2 = vsubq_s32(t2, DCT_RSHIFT1(t3));
+    t6 = vaddq_s32(t6, t7);
+    t6h = DCT_RSHIFT1(t6);
+    t7 = vsubq_s32(t6h, t7);
+    t0 = vaddq_s32(t0, t6h);
+    t6 = vsubq_s32(t0, t6);
+    t2 = vsubq_s32(t4h, t2);
+    t4 = vsubq_s32(t2, t4);
+    t0 = vsubq_s32(t0, DCT_MUL(t4, 13573, 15));
+    t4 = vaddq_s32(t4, DCT_MUL(t0, 11585, 14));
+    t0 = vsubq_s32(t0, DCT_MUL(t4, 13573, 15));
+    t6 = vsubq_s32(t6, DCT_MUL(t2, 21895, 15));
+    t2 = vaddq_s32(t2, DCT_MUL(t6, 15137, 14));
+    t6 = vsubq_s32(t6, DCT_MUL(t2, 21895, 15));
+    t3 = vaddq_s32(t3, DCT_MUL(t5, 19195, 15));
+    t5 = vaddq_s32(t5, DCT_MUL(t3, 11585, 14));
+    t3 = vsubq_s32(t3, DCT_MUL(t5, 7489, 13));
+    t7 = vsubq_s32(DCT_RSHIFT1(t5), t7);
+    t5 = vsubq_s32(t5, t7);
+    t3 = vsubq_s32(t1h, t3);
+    t1 = vsubq_s32(t1, t3);
+    t7 = vaddq_s32(t7, DCT_MUL(t1, 3227, 15));
+    t1 = vsubq_s32(t1, DCT_MUL(t7, 6393, 15));
+    t7 = vaddq_s32(t7, DCT_MUL(t1, 3227, 15));
+    t5 = vaddq_s32(t5, DCT_MUL(t3, 2485, 13));
+    t3 = vsubq_s32(t3, DCT_MUL(t5, 18205, 15));
+    t5 = vaddq_s32(t5, DCT_MUL(t3, 2485, 13));
+
+    x[0] = t0;
+    x[1] = t1;
+    x[2] = t2;
+    x[3] = t3;
+    x[4] = t4;
+    x[5] = t5;
+    x[6] = t6;
+    x[7] = t7;
+}
+
+static inline void transpose_4x4(int32x4_t *r0, int32x4_t *r1,
+                                 int32x4_t *r2, int32x4_t *r3)
+{
+    const int32x4_t t0 = vtrn1q_s32(*r0, *r1);
+    const int32x4_t t1 = vtrn2q_s32(*r0, *r1);
+    const int32x4_t t2 = vtrn1q_s32(*r2, *r3);
+    const int32x4_t t3 = vtrn2q_s32(*r2, *r3);
+    *r0 = vreinterpretq_s32_s64(vtrn1q_s64(vreinterpretq_s64_s32(t0),
+                                           vreinterpretq_s64_s32(t2)));
+    *r1 = vreinterpretq_s32_s64(vtrn1q_s64(vreinterpretq_s64_s32(t1),
+                                           vreinterpretq_s64_s32(t3)));
+    *r2 = vreinterpretq_s32_s64(vtrn2q_s64(vreinterpretq_s64_s32(t0),
+                                           vreinterpretq_s64_s32(t2)));
+    *r3 = vreinterpretq_s32_s64(vtrn2q_s64(vreinterpretq_s64_s32(t1),
+                                           vreinterpretq_s64_s32(t3)));
+}
+
+/*
+ * x[0] holds the left and x[1] the right half of each row. Transposing the
+ * four 4x4 quadrants in place, the top right and bottom left ones swap.
+ */
+static inline void transpose_8x8(int32x4_t x[2][8])
+{
+    for (unsigned h = 0; h < 2; h++) {
+        transpose_4x4(&x[h][0], &x[h][1], &x[h][2], &x[h][3]);
+        transpose_4x4(&x[h][4], &x[h][5], &x[h][6], &x[h][7]);
+    }
+    for (unsigned i = 0; i < 4; i++) {
+        const int32x4_t t = x[1][i];
+        x[1][i] = x[0][i + 4];
+        x[0][i + 4] = t;
+    }
+}
+
+/*
+ * The lanes hold the columns of the block, so each pass transforms all eight
+ * columns, and the block is transposed after each pass like in the scalar
+ * code. Coefficient (i, j) ends up in lane j % 4 of x[j / 4][i].
+ */
+static inline void od_bin_fdct8x8_neon(int32x4_t x[2][8])
+{
+    od_bin_fdct8_neon(x[0]);
+    od_bin_fdct8_neon(x[1]);
+    transpose_8x8(x);
+    od_bin_fdct8_neon(x[0]);
+    od_bin_fdct8_neon(x[1]);
+    transpose_8x8(x);
+}
+
+static inline void load_block(int32x4_t x[2][8], const unsigned char *p,
+                              int stride, int hbd)
+{
+    for (unsigned i = 0; i < 8; i++, p += stride) {
+        const uint16x8_t row = hbd ? vld1q_u16((const uint16_t*) p) :
+                                     vmovl_u8(vld1_u8(p));
+        x[0][i] = vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(row)));
+        x[1][i] = vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(row)));
+    }
+}
+
+/*
+ * Stores the terms of the global and of the quadrant variance sums, with the
+ * means computed as in the scalar code.
+ */
+static inline void block_var_terms(const int32x4_t x[2][8], float *gvar,
+                                   float *vars)
+{
+    int32_t s[4];
+    for (unsigned h = 0; h < 2; h++) {
+        const int32x4_t top = vaddq_s32(vaddq_s32(x[h][0], x[h][1]),
+                                        vaddq_s32(x[h][2], x[h][3]));
+        const int32x4_t bot = vaddq_s32(vaddq_s32(x[h][4], x[h][5]),
+                                        vaddq_s32(x[h][6], x[h][7]));
+        s[2 * h] = vaddvq_s32(top);
+        s[2 * h + 1] = vaddvq_s32(bot);
+    }
+
+    // the integer sums are exact in float, and so are the power of 2 divisions
+    const float gmean = (float) (s[0] + s[1] + s[2] + s[3]) / 64.f;
+    const float means[4] = {
+        (float) s[0] / 16.f, (float) s[1] / 16.f,
+        (float) s[2] / 16.f, (float) s[3] / 16.f,
+    };
+
+    const float32x4_t gm = vdupq_n_f32(gmean);
+    for (unsigned h = 0; h < 2; h++) {
+        for (unsigned i = 0; i < 8; i++) {
+            const float32x4_t v = vcvtq_f32_s32(x[h][i]);
+            const float32x4_t g = vsubq_f32(v, gm);
+            const float32x4_t d =
+                vsubq_f32(v, vdupq_n_f32(means[2 * h + (i >= 4)]));
+            vst1q_f32(gvar + 8 * i + 4 * h, vmulq_f32(g, g));
+            vst1q_f32(vars + 8 * i + 4 * h, vmulq_f32(d, d));
+        }
+    }
+}
+
+/*
+ * Sums the variance terms of each quadrant in the scalar order, with one
+ * register accumulator per quadrant.
+ */
+static inline void quadrant_sums(const float *terms, float vars[4])
+{
+    float v0 = 0, v1 = 0, v2 = 0, v3 = 0;
+    for (unsigned i = 0; i < 4; i++) {
+        for (unsigned j = 0; j < 4; j++) {
+            v0 += terms[8 * i + j];
+            v2 += terms[8 * i + j + 4];
+        }
+    }
+    for (unsigned i = 4; i < 8; i++) {
+        for (unsigned j = 0; j < 4; j++) {
+            v1 += terms[8 * i + j];
+            v3 += terms[8 * i + j + 4];
+        }
+    }
+    vars[0] = v0;
+    vars[1] = v1;
+    vars[2] = v2;
+    vars[3] = v3;
+}
+
+static inline void block_mask_terms(const int32x4_t x[2][8],
+                                    const float *mask, float *terms)
+{
+    for (unsigned h = 0; h < 2; h++) {
+        for (unsigned i = 0; i < 8; i++) {
+            const float32x4_t sq =
+                vcvtq_f32_s32(vmulq_s32(x[h][i], x[h][i]));
+            vst1q_f32(terms + 8 * i + 4 * h,
+                      vmulq_f32(sq, vld1q_f32(mask + 8 * i + 4 * h)));
+        }
+    }
+    // the DC coefficient does not contribute to the masking
+    terms[0] = 0.f;
+}
+
+static inline void block_err_terms(const int32x4_t s[2][8],
+                                   const int32x4_t d[2][8], float s_mask,
+                                   const float *mask, const float *csf,
+                                   float *terms)
+{
+    const float32x4_t m = vdupq_n_f32(s_mask);
+    for (unsigned h = 0; h < 2; h++) {
+        for (unsigned i = 0; i < 8; i++) {
+            const float32x4_t err = vcvtq_f32_s32(vabdq_s32(s[h][i], d[h][i]));
+            const float32x4_t thr =
+                vdivq_f32(m, vld1q_f32(mask + 8 * i + 4 * h));
+            float32x4_t e = vreinterpretq_f32_u32(
+                vbicq_u32(vreinterpretq_u32_f32(vsubq_f32(err, thr)),
+                          vcltq_f32(err, thr)));
+            // the DC coefficient is not masked
+            if (!h && !i)
+                e = vsetq_lane_f32(vgetq_lane_f32(err, 0), e, 0);
+            const float32x4_t t =
+                vmulq_f32(e, vld1q_f32(csf + 8 * i + 4 * h));
+            vst1q_f32(terms + 8 * i + 4 * h, vmulq_f32(t, t));
+        }
+    }
+}
+
+typedef struct PsnrHvsBlock {
+    int32x4_t dct[2][8];
+    float gvar_terms[8 * 8];
+    float vars_terms[8 * 8];
+    float mask_terms[8 * 8];
+} PsnrHvsBlock;
+
+static inline void block_terms(PsnrHvsBlock *b, const unsigned char *p,
+                               int stride, int hbd, const float *mask)
+{
+    load_block(b->dct, p, stride, hbd);
+    block_var_terms(b->dct, b->gvar_terms, b->vars_terms);
+    od_bin_fdct8x8_neon(b->dct);
+    block_mask_terms(b->dct, mask, b->mask_terms);
+}
+
+/*
+ * The part of the scalar code which follows the sums, giving the masking
+ * level of one block of one picture.
+ */
+static inline float block_mask(float gvar, float vars[4], float mask)
+{
+    int i;
+    gvar *= 1 / 63.f * 64;
+    for (i = 0; i < 4; i++)
+        vars[i] *= 1 / 15.f * 16;
+    if (gvar > 0)
+        gvar = (vars[0] + vars[1] + vars[2] + vars[3]) / gvar;
+    return sqrt(mask * gvar) / 32.f;
+}
+
+double calc_psnrhvs_neon(const unsigned char *_src, int _systride,
+                         const unsigned char *_dst, int _dystride,
+                         double _par, int depth, int _w, int _h, int _step,
+                         float _csf[8][8])
+{
+    float ret;
+    float mask[8][8];
+    float err_terms[2 * 8 * 8] = { 0 };
+    int pixels;
+    int x;
+    int y;
+    int32_t samplemax;
+    const int hbd = depth > 8;
+    (void)_par;
+    ret = pixels = 0;
+
+    for (x = 0; x < 8; x++)
+        for (y = 0; y < 8; y++)
+            mask[x][y] = (_csf[x][y] * 0.3885746225901003) *
+                         (_csf[x][y] * 0.3885746225901003);
+
+    /*
+     Blocks are processed in pairs, so that the sums of both, which are long
+     chains of dependent additions, run side by side. An odd block at the end
+     of a row is paired with itself, and its copy is not counted.
+    */
+    for (y = 0; y < _h - 7; y += _step) {
+        for (x = 0; x < _w - 7; x += 2 * _step) {
+            const int x1 = x + _step < _w - 7 ? x + _step : x;
+            const unsigned char *src = _src + y * _systride;
+            const unsigned char *dst = _dst + y * _dystride;
+            PsnrHvsBlock b[4];
+            float gvar0 = 0, gvar1 = 0, gvar2 = 0, gvar3 = 0;
+            float mask0 = 0, mask1 = 0, mask2 = 0, mask3 = 0;
+            float vars[4][4];
+            float s_mask;
+            float d_mask;
+            int i;
+
+            block_terms(&b[0], src + (x << hbd), _systride, hbd, mask[0]);
+            block_terms(&b[1], dst + (x << hbd), _dystride, hbd, mask[0]);
+            block_terms(&b[2], src + (x1 << hbd), _systride, hbd, mask[0]);
+            block_terms(&b[3], dst + (x1 << hbd), _dystride, hbd, mask[0]);
+
+            /*
+             The error terms of the previous pair are summed here, which keeps
+             the order of the additions to ret but hides their latency. Before
+             the first pair they are all zero.
+            */
+            for (i = 0; i < 64; i++) {
+                gvar0 += b[0].gvar_terms[i];
+                gvar1 += b[1].gvar_terms[i];
+                gvar2 += b[2].gvar_terms[i];
+                gvar3 += b[3].gvar_terms[i];
+                mask0 += b[0].mask_terms[i];
+                mask1 += b[1].mask_terms[i];
+                mask2 += b[2].mask_terms[i];
+                mask3 += b[3].mask_terms[i];
+                ret += err_terms[2 * i];
+                ret += err_terms[2 * i + 1];
+            }
+            for (i = 0; i < 4; i++)
+                quadrant_sums(b[i].vars_terms, vars[i]);
+
+            s_mask = block_mask(gvar0, vars[0], mask0);
+            d_mask = block_mask(gvar1, vars[1], mask1);
+            if (d_mask > s_mask)
+                s_mask = d_mask;
+            block_err_terms(b[0].dct, b[1].dct, s_mask, mask[0], _csf[0],
+                            err_terms);
+            pixels += 64;
+
+            if (x1 == x) {
+                memset(err_terms + 64, 0, 64 * sizeof(*err_terms));
+                continue;
+            }
+            s_mask = block_mask(gvar2, vars[2], mask2);
+            d_mask = block_mask(gvar3, vars[3], mask3);
+            if (d_mask > s_mask)
+                s_mask = d_mask;
+            block_err_terms(b[2].dct, b[3].dct, s_mask, mask[0], _csf[0],
+                            err_terms + 64);
+            pixels += 64;
+        }
+    }
+    for (x = 0; x < 2 * 64; x++)
+        ret += err_terms[x];
+    ret /= pixels;
+    samplemax = (1 << depth) - 1;
+    ret /= samplemax * samplemax;
+    return ret;
+}
@@ -0,0 +1,27 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef ARM64_PSNR_HVS_H_
+#define ARM64_PSNR_HVS_H_
+
+double calc_psnrhvs_neon(const unsigned char *_src, int _systride,
+                         const unsigned char *_dst, int _dystride,
+                         double _par, int depth, int _w, int _h, int _step,
+                         float _csf[8][8]);
+
+#endif /* ARM64_PSNR_HVS_H_ */
@@ -0,0 +1,86 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <arm_neon.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "feature/arm64/psnr_neon.h"
+
+uint64_t psnr_sse_8_neon(const uint8_t *ref, ptrdiff_t ref_stride,
+                         const uint8_t *dis, ptrdiff_t dis_stride,
+                         unsigned w, unsigned h)
+{
+    const unsigned w16 = w & ~15u;
+    uint64x2_t sse = vdupq_n_u64(0);
+    uint64_t sse_tail = 0;
+
+    for (unsigned i = 0; i < h; i++) {
+        // each 32-bit lane takes at most 4 * 255^2 per iteration
+        uint32x4_t sse_row = vdupq_n_u32(0);
+        unsigned j = 0;
+        for (; j < w16; j += 16) {
+            const uint8x16_t e = vabdq_u8(vld1q_u8(ref + j), vld1q_u8(dis + j));
+            const uint8x8_t e_lo = vget_low_u8(e);
+            sse_row = vpadalq_u16(sse_row, vmull_u8(e_lo, e_lo));
+            sse_row = vpadalq_u16(sse_row, vmull_high_u8(e, e));
+        }
+        sse = vpadalq_u32(sse, sse_row);
+
+        uint32_t sse_inner = 0;
+        for (; j < w; j++) {
+            const int16_t e = ref[j] - dis[j];
+            sse_inner += e * e;
+        }
+        sse_tail += sse_inner;
+
+        ref += ref_stride;
+        dis += dis_stride;
+    }
+
+    return vaddvq_u64(sse) + sse_tail;
+}
+
+uint64_t psnr_sse_16_neon(const uint16_t *ref, ptrdiff_t ref_stride,
+                          const uint16_t *dis, ptrdiff_t dis_stride,
+                          unsigned w, unsigned h)
+{
+    const unsigned w8 = w & ~7u;
+    uint64x2_t sse = vdupq_n_u64(0);
+    uint64_t sse_tail = 0;
+
+    for (unsigned i = 0; i < h; i++) {
+        unsigned j = 0;
+        for (; j < w8; j += 8) {
+            const uint16x8_t e = vabdq_u16(vld1q_u16(ref + j), vld1q_u16(dis + j));
+            const uint16x4_t e_lo = vget_low_u16(e);
+            sse = vpadalq_u32(sse, vmull_u16(e_lo, e_lo));
+            sse = vpadalq_u32(sse, vmull_high_u16(e, e));
+        }
+        for (; j < w; j++) {
+            const uint32_t e = abs(ref[j] - dis[j]);
+            sse_tail += e * e;
+        }
+
+        ref += ref_stride / sizeof(*ref);
+        dis += dis_stride / sizeof(*dis);
+    }
+
+    return vaddvq_u64(sse) + sse_tail;
+}
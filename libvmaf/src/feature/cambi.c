@@ -32,6 +32,11 @@
 
 #if ARCH_X86
 #include "x86/cambi_avx2.h"
+#if HAVE_AVX512
+#include "x86/cambi_avx512.h"
+#endif
+#elif ARCH_AARCH64
+#include "arm64/cambi_neon.h"
 #endif
 
 /* Ratio of pixels for computation, must be 0 < topk <= 1.0 */
@@ -78,7 +83,7 @@ static const int g_contrast_weights[32] = {1, 2, 3, 4, 4, 5, 5, 6, 6, 6, 6, 7, 7
 
 typedef struct CambiBuffers {
     float *c_values;
-    uint32_t *mask_dp;
+    uint16_t *mask_column_sums;
     uint16_t *c_values_histograms;
     uint16_t *filter_mode_buffer;
     uint16_t *diffs_to_consider;
@@ -90,6 +95,15 @@ typedef struct CambiBuffers {
 
 typedef void (*VmafRangeUpdater)(uint16_t *arr, int left, int right);
 typedef void (*VmafDerivativeCalculator)(const uint16_t *image_data, uint16_t *derivative_buffer, int width, int height, int row, int stride);
+typedef void (*VmafCValuesRowCalculator)(float *c_values, const uint16_t *histograms, const uint16_t *image,
+                                         const uint16_t *mask, int row, int width, ptrdiff_t stride,
+                                         const uint16_t num_diffs, const uint16_t *tvi_for_diff,
+                                         const int *diff_weights, const int *all_diffs);
+typedef void (*VmafAntiDitheringRowFilter)(uint16_t *row, const uint16_t *next_row, int width);
+typedef void (*VmafModeRowFilter)(uint16_t *dst, const uint16_t *a, const uint16_t *b, const uint16_t *c, int width);
+typedef void (*VmafRowDecimator)(uint16_t *dst, const uint16_t *src, int width);
+typedef void (*VmafSpatialMaskRowCalculator)(uint16_t *mask_row, const uint16_t *column_sums, int width,
+                                             uint16_t window, uint16_t mask_index);
 
 typedef struct CambiState {
     VmafPicture pics[PICS_BUFFER_SIZE];
@@ -110,6 +124,11 @@ typedef struct CambiState {
     VmafRangeUpdater inc_range_callback;
     VmafRangeUpdater dec_range_callback;
     VmafDerivativeCalculator derivative_callback;
+    VmafCValuesRowCalculator c_values_row_callback;
+    VmafAntiDitheringRowFilter anti_dithering_callback;
+    VmafModeRowFilter mode_row_callback;
+    VmafRowDecimator decimate_row_callback;
+    VmafSpatialMaskRowCalculator spatial_mask_row_callback;
     CambiBuffers buffers;
 } CambiState;
 
@@ -333,6 +352,59 @@ static void get_derivative_data_for_row(const uint16_t *image_data, uint16_t *de
     }
 }
 
+static void calculate_c_values_row(float *c_values, const uint16_t *histograms, const uint16_t *image,
+                                   const uint16_t *mask, int row, int width, ptrdiff_t stride,
+                                   const uint16_t num_diffs, const uint16_t *tvi_for_diff,
+                                   const int *diff_weights, const int *all_diffs);
+static void anti_dithering_row(uint16_t *row, const uint16_t *next_row, int width);
+static void mode3_row(uint16_t *dst, const uint16_t *a, const uint16_t *b, const uint16_t *c, int width);
+static void decimate_row(uint16_t *dst, const uint16_t *src, int width);
+static void spatial_mask_row(uint16_t *mask_row, const uint16_t *column_sums, int width,
+                             uint16_t window, uint16_t mask_index);
+
+static void init_callbacks(CambiState *s) {
+    s->inc_range_callback = increment_range;
+    s->dec_range_callback = decrement_range;
+    s->derivative_callback = get_derivative_data_for_row;
+    s->c_values_row_callback = calculate_c_values_row;
+    s->anti_dithering_callback = anti_dithering_row;
+    s->mode_row_callback = mode3_row;
+    s->decimate_row_callback = decimate_row;
+    s->spatial_mask_row_callback = spatial_mask_row;
+
+#if ARCH_X86
+    unsigned flags = vmaf_get_cpu_flags();
+    if (flags & VMAF_X86_CPU_FLAG_AVX2) {
+        s->inc_range_callback = cambi_increment_range_avx2;
+        s->dec_range_callback = cambi_decrement_range_avx2;
+        s->derivative_callback = get_derivative_data_for_row_avx2;
+        s->anti_dithering_callback = anti_dithering_row_avx2;
+        s->mode_row_callback = mode3_row_avx2;
+        s->decimate_row_callback = decimate_row_avx2;
+        s->spatial_mask_row_callback = spatial_mask_row_avx2;
+    }
+#if HAVE_AVX512
+    if (flags & VMAF_X86_CPU_FLAG_AVX512) {
+        s->inc_range_callback = cambi_increment_range_avx512;
+        s->dec_range_callback = cambi_decrement_range_avx512;
+        s->c_values_row_callback = calculate_c_values_row_avx512;
+    }
+#endif
+#elif ARCH_AARCH64
+    unsigned flags = vmaf_get_cpu_flags();
+    if (flags & VMAF_ARM_CPU_FLAG_NEON) {
+        s->inc_range_callback = cambi_increment_range_neon;
+        s->dec_range_callback = cambi_decrement_range_neon;
+        s->derivative_callback = get_derivative_data_for_row_neon;
+        s->c_values_row_callback = calculate_c_values_row_neon;
+        s->anti_dithering_callback = anti_dithering_row_neon;
+        s->mode_row_callback = mode3_row_neon;
+        s->decimate_row_callback = decimate_row_neon;
+        s->spatial_mask_row_callback = spatial_mask_row_neon;
+    }
+#endif
+}
+
 #ifdef _WIN32
     #define PATH_SEPARATOR '\\'
 #else
@@ -405,15 +477,13 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
     if (!s->buffers.c_values) return -ENOMEM;
 
     const uint16_t num_bins = 1024 + (s->buffers.all_diffs[2 * num_diffs] - s->buffers.all_diffs[0]);
-    s->buffers.c_values_histograms = aligned_malloc(ALIGN_CEIL(alloc_w * num_bins * sizeof(uint16_t)), 32);
+    // one spare entry past the last bin for the 32-bit gathers of the SIMD c-value kernels
+    s->buffers.c_values_histograms = aligned_malloc(ALIGN_CEIL((alloc_w * num_bins + 1) * sizeof(uint16_t)), 32);
     if (!s->buffers.c_values_histograms) return -ENOMEM;
 
     int pad_size = MASK_FILTER_SIZE >> 1;
-    int dp_width = alloc_w + 2 * pad_size + 1;
-    int dp_height = 2 * pad_size + 2;
-
-    s->buffers.mask_dp = aligned_malloc(ALIGN_CEIL(dp_height * dp_width * sizeof(uint32_t)), 32);
-    if (!s->buffers.mask_dp) return -ENOMEM;
+    s->buffers.mask_column_sums = aligned_malloc(ALIGN_CEIL((alloc_w + 2 * pad_size) * sizeof(uint16_t)), 32);
+    if (!s->buffers.mask_column_sums) return -ENOMEM;
     s->buffers.filter_mode_buffer = aligned_malloc(ALIGN_CEIL(3 * alloc_w * sizeof(uint16_t)), 32);
     if (!s->buffers.filter_mode_buffer) return -ENOMEM;
     s->buffers.derivative_buffer = aligned_malloc(ALIGN_CEIL(alloc_w * sizeof(uint16_t)), 32);
@@ -439,26 +509,47 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
         }
     }
 
-    s->inc_range_callback = increment_range;
-    s->dec_range_callback = decrement_range;
-    s->derivative_callback = get_derivative_data_for_row;
-
-#if ARCH_X86
-    unsigned flags = vmaf_get_cpu_flags();
-    if (flags & VMAF_X86_CPU_FLAG_AVX2) {
-        s->inc_range_callback = cambi_increment_range_avx2;
-        s->dec_range_callback = cambi_decrement_range_avx2;
-        s->derivative_callback = get_derivative_data_for_row_avx2;
-    }
-#endif
+    init_callbacks(s);
 
     return err;
 }
 
 /* Preprocessing functions */
 
+static void anti_dithering_row(uint16_t *row, const uint16_t *next_row, int width) {
+    for (int j = 0; j < width - 1; j++) {
+        row[j] = (row[j] + row[j + 1] + next_row[j] + next_row[j + 1]) >> 2;
+    }
+
+    // Last column
+    row[width - 1] = (row[width - 1] + next_row[width - 1]) >> 1;
+}
+
+/*
+* Runs the anti-dithering filter on output row i - 1 as soon as row i has been converted,
+* so that conversion and filtering happen in one pass while both rows are still in cache.
+* A NULL anti_dithering_callback disables the filter.
+*/
+static FORCE_INLINE inline void anti_dither_converted_row(uint16_t *out_data, ptrdiff_t out_stride,
+                                                          unsigned i, unsigned out_w, unsigned out_h,
+                                                          VmafAntiDitheringRowFilter anti_dithering_callback) {
+    if (!anti_dithering_callback) return;
+    if (i > 0) {
+        anti_dithering_callback(&out_data[(i - 1) * out_stride], &out_data[i * out_stride], out_w);
+    }
+
+    if (i == out_h - 1) {
+        // Last row
+        uint16_t *row = &out_data[i * out_stride];
+        for (unsigned j = 0; j + 1 < out_w; j++) {
+            row[j] = (row[j] + row[j + 1]) >> 1;
+        }
+    }
+}
+
 // For bitdepths <= 8.
-static void decimate_generic_uint8_and_convert_to_10b(const VmafPicture *pic, VmafPicture *out_pic, unsigned out_w, unsigned out_h) {
+static void decimate_generic_uint8_and_convert_to_10b(const VmafPicture *pic, VmafPicture *out_pic, unsigned out_w, unsigned out_h,
+                                                      VmafAntiDitheringRowFilter anti_dithering_callback) {
     uint8_t *data = pic->data[0];
     uint16_t *out_data = out_pic->data[0];
     ptrdiff_t stride = pic->stride[0];
@@ -474,6 +565,7 @@ static void decimate_generic_uint8_and_convert_to_10b(const VmafPicture *pic, Vm
             for (unsigned j = 0; j < out_w; j++) {
                 out_data[i * out_stride + j] = data[i * stride + j] << shift_factor;
             }
+            anti_dither_converted_row(out_data, out_stride, i, out_w, out_h, anti_dithering_callback);
         }
         return;
     }
@@ -493,12 +585,14 @@ static void decimate_generic_uint8_and_convert_to_10b(const VmafPicture *pic, Vm
             out_data[i * out_stride + j] = data[ori_y * stride + ori_x] << shift_factor;
             x += ratio_x;
         }
+        anti_dither_converted_row(out_data, out_stride, i, out_w, out_h, anti_dithering_callback);
         y += ratio_y;
     }
 }
 
 // For the special case of bitdepth 9, which doesn't fit into uint8_t but has to be upscaled to 10b.
-static void decimate_generic_9b_and_convert_to_10b(const VmafPicture *pic, VmafPicture *out_pic, unsigned out_w, unsigned out_h) {
+static void decimate_generic_9b_and_convert_to_10b(const VmafPicture *pic, VmafPicture *out_pic, unsigned out_w, unsigned out_h,
+                                                   VmafAntiDitheringRowFilter anti_dithering_callback) {
     uint16_t *data = pic->data[0];
     uint16_t *out_data = out_pic->data[0];
     ptrdiff_t stride = pic->stride[0] >> 1;
@@ -512,6 +606,7 @@ static void decimate_generic_9b_and_convert_to_10b(const VmafPicture *pic, VmafP
             for (unsigned j = 0; j < out_w; j++) {
                 out_data[i * out_stride + j] = data[i * stride + j] << 1;
             }
+            anti_dither_converted_row(out_data, out_stride, i, out_w, out_h, anti_dithering_callback);
         }
         return;
     }
@@ -531,12 +626,14 @@ static void decimate_generic_9b_and_convert_to_10b(const VmafPicture *pic, VmafP
             out_data[i * out_stride + j] = data[ori_y * stride + ori_x] << 1;
             x += ratio_x;
         }
+        anti_dither_converted_row(out_data, out_stride, i, out_w, out_h, anti_dithering_callback);
         y += ratio_y;
     }
 }
 
 // For bitdepths >= 10.
-static void decimate_generic_uint16_and_convert_to_10b(const VmafPicture *pic, VmafPicture *out_pic, unsigned out_w, unsigned out_h) {
+static void decimate_generic_uint16_and_convert_to_10b(const VmafPicture *pic, VmafPicture *out_pic, unsigned out_w, unsigned out_h,
+                                                       VmafAntiDitheringRowFilter anti_dithering_callback) {
     uint16_t *data = pic->data[0];
     uint16_t *out_data = out_pic->data[0];
     ptrdiff_t stride = pic->stride[0] >> 1;
@@ -549,16 +646,17 @@ static void decimate_generic_uint16_and_convert_to_10b(const VmafPicture *pic, V
 
     // if the input and output sizes are the same
     if (in_w == out_w && in_h == out_h) {
-        if (pic->bpc == 10) {
-            // memcpy is faster in case the original bitdepth is already 10
-            memcpy(out_data, data, stride * pic->h[0] * sizeof(uint16_t));
-        }
-        else {
-            for (unsigned i = 0; i < out_h; i++) {
+        for (unsigned i = 0; i < out_h; i++) {
+            if (pic->bpc == 10) {
+                // memcpy is faster in case the original bitdepth is already 10
+                memcpy(&out_data[i * out_stride], &data[i * stride], out_w * sizeof(uint16_t));
+            }
+            else {
                 for (unsigned j = 0; j < out_w; j++) {
                     out_data[i * out_stride + j] = (data[i * stride + j] + rounding_offset) >> shift_factor;
                 }
             }
+            anti_dither_converted_row(out_data, out_stride, i, out_w, out_h, anti_dithering_callback);
         }
         return;
     }
@@ -578,36 +676,11 @@ static void decimate_generic_uint16_and_convert_to_10b(const VmafPicture *pic, V
             out_data[i * out_stride + j] = (data[ori_y * stride + ori_x] + rounding_offset) >> shift_factor;
             x += ratio_x;
         }
+        anti_dither_converted_row(out_data, out_stride, i, out_w, out_h, anti_dithering_callback);
         y += ratio_y;
     }
 }
 
-static void anti_dithering_filter(VmafPicture *pic, unsigned width, unsigned height) {
-    uint16_t *data = pic->data[0];
-    int stride = pic->stride[0] >> 1;
-
-    for (unsigned i = 0; i < height - 1; i++) {
-        for (unsigned j = 0; j < width - 1; j++) {
-            data[i * stride + j] = (data[i * stride + j] +
-                                    data[i * stride + j + 1] +
-                                    data[(i + 1) * stride + j] +
-                                    data[(i + 1) * stride + j + 1]) >> 2;
-        }
-
-        // Last column
-        unsigned j = width - 1;
-        data[i * stride + j] = (data[i * stride + j] +
-                                data[(i + 1) * stride + j]) >> 1;
-    }
-
-    // Last row
-    unsigned i = height - 1;
-    for (unsigned j = 0; j < width - 1; j++) {
-        data[i * stride + j] = (data[i * stride + j] +
-                                data[i * stride + j + 1]) >> 1;
-    }
-}
-
 static int validate_image_lbd(const VmafPicture *pic) {
     int bpc = pic->bpc;
     if (bpc == 8) return 0;
@@ -660,36 +733,41 @@ static int validate_image(const VmafPicture *pic) {
     }
 }
 
-static int cambi_preprocessing(const VmafPicture *image, VmafPicture *preprocessed, int width, int height, int enc_bitdepth) {
+static int cambi_preprocessing(const VmafPicture *image, VmafPicture *preprocessed, int width, int height, int enc_bitdepth,
+                               VmafAntiDitheringRowFilter anti_dithering_callback) {
     if (validate_image(image)) {
         return -EINVAL;
     }
+    if (enc_bitdepth >= 10) {
+        anti_dithering_callback = NULL;
+    }
     if (image->bpc >= 10) {
-        decimate_generic_uint16_and_convert_to_10b(image, preprocessed, width, height);
+        decimate_generic_uint16_and_convert_to_10b(image, preprocessed, width, height, anti_dithering_callback);
     }
     else {
         if (image->bpc <= 8) {
-            decimate_generic_uint8_and_convert_to_10b(image, preprocessed, width, height);
+            decimate_generic_uint8_and_convert_to_10b(image, preprocessed, width, height, anti_dithering_callback);
         }
         else {
-            decimate_generic_9b_and_convert_to_10b(image, preprocessed, width, height);
+            decimate_generic_9b_and_convert_to_10b(image, preprocessed, width, height, anti_dithering_callback);
         }
     }
-    if (enc_bitdepth < 10) {
-        anti_dithering_filter(preprocessed, width, height);
-    }
 
     return 0;
 }
 
 /* Banding detection functions */
-static void decimate(VmafPicture *image, unsigned width, unsigned height) {
+static void decimate_row(uint16_t *dst, const uint16_t *src, int width) {
+    for (int j = 0; j < width; j++) {
+        dst[j] = src[j << 1];
+    }
+}
+
+static void decimate(VmafPicture *image, unsigned width, unsigned height, VmafRowDecimator decimate_row_callback) {
     uint16_t *data = image->data[0];
     ptrdiff_t stride = image->stride[0] >> 1;
     for (unsigned i = 0; i < height; i++) {
-        for (unsigned j = 0; j < width; j++) {
-            data[i * stride + j] = data[(i << 1) * stride + (j << 1)];
-        }
+        decimate_row_callback(&data[i * stride], &data[(i << 1) * stride], width);
     }
 }
 
@@ -705,21 +783,26 @@ static inline uint16_t mode3(uint16_t a, uint16_t b, uint16_t c) {
     return min3(a, b, c);
 }
 
-static void filter_mode(const VmafPicture *image, int width, int height, uint16_t *buffer) {
+static void mode3_row(uint16_t *dst, const uint16_t *a, const uint16_t *b, const uint16_t *c, int width) {
+    for (int j = 0; j < width; j++) {
+        dst[j] = mode3(a[j], b[j], c[j]);
+    }
+}
+
+static void filter_mode(const VmafPicture *image, int width, int height, uint16_t *buffer,
+                        VmafModeRowFilter mode_row_callback) {
     uint16_t *data = image->data[0];
     ptrdiff_t stride = image->stride[0] >> 1;
     int curr_line = 0;
     for (int i = 0; i < height; i++) {
-        buffer[curr_line * width + 0] = data[i * stride + 0];
-        for (int j = 1; j < width - 1; j++) {
-            buffer[curr_line * width + j] = mode3(data[i * stride + j - 1], data[i * stride + j], data[i * stride + j + 1]);
-        }
-        buffer[curr_line * width + width - 1] = data[i * stride + width - 1];
+        const uint16_t *row = &data[i * stride];
+        uint16_t *line = &buffer[curr_line * width];
+        line[0] = row[0];
+        mode_row_callback(&line[1], &row[0], &row[1], &row[2], width - 2);
+        line[width - 1] = row[width - 1];
 
         if (i > 1) {
-            for (int j = 0; j < width; j++) {
-                data[(i - 1) * stride + j] = mode3(buffer[0 * width + j], buffer[1 * width + j], buffer[2 * width + j]);
-            }
+            mode_row_callback(&data[(i - 1) * stride], &buffer[0 * width], &buffer[1 * width], &buffer[2 * width], width);
         }
         curr_line = (curr_line + 1 == 3 ? 0 : curr_line + 1);
     }
@@ -744,89 +827,74 @@ static FORCE_INLINE inline uint16_t get_mask_index(unsigned input_width, unsigne
     return (filter_size * filter_size + 3 * (ceil_log2(shifted_wh) - 11) - 1)>>1;
 }
 
+static void spatial_mask_row(uint16_t *mask_row, const uint16_t *column_sums, int width,
+                             uint16_t window, uint16_t mask_index) {
+    unsigned sum = 0;
+    for (int k = 0; k < window - 1; k++) {
+        sum += column_sums[k];
+    }
+    for (int j = 0; j < width; j++) {
+        sum += column_sums[j + window - 1];
+        mask_row[j] = (sum > mask_index);
+        sum -= column_sums[j];
+    }
+}
+
 /*
 * This function calculates the horizontal and vertical derivatives of the image using 2x1 and 1x2 kernels.
 * We say a pixel has zero_derivative=1 if it's equal to its right and bottom neighbours, and =0 otherwise (edges also count as "equal").
 * This function then computes the sum of zero_derivative on the filter_size x filter_size square around each pixel
 * and stores 1 into the corresponding mask index iff this number is larger than mask_index.
-* To calculate the square sums, it uses a dynamic programming algorithm based on inclusion-exclusion.
-* To save memory, it uses a DP matrix of only the necessary size, rather than the full matrix, and indexes its rows cyclically.
+* To calculate the square sums, it keeps the sum of zero_derivative over the rows of the current square for each column,
+* adding the row that enters the square and subtracting the one that leaves it as the square moves down.
+* The square sums are then sliding sums of these column sums along the row.
+* column_sums holds width + 2 * pad_size entries; the pad_size entries on each side stay zero.
 */
 static void get_spatial_mask_for_index(const VmafPicture *image, VmafPicture *mask,
-                                       uint32_t *dp, uint16_t *derivative_buffer, uint16_t mask_index,
-                                       uint16_t filter_size, int width, int height, VmafDerivativeCalculator derivative_callback) {
+                                       uint16_t *column_sums, uint16_t *derivative_buffer, uint16_t mask_index,
+                                       uint16_t filter_size, int width, int height,
+                                       VmafDerivativeCalculator derivative_callback,
+                                       VmafSpatialMaskRowCalculator spatial_mask_row_callback) {
     uint16_t pad_size = filter_size >> 1;
     uint16_t *image_data = image->data[0];
     uint16_t *mask_data = mask->data[0];
     ptrdiff_t stride = image->stride[0] >> 1;
+    uint16_t *sums = &column_sums[pad_size];
 
-    int dp_width = width + 2 * pad_size + 1;
-    int dp_height = 2 * pad_size + 2;
-    memset(dp, 0, dp_width * dp_height * sizeof(uint32_t));
+    memset(column_sums, 0, (width + 2 * pad_size) * sizeof(uint16_t));
 
-    // Initial computation: fill dp except for the last row
-    for (int i = 0; i < pad_size; i++) {
-        if (i < height) {
-            derivative_callback(image_data, derivative_buffer, width, height, i, stride);
-        }
-        for (int j = 0; j < width + pad_size; j++) {
-            int value = (i < height && j < width ? derivative_buffer[j] : 0);
-            int curr_row = i + pad_size + 1;
-            int curr_col = j + pad_size + 1;
-            dp[curr_row * dp_width + curr_col] =
-                value
-                + dp[(curr_row - 1) * dp_width + curr_col]
-                + dp[curr_row * dp_width + curr_col - 1]
-                - dp[(curr_row - 1) * dp_width + curr_col - 1];
+    // Initial computation: the rows above the bottom row of the first square
+    for (int i = 0; i < pad_size && i < height; i++) {
+        derivative_callback(image_data, derivative_buffer, width, height, i, stride);
+        for (int j = 0; j < width; j++) {
+            sums[j] += derivative_buffer[j];
         }
     }
 
-    // Start from the last row in the dp matrix
-    int prev_row = dp_height - 2;
-    int curr_row = dp_height - 1;
-    int curr_compute = pad_size + 1;
-    int bottom = (curr_compute + pad_size) % dp_height;
-    int top = (curr_compute + dp_height - pad_size - 1) % dp_height;
-    for (int i = pad_size; i < height + pad_size; i++) {
-        if (i < height) {
-            derivative_callback(image_data, derivative_buffer, width, height, i, stride);
-        }
-        // First compute the values of dp for curr_row
-        for (int j = 0; j < width + pad_size; j++) {
-            int value = (i < height && j < width ? derivative_buffer[j] : 0);
-            int curr_col = j + pad_size + 1;
-            dp[curr_row * dp_width + curr_col] =
-                value
-                + dp[prev_row * dp_width + curr_col]
-                + dp[curr_row * dp_width + curr_col - 1]
-                - dp[prev_row * dp_width + curr_col - 1];
+    for (int i = 0; i < height; i++) {
+        if (i + pad_size < height) {
+            derivative_callback(image_data, derivative_buffer, width, height, i + pad_size, stride);
+            for (int j = 0; j < width; j++) {
+                sums[j] += derivative_buffer[j];
+            }
         }
-        prev_row = curr_row;
-        curr_row = (curr_row + 1 == dp_height ? 0 : curr_row + 1);
-
-        // Then use the values to compute the square sum for the curr_compute row.
-        for (int j = 0; j < width; j++) {
-            int curr_col = j + pad_size + 1;
-            int right = curr_col + pad_size;
-            int left = curr_col - pad_size - 1;
-            int result =
-                dp[bottom * dp_width + right]
-                - dp[bottom * dp_width + left]
-                - dp[top * dp_width + right]
-                + dp[top * dp_width + left];
-            mask_data[(i - pad_size) * stride + j] = (result > mask_index);
+        if (i - pad_size - 1 >= 0) {
+            derivative_callback(image_data, derivative_buffer, width, height, i - pad_size - 1, stride);
+            for (int j = 0; j < width; j++) {
+                sums[j] -= derivative_buffer[j];
+            }
         }
-        curr_compute = (curr_compute + 1 == dp_height ? 0 : curr_compute + 1);
-        bottom = (bottom + 1 == dp_height ? 0 : bottom + 1);
-        top = (top + 1 == dp_height ? 0 : top + 1);
+        spatial_mask_row_callback(&mask_data[i * stride], column_sums, width, 2 * pad_size + 1, mask_index);
     }
 }
 
 static void get_spatial_mask(const VmafPicture *image, VmafPicture *mask,
-                             uint32_t *dp, uint16_t *derivative_buffer, unsigned width, unsigned height,
-                             VmafDerivativeCalculator derivative_callback) {
+                             uint16_t *column_sums, uint16_t *derivative_buffer, unsigned width, unsigned height,
+                             VmafDerivativeCalculator derivative_callback,
+                             VmafSpatialMaskRowCalculator spatial_mask_row_callback) {
     uint16_t mask_index = get_mask_index(width, height, MASK_FILTER_SIZE);
-    get_spatial_mask_for_index(image, mask, dp, derivative_buffer, mask_index, MASK_FILTER_SIZE, width, height, derivative_callback);
+    get_spatial_mask_for_index(image, mask, column_sums, derivative_buffer, mask_index, MASK_FILTER_SIZE, width, height,
+                               derivative_callback, spatial_mask_row_callback);
 }
 
 static float c_value_pixel(const uint16_t *histograms, uint16_t value, const int *diff_weights,
@@ -913,10 +981,10 @@ static FORCE_INLINE inline void update_histogram_add_first_pass(uint16_t *histog
     }
 }
 
-static FORCE_INLINE inline void calculate_c_values_row(float *c_values, uint16_t *histograms, uint16_t *image,
-                                                       uint16_t *mask, int row, int width, ptrdiff_t stride,
-                                                       const uint16_t num_diffs, const uint16_t *tvi_for_diff,
-                                                       const int *diff_weights, const int *all_diffs) {
+static void calculate_c_values_row(float *c_values, const uint16_t *histograms, const uint16_t *image,
+                                   const uint16_t *mask, int row, int width, ptrdiff_t stride,
+                                   const uint16_t num_diffs, const uint16_t *tvi_for_diff,
+                                   const int *diff_weights, const int *all_diffs) {
     for (int col = 0; col < width; col++) {
         if (mask[row * stride + col]) {
             c_values[row * width + col] = c_value_pixel(
@@ -930,7 +998,8 @@ static void calculate_c_values(VmafPicture *pic, const VmafPicture *mask_pic,
                                float *c_values, uint16_t *histograms, uint16_t window_size,
                                const uint16_t num_diffs, const uint16_t *tvi_for_diff,
                                const int *diff_weights, const int *all_diffs, int width, int height,
-                               VmafRangeUpdater inc_range_callback, VmafRangeUpdater dec_range_callback) {
+                               VmafRangeUpdater inc_range_callback, VmafRangeUpdater dec_range_callback,
+                               VmafCValuesRowCalculator c_values_row_callback) {
 
     uint16_t pad_size = window_size >> 1;
     const uint16_t num_bins = 1024 + (all_diffs[2*num_diffs] - all_diffs[0]);
@@ -972,7 +1041,7 @@ static void calculate_c_values(VmafPicture *pic, const VmafPicture *mask_pic,
                 update_histogram_add_edge(histograms, image, mask, i, j, width, stride, pad_size, num_diffs, inc_range_callback);
             }
         }
-        calculate_c_values_row(c_values, histograms, image, mask, i, width, stride, num_diffs, tvi_for_diff, diff_weights, all_diffs);
+        c_values_row_callback(c_values, histograms, image, mask, i, width, stride, num_diffs, tvi_for_diff, diff_weights, all_diffs);
     }
     for (int i = pad_size + 1; i < height - pad_size; i++) {
         for (int j = 0; j < pad_size; j++) {
@@ -987,7 +1056,7 @@ static void calculate_c_values(VmafPicture *pic, const VmafPicture *mask_pic,
             update_histogram_subtract_edge(histograms, image, mask, i, j, width, stride, pad_size, num_diffs, dec_range_callback);
             update_histogram_add_edge(histograms, image, mask, i, j, width, stride, pad_size, num_diffs, inc_range_callback);
         }
-        calculate_c_values_row(c_values, histograms, image, mask, i, width, stride, num_diffs, tvi_for_diff, diff_weights, all_diffs);
+        c_values_row_callback(c_values, histograms, image, mask, i, width, stride, num_diffs, tvi_for_diff, diff_weights, all_diffs);
     }
     for (int i = height - pad_size; i < height; i++) {
         if (i - pad_size - 1 >= 0) {
@@ -1001,7 +1070,7 @@ static void calculate_c_values(VmafPicture *pic, const VmafPicture *mask_pic,
                 update_histogram_subtract_edge(histograms, image, mask, i, j, width, stride, pad_size, num_diffs, dec_range_callback);
             }
         }
-        calculate_c_values_row(c_values, histograms, image, mask, i, width, stride, num_diffs, tvi_for_diff, diff_weights, all_diffs);
+        c_values_row_callback(c_values, histograms, image, mask, i, width, stride, num_diffs, tvi_for_diff, diff_weights, all_diffs);
     }
 }
 
@@ -1093,7 +1162,9 @@ static int dump_c_values(FILE *heatmaps_files[], const float *c_values, int widt
 static int cambi_score(VmafPicture *pics, uint16_t window_size, double topk,
                        const uint16_t num_diffs, const uint16_t *tvi_for_diff,
                        CambiBuffers buffers, VmafRangeUpdater inc_range_callback, VmafRangeUpdater dec_range_callback,
-                       VmafDerivativeCalculator derivative_callback, double *score, bool write_heatmaps, FILE *heatmaps_files[],
+                       VmafDerivativeCalculator derivative_callback, VmafCValuesRowCalculator c_values_row_callback,
+                       VmafModeRowFilter mode_row_callback, VmafRowDecimator decimate_row_callback,
+                       VmafSpatialMaskRowCalculator spatial_mask_row_callback, double *score, bool write_heatmaps, FILE *heatmaps_files[],
                        int width, int height, int frame) {
     double scores_per_scale[NUM_SCALES];
     VmafPicture *image = &pics[0];
@@ -1102,20 +1173,21 @@ static int cambi_score(VmafPicture *pics, uint16_t window_size, double topk,
     int scaled_width = width;
     int scaled_height = height;
 
-    get_spatial_mask(image, mask, buffers.mask_dp, buffers.derivative_buffer, width, height, derivative_callback);
+    get_spatial_mask(image, mask, buffers.mask_column_sums, buffers.derivative_buffer, width, height,
+                     derivative_callback, spatial_mask_row_callback);
     for (unsigned scale = 0; scale < NUM_SCALES; scale++) {
         if (scale > 0) {
             scaled_width = (scaled_width + 1) >> 1;
             scaled_height = (scaled_height + 1) >> 1;
-            decimate(image, scaled_width, scaled_height);
-            decimate(mask, scaled_width, scaled_height);
+            decimate(image, scaled_width, scaled_height, decimate_row_callback);
+            decimate(mask, scaled_width, scaled_height, decimate_row_callback);
         }
 
-        filter_mode(image, scaled_width, scaled_height, buffers.filter_mode_buffer);
+        filter_mode(image, scaled_width, scaled_height, buffers.filter_mode_buffer, mode_row_callback);
 
         calculate_c_values(image, mask, buffers.c_values, buffers.c_values_histograms, window_size,
                            num_diffs, tvi_for_diff, buffers.diff_weights, buffers.all_diffs, scaled_width, scaled_height,
-                           inc_range_callback, dec_range_callback);
+                           inc_range_callback, dec_range_callback, c_values_row_callback);
 
         if (write_heatmaps) {
             int err = dump_c_values(heatmaps_files, buffers.c_values, scaled_width, scaled_height, scale, window_size,
@@ -1138,12 +1210,13 @@ static int preprocess_and_extract_cambi(CambiState *s, VmafPicture *pic, double
     int window_size = is_src ? s->src_window_size : s->window_size;
     int num_diffs = 1 << s->max_log_contrast;
 
-    int err = cambi_preprocessing(pic, &s->pics[0], width, height, s->enc_bitdepth);
+    int err = cambi_preprocessing(pic, &s->pics[0], width, height, s->enc_bitdepth, s->anti_dithering_callback);
     if (err) return err;
 
     bool write_heatmaps = s->heatmaps_path && !is_src;
     err = cambi_score(s->pics, window_size, s->topk, num_diffs, s->buffers.tvi_for_diff,
-                      s->buffers, s->inc_range_callback, s->dec_range_callback, s->derivative_callback, score, write_heatmaps, s->heatmaps_files, width, height, frame);
+                      s->buffers, s->inc_range_callback, s->dec_range_callback, s->derivative_callback, s->c_values_row_callback,
+                      s->mode_row_callback, s->decimate_row_callback, s->spatial_mask_row_callback, score, write_heatmaps, s->heatmaps_files, width, height, frame);
     if (err) return err;
 
     return 0;
@@ -1194,7 +1267,7 @@ static int close_cambi(VmafFeatureExtractor *fex) {
     aligned_free(s->buffers.tvi_for_diff);
     aligned_free(s->buffers.c_values);
     aligned_free(s->buffers.c_values_histograms);
-    aligned_free(s->buffers.mask_dp);
+    aligned_free(s->buffers.mask_column_sums);
     aligned_free(s->buffers.filter_mode_buffer);
     aligned_free(s->buffers.diffs_to_consider);
     aligned_free(s->buffers.diff_weights);
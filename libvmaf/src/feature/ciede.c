@@ -45,84 +45,55 @@ SOFTWARE.
 #include <errno.h>
 #include <math.h>
 #include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 
+#include "ciede.h"
+#include "cpu.h"
 #include "feature_collector.h"
 #include "feature_extractor.h"
 #include "mem.h"
 #include "opt.h"
 
-typedef struct CiedeState {
-    VmafPicture ref;
-    VmafPicture dist;
-    void (*scale_chroma_planes)(VmafPicture *in, VmafPicture *out);
-} CiedeState;
-
-static void scale_chroma_planes_hbd(VmafPicture *in, VmafPicture *out)
-{
-    const int ss_hor = in->pix_fmt != VMAF_PIX_FMT_YUV444P;
-    const int ss_ver = in->pix_fmt == VMAF_PIX_FMT_YUV420P;
-
-    for (unsigned p = 0; p < 3; p++) {
-        uint16_t *in_buf = in->data[p];
-        uint16_t *out_buf = out->data[p];
-        for (unsigned i = 0; i < out->h[p]; i++) {
-            for (unsigned j = 0; j < out->w[p]; j++) {
-                out_buf[j] = in_buf[(j / ((p && ss_ver) ? 2 : 1))];
-            }
-            in_buf += (((p && ss_hor) ? i % 2 : 1) * in->stride[p]) / 2;
-            out_buf += out->stride[p] / 2;
-        }
-    }
-}
+#if ARCH_X86
+#include "x86/ciede_avx2.h"
+#endif
 
-static void scale_chroma_planes(VmafPicture *in, VmafPicture *out)
-{
-    const int ss_hor = in->pix_fmt != VMAF_PIX_FMT_YUV444P;
-    const int ss_ver = in->pix_fmt == VMAF_PIX_FMT_YUV420P;
-
-    for (unsigned p = 0; p < 3; p++) {
-        uint8_t *in_buf = in->data[p];
-        uint8_t *out_buf = out->data[p];
-        for (unsigned i = 0; i < out->h[p]; i++) {
-            for (unsigned j = 0; j < out->w[p]; j++) {
-                out_buf[j] = in_buf[(j / ((p && ss_ver) ? 2 : 1))];
-            }
-            in_buf += ((p && ss_hor) ? i % 2 : 1) * in->stride[p];
-            out_buf += out->stride[p];
-        }
-    }
-}
-
-static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
-                unsigned bpc, unsigned w, unsigned h)
-{
-    CiedeState *s = fex->priv;
-    int err = 0;
-
-    if (pix_fmt == VMAF_PIX_FMT_YUV400P)
-        return -EINVAL;
-
-    if (pix_fmt == VMAF_PIX_FMT_YUV444P)
-        return 0;
+/*
+ * The sRGB transfer function and the cube root of the XYZ to Lab mapping are
+ * read from tables built in init(), interpolating linearly between entries.
+ * The transfer function is smooth and is sampled uniformly over [0, 4). The
+ * cube root is steep close to zero, so its table is indexed by the exponent
+ * and the top mantissa bits of its float argument, which gives every octave
+ * of [2^-7, 2^4) the same relative resolution. Both stay within 2e-7 of the
+ * exact mapping; see test_ciede. The tables are only used along with
+ * ciede2000_row_avx2(), whose error is much larger. Without AVX2, pixels are
+ * converted in double precision, as they always have been.
+ */
+#define GAMMA_LUT_MAX 4
+#define GAMMA_LUT_SCALE 2048
+#define GAMMA_LUT_SIZE (GAMMA_LUT_MAX * GAMMA_LUT_SCALE)
 
-    switch (bpc) {
-    case 8:
-        s->scale_chroma_planes = scale_chroma_planes;
-        break;
-    case 10:
-    case 12:
-    case 16:
-        s->scale_chroma_planes = scale_chroma_planes_hbd;
-        break;
-    default:
-        return -EINVAL;
-    }
+#define CBRT_LUT_MIN_EXP (-7)
+#define CBRT_LUT_MAX_EXP 4
+#define CBRT_LUT_MANTISSA_BITS 10
+#define CBRT_LUT_SIZE \
+    ((CBRT_LUT_MAX_EXP - CBRT_LUT_MIN_EXP) << CBRT_LUT_MANTISSA_BITS)
 
-    err |= vmaf_picture_alloc(&s->ref, VMAF_PIX_FMT_YUV444P, bpc, w, h);
-    err |= vmaf_picture_alloc(&s->dist, VMAF_PIX_FMT_YUV444P, bpc, w, h);
-    return err;
-}
+typedef struct CiedeState {
+    float gamma_lut[GAMMA_LUT_SIZE + 1];
+    float cbrt_lut[CBRT_LUT_SIZE + 1];
+    float y_offset, y_scale;
+    float c_offset, c_scale;
+    float *buf;
+    float *lab[2][3];
+    bool use_lut;
+    void (*yuv_to_lab_row)(const struct CiedeState *s, VmafPicture *pic,
+                           unsigned i, float *const lab[3]);
+    double (*ciede2000_row)(float *const lab_1[3], float *const lab_2[3],
+                            unsigned w, KSubArgs ksub, double de00_sum);
+} CiedeState;
 
 static float get_h_prime(const float x, const float y)
 {
@@ -186,18 +157,6 @@ static float get_r_sub_t(const float c_bar_prime,
           sin(degrees_to_radians(60.0 * exp(-(powf(degrees, 2)))));
 }
 
-typedef struct LABColor {
-    const float l;
-    const float a;
-    const float b;
-} LABColor;
-
-typedef struct KSubArgs {
-    const float l;
-    const float c;
-    const float h;
-} KSubArgs;
-
 static float ciede2000(LABColor color_1, LABColor color_2, KSubArgs ksub)
 {
     const float delta_l_prime = color_2.l - color_1.l;
@@ -307,6 +266,205 @@ static LABColor get_lab_color(double y, double u, double v, unsigned bpc)
     return lab_color;
 }
 
+static inline void store_lab_color(LABColor color, float *const lab[3],
+                                   unsigned j)
+{
+    lab[0][j] = color.l;
+    lab[1][j] = color.a;
+    lab[2][j] = color.b;
+}
+
+static void gamma_lut_init(float *lut)
+{
+    for (unsigned i = 0; i <= GAMMA_LUT_SIZE; i++) {
+        const double A = 0.055;
+        const double D = 1.0 / 1.055;
+        lut[i] = pow_2_4(((double) i / GAMMA_LUT_SCALE + A) * D);
+    }
+}
+
+static inline float gamma_map(const float *lut, float c)
+{
+    if (c <= 10.f / 255.f)
+        return c * (1.f / 12.92f);
+
+    const float t = c * GAMMA_LUT_SCALE;
+    if (t >= GAMMA_LUT_SIZE)
+        return rgb_to_xyz_map(c);
+
+    const unsigned i = t;
+    return lut[i] + (t - i) * (lut[i + 1] - lut[i]);
+}
+
+typedef union {
+    float f;
+    uint32_t u;
+} FloatBits;
+
+#define CBRT_LUT_SHIFT (23 - CBRT_LUT_MANTISSA_BITS)
+#define CBRT_LUT_BASE ((uint32_t) (127 + CBRT_LUT_MIN_EXP) << 23)
+
+static void cbrt_lut_init(float *lut)
+{
+    for (unsigned i = 0; i <= CBRT_LUT_SIZE; i++) {
+        const FloatBits c = { .u = CBRT_LUT_BASE + (i << CBRT_LUT_SHIFT) };
+        lut[i] = cbrt_approx(c.f);
+    }
+}
+
+static inline float lab_map(const float *lut, float c)
+{
+    const float KAPPA = 24389.f / 27.f;
+    const float EPSILON = 216.f / 24389.f;
+
+    if (c <= EPSILON)
+        return (KAPPA * c + 16.f) * (1.f / 116.f);
+
+    const FloatBits bits = { .f = c };
+    const uint32_t k = (bits.u - CBRT_LUT_BASE) >> CBRT_LUT_SHIFT;
+    if (k >= CBRT_LUT_SIZE)
+        return xyz_to_lab_map(c);
+
+    const float frac = (bits.u & ((1 << CBRT_LUT_SHIFT) - 1)) *
+                       (1.f / (1 << CBRT_LUT_SHIFT));
+    return lut[k] + frac * (lut[k + 1] - lut[k]);
+}
+
+static inline void yuv_to_lab(const CiedeState *s, float y, float u, float v,
+                              float *const lab[3], unsigned j)
+{
+    y = (y - s->y_offset) * s->y_scale;
+    u = (u - s->c_offset) * s->c_scale;
+    v = (v - s->c_offset) * s->c_scale;
+
+    // Assumes BT.709
+    const float r = gamma_map(s->gamma_lut, y + 1.28033f * v);
+    const float g = gamma_map(s->gamma_lut, y - 0.21482f * u - 0.38059f * v);
+    const float b = gamma_map(s->gamma_lut, y + 2.12798f * u);
+
+    const float x_lab =
+        lab_map(s->cbrt_lut, (r * 0.4124564390896921f + g * 0.357576077643909f +
+                              b * 0.18043748326639894f) * (1.f / 0.95047f));
+    const float y_lab =
+        lab_map(s->cbrt_lut, r * 0.21267285140562248f + g * 0.715152155287818f +
+                             b * 0.07217499330655958f);
+    const float z_lab =
+        lab_map(s->cbrt_lut, (r * 0.019333895582329317f + g * 0.119192025881303f +
+                              b * 0.9503040785363677f) * (1.f / 1.08883f));
+
+    lab[0][j] = (116.f * y_lab) - 16.f;
+    lab[1][j] = 500.f * (x_lab - y_lab);
+    lab[2][j] = 200.f * (y_lab - z_lab);
+}
+
+static void yuv_to_lab_row(const CiedeState *s, VmafPicture *pic, unsigned i,
+                           float *const lab[3])
+{
+    const int ss_hor = pic->pix_fmt != VMAF_PIX_FMT_YUV444P;
+    const int ss_ver = pic->pix_fmt == VMAF_PIX_FMT_YUV420P;
+    const uint8_t *y = (uint8_t*) pic->data[0] + i * pic->stride[0];
+    const uint8_t *u = (uint8_t*) pic->data[1] + (i >> ss_ver) * pic->stride[1];
+    const uint8_t *v = (uint8_t*) pic->data[2] + (i >> ss_ver) * pic->stride[2];
+
+    if (!s->use_lut) {
+        for (unsigned j = 0; j < pic->w[0]; j++) {
+            store_lab_color(get_lab_color(y[j], u[j >> ss_hor], v[j >> ss_hor],
+                                          pic->bpc), lab, j);
+        }
+        return;
+    }
+
+    for (unsigned j = 0; j < pic->w[0]; j++)
+        yuv_to_lab(s, y[j], u[j >> ss_hor], v[j >> ss_hor], lab, j);
+}
+
+static void yuv_to_lab_row_hbd(const CiedeState *s, VmafPicture *pic,
+                               unsigned i, float *const lab[3])
+{
+    const int ss_hor = pic->pix_fmt != VMAF_PIX_FMT_YUV444P;
+    const int ss_ver = pic->pix_fmt == VMAF_PIX_FMT_YUV420P;
+    const uint16_t *y = (uint16_t*) pic->data[0] + i * (pic->stride[0] / 2);
+    const uint16_t *u =
+        (uint16_t*) pic->data[1] + (i >> ss_ver) * (pic->stride[1] / 2);
+    const uint16_t *v =
+        (uint16_t*) pic->data[2] + (i >> ss_ver) * (pic->stride[2] / 2);
+
+    if (!s->use_lut) {
+        for (unsigned j = 0; j < pic->w[0]; j++) {
+            store_lab_color(get_lab_color(y[j], u[j >> ss_hor], v[j >> ss_hor],
+                                          pic->bpc), lab, j);
+        }
+        return;
+    }
+
+    for (unsigned j = 0; j < pic->w[0]; j++)
+        yuv_to_lab(s, y[j], u[j >> ss_hor], v[j >> ss_hor], lab, j);
+}
+
+static double ciede2000_row(float *const lab_1[3], float *const lab_2[3],
+                            unsigned w, KSubArgs ksub, double de00_sum)
+{
+    for (unsigned j = 0; j < w; j++) {
+        const LABColor color_1 = {
+            .l = lab_1[0][j], .a = lab_1[1][j], .b = lab_1[2][j],
+        };
+        const LABColor color_2 = {
+            .l = lab_2[0][j], .a = lab_2[1][j], .b = lab_2[2][j],
+        };
+        de00_sum += ciede2000(color_1, color_2, ksub);
+    }
+    return de00_sum;
+}
+
+static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
+                unsigned bpc, unsigned w, unsigned h)
+{
+    CiedeState *s = fex->priv;
+    (void) h;
+
+    if (pix_fmt == VMAF_PIX_FMT_YUV400P)
+        return -EINVAL;
+
+    switch (bpc) {
+    case 8:
+        s->yuv_to_lab_row = yuv_to_lab_row;
+        break;
+    case 10:
+    case 12:
+    case 16:
+        s->yuv_to_lab_row = yuv_to_lab_row_hbd;
+        break;
+    default:
+        return -EINVAL;
+    }
+
+    s->ciede2000_row = ciede2000_row;
+#if ARCH_X86
+    unsigned flags = vmaf_get_cpu_flags();
+    if (flags & VMAF_X86_CPU_FLAG_AVX2) {
+        s->ciede2000_row = ciede2000_row_avx2;
+        s->use_lut = true;
+    }
+#endif
+
+    const float scale = 1 << (bpc - 8);
+    s->y_offset = 16.f * scale;
+    s->y_scale = 1.f / (219.f * scale);
+    s->c_offset = 128.f * scale;
+    s->c_scale = 1.f / (224.f * scale);
+
+    gamma_lut_init(s->gamma_lut);
+    cbrt_lut_init(s->cbrt_lut);
+
+    const size_t row_sz = ALIGN_CEIL(w * sizeof(float));
+    s->buf = aligned_malloc(6 * row_sz, 32);
+    if (!s->buf) return -ENOMEM;
+    for (unsigned i = 0; i < 6; i++)
+        s->lab[i / 3][i % 3] = (float*) ((uint8_t*) s->buf + i * row_sz);
+
+    return 0;
+}
+
 static int extract(VmafFeatureExtractor *fex,
                    VmafPicture *ref_pic, VmafPicture *ref_pic_90,
                    VmafPicture *dist_pic, VmafPicture *dist_pic_90,
@@ -316,54 +474,14 @@ static int extract(VmafFeatureExtractor *fex,
     (void) ref_pic_90;
     (void) dist_pic_90;
 
-    VmafPicture *ref;
-    VmafPicture *dist;
-
-    if (ref_pic->pix_fmt == VMAF_PIX_FMT_YUV444P) {
-        // Reuse the provided buffers
-        ref = ref_pic;
-        dist = dist_pic;
-    } else {
-        ref = &s->ref;
-        dist = &s->dist;
-        s->scale_chroma_planes(ref_pic, ref);
-        s->scale_chroma_planes(dist_pic, dist);
-    }
+    const KSubArgs default_ksub = { .l = 0.65, .c = 1.0, .h = 4.0 };
 
     double de00_sum = 0.;
-    for (unsigned i = 0; i < ref->h[0]; i++) {
-        for (unsigned j = 0; j < ref->w[0]; j++) {
-            float r_y, r_u, r_v, d_y, d_u, d_v;
-
-            switch (ref->bpc) {
-            case 8:
-                r_y = ((uint8_t*)ref->data[0])[i * ref->stride[0] + j];
-                r_u = ((uint8_t*)ref->data[1])[i * ref->stride[1] + j];
-                r_v = ((uint8_t*)ref->data[2])[i * ref->stride[2] + j];
-                d_y = ((uint8_t*)dist->data[0])[i * dist->stride[0] + j];
-                d_u = ((uint8_t*)dist->data[1])[i * dist->stride[1] + j];
-                d_v = ((uint8_t*)dist->data[2])[i * dist->stride[2] + j];
-                break;
-            case 10:
-            case 12:
-            case 16:
-                r_y = ((uint16_t*)ref->data[0])[i * (ref->stride[0] / 2) + j];
-                r_u = ((uint16_t*)ref->data[1])[i * (ref->stride[1] / 2) + j];
-                r_v = ((uint16_t*)ref->data[2])[i * (ref->stride[2] / 2) + j];
-                d_y = ((uint16_t*)dist->data[0])[i * (dist->stride[0] / 2) + j];
-                d_u = ((uint16_t*)dist->data[1])[i * (dist->stride[1] / 2) + j];
-                d_v = ((uint16_t*)dist->data[2])[i * (dist->stride[2] / 2) + j];
-                break;
-            default:
-                return -EINVAL;
-            }
-
-            const LABColor color_1 = get_lab_color(r_y, r_u, r_v, ref->bpc);
-            const LABColor color_2 = get_lab_color(d_y, d_u, d_v, dist->bpc);
-            const KSubArgs default_ksub = { .l = 0.65, .c = 1.0, .h = 4.0 };
-            const float de00 = ciede2000(color_1, color_2, default_ksub);
-            de00_sum += de00;
-        }
+    for (unsigned i = 0; i < ref_pic->h[0]; i++) {
+        s->yuv_to_lab_row(s, ref_pic, i, s->lab[0]);
+        s->yuv_to_lab_row(s, dist_pic, i, s->lab[1]);
+        de00_sum = s->ciede2000_row(s->lab[0], s->lab[1], ref_pic->w[0],
+                                    default_ksub, de00_sum);
     }
 
     const double score = 45. - 20. *
@@ -375,10 +493,7 @@ static int extract(VmafFeatureExtractor *fex,
 static int close(VmafFeatureExtractor *fex)
 {
     CiedeState *s = fex->priv;
-    if (s->ref.data[0] && s->dist.data[0]) {
-        vmaf_picture_unref(&s->ref);
-        vmaf_picture_unref(&s->dist);
-    }
+    aligned_free(s->buf);
     return 0;
 }
 
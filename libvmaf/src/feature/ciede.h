@@ -0,0 +1,34 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef FEATURE_CIEDE_H_
+#define FEATURE_CIEDE_H_
+
+typedef struct LABColor {
+    const float l;
+    const float a;
+    const float b;
+} LABColor;
+
+typedef struct KSubArgs {
+    const float l;
+    const float c;
+    const float h;
+} KSubArgs;
+
+#endif /* FEATURE_CIEDE_H_ */
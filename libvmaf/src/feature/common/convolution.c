@@ -21,6 +21,7 @@
 #include "convolution.h"
 #include "convolution_internal.h"
 #include "cpu.h"
+#include "mem.h"
 
 extern int vmaf_floorn(int, int);
 extern int vmaf_ceiln(int, int);
@@ -77,17 +78,82 @@ void convolution_y_c_s(const float *filter, int filter_width, const float *src,
 	}
 }
 
+static float convolution_edge_input_s(enum ConvolutionInput input, const float *filter, int filter_width, const float *src1, const float *src2, int width, int height, int src1_stride, int src2_stride, int i, int j)
+{
+	switch (input) {
+	case CONVOLUTION_INPUT_SQ:
+		return convolution_edge_sq_s(false, filter, filter_width, src1, width, height, src1_stride, i, j);
+	case CONVOLUTION_INPUT_XY:
+		return convolution_edge_xy_s(false, filter, filter_width, src1, src2, width, height, src1_stride, src2_stride, i, j);
+	default:
+		return convolution_edge_s(false, filter, filter_width, src1, width, height, src1_stride, i, j);
+	}
+}
+
+void convolution_scanlines_s(const ConvolutionScanlines *scanlines, enum ConvolutionInput input, const float *filter, int filter_width, const float *src1, const float *src2, float *dst, float *tmp, int width, int height, int src1_stride, int src2_stride, int dst_stride)
+{
+	const convolution_v_scanline_fn v_scanline = scanlines->v[input];
+	int radius = filter_width / 2;
+	int width_mod8 = vmaf_floorn(width, 8);
+
+	int i_vec_end = height - radius;
+	int j_vec_end = width_mod8 - vmaf_ceiln(radius + 1, 8);
+	if (j_vec_end < 0)
+		j_vec_end = 0;
+
+	// The horizontal pass of a row only reads that row of the vertical pass,
+	// so both run row by row and tmp only holds one row.
+	for (int i = 0; i < height; ++i) {
+		int j = 0;
+
+		// Vertical pass.
+		if (i >= radius && i < i_vec_end) {
+			const float *src2_row = src2 ? src2 + i * src2_stride : NULL;
+			v_scanline(filter, filter_width, src1 + i * src1_stride, src2_row, tmp, src1_stride, src2_stride, width_mod8);
+			j = width_mod8;
+		}
+		for (; j < width; ++j) {
+			tmp[j] = convolution_edge_input_s(input, filter, filter_width, src1, src2, width, height, src1_stride, src2_stride, i, j);
+		}
+
+		// Horizontal pass.
+		for (j = 0; j < radius; ++j) {
+			dst[i * dst_stride + j] = convolution_edge_s(true, filter, filter_width, tmp, width, height, 0, 0, j);
+		}
+
+		scanlines->h(filter, filter_width, tmp, dst + i * dst_stride, j_vec_end);
+
+		for (j = j_vec_end + radius; j < width; ++j) {
+			dst[i * dst_stride + j] = convolution_edge_s(true, filter, filter_width, tmp, width, height, 0, 0, j);
+		}
+	}
+}
+
 void convolution_f32_c_s(const float *filter, int filter_width, const float *src, float *dst, float *tmp, int width, int height, int src_stride, int dst_stride)
 {
     /* if support avx */
 
 #if ARCH_X86
     const unsigned flags = vmaf_get_cpu_flags();
+#if HAVE_AVX512
+    if (flags & VMAF_X86_CPU_FLAG_AVX512) {
+        convolution_f32_avx512_s(filter, filter_width, src, dst, tmp, width,
+                                 height, src_stride, dst_stride);
+        return;
+    }
+#endif
     if (flags & VMAF_X86_CPU_FLAG_AVX2) {
         convolution_f32_avx_s(filter, filter_width, src, dst, tmp, width,
                               height, src_stride, dst_stride);
         return;
     }
+#elif ARCH_AARCH64
+    const unsigned flags = vmaf_get_cpu_flags();
+    if (flags & VMAF_ARM_CPU_FLAG_NEON) {
+        convolution_f32_neon_s(filter, filter_width, src, dst, tmp, width,
+                               height, src_stride, dst_stride);
+        return;
+    }
 #endif
 
     /* fall back */
@@ -96,3 +162,44 @@ void convolution_f32_c_s(const float *filter, int filter_width, const float *src
 	convolution_y_c_s(filter, filter_width, src, tmp, width, height, src_stride, dst_stride, 1);
 	convolution_x_c_s(filter, filter_width, tmp, dst, width, height, src_stride, dst_stride, 1);
 }
+
+void convolution_pic_c_s(const float *filter, int filter_width, const void *src, float *dst, float *tmp, int width, int height, ptrdiff_t src_stride, int dst_stride, int hbd, float scale, float offset)
+{
+#if ARCH_X86
+    const unsigned flags = vmaf_get_cpu_flags();
+    if (flags & VMAF_X86_CPU_FLAG_AVX2) {
+        convolution_pic_avx_s(filter, filter_width, src, dst, tmp, width,
+                              height, src_stride, dst_stride, hbd, scale,
+                              offset);
+        return;
+    }
+#endif
+
+#if ARCH_AARCH64
+    if (vmaf_get_cpu_flags() & VMAF_ARM_CPU_FLAG_NEON) {
+        // the neon kernels filter row by row, so they cannot run in place:
+        // the picture is converted into tmp, and they get a row of scratch
+        float *row = aligned_malloc(ALIGN_CEIL(width * sizeof(float)), MAX_ALIGN);
+        if (row) {
+            for (int i = 0; i < height; ++i) {
+                for (int j = 0; j < width; ++j) {
+                    tmp[i * dst_stride + j] = convolution_pic_sample_s(src, src_stride, hbd, scale, offset, i, j);
+                }
+            }
+            convolution_f32_neon_s(filter, filter_width, tmp, dst, row, width, height, dst_stride, dst_stride);
+            aligned_free(row);
+            return;
+        }
+    }
+#endif
+
+	// without simd, converting per tap costs more than it saves, so the
+	// picture is converted into dst, which is only written by the last pass
+	for (int i = 0; i < height; ++i) {
+		for (int j = 0; j < width; ++j) {
+			dst[i * dst_stride + j] = convolution_pic_sample_s(src, src_stride, hbd, scale, offset, i, j);
+		}
+	}
+	convolution_y_c_s(filter, filter_width, dst, tmp, width, height, dst_stride, dst_stride, 1);
+	convolution_x_c_s(filter, filter_width, tmp, dst, width, height, dst_stride, dst_stride, 1);
+}
@@ -19,6 +19,8 @@
 #ifndef CONVOLUTION_H_
 #define CONVOLUTION_H_
 
+#include <stddef.h>
+
 /*
  * All functions listed here expect a SYMMETRICAL filter.
  * All array arguments must be 32-byte aligned.
@@ -40,4 +42,29 @@ void convolution_f32_avx_s(const float *filter, int filter_width, const float *s
 void convolution_f32_avx_sq_s(const float *filter, int filter_width, const float *src, float *dst, float *tmp, int width, int height, int src_stride, int dst_stride);
 
 void convolution_f32_avx_xy_s(const float *filter, int filter_width, const float *src1, const float *src2, float *dst, float *tmp, int width, int height, int src1_stride, int src2_stride, int dst_stride);
+
+void convolution_f32_avx512_s(const float *filter, int filter_width, const float *src, float *dst, float *tmp, int width, int height, int src_stride, int dst_stride);
+
+void convolution_f32_avx512_sq_s(const float *filter, int filter_width, const float *src, float *dst, float *tmp, int width, int height, int src_stride, int dst_stride);
+
+void convolution_f32_avx512_xy_s(const float *filter, int filter_width, const float *src1, const float *src2, float *dst, float *tmp, int width, int height, int src1_stride, int src2_stride, int dst_stride);
+
+void convolution_f32_neon_s(const float *filter, int filter_width, const float *src, float *dst, float *tmp, int width, int height, int src_stride, int dst_stride);
+
+void convolution_f32_neon_sq_s(const float *filter, int filter_width, const float *src, float *dst, float *tmp, int width, int height, int src_stride, int dst_stride);
+
+void convolution_f32_neon_xy_s(const float *filter, int filter_width, const float *src1, const float *src2, float *dst, float *tmp, int width, int height, int src1_stride, int src2_stride, int dst_stride);
+
+/*
+ * Same as converting the samples of src to float with picture_copy() and
+ * calling convolution_f32_c_s() on the result, but the conversion is folded
+ * into the vertical pass, so the float picture is never written.
+ *
+ * src - picture samples, uint16_t if hbd is set, uint8_t otherwise
+ * src_stride - distance between lines in src (bytes)
+ * scale, offset - every sample x is converted to (float)x * scale + offset
+ */
+void convolution_pic_c_s(const float *filter, int filter_width, const void *src, float *dst, float *tmp, int width, int height, ptrdiff_t src_stride, int dst_stride, int hbd, float scale, float offset);
+
+void convolution_pic_avx_s(const float *filter, int filter_width, const void *src, float *dst, float *tmp, int width, int height, ptrdiff_t src_stride, int dst_stride, int hbd, float scale, float offset);
 #endif // CONVOLUTION_H_
@@ -781,26 +781,21 @@ void convolution_f32_avx_s_1d_v_scanline_5(const float * RESTRICT filter, int fi
 	}
 }
 
-void convolution_f32_avx_s_1d(
+static void convolution_f32_avx_s_1d_v(
 	int N,
 	const float * RESTRICT filter,
 	int filter_width,
 	const float * RESTRICT src,
-	float * RESTRICT dst,
 	float * RESTRICT tmp,
 	int width,
 	int height,
 	int src_stride,
-	int dst_stride)
+	int tmp_stride)
 {
 	int radius = filter_width / 2;
 	int width_mod8 = vmaf_floorn(width, 8);
-	int tmp_stride = vmaf_ceiln(width, 8);
-
 	int i_vec_end = height - radius;
-	int j_vec_end = width_mod8 - vmaf_ceiln(radius + 1, 8);
 
-	// Vertical pass.
 	for (int i = 0; i < radius; ++i) {
 		for (int j = 0; j < width; ++j) {
 			tmp[i * tmp_stride + j] = convolution_edge_s(false, filter, filter_width, src, width, height, src_stride, i, j);
@@ -818,8 +813,23 @@ void convolution_f32_avx_s_1d(
 			tmp[i * tmp_stride + j] = convolution_edge_s(false, filter, filter_width, src, width, height, src_stride, i, j);
 		}
 	}
+}
+
+static void convolution_f32_avx_s_1d_h(
+	int N,
+	const float * RESTRICT filter,
+	int filter_width,
+	const float * RESTRICT tmp,
+	float * RESTRICT dst,
+	int width,
+	int height,
+	int tmp_stride,
+	int dst_stride)
+{
+	int radius = filter_width / 2;
+	int width_mod8 = vmaf_floorn(width, 8);
+	int j_vec_end = width_mod8 - vmaf_ceiln(radius + 1, 8);
 
-	// Horizontal pass.
 	for (int i = 0; i < height; ++i) {
 		for (int j = 0; j < radius; ++j) {
 			dst[i * dst_stride + j] = convolution_edge_s(true, filter, filter_width, tmp, width, height, tmp_stride, i, j);
@@ -833,6 +843,24 @@ void convolution_f32_avx_s_1d(
 	}
 }
 
+void convolution_f32_avx_s_1d(
+	int N,
+	const float * RESTRICT filter,
+	int filter_width,
+	const float * RESTRICT src,
+	float * RESTRICT dst,
+	float * RESTRICT tmp,
+	int width,
+	int height,
+	int src_stride,
+	int dst_stride)
+{
+	int tmp_stride = vmaf_ceiln(width, 8);
+
+	convolution_f32_avx_s_1d_v(N, filter, filter_width, src, tmp, width, height, src_stride, tmp_stride);
+	convolution_f32_avx_s_1d_h(N, filter, filter_width, tmp, dst, width, height, tmp_stride, dst_stride);
+}
+
 void convolution_f32_avx_s(const float *filter, int filter_width, const float *src, float *dst, float *tmp, int width, int height, int src_stride, int dst_stride)
 {
 	switch (filter_width) {
@@ -854,6 +882,88 @@ void convolution_f32_avx_s(const float *filter, int filter_width, const float *s
 	}
 }
 
+static inline __m256 convolution_pic_load_avx(const uint8_t *row, int hbd, int j, __m256 scale, __m256 offset)
+{
+	__m256i x = hbd ?
+		_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)((const uint16_t *)row + j))) :
+		_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(row + j)));
+	return _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(x), scale), offset);
+}
+
+// Same as convolution_f32_avx_s_1d_v_scanline_5(), on converted samples.
+static void convolution_pic_avx_s_1d_v_scanline_5(const float * RESTRICT filter, const uint8_t * RESTRICT src, float * RESTRICT dst, ptrdiff_t src_stride, int hbd, float scale, float offset, int j_end)
+{
+	__m256 f0, f1, f2, f3, f4;
+	const __m256 s = _mm256_set1_ps(scale);
+	const __m256 o = _mm256_set1_ps(offset);
+	src -= 2 * src_stride; // radius = 2
+
+	f0 = _mm256_broadcast_ss(filter + 0);
+	f1 = _mm256_broadcast_ss(filter + 1);
+	f2 = _mm256_broadcast_ss(filter + 2);
+	f3 = _mm256_broadcast_ss(filter + 3);
+	f4 = _mm256_broadcast_ss(filter + 4);
+
+	for (int j = 0; j < j_end; j += 8) {
+		__m256 sum0, sum1, sum2, sum3;
+
+		sum0 = _mm256_mul_ps(f0, convolution_pic_load_avx(src + 0 * src_stride, hbd, j, s, o));
+		sum1 = _mm256_mul_ps(f1, convolution_pic_load_avx(src + 1 * src_stride, hbd, j, s, o));
+		sum2 = _mm256_mul_ps(f2, convolution_pic_load_avx(src + 2 * src_stride, hbd, j, s, o));
+		sum3 = _mm256_mul_ps(f3, convolution_pic_load_avx(src + 3 * src_stride, hbd, j, s, o));
+		sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(f4, convolution_pic_load_avx(src + 4 * src_stride, hbd, j, s, o)));
+
+		sum0 = _mm256_add_ps(sum0, sum2);
+		sum1 = _mm256_add_ps(sum1, sum3);
+
+		sum0 = _mm256_add_ps(sum0, sum1);
+
+		_mm256_store_ps(dst + j, sum0);
+	}
+}
+
+void convolution_pic_avx_s(const float *filter, int filter_width, const void *src, float *dst, float *tmp, int width, int height, ptrdiff_t src_stride, int dst_stride, int hbd, float scale, float offset)
+{
+	int tmp_stride = vmaf_ceiln(width, 8);
+
+	if (filter_width != 5) {
+		// no fused vertical pass for this filter, convert into dst first
+		for (int i = 0; i < height; ++i) {
+			for (int j = 0; j < width; ++j) {
+				dst[i * dst_stride + j] = convolution_pic_sample_s(src, src_stride, hbd, scale, offset, i, j);
+			}
+		}
+		convolution_f32_avx_s_1d_v(filter_width, filter, filter_width, dst, tmp, width, height, dst_stride, tmp_stride);
+		convolution_f32_avx_s_1d_h(filter_width, filter, filter_width, tmp, dst, width, height, tmp_stride, dst_stride);
+		return;
+	}
+
+	int radius = filter_width / 2;
+	int width_mod8 = vmaf_floorn(width, 8);
+	int i_vec_end = height - radius;
+
+	// Vertical pass, same as convolution_f32_avx_s_1d_v().
+	for (int i = 0; i < radius; ++i) {
+		for (int j = 0; j < width; ++j) {
+			tmp[i * tmp_stride + j] = convolution_edge_pic_s(filter, filter_width, src, height, src_stride, hbd, scale, offset, i, j);
+		}
+	}
+	for (int i = radius; i < i_vec_end; ++i) {
+		convolution_pic_avx_s_1d_v_scanline_5(filter, (const uint8_t *)src + i * src_stride, tmp + i * tmp_stride, src_stride, hbd, scale, offset, width_mod8);
+
+		for (int j = width_mod8; j < width; ++j) {
+			tmp[i * tmp_stride + j] = convolution_edge_pic_s(filter, filter_width, src, height, src_stride, hbd, scale, offset, i, j);
+		}
+	}
+	for (int i = i_vec_end; i < height; ++i) {
+		for (int j = 0; j < width; ++j) {
+			tmp[i * tmp_stride + j] = convolution_edge_pic_s(filter, filter_width, src, height, src_stride, hbd, scale, offset, i, j);
+		}
+	}
+
+	convolution_f32_avx_s_1d_h(filter_width, filter, filter_width, tmp, dst, width, height, tmp_stride, dst_stride);
+}
+
 void convolution_f32_avx_s_1d_h_sq_scanline_17(const float * RESTRICT filter, int filter_width, const float * RESTRICT src, float * RESTRICT dst, int j_end)
 {
     (void) filter_width;
@@ -0,0 +1,202 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <immintrin.h>
+#include <stdbool.h>
+
+#include "convolution.h"
+#include "convolution_internal.h"
+
+/*
+ * One generic kernel per pass, instantiated below for every filter width
+ * convolution_avx.c unrolls. N is the filter width, or 0 for any other width.
+ * Each output sums its taps in blocks of 9 and in the same order as
+ * convolution_avx.c, so both give the same results. The loops over the taps
+ * are unrolled, so that the products and partial sums stay in registers.
+ */
+
+// j_end is a multiple of 8, so the last vector of a row may be half full
+static inline __mmask16 convolution_mask_avx512(int j, int j_end)
+{
+	return j + 16 <= j_end ? 0xffff : 0x00ff;
+}
+
+// Sum the products p of a block of n taps.
+static FORCE_INLINE inline __m512 convolution_block_avx512(bool unrolled, const __m512 *p, int n)
+{
+	__m512 sum[4] = { _mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps() };
+
+	if (unrolled) {
+#pragma GCC unroll 9
+		for (int t = 0; t < n; ++t)
+			sum[t % 4] = t < 4 ? p[t] : _mm512_add_ps(sum[t % 4], p[t]);
+	} else {
+#pragma GCC unroll 9
+		for (int t = n - 1; t >= 0; --t)
+			sum[t % 4] = t > 4 ? p[t] : _mm512_add_ps(sum[t % 4], p[t]);
+	}
+
+	sum[0] = _mm512_add_ps(sum[0], sum[2]);
+	sum[1] = _mm512_add_ps(sum[1], sum[3]);
+	return _mm512_add_ps(sum[0], sum[1]);
+}
+
+// Add the sum of block x to the sum of the previous blocks.
+static FORCE_INLINE inline __m512 convolution_accum_avx512(bool unrolled, bool horizontal, int x, __m512 accum, __m512 block)
+{
+	if (!unrolled || (horizontal && !x))
+		block = _mm512_add_ps(_mm512_setzero_ps(), block);
+	return x ? _mm512_add_ps(accum, block) : block;
+}
+
+static FORCE_INLINE inline void convolution_v_scanline_avx512(int N, enum ConvolutionInput input, const float * RESTRICT filter, int filter_width, const float * RESTRICT src1, const float * RESTRICT src2, float * RESTRICT dst, int src1_stride, int src2_stride, int j_end)
+{
+	const int fw = N ? N : filter_width;
+	const bool unrolled = N == 5 || N == 9 || N == 17;
+	__m512 f[17];
+
+#pragma GCC unroll 17
+	for (int k = 0; k < N; ++k)
+		f[k] = _mm512_set1_ps(filter[k]);
+
+	src1 -= fw / 2 * src1_stride;
+	if (input == CONVOLUTION_INPUT_XY)
+		src2 -= fw / 2 * src2_stride;
+
+	for (int j = 0; j < j_end; j += 16) {
+		const __mmask16 m = convolution_mask_avx512(j, j_end);
+		__m512 accum = _mm512_setzero_ps();
+
+#pragma GCC unroll 2
+		for (int x = 0; x < fw; x += 9) {
+			const int n = fw - x < 9 ? fw - x : 9;
+			__m512 p[9];
+
+#pragma GCC unroll 9
+			for (int t = 0; t < n; ++t) {
+				const int k = x + t;
+				__m512 g = _mm512_maskz_loadu_ps(m, src1 + k * src1_stride + j);
+				if (input == CONVOLUTION_INPUT_SQ)
+					g = _mm512_mul_ps(g, g);
+				else if (input == CONVOLUTION_INPUT_XY)
+					g = _mm512_mul_ps(g, _mm512_maskz_loadu_ps(m, src2 + k * src2_stride + j));
+				p[t] = _mm512_mul_ps(N ? f[k] : _mm512_set1_ps(filter[k]), g);
+			}
+
+			accum = convolution_accum_avx512(unrolled, false, x, accum, convolution_block_avx512(unrolled, p, n));
+		}
+
+		_mm512_mask_storeu_ps(dst + j, m, accum);
+	}
+}
+
+static FORCE_INLINE inline void convolution_h_scanline_avx512(int N, const float * RESTRICT filter, int filter_width, const float * RESTRICT src, float * RESTRICT dst, int j_end)
+{
+	const int fw = N ? N : filter_width;
+	const bool unrolled = N == 5 || N == 9 || N == 17;
+	__m512 f[17];
+
+#pragma GCC unroll 17
+	for (int k = 0; k < N; ++k)
+		f[k] = _mm512_set1_ps(filter[k]);
+
+	for (int j = 0; j < j_end; j += 16) {
+		const __mmask16 m = convolution_mask_avx512(j, j_end);
+		__m512 accum = _mm512_setzero_ps();
+
+#pragma GCC unroll 2
+		for (int x = 0; x < fw; x += 9) {
+			const int n = fw - x < 9 ? fw - x : 9;
+			__m512 p[9];
+
+#pragma GCC unroll 9
+			for (int t = 0; t < n; ++t) {
+				const int k = x + t;
+				const __m512 g = _mm512_maskz_loadu_ps(m, src + j + k);
+				p[t] = _mm512_mul_ps(N ? f[k] : _mm512_set1_ps(filter[k]), g);
+			}
+
+			accum = convolution_accum_avx512(unrolled, true, x, accum, convolution_block_avx512(unrolled, p, n));
+		}
+
+		_mm512_mask_storeu_ps(dst + j + fw / 2, m, accum);
+	}
+}
+
+#define CONVOLUTION_SCANLINES_AVX512(N) \
+static void convolution_v_scanline_##N##_avx512(const float *filter, int filter_width, const float *src1, const float *src2, float *dst, int src1_stride, int src2_stride, int j_end) \
+{ \
+	convolution_v_scanline_avx512(N, CONVOLUTION_INPUT_SRC, filter, filter_width, src1, src2, dst, src1_stride, src2_stride, j_end); \
+} \
+static void convolution_v_sq_scanline_##N##_avx512(const float *filter, int filter_width, const float *src1, const float *src2, float *dst, int src1_stride, int src2_stride, int j_end) \
+{ \
+	convolution_v_scanline_avx512(N, CONVOLUTION_INPUT_SQ, filter, filter_width, src1, src2, dst, src1_stride, src2_stride, j_end); \
+} \
+static void convolution_v_xy_scanline_##N##_avx512(const float *filter, int filter_width, const float *src1, const float *src2, float *dst, int src1_stride, int src2_stride, int j_end) \
+{ \
+	convolution_v_scanline_avx512(N, CONVOLUTION_INPUT_XY, filter, filter_width, src1, src2, dst, src1_stride, src2_stride, j_end); \
+} \
+static void convolution_h_scanline_##N##_avx512(const float *filter, int filter_width, const float *src, float *dst, int j_end) \
+{ \
+	convolution_h_scanline_avx512(N, filter, filter_width, src, dst, j_end); \
+} \
+static const ConvolutionScanlines convolution_scanlines_##N##_avx512 = { \
+	.v = { \
+		[CONVOLUTION_INPUT_SRC] = convolution_v_scanline_##N##_avx512, \
+		[CONVOLUTION_INPUT_SQ] = convolution_v_sq_scanline_##N##_avx512, \
+		[CONVOLUTION_INPUT_XY] = convolution_v_xy_scanline_##N##_avx512, \
+	}, \
+	.h = convolution_h_scanline_##N##_avx512, \
+};
+
+CONVOLUTION_SCANLINES_AVX512(0)
+CONVOLUTION_SCANLINES_AVX512(3)
+CONVOLUTION_SCANLINES_AVX512(5)
+CONVOLUTION_SCANLINES_AVX512(9)
+CONVOLUTION_SCANLINES_AVX512(17)
+
+static const ConvolutionScanlines *convolution_scanlines_avx512(int filter_width)
+{
+	switch (filter_width) {
+	case 17:
+		return &convolution_scanlines_17_avx512;
+	case 9:
+		return &convolution_scanlines_9_avx512;
+	case 5:
+		return &convolution_scanlines_5_avx512;
+	case 3:
+		return &convolution_scanlines_3_avx512;
+	default:
+		return &convolution_scanlines_0_avx512;
+	}
+}
+
+void convolution_f32_avx512_s(const float *filter, int filter_width, const float *src, float *dst, float *tmp, int width, int height, int src_stride, int dst_stride)
+{
+	convolution_scanlines_s(convolution_scanlines_avx512(filter_width), CONVOLUTION_INPUT_SRC, filter, filter_width, src, NULL, dst, tmp, width, height, src_stride, 0, dst_stride);
+}
+
+void convolution_f32_avx512_sq_s(const float *filter, int filter_width, const float *src, float *dst, float *tmp, int width, int height, int src_stride, int dst_stride)
+{
+	convolution_scanlines_s(convolution_scanlines_avx512(filter_width), CONVOLUTION_INPUT_SQ, filter, filter_width, src, NULL, dst, tmp, width, height, src_stride, 0, dst_stride);
+}
+
+void convolution_f32_avx512_xy_s(const float *filter, int filter_width, const float *src1, const float *src2, float *dst, float *tmp, int width, int height, int src1_stride, int src2_stride, int dst_stride)
+{
+	convolution_scanlines_s(convolution_scanlines_avx512(filter_width), CONVOLUTION_INPUT_XY, filter, filter_width, src1, src2, dst, tmp, width, height, src1_stride, src2_stride, dst_stride);
+}
@@ -23,6 +23,8 @@
 
 #include "macros.h"
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 FORCE_INLINE inline float convolution_edge_s(bool horizontal, const float *filter, int filter_width, const float *src, int width, int height, int stride, int i, int j)
 {
@@ -110,4 +112,65 @@ FORCE_INLINE inline float convolution_edge_xy_s(bool horizontal, const float *fi
 	return accum;
 }
 
+// Read one picture sample and convert it to float, like picture_copy().
+FORCE_INLINE inline float convolution_pic_sample_s(const void *src, ptrdiff_t stride, int hbd, float scale, float offset, int i, int j)
+{
+	const uint8_t *row = (const uint8_t *)src + i * stride;
+	const float val = hbd ? (float)((const uint16_t *)row)[j] : (float)row[j];
+	return val * scale + offset;
+}
+
+FORCE_INLINE inline float convolution_edge_pic_s(const float *filter, int filter_width, const void *src, int height, ptrdiff_t stride, int hbd, float scale, float offset, int i, int j)
+{
+	int radius = filter_width / 2;
+
+	float accum = 0;
+	for (int k = 0; k < filter_width; ++k) {
+		int i_tap = i - radius + k;
+
+		// Handle edges by mirroring.
+		if (i_tap < 0)
+			i_tap = -i_tap;
+		else if (i_tap >= height)
+			i_tap = height - (i_tap - height + 1);
+
+		accum += filter[k] * convolution_pic_sample_s(src, stride, hbd, scale, offset, i_tap, j);
+	}
+	return accum;
+}
+
+/*
+ * What the vertical pass filters: src1, src1 squared, or src1 * src2.
+ * The horizontal pass always filters the output of the vertical pass.
+ */
+enum ConvolutionInput {
+	CONVOLUTION_INPUT_SRC,
+	CONVOLUTION_INPUT_SQ,
+	CONVOLUTION_INPUT_XY,
+	CONVOLUTION_INPUT_COUNT,
+};
+
+/*
+ * Scanline kernels, with the same contract as the ones in convolution_avx.c:
+ * the vertical kernel filters row src1 into dst for columns [0, j_end), the
+ * horizontal kernel filters src into dst + radius for columns [0, j_end).
+ * j_end is a multiple of 8.
+ */
+typedef void (*convolution_v_scanline_fn)(const float *filter, int filter_width, const float *src1, const float *src2, float *dst, int src1_stride, int src2_stride, int j_end);
+typedef void (*convolution_h_scanline_fn)(const float *filter, int filter_width, const float *src, float *dst, int j_end);
+
+typedef struct ConvolutionScanlines {
+	convolution_v_scanline_fn v[CONVOLUTION_INPUT_COUNT];
+	convolution_h_scanline_fn h;
+} ConvolutionScanlines;
+
+/*
+ * Separable convolution with the given scanline kernels. The picture is split
+ * between the kernels and convolution_edge_*_s() exactly like in
+ * convolution_avx.c, so kernels that sum their taps in the same order give the
+ * same results. Both passes run row by row: tmp only needs to hold one row,
+ * and dst must not overlap src1 or src2.
+ */
+void convolution_scanlines_s(const ConvolutionScanlines *scanlines, enum ConvolutionInput input, const float *filter, int filter_width, const float *src1, const float *src2, float *dst, float *tmp, int width, int height, int src1_stride, int src2_stride, int dst_stride);
+
 #endif // CONVOLUTION_INTERNAL_H_
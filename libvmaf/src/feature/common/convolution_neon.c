@@ -0,0 +1,194 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <arm_neon.h>
+#include <stdbool.h>
+
+#include "convolution.h"
+#include "convolution_internal.h"
+
+/*
+ * One generic kernel per pass, instantiated below for every filter width
+ * convolution_avx.c unrolls. N is the filter width, or 0 for any other width.
+ * Each output sums its taps in blocks of 9 and in the same order as
+ * convolution_avx.c, so both give the same results. The loops over the taps
+ * are unrolled, so that the products and partial sums stay in registers.
+ */
+
+// Sum the products p of a block of n taps.
+static FORCE_INLINE inline float32x4_t convolution_block_neon(bool unrolled, const float32x4_t *p, int n)
+{
+	float32x4_t sum[4] = { vdupq_n_f32(0.0f), vdupq_n_f32(0.0f), vdupq_n_f32(0.0f), vdupq_n_f32(0.0f) };
+
+	if (unrolled) {
+#pragma GCC unroll 9
+		for (int t = 0; t < n; ++t)
+			sum[t % 4] = t < 4 ? p[t] : vaddq_f32(sum[t % 4], p[t]);
+	} else {
+#pragma GCC unroll 9
+		for (int t = n - 1; t >= 0; --t)
+			sum[t % 4] = t > 4 ? p[t] : vaddq_f32(sum[t % 4], p[t]);
+	}
+
+	sum[0] = vaddq_f32(sum[0], sum[2]);
+	sum[1] = vaddq_f32(sum[1], sum[3]);
+	return vaddq_f32(sum[0], sum[1]);
+}
+
+// Add the sum of block x to the sum of the previous blocks.
+static FORCE_INLINE inline float32x4_t convolution_accum_neon(bool unrolled, bool horizontal, int x, float32x4_t accum, float32x4_t block)
+{
+	if (!unrolled || (horizontal && !x))
+		block = vaddq_f32(vdupq_n_f32(0.0f), block);
+	return x ? vaddq_f32(accum, block) : block;
+}
+
+static FORCE_INLINE inline void convolution_v_scanline_neon(int N, enum ConvolutionInput input, const float * RESTRICT filter, int filter_width, const float * RESTRICT src1, const float * RESTRICT src2, float * RESTRICT dst, int src1_stride, int src2_stride, int j_end)
+{
+	const int fw = N ? N : filter_width;
+	const bool unrolled = N == 5 || N == 9 || N == 17;
+	float32x4_t f[17];
+
+#pragma GCC unroll 17
+	for (int k = 0; k < N; ++k)
+		f[k] = vdupq_n_f32(filter[k]);
+
+	src1 -= fw / 2 * src1_stride;
+	if (input == CONVOLUTION_INPUT_XY)
+		src2 -= fw / 2 * src2_stride;
+
+	for (int j = 0; j < j_end; j += 4) {
+		float32x4_t accum = vdupq_n_f32(0.0f);
+
+#pragma GCC unroll 2
+		for (int x = 0; x < fw; x += 9) {
+			const int n = fw - x < 9 ? fw - x : 9;
+			float32x4_t p[9];
+
+#pragma GCC unroll 9
+			for (int t = 0; t < n; ++t) {
+				const int k = x + t;
+				float32x4_t g = vld1q_f32(src1 + k * src1_stride + j);
+				if (input == CONVOLUTION_INPUT_SQ)
+					g = vmulq_f32(g, g);
+				else if (input == CONVOLUTION_INPUT_XY)
+					g = vmulq_f32(g, vld1q_f32(src2 + k * src2_stride + j));
+				p[t] = vmulq_f32(N ? f[k] : vdupq_n_f32(filter[k]), g);
+			}
+
+			accum = convolution_accum_neon(unrolled, false, x, accum, convolution_block_neon(unrolled, p, n));
+		}
+
+		vst1q_f32(dst + j, accum);
+	}
+}
+
+static FORCE_INLINE inline void convolution_h_scanline_neon(int N, const float * RESTRICT filter, int filter_width, const float * RESTRICT src, float * RESTRICT dst, int j_end)
+{
+	const int fw = N ? N : filter_width;
+	const bool unrolled = N == 5 || N == 9 || N == 17;
+	float32x4_t f[17];
+
+#pragma GCC unroll 17
+	for (int k = 0; k < N; ++k)
+		f[k] = vdupq_n_f32(filter[k]);
+
+	for (int j = 0; j < j_end; j += 4) {
+		float32x4_t accum = vdupq_n_f32(0.0f);
+
+#pragma GCC unroll 2
+		for (int x = 0; x < fw; x += 9) {
+			const int n = fw - x < 9 ? fw - x : 9;
+			float32x4_t p[9];
+
+#pragma GCC unroll 9
+			for (int t = 0; t < n; ++t) {
+				const int k = x + t;
+				const float32x4_t g = vld1q_f32(src + j + k);
+				p[t] = vmulq_f32(N ? f[k] : vdupq_n_f32(filter[k]), g);
+			}
+
+			accum = convolution_accum_neon(unrolled, true, x, accum, convolution_block_neon(unrolled, p, n));
+		}
+
+		vst1q_f32(dst + j + fw / 2, accum);
+	}
+}
+
+#define CONVOLUTION_SCANLINES_AVX512(N) \
+static void convolution_v_scanline_##N##_neon(const float *filter, int filter_width, const float *src1, const float *src2, float *dst, int src1_stride, int src2_stride, int j_end) \
+{ \
+	convolution_v_scanline_neon(N, CONVOLUTION_INPUT_SRC, filter, filter_width, src1, src2, dst, src1_stride, src2_stride, j_end); \
+} \
+static void convolution_v_sq_scanline_##N##_neon(const float *filter, int filter_width, const float *src1, const float *src2, float *dst, int src1_stride, int src2_stride, int j_end) \
+{ \
+	convolution_v_scanline_neon(N, CONVOLUTION_INPUT_SQ, filter, filter_width, src1, src2, dst, src1_stride, src2_stride, j_end); \
+} \
+static void convolution_v_xy_scanline_##N##_neon(const float *filter, int filter_width, const float *src1, const float *src2, float *dst, int src1_stride, int src2_stride, int j_end) \
+{ \
+	convolution_v_scanline_neon(N, CONVOLUTION_INPUT_XY, filter, filter_width, src1, src2, dst, src1_stride, src2_stride, j_end); \
+} \
+static void convolution_h_scanline_##N##_neon(const float *filter, int filter_width, const float *src, float *dst, int j_end) \
+{ \
+	convolution_h_scanline_neon(N, filter, filter_width, src, dst, j_end); \
+} \
+static const ConvolutionScanlines convolution_scanlines_##N##_neon = { \
+	.v = { \
+		[CONVOLUTION_INPUT_SRC] = convolution_v_scanline_##N##_neon, \
+		[CONVOLUTION_INPUT_SQ] = convolution_v_sq_scanline_##N##_neon, \
+		[CONVOLUTION_INPUT_XY] = convolution_v_xy_scanline_##N##_neon, \
+	}, \
+	.h = convolution_h_scanline_##N##_neon, \
+};
+
+CONVOLUTION_SCANLINES_AVX512(0)
+CONVOLUTION_SCANLINES_AVX512(3)
+CONVOLUTION_SCANLINES_AVX512(5)
+CONVOLUTION_SCANLINES_AVX512(9)
+CONVOLUTION_SCANLINES_AVX512(17)
+
+static const ConvolutionScanlines *convolution_scanlines_neon(int filter_width)
+{
+	switch (filter_width) {
+	case 17:
+		return &convolution_scanlines_17_neon;
+	case 9:
+		return &convolution_scanlines_9_neon;
+	case 5:
+		return &convolution_scanlines_5_neon;
+	case 3:
+		return &convolution_scanlines_3_neon;
+	default:
+		return &convolution_scanlines_0_neon;
+	}
+}
+
+void convolution_f32_neon_s(const float *filter, int filter_width, const float *src, float *dst, float *tmp, int width, int height, int src_stride, int dst_stride)
+{
+	convolution_scanlines_s(convolution_scanlines_neon(filter_width), CONVOLUTION_INPUT_SRC, filter, filter_width, src, NULL, dst, tmp, width, height, src_stride, 0, dst_stride);
+}
+
+void convolution_f32_neon_sq_s(const float *filter, int filter_width, const float *src, float *dst, float *tmp, int width, int height, int src_stride, int dst_stride)
+{
+	convolution_scanlines_s(convolution_scanlines_neon(filter_width), CONVOLUTION_INPUT_SQ, filter, filter_width, src, NULL, dst, tmp, width, height, src_stride, 0, dst_stride);
+}
+
+void convolution_f32_neon_xy_s(const float *filter, int filter_width, const float *src1, const float *src2, float *dst, float *tmp, int width, int height, int src1_stride, int src2_stride, int dst_stride)
+{
+	convolution_scanlines_s(convolution_scanlines_neon(filter_width), CONVOLUTION_INPUT_XY, filter, filter_width, src1, src2, dst, tmp, width, height, src1_stride, src2_stride, dst_stride);
+}
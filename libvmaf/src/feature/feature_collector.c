@@ -407,6 +407,48 @@ int vmaf_feature_collector_append_with_dict(VmafFeatureCollector *fc,
     return vmaf_feature_collector_append(fc, fn, score, index);
 }
 
+int vmaf_feature_collector_merge(VmafFeatureCollector *dst,
+                                 VmafFeatureCollector *src,
+                                 unsigned index_low, unsigned index_high)
+{
+    if (!dst) return -EINVAL;
+    if (!src) return -EINVAL;
+    if (dst == src) return -EINVAL;
+    if (index_low > index_high) return -EINVAL;
+
+    pthread_mutex_lock(&(src->lock));
+    int err = 0;
+
+    // aggregates are computed over every picture a collector has seen, and
+    // can not be restricted to [index_low, index_high]
+    if (src->aggregate_vector.cnt) {
+        err = -ENOTSUP;
+        goto unlock;
+    }
+
+    for (unsigned i = 0; i < src->cnt; i++) {
+        FeatureVector *fv = src->feature_vector[i];
+        for (unsigned j = index_low; j <= index_high && j < fv->capacity; j++) {
+            if (!fv->score[j].written) continue;
+            err = vmaf_feature_collector_append(dst, fv->name,
+                                                fv->score[j].value, j);
+            if (err) goto unlock;
+        }
+    }
+
+    pthread_mutex_lock(&(dst->lock));
+    if (src->timer.begin &&
+        (!dst->timer.begin || src->timer.begin < dst->timer.begin))
+        dst->timer.begin = src->timer.begin;
+    if (src->timer.end > dst->timer.end)
+        dst->timer.end = src->timer.end;
+    pthread_mutex_unlock(&(dst->lock));
+
+unlock:
+    pthread_mutex_unlock(&(src->lock));
+    return err;
+}
+
 int vmaf_feature_collector_get_score(VmafFeatureCollector *feature_collector,
                                      const char *feature_name, double *score,
                                      unsigned index)
@@ -86,6 +86,10 @@ int vmaf_feature_collector_get_aggregate(VmafFeatureCollector *feature_collector
                                          const char *feature_name,
                                          double *score);
 
+int vmaf_feature_collector_merge(VmafFeatureCollector *dst,
+                                 VmafFeatureCollector *src,
+                                 unsigned index_low, unsigned index_high);
+
 void vmaf_feature_collector_destroy(VmafFeatureCollector *feature_collector);
 
 #endif /* __VMAF_FEATURE_COLLECTOR_H__ */
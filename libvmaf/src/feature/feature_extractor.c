@@ -17,6 +17,7 @@
  */
 
 #include <errno.h>
+#include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
 #include <stdlib.h>
@@ -25,6 +26,7 @@
 #include "feature_extractor.h"
 #include "feature_name.h"
 #include "log.h"
+#include "mem.h"
 #include "picture.h"
 
 #ifdef HAVE_CUDA
@@ -175,8 +177,10 @@ int vmaf_feature_extractor_context_init(VmafFeatureExtractorContext *fex_ctx,
     if (!pix_fmt) return -EINVAL;
 
     if (fex_ctx->fex->init && !fex_ctx->is_initialized) {
+        const size_t allocated = aligned_malloc_thread_total();
         int err = fex_ctx->fex->init(fex_ctx->fex, pix_fmt, bpc, w, h);
         if (err) return err;
+        fex_ctx->init_sz = aligned_malloc_thread_total() - allocated;
     }
 
     fex_ctx->is_initialized = true;
@@ -279,6 +283,175 @@ int vmaf_feature_extractor_context_destroy(VmafFeatureExtractorContext *fex_ctx)
     return 0;
 }
 
+static const VmafOption *find_option(const VmafOption *opts, const char *name)
+{
+    if (!opts || !name) return NULL;
+
+    for (unsigned i = 0; opts[i].name; i++) {
+        if (!strcmp(opts[i].name, name))
+            return &opts[i];
+    }
+    return NULL;
+}
+
+static int add_variant(double *val, unsigned *cnt, unsigned max_cnt, double v)
+{
+    for (unsigned i = 0; i < *cnt; i++) {
+        if (val[i] == v) return 0;
+    }
+    if (*cnt >= max_cnt) return -EINVAL;
+    val[(*cnt)++] = v;
+    return 0;
+}
+
+static int parse_variant_list(const VmafOption *opt, const char *list,
+                              double *val, unsigned *cnt, unsigned max_cnt)
+{
+    if (!list) return 0;
+
+    const char *p = list;
+    while (*p) {
+        char *end = NULL;
+        const double v = strtod(p, &end);
+        if (end == p) return -EINVAL;
+        if (v < opt->min || v > opt->max) return -EINVAL;
+        int err = add_variant(val, cnt, max_cnt, v);
+        if (err) return err;
+        p = end;
+        if (*p == ',') p++;
+        else if (*p) return -EINVAL;
+    }
+    return 0;
+}
+
+static bool option_equal(const VmafOption *opt, const void *obj_a,
+                         const void *obj_b)
+{
+    const void *a = (const uint8_t *)obj_a + opt->offset;
+    const void *b = (const uint8_t *)obj_b + opt->offset;
+
+    switch (opt->type) {
+    case VMAF_OPT_TYPE_BOOL:
+        return *(const bool *)a == *(const bool *)b;
+    case VMAF_OPT_TYPE_INT:
+        return *(const int *)a == *(const int *)b;
+    case VMAF_OPT_TYPE_DOUBLE:
+        return *(const double *)a == *(const double *)b;
+    case VMAF_OPT_TYPE_STRING: {
+        const char *str_a = *(char *const *)a, *str_b = *(char *const *)b;
+        if (!str_a || !str_b) return str_a == str_b;
+        return !strcmp(str_a, str_b);
+    }
+    default:
+        return false;
+    }
+}
+
+int vmaf_feature_extractor_context_merge(VmafFeatureExtractorContext *dst,
+                                         VmafFeatureExtractorContext *src)
+{
+    if (!dst) return -EINVAL;
+    if (!src) return -EINVAL;
+    if (dst->is_initialized || src->is_initialized) return -EINVAL;
+
+    VmafFeatureExtractor *fex = dst->fex;
+    if (!fex->variant.option) return -EINVAL;
+    if (strcmp(fex->name, src->fex->name)) return -EINVAL;
+    if (!fex->priv || !src->fex->priv) return -EINVAL;
+
+    const VmafOption *opt = find_option(fex->options, fex->variant.option);
+    if (!opt || opt->type != VMAF_OPT_TYPE_DOUBLE) return -EINVAL;
+    const VmafOption *list_opt =
+        find_option(fex->options, fex->variant.list_option);
+    if (!list_opt || list_opt->type != VMAF_OPT_TYPE_STRING) return -EINVAL;
+
+    double *dst_opt = (double *)((uint8_t *)fex->priv + opt->offset);
+    double *src_opt = (double *)((uint8_t *)src->fex->priv + opt->offset);
+    const char *dst_list = *(char **)((uint8_t *)fex->priv + list_opt->offset);
+    const char *src_list =
+        *(char **)((uint8_t *)src->fex->priv + list_opt->offset);
+
+    // every other option has to match
+    for (const VmafOption *o = fex->options; o->name; o++) {
+        if (o == opt || o == list_opt) continue;
+        if (!option_equal(o, fex->priv, src->fex->priv)) return -EINVAL;
+    }
+
+    const unsigned max_cnt = fex->variant.max_cnt;
+    double *val = malloc(sizeof(*val) * max_cnt);
+    if (!val) return -ENOMEM;
+
+    unsigned cnt = 0;
+    int err = add_variant(val, &cnt, max_cnt, *dst_opt);
+    err |= parse_variant_list(opt, dst_list, val, &cnt, max_cnt);
+    const unsigned dst_cnt = cnt;
+    err |= add_variant(val, &cnt, max_cnt, *src_opt);
+    err |= parse_variant_list(opt, src_list, val, &cnt, max_cnt);
+    if (err || cnt == dst_cnt) goto free_val;
+
+    const size_t buf_sz = 32 * max_cnt;
+    char *buf = malloc(buf_sz);
+    if (!buf) {
+        err = -ENOMEM;
+        goto free_val;
+    }
+    size_t len = 0;
+    for (unsigned i = 1; i < cnt; i++) {
+        len += snprintf(buf + len, buf_sz - len, "%s%.17g",
+                        i > 1 ? "," : "", val[i]);
+    }
+
+    err = vmaf_dictionary_set(&dst->opts_dict, list_opt->name, buf, 0);
+    free(buf);
+    if (err) goto free_val;
+    // string options point into opts_dict, parse them again
+    err = vmaf_fex_ctx_parse_options(dst);
+
+free_val:
+    free(val);
+    return err;
+}
+
+int vmaf_feature_extractor_variants(VmafFeatureExtractor *fex, double *val,
+                                    VmafDictionary **feature_name_dict)
+{
+    if (!fex) return -EINVAL;
+    if (!fex->priv) return -EINVAL;
+    if (!val) return -EINVAL;
+    if (!feature_name_dict) return -EINVAL;
+
+    const VmafOption *opt = find_option(fex->options, fex->variant.option);
+    if (!opt || opt->type != VMAF_OPT_TYPE_DOUBLE) return -EINVAL;
+    const VmafOption *list_opt =
+        find_option(fex->options, fex->variant.list_option);
+    if (!list_opt || list_opt->type != VMAF_OPT_TYPE_STRING) return -EINVAL;
+
+    double *opt_val = (double *)((uint8_t *)fex->priv + opt->offset);
+    const char *list = *(char **)((uint8_t *)fex->priv + list_opt->offset);
+
+    unsigned cnt = 0;
+    int err = add_variant(val, &cnt, fex->variant.max_cnt, *opt_val);
+    err |= parse_variant_list(opt, list, val, &cnt, fex->variant.max_cnt);
+    if (err) return -EINVAL;
+
+    const double opt_val_orig = *opt_val;
+    for (unsigned i = 0; i < cnt; i++) {
+        *opt_val = val[i];
+        feature_name_dict[i] =
+            vmaf_feature_name_dict_from_provided_features(fex->provided_features,
+                                                          fex->options,
+                                                          fex->priv);
+        if (!feature_name_dict[i]) {
+            while (i--) vmaf_dictionary_free(&feature_name_dict[i]);
+            *opt_val = opt_val_orig;
+            return -ENOMEM;
+        }
+    }
+    *opt_val = opt_val_orig;
+
+    return cnt;
+}
+
 int vmaf_fex_ctx_pool_create(VmafFeatureExtractorContextPool **pool,
                              unsigned n_threads)
 {
@@ -307,6 +480,76 @@ fail:
     return -ENOMEM;
 }
 
+static unsigned fex_list_entry_limit(VmafFeatureExtractorContextPool *pool,
+                                     struct fex_list_entry *entry)
+{
+    const unsigned capacity = atomic_load(&entry->capacity);
+    if (!pool->mem_budget || capacity == 1)
+        return capacity;
+    if (!entry->ctx_sz)
+        return 1;
+
+    // temporal feature extractors always have their one context, every
+    // other feature extractor gets the same number of contexts
+    size_t fixed_sz = 0, per_thread_sz = 0;
+    for (unsigned i = 0; i < pool->cnt; i++) {
+        struct fex_list_entry *e = &pool->fex_list[i];
+        if (atomic_load(&e->capacity) == 1)
+            fixed_sz += e->ctx_sz;
+        else
+            per_thread_sz += e->ctx_sz;
+    }
+
+    if (fixed_sz >= pool->mem_budget) return 1;
+    const size_t n = (pool->mem_budget - fixed_sz) / per_thread_sz;
+    return n < 1 ? 1 : n > capacity ? capacity : n;
+}
+
+static void fex_list_entry_trim(struct fex_list_entry *entry)
+{
+    for (int i = 0; i < atomic_load(&entry->capacity); i++) {
+        if (entry->ctx_cnt <= entry->limit) return;
+        VmafFeatureExtractorContext *fex_ctx = entry->ctx_list[i].fex_ctx;
+        if (!fex_ctx || entry->ctx_list[i].in_use) continue;
+        vmaf_feature_extractor_context_close(fex_ctx);
+        vmaf_feature_extractor_context_destroy(fex_ctx);
+        entry->ctx_list[i].fex_ctx = NULL;
+        entry->ctx_cnt--;
+    }
+}
+
+static void update_limits(VmafFeatureExtractorContextPool *pool)
+{
+    for (unsigned i = 0; i < pool->cnt; i++) {
+        struct fex_list_entry *entry = &pool->fex_list[i];
+        const unsigned limit = fex_list_entry_limit(pool, entry);
+        if (limit == entry->limit) continue;
+
+        if (entry->ctx_sz) {
+            vmaf_log(VMAF_LOG_LEVEL_DEBUG,
+                     "%s: up to %u context%s of %zu bytes\n",
+                     entry->fex->name, limit, limit == 1 ? "" : "s",
+                     entry->ctx_sz);
+        }
+        if (limit > entry->limit)
+            pthread_cond_broadcast(&(entry->full));
+        entry->limit = limit;
+        fex_list_entry_trim(entry);
+    }
+}
+
+int vmaf_fex_ctx_pool_set_mem_budget(VmafFeatureExtractorContextPool *pool,
+                                     size_t mem_budget)
+{
+    if (!pool) return -EINVAL;
+
+    pthread_mutex_lock(&(pool->lock));
+    pool->mem_budget = mem_budget;
+    update_limits(pool);
+    pthread_mutex_unlock(&(pool->lock));
+    return 0;
+}
+
 static struct fex_list_entry*
 get_fex_list_entry(VmafFeatureExtractorContextPool *pool,
                    VmafFeatureExtractor *fex, VmafDictionary *opts_dict)
@@ -347,7 +590,9 @@ get_fex_list_entry(VmafFeatureExtractorContextPool *pool,
     }
 
     pool->fex_list[pool->cnt] = entry;
-    return &pool->fex_list[pool->cnt++];
+    struct fex_list_entry *e = &pool->fex_list[pool->cnt++];
+    e->limit = fex_list_entry_limit(pool, e);
+    return e;
 
 free_ctx_list:
     free(entry.ctx_list);
@@ -373,28 +618,38 @@ int vmaf_fex_ctx_pool_aquire(VmafFeatureExtractorContextPool *pool,
         goto unlock;
     }
 
-    while (atomic_load(&entry->capacity) == atomic_load(&entry->in_use))
+    while ((unsigned) atomic_load(&entry->in_use) >= entry->limit)
         pthread_cond_wait(&(entry->full), &(pool->lock));
 
+    // reuse an idle context, create one only if all of them are in use
+    int slot = -1;
     for (int i = 0; i < atomic_load(&entry->capacity); i++) {
-        VmafFeatureExtractorContext *f = entry->ctx_list[i].fex_ctx;
-        if (!f) {
-            VmafDictionary *d = NULL;
-            if (opts_dict) {
-                err = vmaf_dictionary_copy(&opts_dict, &d);
-                if (err) return err;
-            }
-            err = vmaf_feature_extractor_context_create(&f, entry->fex, d);
-            if (err) goto unlock;
-            if (f->fex->flags & VMAF_FEATURE_FRAME_SYNC)
-                f->fex->framesync = (fex->framesync);
+        if (!entry->ctx_list[i].fex_ctx) {
+            if (slot < 0) slot = i;
+            continue;
         }
         if (!entry->ctx_list[i].in_use) {
-            entry->ctx_list[i].fex_ctx = *fex_ctx = f;
-            entry->ctx_list[i].in_use = true;
+            slot = i;
             break;
         }
     }
+
+    VmafFeatureExtractorContext *f = entry->ctx_list[slot].fex_ctx;
+    if (!f) {
+        VmafDictionary *d = NULL;
+        if (opts_dict) {
+            err = vmaf_dictionary_copy(&opts_dict, &d);
+            if (err) goto unlock;
+        }
+        err = vmaf_feature_extractor_context_create(&f, entry->fex, d);
+        if (err) goto unlock;
+        if (f->fex->flags & VMAF_FEATURE_FRAME_SYNC)
+            f->fex->framesync = (fex->framesync);
+        entry->ctx_list[slot].fex_ctx = f;
+        entry->ctx_cnt++;
+    }
+    entry->ctx_list[slot].in_use = true;
+    *fex_ctx = f;
     atomic_fetch_add(&entry->in_use, 1);
 
 unlock:
@@ -433,6 +688,12 @@ int vmaf_fex_ctx_pool_release(VmafFeatureExtractorContextPool *pool,
             entry->ctx_list[i].in_use = false;
             atomic_fetch_sub(&entry->in_use, 1);
             pthread_cond_signal(&(entry->full));
+            if (!entry->ctx_sz && fex_ctx->is_initialized) {
+                entry->ctx_sz = sizeof(*fex_ctx) + sizeof(*fex) +
+                                fex->priv_size + fex_ctx->init_sz;
+                update_limits(pool);
+            }
+            fex_list_entry_trim(entry);
             goto unlock;
         }
     }
@@ -91,6 +91,27 @@ typedef struct VmafFeatureExtractor {
     size_t priv_size; ///< sizeof private data.
     uint64_t flags; ///< Feauture extraction flags, binary or'd.
     const char **provided_features; ///< Provided feature list, NULL terminated.
+    /**
+     * Optional. Names of the picture artifacts (see picture.h) this feature
+     * extractor fetches, NULL terminated. When several feature extractors
+     * fetch the same artifact of a picture, the framework attaches an
+     * artifact cache to the picture and declares their artifacts, so that
+     * each shared artifact is produced only once. Feature extractors check
+     * vmaf_picture_artifact_shared() before going through the cache.
+     */
+    const char **artifacts;
+    /**
+     * Optional. Some feature extractors can compute several variants of
+     * their features, which only differ in the value of one double option,
+     * from one shared set of intermediates. Contexts which only differ in
+     * this option are merged at registration. The values of the merged
+     * contexts are passed as a comma separated list through a string option.
+     */
+    struct {
+        const char *option; ///< VMAF_OPT_FLAG_FEATURE_PARAM option.
+        const char *list_option; ///< Additional values of `option`.
+        unsigned max_cnt; ///< Maximum number of variants, including `option`.
+    } variant;
 
     #ifdef HAVE_CUDA
     VmafCudaState *cu_state; ///< VmafCudaState, set by framework
@@ -112,6 +133,7 @@ typedef struct VmafFeatureExtractorContext {
     bool is_initialized, is_closed;
     VmafDictionary *opts_dict;
     VmafFeatureExtractor *fex;
+    size_t init_sz; ///< Bytes aligned_malloc()'d by fex->init().
 } VmafFeatureExtractorContext;
 
 int vmaf_feature_extractor_context_create(VmafFeatureExtractorContext **fex_ctx,
@@ -137,6 +159,40 @@ int vmaf_feature_extractor_context_delete(VmafFeatureExtractorContext *fex_ctx);
 
 int vmaf_feature_extractor_context_destroy(VmafFeatureExtractorContext *fex_ctx);
 
+/**
+ * Merge `src` into `dst` if both use the same feature extractor, with options
+ * which only differ in fex->variant.option. On success, the values of `src`
+ * are added to the variant list of `dst`, and `src` is no longer needed.
+ *
+ * @return 0 if merged, or a negative error code if the contexts can not be
+ *         merged.
+ */
+int vmaf_feature_extractor_context_merge(VmafFeatureExtractorContext *dst,
+                                         VmafFeatureExtractorContext *src);
+
+/**
+ * Collect the variants of a feature extractor: the value of
+ * fex->variant.option, followed by the values of fex->variant.list_option.
+ * A feature name dictionary is built for each variant.
+ *
+ * @param               fex self, with options already parsed.
+ * @param               val variant values, at least fex->variant.max_cnt.
+ * @param feature_name_dict feature name dictionaries, one per variant.
+ *
+ * @return number of variants, or a negative error code.
+ */
+int vmaf_feature_extractor_variants(VmafFeatureExtractor *fex, double *val,
+                                    VmafDictionary **feature_name_dict);
+
+/**
+ * Contexts are created on demand, when all existing contexts of a feature
+ * extractor are in use. Every feature extractor runs once per frame, so
+ * without a memory budget each may have up to n_threads contexts. With a
+ * memory budget, the size of a context is measured once the first one is
+ * initialized, and each non-temporal feature extractor may have as many
+ * contexts as fit into the budget for all of them, but at least one.
+ * Idle contexts above that limit are destroyed.
+ */
 typedef struct VmafFeatureExtractorContextPool {
     struct fex_list_entry {
         VmafFeatureExtractor *fex;
@@ -146,16 +202,23 @@ typedef struct VmafFeatureExtractorContextPool {
             bool in_use;
         } *ctx_list;
         atomic_int capacity, in_use;
+        unsigned ctx_cnt; ///< Contexts created, at most `limit` when idle.
+        unsigned limit; ///< Contexts which may be in use at once.
+        size_t ctx_sz; ///< Measured size of a context, 0 until known.
         pthread_cond_t full;
     } *fex_list;
     unsigned cnt, capacity;
     pthread_mutex_t lock;
     unsigned n_threads;
+    size_t mem_budget;
 } VmafFeatureExtractorContextPool;
 
 int vmaf_fex_ctx_pool_create(VmafFeatureExtractorContextPool **pool,
                              unsigned n_threads);
 
+int vmaf_fex_ctx_pool_set_mem_budget(VmafFeatureExtractorContextPool *pool,
+                                     size_t mem_budget);
+
 int vmaf_fex_ctx_pool_aquire(VmafFeatureExtractorContextPool *pool,
                              VmafFeatureExtractor *fex,
                              VmafDictionary *opts_dict,
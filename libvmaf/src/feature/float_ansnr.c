@@ -81,11 +81,13 @@ static int extract(VmafFeatureExtractor *fex,
     (void) ref_pic_90;
     (void) dist_pic_90;
 
-    picture_copy(s->ref, s->float_stride, ref_pic, -128, ref_pic->bpc);
-    picture_copy(s->dist, s->float_stride, dist_pic, -128, dist_pic->bpc);
+    const float *ref =
+        picture_copy_shared(s->ref, s->float_stride, ref_pic, -128);
+    const float *dist =
+        picture_copy_shared(s->dist, s->float_stride, dist_pic, -128);
 
     double score, score_psnr;
-    err = compute_ansnr(s->ref, s->dist, ref_pic->w[0], ref_pic->h[0],
+    err = compute_ansnr(ref, dist, ref_pic->w[0], ref_pic->h[0],
                         s->float_stride, s->float_stride, &score, &score_psnr,
                         s->peak, s->psnr_max);
 
@@ -112,6 +114,11 @@ static const char *provided_features[] = {
         NULL
 };
 
+static const char *artifacts[] = {
+        PICTURE_COPY_ARTIFACT(-128),
+        NULL
+};
+
 VmafFeatureExtractor vmaf_fex_float_ansnr = {
         .name = "float_ansnr",
         .init = init,
@@ -119,4 +126,5 @@ VmafFeatureExtractor vmaf_fex_float_ansnr = {
         .close = close,
         .priv_size = sizeof(AnsnrState),
         .provided_features = provided_features,
+        .artifacts = artifacts,
 };
@@ -65,20 +65,22 @@ static int extract(VmafFeatureExtractor *fex,
     (void) ref_pic_90;
     (void) dist_pic_90;
 
-    picture_copy(s->ref, s->float_stride, ref_pic, 0, ref_pic->bpc);
-    picture_copy(s->dist, s->float_stride, dist_pic, 0, dist_pic->bpc);
+    const float *ref =
+        picture_copy_shared(s->ref, s->float_stride, ref_pic, 0);
+    const float *dist =
+        picture_copy_shared(s->dist, s->float_stride, dist_pic, 0);
 
     double score[4];
-    err = compute_1st_moment(s->ref, ref_pic->w[0], ref_pic->h[0],
+    err = compute_1st_moment(ref, ref_pic->w[0], ref_pic->h[0],
                              s->float_stride, &score[0]);
     if (err) return err;
-    err = compute_1st_moment(s->dist, dist_pic->w[0], dist_pic->h[0],
+    err = compute_1st_moment(dist, dist_pic->w[0], dist_pic->h[0],
                              s->float_stride, &score[1]);
     if (err) return err;
-    err = compute_2nd_moment(s->ref, ref_pic->w[0], ref_pic->h[0],
+    err = compute_2nd_moment(ref, ref_pic->w[0], ref_pic->h[0],
                              s->float_stride, &score[2]);
     if (err) return err;
-    err = compute_2nd_moment(s->dist, dist_pic->w[0], dist_pic->h[0],
+    err = compute_2nd_moment(dist, dist_pic->w[0], dist_pic->h[0],
                              s->float_stride, &score[3]);
     if (err) return err;
 
@@ -115,6 +117,11 @@ static const char *provided_features[] = {
     NULL
 };
 
+static const char *artifacts[] = {
+    PICTURE_COPY_ARTIFACT(0),
+    NULL
+};
+
 VmafFeatureExtractor vmaf_fex_float_moment = {
     .name = "float_moment",
     .init = init,
@@ -122,4 +129,5 @@ VmafFeatureExtractor vmaf_fex_float_moment = {
     .close = close,
     .priv_size = sizeof(MomentState),
     .provided_features = provided_features,
+    .artifacts = artifacts,
 };
@@ -27,6 +27,7 @@
 #include "mem.h"
 #include "motion.h"
 #include "motion_tools.h"
+#include "picture.h"
 
 #include "picture_copy.h"
 
@@ -146,11 +147,19 @@ static int extract(VmafFeatureExtractor *fex,
     unsigned blur_idx_1 = (index + 1) % 3;
     unsigned blur_idx_2 = (index + 2) % 3;
 
-    picture_copy(s->ref, s->float_stride, ref_pic, -128, ref_pic->bpc);
-    convolution_f32_c_s(FILTER_5_s, 5, s->ref, s->blur[blur_idx_0], s->tmp,
-                        ref_pic->w[0], ref_pic->h[0],
-                        s->float_stride / sizeof(float),
-                        s->float_stride / sizeof(float));
+    if (vmaf_picture_artifact_shared(ref_pic, PICTURE_COPY_ARTIFACT(-128))) {
+        const float *ref =
+            picture_copy_shared(s->ref, s->float_stride, ref_pic, -128);
+        convolution_f32_c_s(FILTER_5_s, 5, ref, s->blur[blur_idx_0], s->tmp,
+                            ref_pic->w[0], ref_pic->h[0],
+                            s->float_stride / sizeof(float),
+                            s->float_stride / sizeof(float));
+    } else {
+        // nobody shares the converted picture, convert while filtering
+        picture_copy_convolution(FILTER_5_s, 5, ref_pic, -128,
+                                 s->blur[blur_idx_0], s->tmp,
+                                 s->float_stride);
+    }
 
     if (index == 0) {
         err = vmaf_feature_collector_append(feature_collector,
@@ -214,6 +223,11 @@ static const char *provided_features[] = {
     NULL
 };
 
+static const char *artifacts[] = {
+    PICTURE_COPY_ARTIFACT(-128),
+    NULL
+};
+
 VmafFeatureExtractor vmaf_fex_float_motion = {
     .name = "float_motion",
     .init = init,
@@ -223,5 +237,6 @@ VmafFeatureExtractor vmaf_fex_float_motion = {
     .close = close,
     .priv_size = sizeof(MotionState),
     .provided_features = provided_features,
+    .artifacts = artifacts,
     .flags = VMAF_FEATURE_EXTRACTOR_TEMPORAL,
 };
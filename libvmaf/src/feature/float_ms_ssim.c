@@ -28,9 +28,7 @@
 #include "picture_copy.h"
 
 typedef struct MsSsimState {
-    size_t float_stride;
-    float *ref;
-    float *dist;
+    MsSsimBuffer buf;
     bool enable_lcs;
     bool enable_db;
     bool clip_db;
@@ -77,18 +75,7 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
         s->max_db = INFINITY;
     }
 
-    s->float_stride = ALIGN_CEIL(w * sizeof(float));
-    s->ref = aligned_malloc(s->float_stride * h, 32);
-    if (!s->ref) goto fail;
-    s->dist = aligned_malloc(s->float_stride * h, 32);
-    if (!s->dist) goto free_ref;
-
-    return 0;
-
-free_ref:
-    free(s->ref);
-fail:
-    return -ENOMEM;
+    return ms_ssim_buffer_init(&s->buf, w, h);
 }
 
 #define MIN(x, y) (((x) < (y)) ? (x) : (y))
@@ -109,13 +96,14 @@ static int extract(VmafFeatureExtractor *fex,
     (void) ref_pic_90;
     (void) dist_pic_90;
 
-    picture_copy(s->ref, s->float_stride, ref_pic, 0, ref_pic->bpc);
-    picture_copy(s->dist, s->float_stride, dist_pic, 0, dist_pic->bpc);
+    /* the first scale of the pyramid is written in place */
+    const ptrdiff_t stride = s->buf.stride[0] * sizeof(float);
+    picture_copy(s->buf.ref[0], stride, ref_pic, 0, ref_pic->bpc);
+    picture_copy(s->buf.cmp[0], stride, dist_pic, 0, dist_pic->bpc);
 
-    double score, l_scores[5], c_scores[5], s_scores[5];
-    err = compute_ms_ssim(s->ref, s->dist, ref_pic->w[0], ref_pic->h[0],
-                          s->float_stride, s->float_stride,
-                          &score, l_scores, c_scores, s_scores);
+    double score, l_scores[MS_SSIM_SCALES], c_scores[MS_SSIM_SCALES],
+           s_scores[MS_SSIM_SCALES];
+    err = compute_ms_ssim(&s->buf, &score, l_scores, c_scores, s_scores);
     if (err) return err;
 
     if (s->enable_db)
@@ -164,8 +152,7 @@ static int extract(VmafFeatureExtractor *fex,
 static int close(VmafFeatureExtractor *fex)
 {
     MsSsimState *s = fex->priv;
-    if (s->ref) aligned_free(s->ref);
-    if (s->dist) aligned_free(s->dist);
+    ms_ssim_buffer_free(&s->buf);
     return 0;
 }
 
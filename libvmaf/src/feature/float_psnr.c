@@ -81,11 +81,13 @@ static int extract(VmafFeatureExtractor *fex,
     (void) ref_pic_90;
     (void) dist_pic_90;
 
-    picture_copy(s->ref, s->float_stride, ref_pic, 0, ref_pic->bpc);
-    picture_copy(s->dist, s->float_stride, dist_pic, 0, dist_pic->bpc);
+    const float *ref =
+        picture_copy_shared(s->ref, s->float_stride, ref_pic, 0);
+    const float *dist =
+        picture_copy_shared(s->dist, s->float_stride, dist_pic, 0);
 
     double score;
-    err = compute_psnr(s->ref, s->dist, ref_pic->w[0], ref_pic->h[0],
+    err = compute_psnr(ref, dist, ref_pic->w[0], ref_pic->h[0],
                        s->float_stride, s->float_stride, &score,
                        s->peak, s->psnr_max);
 
@@ -109,6 +111,11 @@ static const char *provided_features[] = {
     NULL
 };
 
+static const char *artifacts[] = {
+    PICTURE_COPY_ARTIFACT(0),
+    NULL
+};
+
 VmafFeatureExtractor vmaf_fex_float_psnr = {
     .name = "float_psnr",
     .init = init,
@@ -116,4 +123,5 @@ VmafFeatureExtractor vmaf_fex_float_psnr = {
     .close = close,
     .priv_size = sizeof(PsnrState),
     .provided_features = provided_features,
+    .artifacts = artifacts,
 };
@@ -109,11 +109,13 @@ static int extract(VmafFeatureExtractor *fex,
     (void) ref_pic_90;
     (void) dist_pic_90;
 
-    picture_copy(s->ref, s->float_stride, ref_pic, 0, ref_pic->bpc);
-    picture_copy(s->dist, s->float_stride, dist_pic, 0, dist_pic->bpc);
+    const float *ref =
+        picture_copy_shared(s->ref, s->float_stride, ref_pic, 0);
+    const float *dist =
+        picture_copy_shared(s->dist, s->float_stride, dist_pic, 0);
 
     double score, l_score, c_score, s_score;
-    err = compute_ssim(s->ref, s->dist, ref_pic->w[0], ref_pic->h[0],
+    err = compute_ssim(ref, dist, ref_pic->w[0], ref_pic->h[0],
                        s->float_stride, s->float_stride,
                        &score, &l_score, &c_score, &s_score);
     if (err) return err;
@@ -148,6 +150,11 @@ static const char *provided_features[] = {
     NULL
 };
 
+static const char *artifacts[] = {
+    PICTURE_COPY_ARTIFACT(0),
+    NULL
+};
+
 VmafFeatureExtractor vmaf_fex_float_ssim = {
     .name = "float_ssim",
     .init = init,
@@ -156,4 +163,5 @@ VmafFeatureExtractor vmaf_fex_float_ssim = {
     .close = close,
     .priv_size = sizeof(SsimState),
     .provided_features = provided_features,
+    .artifacts = artifacts,
 };
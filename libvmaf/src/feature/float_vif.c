@@ -113,12 +113,14 @@ static int extract(VmafFeatureExtractor *fex,
     (void) ref_pic_90;
     (void) dist_pic_90;
 
-    picture_copy(s->ref, s->float_stride, ref_pic, -128, ref_pic->bpc);
-    picture_copy(s->dist, s->float_stride, dist_pic, -128, dist_pic->bpc);
+    const float *ref =
+        picture_copy_shared(s->ref, s->float_stride, ref_pic, -128);
+    const float *dist =
+        picture_copy_shared(s->dist, s->float_stride, dist_pic, -128);
 
     double score, score_num, score_den;
     double scores[8];
-    err = compute_vif(s->ref, s->dist, ref_pic->w[0], ref_pic->h[0],
+    err = compute_vif(ref, dist, ref_pic->w[0], ref_pic->h[0],
                       s->float_stride, s->float_stride,
                       &score, &score_num, &score_den, scores,
                       s->vif_enhn_gain_limit,
@@ -197,6 +199,11 @@ static const char *provided_features[] = {
     NULL
 };
 
+static const char *artifacts[] = {
+    PICTURE_COPY_ARTIFACT(-128),
+    NULL
+};
+
 VmafFeatureExtractor vmaf_fex_float_vif = {
     .name = "float_vif",
     .init = init,
@@ -205,4 +212,5 @@ VmafFeatureExtractor vmaf_fex_float_vif = {
     .close = close,
     .priv_size = sizeof(VifState),
     .provided_features = provided_features,
+    .artifacts = artifacts,
 };
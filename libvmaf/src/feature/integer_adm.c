@@ -16,6 +16,9 @@
  *
  */
 
+#include <pthread.h>
+#include <string.h>
+
 #include "cpu.h"
 #include "dict.h"
 #include "feature_collector.h"
@@ -23,25 +26,70 @@
 #include "feature_name.h"
 #include "integer_adm.h"
 #include "log.h"
+#include "picture.h"
 
 #if ARCH_X86
 #include "x86/adm_avx2.h"
+#if HAVE_AVX512
+#include "x86/adm_avx512.h"
+#endif
 #elif ARCH_AARCH64
 #include "arm64/adm_neon.h"
 #include <arm_neon.h>
 #endif
 
+/*
+ * div_lookup[32768 + d] holds 2^30 / d for -32768 <= d <= 32768. Built once
+ * and shared by all contexts, which may be initialized while others run.
+ */
+static int32_t div_lookup[65537];
+static pthread_once_t div_lookup_once = PTHREAD_ONCE_INIT;
+
+static void div_lookup_generator(void)
+{
+    const int32_t div_Q_factor = 1073741824; // 2^30
+    for (int i = 1; i <= 32768; ++i) {
+        int32_t recip = (int32_t)(div_Q_factor / i);
+        div_lookup[32768 + i] = recip;
+        div_lookup[32768 - i] = 0 - recip;
+    }
+}
+
 typedef struct AdmState {
     size_t integer_stride;
     AdmBuffer buf;
     bool debug;
     double adm_enhn_gain_limit;
+    char *adm_enhn_gain_limit_variants;
+    double enhn_gain_limit[ADM_MAX_ENHN_GAIN_LIMITS];
+    unsigned enhn_gain_limit_cnt;
     double adm_norm_view_dist;
     int adm_ref_display_height;
     void (*dwt2_8)(const uint8_t *src, const adm_dwt_band_t *dst,
                    AdmBuffer *buf, int w, int h, int src_stride,
                    int dst_stride);
-    VmafDictionary *feature_name_dict;
+    void (*dwt2_16)(const uint16_t *src, const adm_dwt_band_t *dst,
+                    AdmBuffer *buf, int w, int h, int src_stride,
+                    int dst_stride, int inp_size_bits);
+    void (*dwt2_s123_combined)(const int32_t *i4_ref_scale,
+                               const int32_t *i4_curr_dis, AdmBuffer *buf,
+                               int w, int h, int ref_stride, int dis_stride,
+                               int dst_stride, int scale);
+    void (*decouple)(AdmBuffer *buf, int w, int h, int stride,
+                     double adm_enhn_gain_limit);
+    void (*decouple_s123)(AdmBuffer *buf, int w, int h, int stride,
+                          double adm_enhn_gain_limit);
+    void (*csf)(AdmBuffer *buf, int w, int h, int stride,
+                double adm_norm_view_dist, int adm_ref_display_height);
+    void (*i4_csf)(AdmBuffer *buf, int scale, int w, int h, int stride,
+                   double adm_norm_view_dist, int adm_ref_display_height);
+    float (*cm)(AdmBuffer *buf, int w, int h, int src_stride,
+                int csf_a_stride, double adm_norm_view_dist,
+                int adm_ref_display_height);
+    float (*i4_cm)(AdmBuffer *buf, int w, int h, int src_stride,
+                   int csf_a_stride, int scale, double adm_norm_view_dist,
+                   int adm_ref_display_height);
+    VmafDictionary *feature_name_dict[ADM_MAX_ENHN_GAIN_LIMITS];
 } AdmState;
 
 static const VmafOption options[] = {
@@ -64,6 +112,14 @@ static const VmafOption options[] = {
         .max = DEFAULT_ADM_ENHN_GAIN_LIMIT,
         .flags = VMAF_OPT_FLAG_FEATURE_PARAM,
     },
+    {
+        .name = "adm_enhn_gain_limit_variants",
+        .help = "additional values of adm_enhn_gain_limit, comma separated, "
+                "which are computed in the same pass",
+        .offset = offsetof(AdmState, adm_enhn_gain_limit_variants),
+        .type = VMAF_OPT_TYPE_STRING,
+        .default_val.s = NULL,
+    },
     {
         .name = "adm_norm_view_dist",
         .alias = "nvd",
@@ -89,26 +145,6 @@ static const VmafOption options[] = {
     { 0 }
 };
 
-/*
- * lambda = 0 (finest scale), 1, 2, 3 (coarsest scale);
- * theta = 0 (ll), 1 (lh - vertical), 2 (hh - diagonal), 3(hl - horizontal).
- */
-static inline float
-dwt_quant_step(const struct dwt_model_params *params, int lambda, int theta,
-        double adm_norm_view_dist, int adm_ref_display_height)
-{
-    // Formula (1), page 1165 - display visual resolution (DVR), in pixels/degree
-    // of visual angle. This should be 56.55
-    float r = adm_norm_view_dist * adm_ref_display_height * M_PI / 180.0;
-
-    // Formula (9), page 1171
-    float temp = log10(pow(2.0, lambda + 1)*params->f0*params->g[theta] / r);
-    float Q = 2.0*params->a*pow(10.0, params->k*temp*temp) /
-        dwt_7_9_basis_function_amplitudes[lambda][theta];
-
-    return Q;
-}
-
 // i = 0, j = 0: indices y: 1,0,1, x: 1,0,1  for Fixed-point
 #define ADM_CM_THRESH_S_0_0(angles,flt_angles,src_stride,accum,w,h,i,j) \
 { \
@@ -2422,9 +2458,52 @@ static void adm_dwt2_s123_combined(const int32_t *i4_ref_scale, const int32_t *i
     }
 }
 
+static void adm_dwt2(AdmState *s, VmafPicture *pic, adm_dwt_band_t *dst,
+                     AdmBuffer *buf, size_t stride)
+{
+    const int w = pic->w[0];
+    const int h = pic->h[0];
+    const size_t buf_stride = buf->ind_size_x >> 2;
+
+    if (pic->bpc == 8)
+        s->dwt2_8(pic->data[0], dst, buf, w, h, stride, buf_stride);
+    else
+        s->dwt2_16(pic->data[0], dst, buf, w, h, stride, buf_stride, pic->bpc);
+}
+
+/* Scale 0 dwt2 bands of the reference, independent of the adm options. */
+#define ADM_DWT2_ARTIFACT "integer_adm_dwt2"
+
+struct Dwt2Cookie {
+    AdmState *s;
+    VmafPicture *pic;
+    AdmBuffer *buf;
+    size_t stride;
+};
+
+static int produce_dwt2(void *data, void *cookie)
+{
+    struct Dwt2Cookie *c = cookie;
+    const size_t band_sz = c->buf->ind_size_x * ((c->pic->h[0] + 1) / 2) / 2;
+
+    adm_dwt_band_t dst = {
+        .band_a = (int16_t *)((char *)data + 0 * band_sz),
+        .band_h = (int16_t *)((char *)data + 1 * band_sz),
+        .band_v = (int16_t *)((char *)data + 2 * band_sz),
+        .band_d = (int16_t *)((char *)data + 3 * band_sz),
+    };
+    adm_dwt2(c->s, c->pic, &dst, c->buf, c->stride);
+    return 0;
+}
+
+/*
+ * The dwt is shared between all the enhancement gain limits, decoupling, csf
+ * and contrast masking are run once per gain limit. score, score_num and
+ * score_den receive one value, scores eight values, per gain limit.
+ */
 void integer_compute_adm(AdmState *s, VmafPicture *ref_pic, VmafPicture *dis_pic,
                          double *score, double *score_num, double *score_den, double *scores, AdmBuffer *buf,
-                         double adm_enhn_gain_limit,
+                         const double *adm_enhn_gain_limit, unsigned n_gain_limits,
                          double adm_norm_view_dist, int adm_ref_display_height)
 {
     int w = ref_pic->w[0];
@@ -2448,26 +2527,34 @@ void integer_compute_adm(AdmState *s, VmafPicture *ref_pic, VmafPicture *dis_pic
         curr_dis_stride = dis_pic->stride[0] >> 1;
     }
 
-    double num = 0;
+    double num[ADM_MAX_ENHN_GAIN_LIMITS] = { 0 };
     double den = 0;
 	for (unsigned scale = 0; scale < 4; ++scale) {
-		float num_scale = 0.0;
+		float num_scale[ADM_MAX_ENHN_GAIN_LIMITS];
 		float den_scale = 0.0;
 
         dwt2_src_indices_filt(buf->ind_y, buf->ind_x, w, h);
 		if(scale==0) {
-            if (ref_pic->bpc == 8) {
-                s->dwt2_8(ref_pic->data[0], &buf->ref_dwt2, buf, w, h,
-                          curr_ref_stride, buf_stride);
-                s->dwt2_8(dis_pic->data[0], &buf->dis_dwt2, buf, w, h,
-                          curr_dis_stride, buf_stride);
-            }
-            else {
-                adm_dwt2_16(ref_pic->data[0], &buf->ref_dwt2, buf, w, h,
-                            curr_ref_stride, buf_stride, ref_pic->bpc);
-                adm_dwt2_16(dis_pic->data[0], &buf->dis_dwt2, buf, w, h,
-                            curr_dis_stride, buf_stride, dis_pic->bpc);
+            if (vmaf_picture_artifact_shared(ref_pic, ADM_DWT2_ARTIFACT)) {
+                // the four bands of ref_dwt2 are laid out back to back, the
+                // simd kernels may store up to one vector past the last band
+                const size_t dwt2_sz = 4 * (buf->ind_size_x * ((h + 1) / 2) / 2);
+                const size_t artifact_sz = dwt2_sz + 64;
+                struct Dwt2Cookie cookie = {
+                    .s = s, .pic = ref_pic, .buf = buf, .stride = curr_ref_stride,
+                };
+                const void *shared_dwt2;
+                int err = vmaf_picture_artifact_get(ref_pic, ADM_DWT2_ARTIFACT,
+                                                    artifact_sz, produce_dwt2,
+                                                    &cookie, &shared_dwt2);
+                if (err)
+                    adm_dwt2(s, ref_pic, &buf->ref_dwt2, buf, curr_ref_stride);
+                else
+                    memcpy(buf->ref_dwt2.band_a, shared_dwt2, dwt2_sz);
+            } else {
+                adm_dwt2(s, ref_pic, &buf->ref_dwt2, buf, curr_ref_stride);
             }
+            adm_dwt2(s, dis_pic, &buf->dis_dwt2, buf, curr_dis_stride);
 
 			i16_to_i32(&buf->ref_dwt2, &buf->i4_ref_dwt2, w, h, buf_stride);
 			i16_to_i32(&buf->dis_dwt2, &buf->i4_dis_dwt2, w, h, buf_stride);
@@ -2475,37 +2562,41 @@ void integer_compute_adm(AdmState *s, VmafPicture *ref_pic, VmafPicture *dis_pic
 			w = (w + 1) / 2;
 			h = (h + 1) / 2;
 
-			adm_decouple(buf, w, h, buf_stride, adm_enhn_gain_limit);
-
 			den_scale = adm_csf_den_scale(&buf->ref_dwt2, w, h, buf_stride,
                                  adm_norm_view_dist, adm_ref_display_height);
 
-			adm_csf(buf, w, h, buf_stride, adm_norm_view_dist, adm_ref_display_height);
+            for (unsigned k = 0; k < n_gain_limits; k++) {
+                s->decouple(buf, w, h, buf_stride, adm_enhn_gain_limit[k]);
 
-			num_scale = adm_cm(buf, w, h, buf_stride, buf_stride,
-                               adm_norm_view_dist, adm_ref_display_height);
+                s->csf(buf, w, h, buf_stride, adm_norm_view_dist,
+                       adm_ref_display_height);
+
+                num_scale[k] = s->cm(buf, w, h, buf_stride, buf_stride,
+                                     adm_norm_view_dist, adm_ref_display_height);
+            }
 		}
 		else {
-            adm_dwt2_s123_combined(i4_curr_ref_scale, i4_curr_dis_scale, buf, w, h, curr_ref_stride,
+            s->dwt2_s123_combined(i4_curr_ref_scale, i4_curr_dis_scale, buf, w, h, curr_ref_stride,
                                    curr_dis_stride, buf_stride, scale);
 
 			w = (w + 1) / 2;
 			h = (h + 1) / 2;
 
-			adm_decouple_s123(buf, w, h, buf_stride, adm_enhn_gain_limit);
-
 			den_scale = adm_csf_den_s123(
 			        &buf->i4_ref_dwt2, scale, w, h, buf_stride,
 			        adm_norm_view_dist, adm_ref_display_height);
 
-			i4_adm_csf(buf, scale, w, h, buf_stride,
-              adm_norm_view_dist, adm_ref_display_height);
+            for (unsigned k = 0; k < n_gain_limits; k++) {
+                s->decouple_s123(buf, w, h, buf_stride, adm_enhn_gain_limit[k]);
 
-			num_scale = i4_adm_cm(buf, w, h, buf_stride, buf_stride, scale,
-                         adm_norm_view_dist, adm_ref_display_height);
+                s->i4_csf(buf, scale, w, h, buf_stride,
+                          adm_norm_view_dist, adm_ref_display_height);
+
+                num_scale[k] = s->i4_cm(buf, w, h, buf_stride, buf_stride, scale,
+                                        adm_norm_view_dist, adm_ref_display_height);
+            }
 		}
 
-		num += num_scale;
 		den += den_scale;
 
 		i4_curr_ref_scale = buf->i4_ref_dwt2.band_a;
@@ -2514,21 +2605,27 @@ void integer_compute_adm(AdmState *s, VmafPicture *ref_pic, VmafPicture *dis_pic
 		curr_ref_stride = buf_stride;
 		curr_dis_stride = buf_stride;
 
-		scores[2 * scale + 0] = num_scale;
-		scores[2 * scale + 1] = den_scale;
+        for (unsigned k = 0; k < n_gain_limits; k++) {
+            num[k] += num_scale[k];
+            scores[8 * k + 2 * scale + 0] = num_scale[k];
+            scores[8 * k + 2 * scale + 1] = den_scale;
+        }
 	}
 
-	num = num < numden_limit ? 0 : num;
 	den = den < numden_limit ? 0 : den;
 
-	if (den == 0.0) {
-		*score = 1.0f;
-	}
-	else {
-		*score = num / den;
-	}
-    *score_num = num;
-    *score_den = den;
+    for (unsigned k = 0; k < n_gain_limits; k++) {
+        num[k] = num[k] < numden_limit ? 0 : num[k];
+
+        if (den == 0.0) {
+            score[k] = 1.0f;
+        }
+        else {
+            score[k] = num[k] / den;
+        }
+        score_num[k] = num[k];
+        score_den[k] = den;
+    }
 
 }
 
@@ -2593,12 +2690,33 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
     }
 
     s->dwt2_8 = adm_dwt2_8;
+    s->dwt2_16 = adm_dwt2_16;
+    s->dwt2_s123_combined = adm_dwt2_s123_combined;
+    s->decouple = adm_decouple;
+    s->decouple_s123 = adm_decouple_s123;
+    s->csf = adm_csf;
+    s->i4_csf = i4_adm_csf;
+    s->cm = adm_cm;
+    s->i4_cm = i4_adm_cm;
 
 #if ARCH_X86
     unsigned flags = vmaf_get_cpu_flags();
     if (flags & VMAF_X86_CPU_FLAG_AVX2) {
         if (!(w % 8)) s->dwt2_8 = adm_dwt2_8_avx2;
     }
+#if HAVE_AVX512
+    if (flags & VMAF_X86_CPU_FLAG_AVX512) {
+        s->dwt2_8 = adm_dwt2_8_avx512;
+        s->dwt2_16 = adm_dwt2_16_avx512;
+        s->dwt2_s123_combined = adm_dwt2_s123_combined_avx512;
+        s->decouple = adm_decouple_avx512;
+        s->decouple_s123 = adm_decouple_s123_avx512;
+        s->csf = adm_csf_avx512;
+        s->i4_csf = i4_adm_csf_avx512;
+        s->cm = adm_cm_avx512;
+        s->i4_cm = i4_adm_cm_avx512;
+    }
+#endif
 #elif ARCH_AARCH64
     unsigned flags = vmaf_get_cpu_flags();
     if (flags & VMAF_ARM_CPU_FLAG_NEON) {
@@ -2606,6 +2724,8 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
     }
 #endif
 
+    int err = -ENOMEM;
+
     s->integer_stride   = ALIGN_CEIL(w * sizeof(int32_t));
     s->buf.ind_size_x   = ALIGN_CEIL(((w + 1) / 2) * sizeof(int32_t));
     s->buf.ind_size_y   = ALIGN_CEIL(((h + 1) / 2) * sizeof(int32_t));
@@ -2640,12 +2760,15 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
     void *ind_buf_x = s->buf.buf_x_orig;
     init_index(s->buf.ind_x, ind_buf_x, s->buf.ind_size_x);
 
-    div_lookup_generator();
+    pthread_once(&div_lookup_once, div_lookup_generator);
 
-    s->feature_name_dict =
-        vmaf_feature_name_dict_from_provided_features(fex->provided_features,
-                fex->options, s);
-    if (!s->feature_name_dict) goto fail;
+    int cnt = vmaf_feature_extractor_variants(fex, s->enhn_gain_limit,
+                                              s->feature_name_dict);
+    if (cnt < 0) {
+        err = cnt;
+        goto fail;
+    }
+    s->enhn_gain_limit_cnt = cnt;
 
     return 0;
 
@@ -2654,90 +2777,107 @@ fail:
     if (s->buf.tmp_ref)     aligned_free(s->buf.tmp_ref);
     if (s->buf.buf_x_orig)  aligned_free(s->buf.buf_x_orig);
     if (s->buf.buf_y_orig)  aligned_free(s->buf.buf_y_orig);
-    vmaf_dictionary_free(&s->feature_name_dict);
-    return -ENOMEM;
+    return err;
 }
 
-static int extract(VmafFeatureExtractor *fex,
-                   VmafPicture *ref_pic, VmafPicture *ref_pic_90,
-                   VmafPicture *dist_pic, VmafPicture *dist_pic_90,
-                   unsigned index, VmafFeatureCollector *feature_collector)
+static int write_scores(VmafFeatureCollector *feature_collector, unsigned index,
+                        double score, double score_num, double score_den,
+                        const double *scores,
+                        VmafDictionary *feature_name_dict, bool debug)
 {
-    AdmState *s = fex->priv;
     int err = 0;
 
-    (void) ref_pic_90;
-    (void) dist_pic_90;
-
-    double score, score_num, score_den;
-    double scores[8];
-
-    // current implementation is limited by the 16-bit data pipeline, thus
-    // cannot handle an angular frequency smaller than 1080p * 3H
-    if (s->adm_norm_view_dist * s->adm_ref_display_height <
-        DEFAULT_ADM_NORM_VIEW_DIST * DEFAULT_ADM_REF_DISPLAY_HEIGHT) {
-        return -EINVAL;
-    }
-
-    integer_compute_adm(s, ref_pic, dist_pic, &score, &score_num, &score_den,
-                        scores, &s->buf,
-                        s->adm_enhn_gain_limit,
-                        s->adm_norm_view_dist, s->adm_ref_display_height);
-
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "VMAF_integer_feature_adm2_score", score,
+            feature_name_dict, "VMAF_integer_feature_adm2_score", score,
             index);
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm_scale0", scores[0] / scores[1],
+            feature_name_dict, "integer_adm_scale0", scores[0] / scores[1],
             index);
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm_scale1", scores[2] / scores[3],
+            feature_name_dict, "integer_adm_scale1", scores[2] / scores[3],
             index);
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm_scale2", scores[4] / scores[5],
+            feature_name_dict, "integer_adm_scale2", scores[4] / scores[5],
             index);
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm_scale3", scores[6] / scores[7],
+            feature_name_dict, "integer_adm_scale3", scores[6] / scores[7],
             index);
 
-    if (!s->debug) return err;
+    if (!debug) return err;
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm", score, index);
+            feature_name_dict, "integer_adm", score, index);
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm_num", score_num, index);
+            feature_name_dict, "integer_adm_num", score_num, index);
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm_den", score_den, index);
+            feature_name_dict, "integer_adm_den", score_den, index);
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm_num_scale0", scores[0], index);
+            feature_name_dict, "integer_adm_num_scale0", scores[0], index);
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm_den_scale0", scores[1], index);
+            feature_name_dict, "integer_adm_den_scale0", scores[1], index);
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm_num_scale1", scores[2], index);
+            feature_name_dict, "integer_adm_num_scale1", scores[2], index);
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm_den_scale1", scores[3], index);
+            feature_name_dict, "integer_adm_den_scale1", scores[3], index);
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm_num_scale2", scores[4], index);
+            feature_name_dict, "integer_adm_num_scale2", scores[4], index);
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm_den_scale2", scores[5], index);
+            feature_name_dict, "integer_adm_den_scale2", scores[5], index);
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm_num_scale3", scores[6], index);
+            feature_name_dict, "integer_adm_num_scale3", scores[6], index);
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm_den_scale3", scores[7], index);
+            feature_name_dict, "integer_adm_den_scale3", scores[7], index);
+
+    return err;
+}
+
+static int extract(VmafFeatureExtractor *fex,
+                   VmafPicture *ref_pic, VmafPicture *ref_pic_90,
+                   VmafPicture *dist_pic, VmafPicture *dist_pic_90,
+                   unsigned index, VmafFeatureCollector *feature_collector)
+{
+    AdmState *s = fex->priv;
+    int err = 0;
+
+    (void) ref_pic_90;
+    (void) dist_pic_90;
+
+    double score[ADM_MAX_ENHN_GAIN_LIMITS];
+    double score_num[ADM_MAX_ENHN_GAIN_LIMITS];
+    double score_den[ADM_MAX_ENHN_GAIN_LIMITS];
+    double scores[8 * ADM_MAX_ENHN_GAIN_LIMITS];
+
+    // current implementation is limited by the 16-bit data pipeline, thus
+    // cannot handle an angular frequency smaller than 1080p * 3H
+    if (s->adm_norm_view_dist * s->adm_ref_display_height <
+        DEFAULT_ADM_NORM_VIEW_DIST * DEFAULT_ADM_REF_DISPLAY_HEIGHT) {
+        return -EINVAL;
+    }
+
+    integer_compute_adm(s, ref_pic, dist_pic, score, score_num, score_den,
+                        scores, &s->buf,
+                        s->enhn_gain_limit, s->enhn_gain_limit_cnt,
+                        s->adm_norm_view_dist, s->adm_ref_display_height);
+
+    for (unsigned k = 0; k < s->enhn_gain_limit_cnt; k++) {
+        err |= write_scores(feature_collector, index, score[k],
+                            score_num[k], score_den[k], &scores[8 * k],
+                            s->feature_name_dict[k], s->debug);
+    }
 
     return err;
 }
@@ -2750,7 +2890,8 @@ static int close(VmafFeatureExtractor *fex)
     if (s->buf.tmp_ref)     aligned_free(s->buf.tmp_ref);
     if (s->buf.buf_x_orig)  aligned_free(s->buf.buf_x_orig);
     if (s->buf.buf_y_orig)  aligned_free(s->buf.buf_y_orig);
-    vmaf_dictionary_free(&s->feature_name_dict);
+    for (unsigned k = 0; k < s->enhn_gain_limit_cnt; k++)
+        vmaf_dictionary_free(&s->feature_name_dict[k]);
 
     return 0;
 }
@@ -2765,6 +2906,11 @@ static const char *provided_features[] = {
     NULL
 };
 
+static const char *artifacts[] = {
+    ADM_DWT2_ARTIFACT,
+    NULL
+};
+
 VmafFeatureExtractor vmaf_fex_integer_adm = {
     .name = "adm",
     .init = init,
@@ -2773,4 +2919,10 @@ VmafFeatureExtractor vmaf_fex_integer_adm = {
     .close = close,
     .priv_size = sizeof(AdmState),
     .provided_features = provided_features,
+    .artifacts = artifacts,
+    .variant = {
+        .option = "adm_enhn_gain_limit",
+        .list_option = "adm_enhn_gain_limit_variants",
+        .max_cnt = ADM_MAX_ENHN_GAIN_LIMITS,
+    },
 };
@@ -8,17 +8,6 @@
 #include <stdint.h>
 #include <string.h>
 
-static int32_t div_lookup[65537];
-static const int32_t div_Q_factor = 1073741824; // 2^30
-
-static inline void div_lookup_generator() {
-    for (int i = 1; i <= 32768; ++i) {
-        int32_t recip = (int32_t)(div_Q_factor / i);
-        div_lookup[32768 + i] = recip;
-        div_lookup[32768 - i] = 0 - recip;
-    }
-}
-
 typedef struct adm_dwt_band_t {
     int16_t *band_a; /* Low-pass V + low-pass H. */
     int16_t *band_v; /* Low-pass V + high-pass H. */
@@ -69,6 +58,9 @@ typedef struct AdmBuffer {
 #define DEFAULT_ADM_ENHN_GAIN_LIMIT (100.0)
 #endif // !DEFAULT_ADM_ENHN_GAIN_LIMIT
 
+/* Number of enhancement gain limits which can be computed in one pass */
+#define ADM_MAX_ENHN_GAIN_LIMITS 4
+
 #ifndef DEFAULT_ADM_NORM_VIEW_DIST
 #define DEFAULT_ADM_NORM_VIEW_DIST (3.0)
 #endif // !DEFAULT_ADM_NORM_VIEW_DIST
@@ -155,4 +147,24 @@ static const float dwt_7_9_basis_function_amplitudes[6][4] = {
     {0.045943, 0.059758, 0.077727, 0.059758},
     {0.023013, 0.030018, 0.039156, 0.030018}};
 
+/*
+ * lambda = 0 (finest scale), 1, 2, 3 (coarsest scale);
+ * theta = 0 (ll), 1 (lh - vertical), 2 (hh - diagonal), 3(hl - horizontal).
+ */
+static inline float
+dwt_quant_step(const struct dwt_model_params *params, int lambda, int theta,
+        double adm_norm_view_dist, int adm_ref_display_height)
+{
+    // Formula (1), page 1165 - display visual resolution (DVR), in pixels/degree
+    // of visual angle. This should be 56.55
+    float r = adm_norm_view_dist * adm_ref_display_height * M_PI / 180.0;
+
+    // Formula (9), page 1171
+    float temp = log10(pow(2.0, lambda + 1)*params->f0*params->g[theta] / r);
+    float Q = 2.0*params->a*pow(10.0, params->k*temp*temp) /
+        dwt_7_9_basis_function_amplitudes[lambda][theta];
+
+    return Q;
+}
+
 #endif /* _FEATURE_ADM_H_ */
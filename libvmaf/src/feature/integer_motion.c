@@ -35,6 +35,8 @@
 #if HAVE_AVX512
 #include "x86/motion_avx512.h"
 #endif
+#elif ARCH_AARCH64
+#include "arm64/motion_neon.h"
 #endif
 
 typedef struct MotionState {
@@ -50,7 +52,12 @@ typedef struct MotionState {
     void (*x_convolution)(const uint16_t *src, uint16_t *dst, unsigned width,
                           unsigned height, ptrdiff_t src_stride,
                           ptrdiff_t dst_stride);
-    void (*sad)(VmafPicture *pic_a, VmafPicture *pic_b, uint64_t *sad);
+    uint64_t (*sad)(const uint16_t *a, ptrdiff_t a_stride,
+                    const uint16_t *b, ptrdiff_t b_stride,
+                    unsigned w, unsigned h);
+    void (*sad_pair)(const uint16_t *a, const uint16_t *b, const uint16_t *c,
+                     ptrdiff_t stride, unsigned w, unsigned h,
+                     uint64_t *sad_b, uint64_t *sad_c);
     VmafDictionary *feature_name_dict;
 } MotionState;
 
@@ -224,20 +231,45 @@ y_convolution_8(void *src, uint16_t *dst, unsigned width,
     }
 }
 
-static void sad_c(VmafPicture *pic_a, VmafPicture *pic_b, uint64_t *sad)
+static uint64_t sad_c(const uint16_t *a, ptrdiff_t a_stride,
+                      const uint16_t *b, ptrdiff_t b_stride,
+                      unsigned w, unsigned h)
 {
-    *sad = 0;
+    uint64_t sad = 0;
 
-    uint16_t *a = pic_a->data[0];
-    uint16_t *b = pic_b->data[0];
-    for (unsigned i = 0; i < pic_a->h[0]; i++) {
+    for (unsigned i = 0; i < h; i++) {
         uint32_t inner_sad = 0;
-        for (unsigned j = 0; j < pic_a->w[0]; j++) {
+        for (unsigned j = 0; j < w; j++) {
             inner_sad += abs(a[j] - b[j]);
         }
-        *sad += inner_sad;
-        a += (pic_a->stride[0] / 2);
-        b += (pic_b->stride[0] / 2);
+        sad += inner_sad;
+        a += a_stride;
+        b += b_stride;
+    }
+
+    return sad;
+}
+
+/* sad(a, b) and sad(a, c) in one pass over a */
+static void sad_pair_c(const uint16_t *a, const uint16_t *b, const uint16_t *c,
+                       ptrdiff_t stride, unsigned w, unsigned h,
+                       uint64_t *sad_b, uint64_t *sad_c)
+{
+    *sad_b = 0;
+    *sad_c = 0;
+
+    for (unsigned i = 0; i < h; i++) {
+        uint32_t inner_sad_b = 0;
+        uint32_t inner_sad_c = 0;
+        for (unsigned j = 0; j < w; j++) {
+            inner_sad_b += abs(a[j] - b[j]);
+            inner_sad_c += abs(a[j] - c[j]);
+        }
+        *sad_b += inner_sad_b;
+        *sad_c += inner_sad_c;
+        a += stride;
+        b += stride;
+        c += stride;
     }
 }
 
@@ -297,18 +329,33 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
 
     s->y_convolution = bpc == 8 ? y_convolution_8 : y_convolution_16;
     s->x_convolution = x_convolution_16;
+    s->sad = sad_c;
+    s->sad_pair = sad_pair_c;
 
 #if ARCH_X86
     unsigned flags = vmaf_get_cpu_flags();
-    if (flags & VMAF_X86_CPU_FLAG_AVX2)
+    if (flags & VMAF_X86_CPU_FLAG_AVX2) {
         s->x_convolution = x_convolution_16_avx2;
+        s->sad = sad_16_avx2;
+        s->sad_pair = sad_pair_16_avx2;
+    }
 #if HAVE_AVX512
-    if (flags & VMAF_X86_CPU_FLAG_AVX512)
+    if (flags & VMAF_X86_CPU_FLAG_AVX512) {
         s->x_convolution = x_convolution_16_avx512;
+        s->sad = sad_16_avx512;
+        s->sad_pair = sad_pair_16_avx512;
+    }
 #endif
+#elif ARCH_AARCH64
+    unsigned flags = vmaf_get_cpu_flags();
+    if (flags & VMAF_ARM_CPU_FLAG_NEON) {
+        s->y_convolution = bpc == 8 ? y_convolution_8_neon : y_convolution_16_neon;
+        s->x_convolution = x_convolution_16_neon;
+        s->sad = sad_16_neon;
+        s->sad_pair = sad_pair_16_neon;
+    }
 #endif
 
-    s->sad = sad_c;
     s->score = 0.;
 
     return 0;
@@ -343,6 +390,34 @@ static inline double normalize_and_scale_sad(uint64_t sad,
     return (float) (sad / 256.) / (w * h);
 }
 
+static void blur_ref(MotionState *s, VmafPicture *ref_pic, uint16_t *dst)
+{
+    const ptrdiff_t y_src_stride =
+        ref_pic->bpc == 8 ? ref_pic->stride[0] : ref_pic->stride[0] / 2;
+
+    s->y_convolution(ref_pic->data[0], s->tmp.data[0], ref_pic->w[0],
+                     ref_pic->h[0], y_src_stride, s->tmp.stride[0] / 2,
+                     ref_pic->bpc);
+
+    s->x_convolution(s->tmp.data[0], dst, s->tmp.w[0], s->tmp.h[0],
+                     s->tmp.stride[0] / 2, s->blur[0].stride[0] / 2);
+}
+
+/* Blurred reference luma, the same for every motion feature extractor. */
+#define MOTION_BLUR_ARTIFACT "integer_motion_blur"
+
+struct BlurCookie {
+    MotionState *s;
+    VmafPicture *ref_pic;
+};
+
+static int produce_blur(void *data, void *cookie)
+{
+    struct BlurCookie *c = cookie;
+    blur_ref(c->s, c->ref_pic, data);
+    return 0;
+}
+
 static int extract(VmafFeatureExtractor *fex,
                    VmafPicture *ref_pic, VmafPicture *ref_pic_90,
                    VmafPicture *dist_pic, VmafPicture *dist_pic_90,
@@ -360,16 +435,19 @@ static int extract(VmafFeatureExtractor *fex,
     const unsigned blur_idx_1 = (index + 1) % 3;
     const unsigned blur_idx_2 = (index + 2) % 3;
 
-    const ptrdiff_t y_src_stride =
-        ref_pic->bpc == 8 ? ref_pic->stride[0] : ref_pic->stride[0] / 2;
-
-    s->y_convolution(ref_pic->data[0], s->tmp.data[0], ref_pic->w[0],
-                     ref_pic->h[0], y_src_stride, s->tmp.stride[0] / 2,
-                     ref_pic->bpc);
-
-    s->x_convolution(s->tmp.data[0], s->blur[blur_idx_0].data[0],
-                     s->tmp.w[0], s->tmp.h[0], s->tmp.stride[0] / 2,
-                     s->blur[blur_idx_0].stride[0] / 2);
+    VmafPicture *blur = &s->blur[blur_idx_0];
+    if (vmaf_picture_artifact_shared(ref_pic, MOTION_BLUR_ARTIFACT)) {
+        const size_t blur_sz = blur->stride[0] * blur->h[0];
+        struct BlurCookie cookie = { .s = s, .ref_pic = ref_pic };
+        const void *shared_blur;
+        err = vmaf_picture_artifact_get(ref_pic, MOTION_BLUR_ARTIFACT,
+                                        blur_sz, produce_blur, &cookie,
+                                        &shared_blur);
+        if (err) return err;
+        memcpy(blur->data[0], shared_blur, blur_sz);
+    } else {
+        blur_ref(s, ref_pic, blur->data[0]);
+    }
 
     if (index == 0) {
         err = vmaf_feature_collector_append(feature_collector,
@@ -383,8 +461,18 @@ static int extract(VmafFeatureExtractor *fex,
         return err;
     }
 
-    uint64_t sad;
-    s->sad(&s->blur[blur_idx_2], &s->blur[blur_idx_0], &sad);
+    const ptrdiff_t blur_stride = s->blur[0].stride[0] / 2;
+    uint64_t sad, sad2 = 0;
+    if (index == 1) {
+        sad = s->sad(s->blur[blur_idx_2].data[0], blur_stride,
+                     s->blur[blur_idx_0].data[0], blur_stride,
+                     ref_pic->w[0], ref_pic->h[0]);
+    } else {
+        // both scores compare against blur[blur_idx_2], read it only once
+        s->sad_pair(s->blur[blur_idx_2].data[0], s->blur[blur_idx_0].data[0],
+                    s->blur[blur_idx_1].data[0], blur_stride,
+                    ref_pic->w[0], ref_pic->h[0], &sad, &sad2);
+    }
     double score = s->score =
         normalize_and_scale_sad(sad, ref_pic->w[0], ref_pic->h[0]);
 
@@ -398,8 +486,6 @@ static int extract(VmafFeatureExtractor *fex,
     if (index == 1)
         return 0;
 
-    uint64_t sad2;
-    s->sad(&s->blur[blur_idx_2], &s->blur[blur_idx_1], &sad2);
     double score2 = normalize_and_scale_sad(sad2, ref_pic->w[0], ref_pic->h[0]);
 
     score2 = score2 < score ? score2 : score;
@@ -427,6 +513,11 @@ static const char *provided_features[] = {
     NULL
 };
 
+static const char *artifacts[] = {
+    MOTION_BLUR_ARTIFACT,
+    NULL
+};
+
 VmafFeatureExtractor vmaf_fex_integer_motion = {
     .name = "motion",
     .init = init,
@@ -436,5 +527,6 @@ VmafFeatureExtractor vmaf_fex_integer_motion = {
     .options = options,
     .priv_size = sizeof(MotionState),
     .provided_features = provided_features,
+    .artifacts = artifacts,
     .flags = VMAF_FEATURE_EXTRACTOR_TEMPORAL,
 };
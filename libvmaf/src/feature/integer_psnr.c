@@ -23,10 +23,20 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "cpu.h"
 #include "feature_collector.h"
 #include "feature_extractor.h"
 #include "opt.h"
 
+#if ARCH_X86
+#include "x86/psnr_avx2.h"
+#if HAVE_AVX512
+#include "x86/psnr_avx512.h"
+#endif
+#elif ARCH_AARCH64
+#include "arm64/psnr_neon.h"
+#endif
+
 typedef struct PsnrState {
     bool enable_chroma;
     bool enable_mse;
@@ -39,6 +49,12 @@ typedef struct PsnrState {
         uint64_t sse[3];
         uint64_t n_pixels[3];
     } apsnr;
+    uint64_t (*sse_8)(const uint8_t *ref, ptrdiff_t ref_stride,
+                      const uint8_t *dis, ptrdiff_t dis_stride,
+                      unsigned w, unsigned h);
+    uint64_t (*sse_16)(const uint16_t *ref, ptrdiff_t ref_stride,
+                       const uint16_t *dis, ptrdiff_t dis_stride,
+                       unsigned w, unsigned h);
 } PsnrState;
 
 static const VmafOption options[] = {
@@ -82,6 +98,39 @@ static const VmafOption options[] = {
     { 0 }
 };
 
+static uint64_t psnr_sse_8(const uint8_t *ref, ptrdiff_t ref_stride,
+                           const uint8_t *dis, ptrdiff_t dis_stride,
+                           unsigned w, unsigned h)
+{
+    uint64_t sse = 0;
+    for (unsigned i = 0; i < h; i++) {
+        uint32_t sse_inner = 0;
+        for (unsigned j = 0; j < w; j++) {
+            const int16_t e = ref[j] - dis[j];
+            sse_inner += e * e;
+        }
+        sse += sse_inner;
+        ref += ref_stride;
+        dis += dis_stride;
+    }
+    return sse;
+}
+
+static uint64_t psnr_sse_16(const uint16_t *ref, ptrdiff_t ref_stride,
+                            const uint16_t *dis, ptrdiff_t dis_stride,
+                            unsigned w, unsigned h)
+{
+    uint64_t sse = 0;
+    for (unsigned i = 0; i < h; i++) {
+        for (unsigned j = 0; j < w; j++) {
+            const uint32_t e = abs(ref[j] - dis[j]);
+            sse += e * e;
+        }
+        ref += ref_stride / 2;
+        dis += dis_stride / 2;
+    }
+    return sse;
+}
 
 static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
                 unsigned bpc, unsigned w, unsigned h)
@@ -89,6 +138,29 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
     PsnrState *s = fex->priv;
     s->peak = s->reduced_hbd_peak ? 255 * 1 << (bpc - 8) : (1 << bpc) - 1;
 
+    s->sse_8 = psnr_sse_8;
+    s->sse_16 = psnr_sse_16;
+
+#if ARCH_X86
+    unsigned flags = vmaf_get_cpu_flags();
+    if (flags & VMAF_X86_CPU_FLAG_AVX2) {
+        s->sse_8 = psnr_sse_8_avx2;
+        s->sse_16 = psnr_sse_16_avx2;
+    }
+#if HAVE_AVX512
+    if (flags & VMAF_X86_CPU_FLAG_AVX512) {
+        s->sse_8 = psnr_sse_8_avx512;
+        s->sse_16 = psnr_sse_16_avx512;
+    }
+#endif
+#elif ARCH_AARCH64
+    unsigned flags = vmaf_get_cpu_flags();
+    if (flags & VMAF_ARM_CPU_FLAG_NEON) {
+        s->sse_8 = psnr_sse_8_neon;
+        s->sse_16 = psnr_sse_16_neon;
+    }
+#endif
+
     if (pix_fmt == VMAF_PIX_FMT_YUV400P)
         s->enable_chroma = false;
 
@@ -123,20 +195,10 @@ static int psnr(VmafPicture *ref_pic, VmafPicture *dist_pic,
     int err = 0;
 
     for (unsigned p = 0; p < n; p++) {
-        uint8_t *ref = ref_pic->data[p];
-        uint8_t *dis = dist_pic->data[p];
-
-        uint64_t sse = 0;
-        for (unsigned i = 0; i < ref_pic->h[p]; i++) {
-            uint32_t sse_inner = 0;
-            for (unsigned j = 0; j < ref_pic->w[p]; j++) {
-                const int16_t e = ref[j] - dis[j];
-                sse_inner += e * e;
-            }
-            sse += sse_inner;
-            ref += ref_pic->stride[p];
-            dis += dist_pic->stride[p];
-        }
+        const uint64_t sse =
+            s->sse_8(ref_pic->data[p], ref_pic->stride[p],
+                     dist_pic->data[p], dist_pic->stride[p],
+                     ref_pic->w[p], ref_pic->h[p]);
 
         if (s->enable_apsnr) {
             s->apsnr.sse[p] += sse;
@@ -167,18 +229,10 @@ static int psnr_hbd(VmafPicture *ref_pic, VmafPicture *dist_pic,
     int err = 0;
 
     for (unsigned p = 0; p < n; p++) {
-        uint16_t *ref = ref_pic->data[p];
-        uint16_t *dis = dist_pic->data[p];
-
-        uint64_t sse = 0;
-        for (unsigned i = 0; i < ref_pic->h[p]; i++) {
-            for (unsigned j = 0; j < ref_pic->w[p]; j++) {
-                const uint32_t e = abs(ref[j] - dis[j]);
-                sse += e * e;
-            }
-            ref += ref_pic->stride[p] / 2;
-            dis += dist_pic->stride[p] / 2;
-        }
+        const uint64_t sse =
+            s->sse_16(ref_pic->data[p], ref_pic->stride[p],
+                      dist_pic->data[p], dist_pic->stride[p],
+                      ref_pic->w[p], ref_pic->h[p]);
 
         if (s->enable_apsnr) {
             s->apsnr.sse[p] += sse;
@@ -25,15 +25,27 @@ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <errno.h>
 #include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include "cpu.h"
 #include "feature_collector.h"
 #include "feature_extractor.h"
+#include "mem.h"
+
+#if ARCH_X86
+#include "x86/ssim_avx2.h"
+#endif
 
 #define KERNEL_SHIFT (8)
 #define KERNEL_WEIGHT (1<<KERNEL_SHIFT)
 #define KERNEL_ROUND ((1<<KERNEL_SHIFT)>>1)
+#define KERNEL_MAX_LEN (5)
+#define KERNEL_MAX_SZ (2*KERNEL_MAX_LEN-1)
 
 #ifndef M_PI
 #define M_PI 3.141592653589793238462643
@@ -60,6 +72,8 @@ static int gaussian_filter_init(unsigned **_kernel,double _sigma,int _max_len){
   kernel_len=len>=_max_len?_max_len-1:(int)len;
   kernel_sz=kernel_len<<1|1;
   kernel=(unsigned *)malloc(kernel_sz*sizeof(*kernel));
+  *_kernel=kernel;
+  if(kernel==NULL)return 0;
   sum=0;
   for(ci=kernel_len;ci>0;ci--){
     kernel[kernel_len-ci]=kernel[kernel_len+ci]=
@@ -67,139 +81,231 @@ static int gaussian_filter_init(unsigned **_kernel,double _sigma,int _max_len){
     sum+=kernel[kernel_len-ci];
   }
   kernel[kernel_len]=KERNEL_WEIGHT-(sum<<1);
-  *_kernel=kernel;
   return kernel_sz;
 }
 
-typedef struct ssim_moments ssim_moments;
-
-struct ssim_moments{
-  int64_t mux;
-  int64_t muy;
-  int64_t x2;
-  int64_t xy;
-  int64_t y2;
-  int64_t w;
-};
+/*
+ * The moments of a line are kept as five planes (mux, muy, x2, xy, y2) of
+ * doubles. All sums are integers well below 2**53, so they are exact in any
+ * order, and the scores are the same as those of a 64-bit integer
+ * accumulation.
+ *
+ * The products of a line are kept in planes with kernel_sz>>1 zeros on either
+ * side, and lines outside of the picture are read as a plane of zeros, so that
+ * the filters need no special case at the borders. The weight of the kernel
+ * taps which fall inside the picture is accounted for separately.
+ */
+typedef struct SsimState {
+    unsigned *kernel;
+    int kernel_sz;
+    uint32_t *prod;
+    ptrdiff_t prod_stride;
+    double *buf;
+    double *lines[KERNEL_MAX_SZ];
+    double *zero_line;
+    ptrdiff_t stride;
+    double *hw;
+    double hw_sum;
+    double *terms;
+    void (*hmoments)(const unsigned char *src, const unsigned char *dst,
+                     int hbd, int w, const unsigned *kernel, int kernel_sz,
+                     uint32_t *prod, ptrdiff_t prod_stride, double *moments,
+                     ptrdiff_t stride);
+    void (*vterms)(double *const *lines, const unsigned *kernel,
+                   int kernel_sz, ptrdiff_t stride, const double *hw,
+                   double vw, double k1, double k2, int w, double *terms);
+} SsimState;
 
 #define SSIM_K1 (0.01*0.01)
 #define SSIM_K2 (0.03*0.03)
 
-static double calc_ssim(const unsigned char *_src,int _systride,
- const unsigned char *_dst,int _dystride,double _par,int depth,int _w,int _h){
-  ssim_moments  *line_buf;
-  ssim_moments **lines;
+static void ssim_hmoments(const unsigned char *_src,const unsigned char *_dst,
+ int _hbd,int _w,const unsigned *_kernel,int _kernel_sz,uint32_t *_prod,
+ ptrdiff_t _prod_stride,double *_moments,ptrdiff_t _stride){
+  int offs;
+  int x;
+  int k;
+  int i;
+  offs=_kernel_sz>>1;
+  for(x=0;x<_w;x++){
+    uint32_t s;
+    uint32_t d;
+    if(_hbd){
+      s=((const uint16_t *)_src)[x];
+      d=((const uint16_t *)_dst)[x];
+    }
+    else{
+      s=_src[x];
+      d=_dst[x];
+    }
+    _prod[offs+x]=s;
+    _prod[_prod_stride+offs+x]=d;
+    _prod[2*_prod_stride+offs+x]=s*s;
+    _prod[3*_prod_stride+offs+x]=s*d;
+    _prod[4*_prod_stride+offs+x]=d*d;
+  }
+  for(i=0;i<5;i++){
+    const uint32_t *prod;
+    double         *moments;
+    prod=_prod+i*_prod_stride;
+    moments=_moments+i*_stride;
+    for(x=0;x<_w;x++){
+      int64_t m;
+      m=0;
+      for(k=0;k<_kernel_sz;k++)m+=_kernel[k]*(int64_t)prod[x+k];
+      moments[x]=m;
+    }
+  }
+}
+
+static void ssim_vterms(double *const *_lines,const unsigned *_kernel,
+ int _kernel_sz,ptrdiff_t _stride,const double *_hw,double _vw,double _k1,
+ double _k2,int _w,double *_terms){
+  int x;
+  int k;
+  for(x=0;x<_w;x++){
+    double mux;
+    double muy;
+    double x2;
+    double xy;
+    double y2;
+    double c1;
+    double c2;
+    double mx2;
+    double mxy;
+    double my2;
+    double w;
+    mux=muy=x2=xy=y2=0;
+    for(k=0;k<_kernel_sz;k++){
+      const double *buf;
+      double        window;
+      buf=_lines[k]+x;
+      window=_kernel[k];
+      mux+=window*buf[0];
+      muy+=window*buf[_stride];
+      x2+=window*buf[2*_stride];
+      xy+=window*buf[3*_stride];
+      y2+=window*buf[4*_stride];
+    }
+    w=_hw[x]*_vw;
+    c1=_k1*w*w;
+    c2=_k2*w*w;
+    mx2=mux*mux;
+    mxy=mux*muy;
+    my2=muy*muy;
+    _terms[x]=w*(2*mxy+c1)*(c2+2*(xy*w-mxy))/
+     ((mx2+my2+c1)*(x2*w-mx2+y2*w-my2+c2));
+  }
+}
+
+static double calc_ssim(SsimState *_s,const unsigned char *_src,
+ int _systride,const unsigned char *_dst,int _dystride,int depth,int _w,
+ int _h){
+  double        *lines[KERNEL_MAX_SZ];
   double         ssim;
   double         ssimw;
-  unsigned      *hkernel;
-  int            hkernel_sz;
-  int            hkernel_offs;
-  unsigned      *vkernel;
-  int            vkernel_sz;
-  int            vkernel_offs;
-  int            log_line_sz;
-  int            line_sz;
-  int            line_mask;
+  double         k1;
+  double         k2;
+  int            kernel_sz;
+  int            offs;
   int            x;
   int            y;
   int            samplemax;
-  samplemax = (1 << depth) - 1;
-  vkernel_sz=gaussian_filter_init(&vkernel,1.5,5);
-  vkernel_offs=vkernel_sz>>1;
-  for(line_sz=1,log_line_sz=0;line_sz<vkernel_sz;line_sz<<=1,log_line_sz++);
-  line_mask=line_sz-1;
-  lines=(ssim_moments **)malloc(line_sz*sizeof(*lines));
-  lines[0]=line_buf=(ssim_moments *)malloc(line_sz*_w*sizeof(*line_buf));
-  for(y=1;y<line_sz;y++)lines[y]=lines[y-1]+_w;
-  hkernel_sz=gaussian_filter_init(&hkernel,1.5,5);
-  hkernel_offs=hkernel_sz>>1;
+  samplemax=(1<<depth)-1;
+  k1=(double)samplemax*samplemax*SSIM_K1;
+  k2=(double)samplemax*samplemax*SSIM_K2;
+  kernel_sz=_s->kernel_sz;
+  offs=kernel_sz>>1;
   ssim=0;
   ssimw=0;
-  for(y=0;y<_h+vkernel_offs;y++){
-    ssim_moments *buf;
-    int           k;
-    int           k_min;
-    int           k_max;
+  for(y=0;y<_h+offs;y++){
     if(y<_h){
-      buf=lines[y&line_mask];
-      for(x=0;x<_w;x++){
-        ssim_moments m;
-        memset(&m,0,sizeof(m));
-        k_min=hkernel_offs-x<=0?0:hkernel_offs-x;
-        k_max=x+hkernel_offs-_w+1<=0?
-         hkernel_sz:hkernel_sz-(x+hkernel_offs-_w+1);
-        for(k=k_min;k<k_max;k++){
-          signed s;
-          signed d;
-          signed window;
-          if (depth > 8) {
-            s = _src[(x-hkernel_offs+k)*2] +
-             (_src[(x-hkernel_offs+k)*2 + 1] << 8);
-            d = _dst[(x-hkernel_offs+k)*2] +
-             (_dst[(x-hkernel_offs+k)*2 + 1] << 8);
-          } else {
-            s=_src[(x-hkernel_offs+k)];
-            d=_dst[(x-hkernel_offs+k)];
-          }
-          window=hkernel[k];
-          m.mux+=window*s;
-          m.muy+=window*d;
-          m.x2+=window*s*s;
-          m.xy+=window*s*d;
-          m.y2+=window*d*d;
-          m.w+=window;
-        }
-        *(buf+x)=*&m;
-      }
+      _s->hmoments(_src,_dst,depth>8,_w,_s->kernel,kernel_sz,_s->prod,
+       _s->prod_stride,_s->lines[y%kernel_sz],_s->stride);
       _src+=_systride;
       _dst+=_dystride;
     }
-    if(y>=vkernel_offs){
-      k_min=vkernel_sz-y-1<=0?0:vkernel_sz-y-1;
-      k_max=y+1-_h<=0?vkernel_sz:vkernel_sz-(y+1-_h);
-      for(x=0;x<_w;x++){
-        ssim_moments m;
-        double       c1;
-        double       c2;
-        double       mx2;
-        double       mxy;
-        double       my2;
-        double       w;
-        memset(&m,0,sizeof(m));
-        for(k=k_min;k<k_max;k++){
-          signed window;
-          buf = lines[(y + 1 - vkernel_sz + k) & line_mask] + x;
-          window=vkernel[k];
-          m.mux+=window*buf->mux;
-          m.muy+=window*buf->muy;
-          m.x2+=window*buf->x2;
-          m.xy+=window*buf->xy;
-          m.y2+=window*buf->y2;
-          m.w+=window*buf->w;
+    if(y>=offs){
+      double vw;
+      int    k;
+      vw=0;
+      for(k=0;k<kernel_sz;k++){
+        int line;
+        line=y+1-kernel_sz+k;
+        if(line<0||line>=_h)lines[k]=_s->zero_line;
+        else{
+          lines[k]=_s->lines[line%kernel_sz];
+          vw+=_s->kernel[k];
         }
-        w=m.w;
-        c1=samplemax*samplemax*SSIM_K1*w*w;
-        c2=samplemax*samplemax*SSIM_K2*w*w;
-        mx2=m.mux*(double)m.mux;
-        mxy=m.mux*(double)m.muy;
-        my2=m.muy*(double)m.muy;
-        ssim+=m.w*(2*mxy+c1)*(c2+2*(m.xy*w-mxy))/
-         ((mx2+my2+c1)*(m.x2*w-mx2+m.y2*w-my2+c2));
-        ssimw+=m.w;
       }
+      _s->vterms(lines,_s->kernel,kernel_sz,_s->stride,_s->hw,vw,k1,k2,_w,
+       _s->terms);
+      for(x=0;x<_w;x++)ssim+=_s->terms[x];
+      ssimw+=vw*_s->hw_sum;
     }
   }
-  free(line_buf);
-  free(lines);
-  free(vkernel);
-  free(hkernel);
   return ssim/ssimw;
 }
 
 static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
                 unsigned bpc, unsigned w, unsigned h)
 {
+    SsimState *s = fex->priv;
+    (void) pix_fmt;
+    (void) h;
+
+    s->kernel_sz = gaussian_filter_init(&s->kernel, 1.5, KERNEL_MAX_LEN);
+    if (!s->kernel) return -ENOMEM;
+    const int offs = s->kernel_sz >> 1;
+
+    // planes are padded to whole vectors of 8, so that SIMD may overrun w
+    const unsigned w8 = (w + 7) & ~7;
+    s->prod_stride = w8 + 2 * offs;
+    s->stride = w8;
+
+    s->prod = aligned_malloc(5 * s->prod_stride * sizeof(*s->prod), 32);
+    if (!s->prod) goto fail;
+    memset(s->prod, 0, 5 * s->prod_stride * sizeof(*s->prod));
+
+    const size_t line_sz = 5 * s->stride;
+    const size_t buf_sz = (s->kernel_sz + 1) * line_sz + 2 * s->stride;
+    s->buf = aligned_malloc(buf_sz * sizeof(*s->buf), 32);
+    if (!s->buf) goto fail;
+    memset(s->buf, 0, buf_sz * sizeof(*s->buf));
+    for (int i = 0; i < s->kernel_sz; i++)
+        s->lines[i] = s->buf + i * line_sz;
+    s->zero_line = s->buf + s->kernel_sz * line_sz;
+    s->hw = s->zero_line + line_sz;
+    s->terms = s->hw + s->stride;
+
+    s->hw_sum = 0;
+    for (unsigned x = 0; x < w; x++) {
+        for (int k = 0; k < s->kernel_sz; k++) {
+            const int i = (int) x - offs + k;
+            if (i >= 0 && i < (int) w)
+                s->hw[x] += s->kernel[k];
+        }
+        s->hw_sum += s->hw[x];
+    }
+
+    s->hmoments = ssim_hmoments;
+    s->vterms = ssim_vterms;
+#if ARCH_X86
+    unsigned flags = vmaf_get_cpu_flags();
+    if (flags & VMAF_X86_CPU_FLAG_AVX2) {
+        // 32-bit sums of the products hold up to 12 bits per sample
+        if (bpc <= 12)
+            s->hmoments = ssim_hmoments_avx2;
+        s->vterms = ssim_vterms_avx2;
+    }
+#endif
+
     return 0;
+
+fail:
+    aligned_free(s->prod);
+    free(s->kernel);
+    return -ENOMEM;
 }
 
 static int extract(VmafFeatureExtractor *fex,
@@ -207,12 +313,13 @@ static int extract(VmafFeatureExtractor *fex,
                    VmafPicture *dist_pic, VmafPicture *dist_pic_90,
                    unsigned index, VmafFeatureCollector *feature_collector)
 {
+    SsimState *s = fex->priv;
     (void) ref_pic_90;
     (void) dist_pic_90;
 
     double score =
-        calc_ssim(ref_pic->data[0], ref_pic->stride[0],
-                  dist_pic->data[0], dist_pic->stride[0], 1.0, ref_pic->bpc,
+        calc_ssim(s, ref_pic->data[0], ref_pic->stride[0],
+                  dist_pic->data[0], dist_pic->stride[0], ref_pic->bpc,
                   ref_pic->w[0], ref_pic->h[0]);
     int err =
         vmaf_feature_collector_append(feature_collector, "ssim", score, index);
@@ -222,6 +329,10 @@ static int extract(VmafFeatureExtractor *fex,
 
 static int close(VmafFeatureExtractor *fex)
 {
+    SsimState *s = fex->priv;
+    aligned_free(s->buf);
+    aligned_free(s->prod);
+    free(s->kernel);
     return 0;
 }
 
@@ -235,5 +346,6 @@ VmafFeatureExtractor vmaf_fex_ssim = {
     .init = init,
     .extract = extract,
     .close = close,
+    .priv_size = sizeof(SsimState),
     .provided_features = provided_features,
 };
@@ -18,6 +18,7 @@
 
 #include <errno.h>
 #include <math.h>
+#include <pthread.h>
 #include <string.h>
 #include <stdio.h>
 
@@ -44,11 +45,12 @@
 typedef struct VifState {
     VifPublicState public;
     bool debug;
+    char *vif_enhn_gain_limit_variants;
     void (*subsample_rd_8)(VifBuffer buf, unsigned w, unsigned h);
     void (*subsample_rd_16)(VifBuffer buf, unsigned w, unsigned h, int scale, int bpc);
     void (*vif_statistic_8)(VifPublicState *s, float *num, float *den, unsigned w, unsigned h);
     void (*vif_statistic_16)(VifPublicState *s, float *num, float *den, unsigned w, unsigned h, int bpc, int scale);
-    VmafDictionary *feature_name_dict;
+    VmafDictionary *feature_name_dict[VIF_MAX_ENHN_GAIN_LIMITS];
 } VifState;
 
 static const VmafOption options[] = {
@@ -71,6 +73,14 @@ static const VmafOption options[] = {
         .max = DEFAULT_VIF_ENHN_GAIN_LIMIT,
         .flags = VMAF_OPT_FLAG_FEATURE_PARAM,
     },
+    {
+        .name = "vif_enhn_gain_limit_variants",
+        .help = "additional values of vif_enhn_gain_limit, comma separated, "
+                "which are computed in the same pass",
+        .offset = offsetof(VifState, vif_enhn_gain_limit_variants),
+        .type = VMAF_OPT_TYPE_STRING,
+        .default_val.s = NULL,
+    },
     { 0 }
 };
 
@@ -212,10 +222,17 @@ static void subsample_rd_16(VifBuffer buf, unsigned w, unsigned h, int scale, in
 #define MIN(x, y) (((x) < (y)) ? (x) : (y))
 #define MAX(x, y) (((x) > (y)) ? (x) : (y))
 
-static inline void log_generate(uint16_t *log2_table)
+/*
+ * log2 in Q11, built once and shared by all contexts. The avx512 kernels
+ * gather 64 bits per entry, so the table is padded by three entries.
+ */
+static uint16_t vif_log2_table[65537 + 3];
+static pthread_once_t vif_log2_table_once = PTHREAD_ONCE_INIT;
+
+static void log_generate(void)
 {
     for (unsigned i = 32767; i < 65536; ++i) {
-        log2_table[i] = (uint16_t)round(log2f((float)i) * 2048);
+        vif_log2_table[i] = (uint16_t)round(log2f((float)i) * 2048);
     }
 }
 
@@ -223,13 +240,12 @@ void vif_statistic_8(struct VifPublicState *s, float *num, float *den, unsigned
     const unsigned fwidth = vif_filter1d_width[0];
     const uint16_t *vif_filt_s0 = vif_filter1d_table[0];
     VifBuffer buf = s->buf;
-    int64_t accum_num_log = 0.0;
+    int64_t accum_num_log[VIF_MAX_ENHN_GAIN_LIMITS] = { 0 };
     int64_t accum_den_log = 0.0;
     int64_t accum_num_non_log = 0;
     int64_t accum_den_non_log = 0;
     static const int32_t sigma_nsq = 65536 << 1;
-    uint16_t *log2_table = s->log2_table;
-    double vif_enhn_gain_limit = s->vif_enhn_gain_limit;
+    const uint16_t *log2_table = s->log2_table;
 
     for (unsigned i = 0; i < h; ++i) {
         //VERTICAL
@@ -312,24 +328,8 @@ void vif_statistic_8(struct VifPublicState *s, float *num, float *den, unsigned
                 accum_den_log += log2_32(log2_table, sigma_nsq + sigma1_sq) - 2048 * 17;
 
                 if (sigma12 > 0 && sigma2_sq > 0) {
-                    /**
-                    * In floating-point numerator = log2((1.0f + (g * g * sigma1_sq)/(sv_sq + sigma_nsq))
-                    *
-                    * In Fixed-point the above is converted to
-                    * numerator = log2((sv_sq + sigma_nsq)+(g * g * sigma1_sq))- log2(sv_sq + sigma_nsq)
-                    */
-
-                    const double eps = 65536 * 1.0e-10;
-                    double g = sigma12 / (sigma1_sq + eps); // this epsilon can go away
-                    int32_t sv_sq = sigma2_sq - g * sigma12;
-
-                    sv_sq = (uint32_t)(MAX(sv_sq, 0));
-
-                    g = MIN(g, vif_enhn_gain_limit);
-
-                    uint32_t numer1 = (sv_sq + sigma_nsq);
-                    int64_t numer1_tmp = (int64_t)((g * g * sigma1_sq)) + numer1; //numerator
-                    accum_num_log += log2_64(log2_table, numer1_tmp) - log2_64(log2_table, numer1);
+                    vif_accumulate_num_log(s, accum_num_log,
+                                           sigma1_sq, sigma2_sq, sigma12);
                 }
             }
             else {
@@ -338,7 +338,8 @@ void vif_statistic_8(struct VifPublicState *s, float *num, float *den, unsigned
             }
         }
     }
-    num[0] = accum_num_log / 2048.0 + (accum_den_non_log - ((accum_num_non_log) / 16384.0) / (65025.0));
+    for (unsigned k = 0; k < s->enhn_gain_limit_cnt; k++)
+        num[k] = accum_num_log[k] / 2048.0 + (accum_den_non_log - ((accum_num_non_log) / 16384.0) / (65025.0));
     den[0] = accum_den_log / 2048.0 + accum_den_non_log;
 }
 
@@ -346,13 +347,12 @@ void vif_statistic_16(struct VifPublicState *s, float *num, float *den, unsigned
     const unsigned fwidth = vif_filter1d_width[scale];
     const uint16_t *vif_filt = vif_filter1d_table[scale];
     VifBuffer buf = s->buf;
-    int64_t accum_num_log = 0.0;
+    int64_t accum_num_log[VIF_MAX_ENHN_GAIN_LIMITS] = { 0 };
     int64_t accum_den_log = 0.0;
     int64_t accum_num_non_log = 0;
     int64_t accum_den_non_log = 0;
     static const int32_t sigma_nsq = 65536 << 1;
-    uint16_t *log2_table = s->log2_table;
-    double vif_enhn_gain_limit = s->vif_enhn_gain_limit;
+    const uint16_t *log2_table = s->log2_table;
     int32_t add_shift_round_HP, shift_HP;
     int32_t add_shift_round_VP, shift_VP;
     int32_t add_shift_round_VP_sq, shift_VP_sq;
@@ -455,24 +455,8 @@ void vif_statistic_16(struct VifPublicState *s, float *num, float *den, unsigned
                 accum_den_log += log2_32(log2_table, sigma_nsq + sigma1_sq) - 2048 * 17;
 
                 if (sigma12 > 0 && sigma2_sq > 0) {
-                    /**
-                    * In floating-point numerator = log2((1.0f + (g * g * sigma1_sq)/(sv_sq + sigma_nsq))
-                    *
-                    * In Fixed-point the above is converted to
-                    * numerator = log2((sv_sq + sigma_nsq)+(g * g * sigma1_sq))- log2(sv_sq + sigma_nsq)
-                    */
-
-                    const double eps = 65536 * 1.0e-10;
-                    double g = sigma12 / (sigma1_sq + eps); // this epsilon can go away
-                    int32_t sv_sq = sigma2_sq - g * sigma12;
-
-                    sv_sq = (uint32_t)(MAX(sv_sq, 0));
-
-                    g = MIN(g, vif_enhn_gain_limit);
-
-                    uint32_t numer1 = (sv_sq + sigma_nsq);
-                    int64_t numer1_tmp = (int64_t)((g * g * sigma1_sq)) + numer1; //numerator
-                    accum_num_log += log2_64(log2_table, numer1_tmp) - log2_64(log2_table, numer1);
+                    vif_accumulate_num_log(s, accum_num_log,
+                                           sigma1_sq, sigma2_sq, sigma12);
                 }
             }
             else {
@@ -481,7 +465,8 @@ void vif_statistic_16(struct VifPublicState *s, float *num, float *den, unsigned
             }
         }
     }
-    num[0] = accum_num_log / 2048.0 + (accum_den_non_log - ((accum_num_non_log) / 16384.0) / (65025.0));
+    for (unsigned k = 0; k < s->enhn_gain_limit_cnt; k++)
+        num[k] = accum_num_log[k] / 2048.0 + (accum_den_non_log - ((accum_num_non_log) / 16384.0) / (65025.0));
     den[0] = accum_den_log / 2048.0 + accum_den_non_log;
 }
 
@@ -493,7 +478,6 @@ VifResiduals vif_compute_line_residuals(VifPublicState *s, unsigned from,
     const uint16_t *vif_filt = vif_filter1d_table[scale];
     VifBuffer buf = s->buf;
     const uint16_t *log2_table = s->log2_table;
-    double vif_enhn_gain_limit = s->vif_enhn_gain_limit;
     static const int32_t sigma_nsq = 65536 << 1;
 
     int32_t shift_HP = 16;
@@ -546,24 +530,8 @@ VifResiduals vif_compute_line_residuals(VifPublicState *s, unsigned from,
             residuals.accum_den_log += log2_32(log2_table, sigma_nsq + sigma1_sq) - 2048 * 17;
 
             if (sigma12 > 0 && sigma2_sq > 0) {
-                /**
-                * In floating-point numerator = log2((1.0f + (g * g * sigma1_sq)/(sv_sq + sigma_nsq))
-                *
-                * In Fixed-point the above is converted to
-                * numerator = log2((sv_sq + sigma_nsq)+(g * g * sigma1_sq))- log2(sv_sq + sigma_nsq)
-                */
-
-                const double eps = 65536 * 1.0e-10;
-                double g = sigma12 / (sigma1_sq + eps); // this epsilon can go away
-                int32_t sv_sq = sigma2_sq - g * sigma12;
-
-                sv_sq = (uint32_t)(MAX(sv_sq, 0));
-
-                g = MIN(g, vif_enhn_gain_limit);
-
-                uint32_t numer1 = (sv_sq + sigma_nsq);
-                int64_t numer1_tmp = (int64_t)((g * g * sigma1_sq)) + numer1; //numerator
-                residuals.accum_num_log += log2_64(log2_table, numer1_tmp) - log2_64(log2_table, numer1);
+                vif_accumulate_num_log(s, residuals.accum_num_log,
+                                       sigma1_sq, sigma2_sq, sigma12);
             }
         }
         else {
@@ -611,7 +579,8 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
     }
 #endif
 
-    log_generate(s->public.log2_table);
+    pthread_once(&vif_log2_table_once, log_generate);
+    s->public.log2_table = vif_log2_table;
 
     (void)pix_fmt;
     const bool hbd = bpc > 8;
@@ -648,17 +617,15 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
     s->public.buf.tmp.ref_convol = data; data += s->public.buf.stride_tmp;
     s->public.buf.tmp.dis_convol = data;
 
-    s->feature_name_dict =
-        vmaf_feature_name_dict_from_provided_features(fex->provided_features,
-                fex->options, s);
-    if (!s->feature_name_dict) goto fail;
+    int cnt = vmaf_feature_extractor_variants(fex, s->public.enhn_gain_limit,
+                                              s->feature_name_dict);
+    if (cnt < 0) {
+        aligned_free(data);
+        return cnt;
+    }
+    s->public.enhn_gain_limit_cnt = cnt;
 
     return 0;
-
-fail:
-    if (data) aligned_free(data);
-    vmaf_dictionary_free(&s->feature_name_dict);
-    return -ENOMEM;
 }
 
 typedef struct VifScore {
@@ -669,27 +636,28 @@ typedef struct VifScore {
 } VifScore;
 
 static int write_scores(VmafFeatureCollector *feature_collector, unsigned index,
-                        VifScore vif, VifState *s)
+                        VifScore vif, VmafDictionary *feature_name_dict,
+                        bool debug)
 {
     int err = 0;
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "VMAF_integer_feature_vif_scale0_score",
+            feature_name_dict, "VMAF_integer_feature_vif_scale0_score",
             vif.scale[0].num / vif.scale[0].den, index);
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "VMAF_integer_feature_vif_scale1_score",
+            feature_name_dict, "VMAF_integer_feature_vif_scale1_score",
             vif.scale[1].num / vif.scale[1].den, index);
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "VMAF_integer_feature_vif_scale2_score",
+            feature_name_dict, "VMAF_integer_feature_vif_scale2_score",
             vif.scale[2].num / vif.scale[2].den, index);
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "VMAF_integer_feature_vif_scale3_score",
+            feature_name_dict, "VMAF_integer_feature_vif_scale3_score",
             vif.scale[3].num / vif.scale[3].den, index);
 
-    if (!s->debug) return err;
+    if (!debug) return err;
 
     const double score_num =
         (double)vif.scale[0].num + (double)vif.scale[1].num +
@@ -703,44 +671,44 @@ static int write_scores(VmafFeatureCollector *feature_collector, unsigned index,
         score_den == 0.0 ? 1.0f : score_num / score_den;
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_vif", score, index);
+            feature_name_dict, "integer_vif", score, index);
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_vif_num", score_num, index);
+            feature_name_dict, "integer_vif_num", score_num, index);
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_vif_den", score_den, index);
+            feature_name_dict, "integer_vif_den", score_den, index);
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_vif_num_scale0", vif.scale[0].num,
+            feature_name_dict, "integer_vif_num_scale0", vif.scale[0].num,
             index);
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_vif_den_scale0", vif.scale[0].den,
+            feature_name_dict, "integer_vif_den_scale0", vif.scale[0].den,
             index);
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_vif_num_scale1", vif.scale[1].num,
+            feature_name_dict, "integer_vif_num_scale1", vif.scale[1].num,
             index);
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_vif_den_scale1", vif.scale[1].den,
+            feature_name_dict, "integer_vif_den_scale1", vif.scale[1].den,
             index);
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_vif_num_scale2", vif.scale[2].num,
+            feature_name_dict, "integer_vif_num_scale2", vif.scale[2].num,
             index);
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_vif_den_scale2", vif.scale[2].den,
+            feature_name_dict, "integer_vif_den_scale2", vif.scale[2].den,
             index);
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_vif_num_scale3", vif.scale[3].num,
+            feature_name_dict, "integer_vif_num_scale3", vif.scale[3].num,
             index);
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_vif_den_scale3", vif.scale[3].den,
+            feature_name_dict, "integer_vif_den_scale3", vif.scale[3].den,
             index);
 
     return err;
@@ -763,10 +731,11 @@ static int extract(VmafFeatureExtractor *fex,
     unsigned char *dis_in = dist_pic->data[0];
     unsigned char *ref_out = s->public.buf.ref;
     unsigned char *dis_out = s->public.buf.dis;
+    const size_t row_sz = (size_t) w << (ref_pic->bpc > 8);
 
     for (unsigned i = 0; i < h; i++) {
-        memcpy(ref_out, ref_in, ref_pic->stride[0]);
-        memcpy(dis_out, dis_in, dist_pic->stride[0]);
+        memcpy(ref_out, ref_in, row_sz);
+        memcpy(dis_out, dis_in, row_sz);
         ref_in += ref_pic->stride[0];
         dis_in += dist_pic->stride[0];
         ref_out += s->public.buf.stride;
@@ -774,6 +743,7 @@ static int extract(VmafFeatureExtractor *fex,
     }
     pad_top_and_bottom(s->public.buf, h, vif_filter1d_width[0]);
 
+    float num[4][VIF_MAX_ENHN_GAIN_LIMITS];
     VifScore vif_score;
     for (unsigned scale = 0; scale < 4; ++scale) {
         if (scale > 0) {
@@ -786,22 +756,30 @@ static int extract(VmafFeatureExtractor *fex,
         }
 
         if (ref_pic->bpc == 8 && scale == 0) {
-            s->vif_statistic_8(&s->public, &vif_score.scale[scale].num, &vif_score.scale[scale].den, w, h);
+            s->vif_statistic_8(&s->public, num[scale], &vif_score.scale[scale].den, w, h);
         }
         else {
-            s->vif_statistic_16(&s->public, &vif_score.scale[scale].num, &vif_score.scale[scale].den, w, h, ref_pic->bpc, scale);
+            s->vif_statistic_16(&s->public, num[scale], &vif_score.scale[scale].den, w, h, ref_pic->bpc, scale);
         }
 
     }
 
-    return write_scores(feature_collector, index, vif_score, s);
+    int err = 0;
+    for (unsigned k = 0; k < s->public.enhn_gain_limit_cnt; k++) {
+        for (unsigned scale = 0; scale < 4; ++scale)
+            vif_score.scale[scale].num = num[scale][k];
+        err |= write_scores(feature_collector, index, vif_score,
+                            s->feature_name_dict[k], s->debug);
+    }
+    return err;
 }
 
 static int close(VmafFeatureExtractor *fex)
 {
     VifState *s = fex->priv;
     if (s->public.buf.data) aligned_free(s->public.buf.data);
-    vmaf_dictionary_free(&s->feature_name_dict);
+    for (unsigned k = 0; k < s->public.enhn_gain_limit_cnt; k++)
+        vmaf_dictionary_free(&s->feature_name_dict[k]);
     return 0;
 }
 
@@ -823,4 +801,9 @@ VmafFeatureExtractor vmaf_fex_integer_vif = {
     .close = close,
     .priv_size = sizeof(VifState),
     .provided_features = provided_features,
+    .variant = {
+        .option = "vif_enhn_gain_limit",
+        .list_option = "vif_enhn_gain_limit_variants",
+        .max_cnt = VIF_MAX_ENHN_GAIN_LIMITS,
+    },
 };
@@ -28,6 +28,9 @@
 #define DEFAULT_VIF_ENHN_GAIN_LIMIT (100.0)
 #endif // !DEFAULT_VIF_ENHN_GAIN_LIMIT
 
+/* Number of enhancement gain limits which can be computed in one pass */
+#define VIF_MAX_ENHN_GAIN_LIMITS 4
+
 static const uint16_t vif_filter1d_table[4][18] = {
     { 489, 935, 1640, 2640, 3896, 5274, 6547, 7455, 7784, 7455, 6547, 5274, 3896, 2640, 1640, 935, 489, 0 },
     { 1244, 3663, 7925, 12590, 14692, 12590, 7925, 3663, 1244, 0 },
@@ -67,7 +70,7 @@ typedef struct VifBuffer {
 } VifBuffer;
 
 typedef struct VifResiduals {
-    int64_t accum_num_log;
+    int64_t accum_num_log[VIF_MAX_ENHN_GAIN_LIMITS];
     int64_t accum_den_log;
     int64_t accum_num_non_log;
     int64_t accum_den_non_log;
@@ -75,8 +78,12 @@ typedef struct VifResiduals {
 
 typedef struct VifPublicState {
     VifBuffer buf;
-    uint16_t log2_table[65537];
+    const uint16_t *log2_table; ///< Shared by all contexts.
     double vif_enhn_gain_limit;
+    /* vif_enhn_gain_limit and its variants, the filtering and the local
+     * statistics are shared, only the numerator is computed for each */
+    double enhn_gain_limit[VIF_MAX_ENHN_GAIN_LIMITS];
+    unsigned enhn_gain_limit_cnt;
 } VifPublicState;
 
 static inline void PADDING_SQ_DATA(VifBuffer buf, int w, unsigned fwidth_half)
@@ -115,6 +122,9 @@ static inline void PADDING_SQ_DATA_2(VifBuffer buf, int w, unsigned fwidth_half)
     }
 }
 
+/*
+ * num receives one numerator per enhancement gain limit in s->enhn_gain_limit
+ */
 void vif_statistic_8(struct VifPublicState *s, float *num, float *den, unsigned w, unsigned h);
 void vif_statistic_16(struct VifPublicState *s, float *num, float *den, unsigned w, unsigned h, int bpc, int scale);
 
@@ -157,4 +167,43 @@ static inline int32_t log2_64(const uint16_t *log2_table, uint64_t temp)
     return log2_table[temp] + 2048 * k;
 }
 
+/*
+ * In floating-point numerator = log2((1.0f + (g * g * sigma1_sq)/(sv_sq + sigma_nsq))
+ *
+ * In Fixed-point the above is converted to
+ * numerator = log2((sv_sq + sigma_nsq)+(g * g * sigma1_sq))- log2(sv_sq + sigma_nsq)
+ *
+ * It is accumulated for every enhancement gain limit, only g is clamped
+ * differently, so log2(sv_sq + sigma_nsq) and clamped values of g which
+ * repeat are shared.
+ */
+static inline void vif_accumulate_num_log(const VifPublicState *s,
+                                          int64_t *accum_num_log,
+                                          int32_t sigma1_sq, int32_t sigma2_sq,
+                                          int32_t sigma12)
+{
+    static const int32_t sigma_nsq = 65536 << 1;
+    const double eps = 65536 * 1.0e-10;
+    const double g = sigma12 / (sigma1_sq + eps); // this epsilon can go away
+    int32_t sv_sq = sigma2_sq - g * sigma12;
+
+    sv_sq = (uint32_t)(sv_sq > 0 ? sv_sq : 0);
+
+    const uint32_t numer1 = (sv_sq + sigma_nsq);
+    const int32_t numer1_log = log2_64(s->log2_table, numer1);
+
+    double g_prev = -1.0;
+    int32_t num_log = 0;
+    for (unsigned k = 0; k < s->enhn_gain_limit_cnt; k++) {
+        const double g_k =
+            g < s->enhn_gain_limit[k] ? g : s->enhn_gain_limit[k];
+        if (g_k != g_prev) {
+            int64_t numer1_tmp = (int64_t)((g_k * g_k * sigma1_sq)) + numer1; //numerator
+            num_log = log2_64(s->log2_table, numer1_tmp) - numer1_log;
+            g_prev = g_k;
+        }
+        accum_num_log[k] += num_log;
+    }
+}
+
 #endif /* _FEATURE_VIF_H_ */
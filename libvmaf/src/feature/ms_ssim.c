@@ -16,23 +16,23 @@
  *
  */
 
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <limits.h>
+#include <errno.h>
+#include <math.h>
 #include <stddef.h>
-#include <stdint.h>
+#include <stdio.h>
 #include <string.h>
-#include <math.h>
 
+#include "cpu.h"
 #include "mem.h"
-#include "iqa/math_utils.h"
-#include "iqa/decimate.h"
+#include "ms_ssim.h"
 #include "iqa/ssim_tools.h"
 
+#if ARCH_X86
+#include "x86/ms_ssim_avx2.h"
+#endif
+
 /* Low-pass filter for down-sampling (9/7 biorthogonal wavelet filter) */
-#define LPF_LEN 9
-static const float g_lpf[LPF_LEN][LPF_LEN] = {
+static const float g_lpf[MS_SSIM_LPF_LEN][MS_SSIM_LPF_LEN] = {
    { 0.000714f,-0.000450f,-0.002090f, 0.007132f, 0.016114f, 0.007132f,-0.002090f,-0.000450f, 0.000714f},
    {-0.000450f, 0.000283f, 0.001316f,-0.004490f,-0.010146f,-0.004490f, 0.001316f, 0.000283f,-0.000450f},
    {-0.002090f, 0.001316f, 0.006115f,-0.020867f,-0.047149f,-0.020867f, 0.006115f, 0.001316f,-0.002090f},
@@ -44,280 +44,247 @@ static const float g_lpf[LPF_LEN][LPF_LEN] = {
    { 0.000714f,-0.000450f,-0.002090f, 0.007132f, 0.016114f, 0.007132f,-0.002090f,-0.000450f, 0.000714f},
 };
 
-static const float g_lpf_h[LPF_LEN] = {
-    0.026727f, -0.016828f, -0.078201f, 0.266846f, 0.602914f, 0.266846f, -0.078201f, -0.016828f, 0.026727f
-};
-
-static const float g_lpf_v[LPF_LEN] = {
-    0.026727f, -0.016828f, -0.078201f, 0.266846f, 0.602914f, 0.266846f, -0.078201f, -0.016828f, 0.026727f
-};
-
 /* Alpha, beta, and gamma values for each scale */
 static float g_alphas[] = { 0.0000f, 0.0000f, 0.0000f, 0.0000f, 0.1333f };
 static float g_betas[]  = { 0.0448f, 0.2856f, 0.3001f, 0.2363f, 0.1333f };
 static float g_gammas[] = { 0.0448f, 0.2856f, 0.3001f, 0.2363f, 0.1333f };
 
-struct _context {
-    double l;  /* Luminance */
-    double c;  /* Contrast */
-    double s;  /* Structure */
-    float alpha;
-    float beta;
-    float gamma;
-};
+#define BORDER (MS_SSIM_LPF_LEN / 2)
 
-/* Called for each pixel */
-int _ms_ssim_map(const struct _ssim_int *si, void *ctx)
+/*
+ * The filters below compute exactly what _iqa_decimate() and _iqa_ssim()
+ * compute for the default arguments: products in single precision, summed in
+ * double precision in the same order, and the same mix of single and double
+ * precision in the per pixel terms. Rows are streamed through a ring of
+ * horizontally filtered statistics instead of filtering whole planes.
+ */
+
+static void decimate_row(const float *src, ptrdiff_t stride,
+                         const float *kernel, int w, float *dst)
 {
-    struct _context *ms_ctx = (struct _context*)ctx;
-    ms_ctx->l += si->l;
-    ms_ctx->c += si->c;
-    ms_ctx->s += si->s;
-    return 0;
+    for (int x = 0; x < w; x++) {
+        const float *p = src - BORDER * stride + 2 * x - BORDER;
+        double sum = 0.0;
+        for (int v = 0; v < MS_SSIM_LPF_LEN; v++, p += stride) {
+            for (int u = 0; u < MS_SSIM_LPF_LEN; u++)
+                sum += p[u] * kernel[v * MS_SSIM_LPF_LEN + u];
+        }
+        dst[x] = (float)sum;
+    }
 }
 
-/* Called to calculate the final result */
-float _ms_ssim_reduce(int w, int h, void *ctx)
+static void hfilter(const float *ref, const float *cmp, const float *kernel,
+                    int w, float *maps, ptrdiff_t stride)
 {
-    double size = (double)(w*h);
-    struct _context *ms_ctx = (struct _context*)ctx;
-    ms_ctx->l = pow(ms_ctx->l / size, (double)ms_ctx->alpha);
-    ms_ctx->c = pow(ms_ctx->c / size, (double)ms_ctx->beta);
-    ms_ctx->s = pow(fabs(ms_ctx->s / size), (double)ms_ctx->gamma);
-    return (float)(ms_ctx->l * ms_ctx->c * ms_ctx->s);
+    for (int x = 0; x < w; x++) {
+        double mu1 = 0.0, mu2 = 0.0, s11 = 0.0, s22 = 0.0, s12 = 0.0;
+        for (int k = 0; k < MS_SSIM_WINDOW_LEN; k++) {
+            const float r = ref[x + k], c = cmp[x + k];
+            mu1 += r * kernel[k];
+            mu2 += c * kernel[k];
+            s11 += (r * r) * kernel[k];
+            s22 += (c * c) * kernel[k];
+            s12 += (r * c) * kernel[k];
+        }
+        maps[x] = (float)mu1;
+        maps[stride + x] = (float)mu2;
+        maps[2 * stride + x] = (float)s11;
+        maps[3 * stride + x] = (float)s22;
+        maps[4 * stride + x] = (float)s12;
+    }
 }
 
-/* Releases the scaled buffers */
-void _free_buffers(float **buf, int scales)
+static void vfilter_terms(float *const *rows, ptrdiff_t stride,
+                          const float *kernel, int w,
+                          double *l, double *c, double *s)
 {
-    int idx;
-    for (idx=0; idx<scales; ++idx)
-        free(buf[idx]);
+    const float C1 = MS_SSIM_C1, C2 = MS_SSIM_C2, C3 = MS_SSIM_C3;
+
+    for (int x = 0; x < w; x++) {
+        float m[5];
+        for (int i = 0; i < 5; i++) {
+            double sum = 0.0;
+            for (int k = 0; k < MS_SSIM_WINDOW_LEN; k++)
+                sum += rows[k][i * stride + x] * kernel[k];
+            m[i] = (float)sum;
+        }
+        const float mu1 = m[0], mu2 = m[1];
+        float sigma1_sqd = m[2] - mu1 * mu1;
+        float sigma2_sqd = m[3] - mu2 * mu2;
+        const float sigma12 = m[4] - mu1 * mu2;
+        sigma1_sqd = 0.0 > sigma1_sqd ? 0.0 : sigma1_sqd;
+        sigma2_sqd = 0.0 > sigma2_sqd ? 0.0 : sigma2_sqd;
+
+        const float sigma1_sigma2 = sqrt(sigma1_sqd * sigma2_sqd);
+        l[x] = (2.0 * mu1 * mu2 + C1) / (mu1 * mu1 + mu2 * mu2 + C1);
+        c[x] = (2.0 * sigma1_sigma2 + C2) / (sigma1_sqd + sigma2_sqd + C2);
+        /* a flat window may give a slightly negative sigma12, see _iqa_ssim() */
+        const float clamped_sigma12 =
+            (sigma12 < 0.0f && sigma1_sigma2 <= 0.0f) ? 0.0f : sigma12;
+        s[x] = (clamped_sigma12 + C3) / (sigma1_sigma2 + C3);
+    }
 }
 
-/* Allocates the scaled buffers. If error, all buffers are free'd */
-int _alloc_buffers(float **buf, int w, int h, int scales)
+static void pad_level(float *img, ptrdiff_t stride, int w, int h)
 {
-    int idx;
-    int cur_w = w;
-    int cur_h = h;
-    for (idx=0; idx<scales; ++idx) {
-        buf[idx] = (float*)malloc(cur_w*cur_h*sizeof(float));
-        if (!buf[idx]) {
-            _free_buffers(buf, idx);
-            return 1;
+    for (int y = 0; y < h; y++) {
+        float *p = img + y * stride;
+        for (int i = 0; i < BORDER; i++) {
+            p[-1 - i] = p[i];
+            p[w + i] = p[w - 1 - i];
         }
-        cur_w = cur_w/2 + (cur_w&1);
-        cur_h = cur_h/2 + (cur_h&1);
     }
-    return 0;
+    for (int i = 0; i < BORDER; i++) {
+        memcpy(img - (1 + i) * stride - BORDER, img + i * stride - BORDER,
+               (w + 2 * BORDER) * sizeof(*img));
+        memcpy(img + (h + i) * stride - BORDER,
+               img + (h - 1 - i) * stride - BORDER,
+               (w + 2 * BORDER) * sizeof(*img));
+    }
 }
 
-int compute_ms_ssim(const float *ref, const float *cmp, int w, int h,
-        int ref_stride, int cmp_stride, double *score,
-        double* l_scores, double* c_scores, double* s_scores)
+static void decimate(MsSsimBuffer *buf, float *const img[MS_SSIM_SCALES],
+                     int idx)
 {
-
-    int ret = 1;
-
-    int wang=1; /* set default to wang's ms_ssim */
-    int scales=SCALES;
-    int gauss=1;
-    const float *alphas=g_alphas, *betas=g_betas, *gammas=g_gammas;
-    int idx,x,y,cur_w,cur_h;
-    int offset,src_offset;
-    float **ref_imgs, **cmp_imgs; /* Array of pointers to scaled images */
-    double msssim;
-    float l, c, s;
-    struct _kernel lpf, window;
-    struct iqa_ssim_args s_args;
-    struct _map_reduce mr;
-    struct _context ms_ctx;
-
-    /* check stride */
-    int stride = ref_stride; /* stride in bytes */
-    if (stride != cmp_stride)
-    {
-        printf("error: for ms_ssim, ref_stride (%d) != dis_stride (%d) bytes.\n", ref_stride, cmp_stride);
-        fflush(stdout);
-        goto fail_or_end;
-    }
-    stride /= sizeof(float); /* stride_ in pixels */
-
-    /* specify some default parameters */
-    const struct iqa_ms_ssim_args *args = 0; /* 0 for default */
-
-    /* initialize algorithm parameters */
-    if (args) {
-        wang   = args->wang;
-        gauss  = args->gaussian;
-        scales = args->scales;
-        if (args->alphas)
-            alphas = args->alphas;
-        if (args->betas)
-            betas  = args->betas;
-        if (args->gammas)
-            gammas = args->gammas;
+    const ptrdiff_t stride = buf->stride[idx - 1];
+    pad_level(img[idx - 1], stride, buf->w[idx - 1], buf->h[idx - 1]);
+    for (int y = 0; y < buf->h[idx]; y++) {
+        buf->decimate_row(img[idx - 1] + 2 * y * stride, stride,
+                          &g_lpf[0][0], buf->w[idx],
+                          img[idx] + y * buf->stride[idx]);
     }
+}
 
-    /* make sure we won't scale below 1x1 */
-    cur_w = w;
-    cur_h = h;
-    for (idx=0; idx<scales; ++idx) {
-        if ( gauss ? cur_w<GAUSSIAN_LEN || cur_h<GAUSSIAN_LEN : cur_w<LPF_LEN || cur_h<LPF_LEN )
-        {
-            printf("error: scale below 1x1!\n");
-            goto fail_or_end;
+static void ssim(MsSsimBuffer *buf, int idx, float *l_mean, float *c_mean,
+                 float *s_mean)
+{
+    const int w = buf->w[idx] - MS_SSIM_WINDOW_LEN + 1;
+    const int h = buf->h[idx] - MS_SSIM_WINDOW_LEN + 1;
+    const ptrdiff_t maps_sz = 5 * buf->maps_stride;
+    float *rows[MS_SSIM_WINDOW_LEN];
+    double l_sum = 0.0, c_sum = 0.0, s_sum = 0.0;
+
+    for (int y = 0; y < buf->h[idx]; y++) {
+        buf->hfilter(buf->ref[idx] + y * buf->stride[idx],
+                     buf->cmp[idx] + y * buf->stride[idx],
+                     g_gaussian_window_h, w,
+                     buf->maps + (y % MS_SSIM_WINDOW_LEN) * maps_sz,
+                     buf->maps_stride);
+        if (y < MS_SSIM_WINDOW_LEN - 1) continue;
+
+        for (int k = 0; k < MS_SSIM_WINDOW_LEN; k++) {
+            const int i = (y + 1 - MS_SSIM_WINDOW_LEN + k) % MS_SSIM_WINDOW_LEN;
+            rows[k] = buf->maps + i * maps_sz;
+        }
+        buf->vfilter_terms(rows, buf->maps_stride, g_gaussian_window_v, w,
+                           buf->l, buf->c, buf->s);
+        for (int x = 0; x < w; x++) {
+            l_sum += buf->l[x];
+            c_sum += buf->c[x];
+            s_sum += buf->s[x];
         }
-        cur_w /= 2;
-        cur_h /= 2;
     }
 
-    window.kernel = (float*)g_square_window;
-    window.kernel_h = (float*)g_square_window_h; /* zli-nflx */
-    window.kernel_v = (float*)g_square_window_v; /* zli-nflx */
-    window.w = window.h = SQUARE_LEN;
-    window.normalized = 1;
-    window.bnd_opt = KBND_SYMMETRIC;
-    if (gauss) {
-        window.kernel = (float*)g_gaussian_window;
-        window.kernel_h = (float*)g_gaussian_window_h; /* zli-nflx */
-        window.kernel_v = (float*)g_gaussian_window_v; /* zli-nflx */
-        window.w = window.h = GAUSSIAN_LEN;
+    *l_mean = (float)(l_sum / (double)(w * h));
+    *c_mean = (float)(c_sum / (double)(w * h));
+    *s_mean = (float)(s_sum / (double)(w * h));
+}
+
+int ms_ssim_buffer_init(MsSsimBuffer *buf, unsigned w, unsigned h)
+{
+    memset(buf, 0, sizeof(*buf));
+
+    /* make sure we won't scale below the SSIM window */
+    for (unsigned idx = 0, cur_w = w, cur_h = h; idx < MS_SSIM_SCALES; ++idx) {
+        if (cur_w < GAUSSIAN_LEN || cur_h < GAUSSIAN_LEN)
+            return -EINVAL;
+        cur_w /= 2;
+        cur_h /= 2;
     }
 
-    mr.map     = _ms_ssim_map;
-    mr.reduce  = _ms_ssim_reduce;
-
-    /* allocate the scaled image buffers */
-    ref_imgs = (float**)malloc(scales*sizeof(float*));
-    cmp_imgs = (float**)malloc(scales*sizeof(float*));
-    if (!ref_imgs || !cmp_imgs) {
-        if (ref_imgs) free(ref_imgs);
-        if (cmp_imgs) free(cmp_imgs);
-        printf("error: unable to malloc ref_imgs or cmp_imgs.\n");
-        fflush(stdout);
-        goto fail_or_end;
+    /*
+     The filters work on whole vectors of 8 and may read and write past the
+     end of a row, so rows are padded well beyond the mirrored border.
+    */
+    size_t data_sz = 0;
+    for (unsigned idx = 0; idx < MS_SSIM_SCALES; ++idx) {
+        buf->w[idx] = idx ? (buf->w[idx - 1] + 1) / 2 : (int)w;
+        buf->h[idx] = idx ? (buf->h[idx - 1] + 1) / 2 : (int)h;
+        buf->stride[idx] =
+            ALIGN_CEIL((buf->w[idx] + 2 * BORDER + 32) * sizeof(float)) /
+            sizeof(float);
+        data_sz += 2 * (buf->h[idx] + 2 * BORDER + 1) * buf->stride[idx];
     }
-    if (_alloc_buffers(ref_imgs, w, h, scales)) {
-        free(ref_imgs);
-        free(cmp_imgs);
-        printf("error: unable to _alloc_buffers on ref_imgs.\n");
-        fflush(stdout);
-        goto fail_or_end;
+    buf->maps_stride = ALIGN_CEIL(w * sizeof(float)) / sizeof(float);
+    data_sz += MS_SSIM_WINDOW_LEN * 5 * buf->maps_stride;
+    data_sz += 3 * 2 * buf->maps_stride;
+
+    buf->data = aligned_malloc(data_sz * sizeof(float), 32);
+    if (!buf->data) return -ENOMEM;
+    memset(buf->data, 0, data_sz * sizeof(float));
+
+    float *p = buf->data;
+    for (unsigned idx = 0; idx < MS_SSIM_SCALES; ++idx) {
+        const size_t sz = (buf->h[idx] + 2 * BORDER + 1) * buf->stride[idx];
+        buf->ref[idx] = p + BORDER * buf->stride[idx] + BORDER;
+        buf->cmp[idx] = p + sz + BORDER * buf->stride[idx] + BORDER;
+        p += 2 * sz;
     }
-    if (_alloc_buffers(cmp_imgs, w, h, scales)) {
-        _free_buffers(ref_imgs, scales);
-        free(ref_imgs);
-        free(cmp_imgs);
-        printf("error: unable to _alloc_buffers on cmp_imgs.\n");
-        fflush(stdout);
-        goto fail_or_end;
+    buf->maps = p;
+    p += MS_SSIM_WINDOW_LEN * 5 * buf->maps_stride;
+    buf->l = (double*) p;
+    buf->c = buf->l + buf->maps_stride;
+    buf->s = buf->c + buf->maps_stride;
+
+    buf->decimate_row = decimate_row;
+    buf->hfilter = hfilter;
+    buf->vfilter_terms = vfilter_terms;
+#if ARCH_X86
+    unsigned flags = vmaf_get_cpu_flags();
+    if (flags & VMAF_X86_CPU_FLAG_AVX2) {
+        buf->decimate_row = ms_ssim_decimate_row_avx2;
+        buf->hfilter = ms_ssim_hfilter_avx2;
+        buf->vfilter_terms = ms_ssim_vfilter_terms_avx2;
     }
+#endif
 
-    /* copy original images into first scale buffer, forcing stride = width. */
-    for (y=0; y<h; ++y) {
-        src_offset = y * stride;
-        offset = y * w;
-        for (x=0; x<w; ++x, ++offset, ++src_offset) {
-            ref_imgs[0][offset] = (float)ref[src_offset];
-            cmp_imgs[0][offset] = (float)cmp[src_offset];
-        }
-    }
+    return 0;
+}
 
-    /* create scaled versions of the images */
-    cur_w=w;
-    cur_h=h;
-    lpf.kernel = (float*)g_lpf;
-    lpf.kernel_h = (float*)g_lpf_h; /* zli-nflx */
-    lpf.kernel_v = (float*)g_lpf_v; /* zli-nflx */
-    lpf.w = lpf.h = LPF_LEN;
-    lpf.normalized = 1;
-    lpf.bnd_opt = KBND_SYMMETRIC;
-    for (idx=1; idx<scales; ++idx) {
-        if (_iqa_decimate(ref_imgs[idx-1], cur_w, cur_h, 2, &lpf, ref_imgs[idx], 0, 0) ||
-            _iqa_decimate(cmp_imgs[idx-1], cur_w, cur_h, 2, &lpf, cmp_imgs[idx], &cur_w, &cur_h))
-        {
-            _free_buffers(ref_imgs, scales);
-            _free_buffers(cmp_imgs, scales);
-            free(ref_imgs);
-            free(cmp_imgs);
-            printf("error: decimation fails on ref_imgs or cmp_imgs.\n");
-            fflush(stdout);
-            goto fail_or_end;
-        }
-    }
+void ms_ssim_buffer_free(MsSsimBuffer *buf)
+{
+    aligned_free(buf->data);
+    buf->data = NULL;
+}
 
-    cur_w=w;
-    cur_h=h;
-    msssim = 1.0;
-    for (idx=0; idx<scales; ++idx) {
-
-        ms_ctx.l = 0;
-        ms_ctx.c = 0;
-        ms_ctx.s = 0;
-        ms_ctx.alpha = alphas[idx];
-        ms_ctx.beta  = betas[idx];
-        ms_ctx.gamma = gammas[idx];
-
-        if (!wang) {
-            /* MS-SSIM* (Rouse/Hemami) */
-            s_args.alpha = 1.0f;
-            s_args.beta  = 1.0f;
-            s_args.gamma = 1.0f;
-            s_args.K1 = 0.0f; /* Force stabilization constants to 0 */
-            s_args.K2 = 0.0f;
-            s_args.L  = 255;
-            s_args.f  = 1; /* Don't resize */
-            mr.context = &ms_ctx;
-            _iqa_ssim(ref_imgs[idx], cmp_imgs[idx], cur_w, cur_h, &window, &mr, &s_args, &l, &c, &s);
-        }
-        else {
-            /* MS-SSIM (Wang) */
-            /*
-            s_args.alpha = 1.0f;
-            s_args.beta  = 1.0f;
-            s_args.gamma = 1.0f;
-            s_args.K1 = 0.01f;
-            s_args.K2 = 0.03f;
-            s_args.L  = 255;
-            s_args.f  = 1; // Don't resize
-            mr.context = &ms_ctx;
-            msssim *= _iqa_ssim(ref_imgs[idx], cmp_imgs[idx], cur_w, cur_h, &window, &mr, &s_args, &l, &c, &s);
-            */
-
-            /* above is equivalent to passing default parameter: */
-            _iqa_ssim(ref_imgs[idx], cmp_imgs[idx], cur_w, cur_h, &window, NULL, NULL, &l, &c, &s);
+int compute_ms_ssim(MsSsimBuffer *buf, double *score,
+                    double* l_scores, double* c_scores, double* s_scores)
+{
+    double msssim = 1.0;
+
+    for (int idx = 0; idx < MS_SSIM_SCALES; ++idx) {
+        float l, c, s;
 
+        /* create the scaled versions of the images, straight from the last */
+        if (idx) {
+            decimate(buf, buf->ref, idx);
+            decimate(buf, buf->cmp, idx);
         }
 
-        msssim *= pow(l, alphas[idx]) * pow(c, betas[idx]) * pow(s, gammas[idx]);
+        ssim(buf, idx, &l, &c, &s);
+
+        msssim *= pow(l, g_alphas[idx]) * pow(c, g_betas[idx]) * pow(s, g_gammas[idx]);
         l_scores[idx] = l;
         c_scores[idx] = c;
         s_scores[idx] = s;
 
         if (msssim == INFINITY) {
-            _free_buffers(ref_imgs, scales);
-            _free_buffers(cmp_imgs, scales);
-            free(ref_imgs);
-            free(cmp_imgs);
             printf("error: ms_ssim is INFINITY.\n");
             fflush(stdout);
-            goto fail_or_end;
+            return 1;
         }
-        cur_w = cur_w/2 + (cur_w&1);
-        cur_h = cur_h/2 + (cur_h&1);
     }
 
-    _free_buffers(ref_imgs, scales);
-    _free_buffers(cmp_imgs, scales);
-    free(ref_imgs);
-    free(cmp_imgs);
-
     *score = msssim;
-
-    ret = 0;
-fail_or_end:
-    return ret;
-
+    return 0;
 }
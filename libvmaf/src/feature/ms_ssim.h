@@ -16,6 +16,52 @@
  *
  */
 
-int compute_ms_ssim(const float *ref, const float *cmp, int w, int h,
-                    int ref_stride, int cmp_stride, double *score,
+#ifndef FEATURE_MS_SSIM_H_
+#define FEATURE_MS_SSIM_H_
+
+#include <stddef.h>
+
+#define MS_SSIM_SCALES 5
+
+/* 9/7 biorthogonal low-pass filter used for down-sampling */
+#define MS_SSIM_LPF_LEN 9
+/* Gaussian window of the SSIM statistics */
+#define MS_SSIM_WINDOW_LEN 11
+
+/* SSIM stabilization constants, for K1 = 0.01, K2 = 0.03 and L = 255 */
+#define MS_SSIM_C1 ((0.01f * 255) * (0.01f * 255))
+#define MS_SSIM_C2 ((0.03f * 255) * (0.03f * 255))
+#define MS_SSIM_C3 (MS_SSIM_C2 / 2.0f)
+
+/*
+ * Scale pyramids of both pictures and the scratch rows of the SSIM filters,
+ * allocated once for a given picture size. Each level is surrounded by a
+ * mirrored border of MS_SSIM_LPF_LEN / 2 samples for the down-sampling
+ * filter, and ref[0] and cmp[0] are written by the caller.
+ */
+typedef struct MsSsimBuffer {
+    float *ref[MS_SSIM_SCALES];
+    float *cmp[MS_SSIM_SCALES];
+    ptrdiff_t stride[MS_SSIM_SCALES];
+    int w[MS_SSIM_SCALES], h[MS_SSIM_SCALES];
+    float *data;
+    float *maps;
+    ptrdiff_t maps_stride;
+    double *l, *c, *s;
+    void (*decimate_row)(const float *src, ptrdiff_t stride,
+                         const float *kernel, int w, float *dst);
+    void (*hfilter)(const float *ref, const float *cmp, const float *kernel,
+                    int w, float *maps, ptrdiff_t stride);
+    void (*vfilter_terms)(float *const *rows, ptrdiff_t stride,
+                          const float *kernel, int w,
+                          double *l, double *c, double *s);
+} MsSsimBuffer;
+
+int ms_ssim_buffer_init(MsSsimBuffer *buf, unsigned w, unsigned h);
+
+void ms_ssim_buffer_free(MsSsimBuffer *buf);
+
+int compute_ms_ssim(MsSsimBuffer *buf, double *score,
                     double* l_scores, double* c_scores, double* s_scores);
+
+#endif /* FEATURE_MS_SSIM_H_ */
@@ -17,49 +17,147 @@
  */
 
 #include <stdint.h>
+#include <stdio.h>
 
 #include <libvmaf/picture.h>
 
-void picture_copy_hbd(float *dst, ptrdiff_t dst_stride,
-                      VmafPicture *src, int offset, float scaler)
+#include "common/convolution.h"
+#include "cpu.h"
+#include "picture.h"
+#include "picture_copy.h"
+
+#if ARCH_X86
+#include "x86/picture_copy_avx2.h"
+#elif ARCH_AARCH64
+#include "arm64/picture_copy_neon.h"
+#endif
+
+/*
+ * All scalers are powers of two, so multiplying with the reciprocal gives
+ * the same result as dividing by the scaler.
+ */
+static int picture_copy_params(unsigned bpc, float *scale)
 {
-    float *float_data = dst;
-    uint16_t *data = src->data[0];
-
-    for (unsigned i = 0; i < src->h[0]; i++) {
-        for (unsigned j = 0; j < src->w[0]; j++) {
-            float_data[j] = (float) data[j] / scaler + offset;
-        }
-        float_data += dst_stride / sizeof(float);
-        data += src->stride[0] / 2;
+    switch (bpc) {
+    case 10:
+        *scale = 1.0f / 4.0f;
+        return 1;
+    case 12:
+        *scale = 1.0f / 16.0f;
+        return 1;
+    case 16:
+        *scale = 1.0f / 256.0f;
+        return 1;
+    default:
+        *scale = 1.0f;
+        return 0;
+    }
+}
+
+static void picture_copy_u8_c(float *dst, ptrdiff_t dst_stride,
+                              const uint8_t *src, ptrdiff_t src_stride,
+                              unsigned w, unsigned h, float scale, float offset)
+{
+    (void) scale;
+
+    for (unsigned i = 0; i < h; i++) {
+        for (unsigned j = 0; j < w; j++)
+            dst[j] = (float) src[j] + offset;
+        dst += dst_stride / sizeof(float);
+        src += src_stride;
+    }
+}
+
+static void picture_copy_u16_c(float *dst, ptrdiff_t dst_stride,
+                               const uint16_t *src, ptrdiff_t src_stride,
+                               unsigned w, unsigned h, float scale,
+                               float offset)
+{
+    for (unsigned i = 0; i < h; i++) {
+        for (unsigned j = 0; j < w; j++)
+            dst[j] = (float) src[j] * scale + offset;
+        dst += dst_stride / sizeof(float);
+        src += src_stride / 2;
     }
-    return;
 }
 
 void picture_copy(float *dst, ptrdiff_t dst_stride,
                   VmafPicture *src, int offset, unsigned bpc)
 {
-    if (bpc == 10) {
-        picture_copy_hbd(dst, dst_stride, src, offset, 4.0f);
-        return;
-    } else if (bpc == 12) {
-        picture_copy_hbd(dst, dst_stride, src, offset, 16.0f);
-        return;
-    } else if (bpc == 16) {
-        picture_copy_hbd(dst, dst_stride, src, offset, 256.0f);
-        return;
+    float scale;
+    const int hbd = picture_copy_params(bpc, &scale);
+
+    void (*copy_u8)(float *dst, ptrdiff_t dst_stride, const uint8_t *src,
+                    ptrdiff_t src_stride, unsigned w, unsigned h, float scale,
+                    float offset) = picture_copy_u8_c;
+    void (*copy_u16)(float *dst, ptrdiff_t dst_stride, const uint16_t *src,
+                     ptrdiff_t src_stride, unsigned w, unsigned h, float scale,
+                     float offset) = picture_copy_u16_c;
+
+#if ARCH_X86
+    const unsigned flags = vmaf_get_cpu_flags();
+    if (flags & VMAF_X86_CPU_FLAG_AVX2) {
+        copy_u8 = picture_copy_u8_avx2;
+        copy_u16 = picture_copy_u16_avx2;
+    }
+#elif ARCH_AARCH64
+    const unsigned flags = vmaf_get_cpu_flags();
+    if (flags & VMAF_ARM_CPU_FLAG_NEON) {
+        copy_u8 = picture_copy_u8_neon;
+        copy_u16 = picture_copy_u16_neon;
     }
+#endif
 
-    float *float_data = dst;
-    uint8_t *data = src->data[0];
+    if (hbd) {
+        copy_u16(dst, dst_stride, src->data[0], src->stride[0], src->w[0],
+                 src->h[0], scale, offset);
+    } else {
+        copy_u8(dst, dst_stride, src->data[0], src->stride[0], src->w[0],
+                src->h[0], scale, offset);
+    }
+}
 
-    for (unsigned i = 0; i < src->h[0]; i++) {
-        for (unsigned j = 0; j < src->w[0]; j++) {
-            float_data[j] = (float) data[j] + offset;
-        }
-        float_data += dst_stride / sizeof(float);
-        data += src->stride[0];
+void picture_copy_convolution(const float *filter, int filter_width,
+                              VmafPicture *src, int offset,
+                              float *dst, float *tmp, ptrdiff_t dst_stride)
+{
+    float scale;
+    const int hbd = picture_copy_params(src->bpc, &scale);
+
+    convolution_pic_c_s(filter, filter_width, src->data[0], dst, tmp,
+                        src->w[0], src->h[0], src->stride[0],
+                        dst_stride / sizeof(float), hbd, scale, offset);
+}
+
+struct PictureCopyCookie {
+    VmafPicture *src;
+    ptrdiff_t stride;
+    int offset;
+};
+
+static int produce_picture_copy(void *data, void *cookie)
+{
+    struct PictureCopyCookie *c = cookie;
+    picture_copy(data, c->stride, c->src, c->offset, c->src->bpc);
+    return 0;
+}
+
+const float *picture_copy_shared(float *buf, ptrdiff_t dst_stride,
+                                 VmafPicture *src, int offset)
+{
+    char key[32];
+    snprintf(key, sizeof(key), "picture_copy_%d", offset);
+    if (vmaf_picture_artifact_shared(src, key)) {
+        struct PictureCopyCookie cookie = {
+            .src = src, .stride = dst_stride, .offset = offset,
+        };
+        const void *shared;
+        int err = vmaf_picture_artifact_get(src, key, dst_stride * src->h[0],
+                                            produce_picture_copy, &cookie,
+                                            &shared);
+        if (!err) return shared;
     }
 
-    return;
+    picture_copy(buf, dst_stride, src, offset, src->bpc);
+    return buf;
 }
@@ -19,3 +19,26 @@
 
 void picture_copy(float *dst, ptrdiff_t dst_stride, VmafPicture *src,
                   int offset, unsigned bpc);
+
+/*
+ * Same as picture_copy() followed by convolution_f32_c_s(), without writing
+ * the converted picture: the conversion is done in the vertical filter pass.
+ * `tmp` must be at least as large as `dst`, `dst_stride` is in bytes.
+ */
+void picture_copy_convolution(const float *filter, int filter_width,
+                              VmafPicture *src, int offset,
+                              float *dst, float *tmp, ptrdiff_t dst_stride);
+
+/* Name of the shared artifact written by picture_copy_shared(). */
+#define PICTURE_COPY_ARTIFACT(offset) "picture_copy_" #offset
+
+/*
+ * Same as picture_copy(), but when other feature extractors declared the
+ * same artifact for `src` (see picture.h), the converted luma plane is
+ * produced once per picture and shared with every other feature extractor
+ * using the same `offset`, and the returned plane lives in the cache and
+ * must not be written. Otherwise `buf` is filled and returned. All callers
+ * must use the same `dst_stride`.
+ */
+const float *picture_copy_shared(float *buf, ptrdiff_t dst_stride,
+                                 VmafPicture *src, int offset);
@@ -31,10 +31,17 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdint.h>
 #include <string.h>
 
+#include "cpu.h"
 #include "feature_collector.h"
 #include "feature_extractor.h"
 #include "log.h"
 
+#if ARCH_X86
+#include "x86/psnr_hvs_avx2.h"
+#elif ARCH_AARCH64
+#include "arm64/psnr_hvs_neon.h"
+#endif
+
 typedef int32_t od_coeff;
 
 #define OD_DCT_OVERFLOW_CHECK(val, scale, offset, idx)
@@ -337,6 +344,13 @@ static double calc_psnrhvs(const unsigned char *_src, int _systride,
     return ret;
 }
 
+typedef struct PsnrHvsState {
+    double (*calc_psnrhvs)(const unsigned char *_src, int _systride,
+                           const unsigned char *_dst, int _dystride,
+                           double _par, int depth, int _w, int _h, int _step,
+                           float _csf[8][8]);
+} PsnrHvsState;
+
 static double convert_score_db(double _score, double _weight)
 {
     return 10 * (-1 * log10(_weight * _score));
@@ -345,8 +359,7 @@ static double convert_score_db(double _score, double _weight)
 static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
                 unsigned bpc, unsigned w, unsigned h)
 {
-    (void) fex;
-    (void) bpc;
+    PsnrHvsState *s = fex->priv;
     (void) w;
     (void) h;
 
@@ -360,8 +373,19 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
 
     if (pix_fmt == VMAF_PIX_FMT_YUV400P)
         return -EINVAL;
-    else
-        return 0;
+
+    s->calc_psnrhvs = calc_psnrhvs;
+#if ARCH_X86
+    unsigned flags = vmaf_get_cpu_flags();
+    if (flags & VMAF_X86_CPU_FLAG_AVX2)
+        s->calc_psnrhvs = calc_psnrhvs_avx2;
+#elif ARCH_AARCH64
+    unsigned flags = vmaf_get_cpu_flags();
+    if (flags & VMAF_ARM_CPU_FLAG_NEON)
+        s->calc_psnrhvs = calc_psnrhvs_neon;
+#endif
+
+    return 0;
 }
 
 static int extract(VmafFeatureExtractor *fex, VmafPicture *ref_pic,
@@ -369,6 +393,7 @@ static int extract(VmafFeatureExtractor *fex, VmafPicture *ref_pic,
                    VmafPicture *dist_pic_90, unsigned index,
                    VmafFeatureCollector *feature_collector)
 {
+    PsnrHvsState *s = fex->priv;
     int err = 0;
 
     (void)ref_pic_90;
@@ -377,10 +402,10 @@ static int extract(VmafFeatureExtractor *fex, VmafPicture *ref_pic,
     double score[3];
     for (unsigned i = 0; i < 3; i++) {
         score[i] =
-            calc_psnrhvs(ref_pic->data[i], ref_pic->stride[i],
-                         dist_pic->data[i], dist_pic->stride[i], 1.0,
-                         ref_pic->bpc, ref_pic->w[i], ref_pic->h[i], 7,
-                         i == 0 ? csf_y : i == 1 ? csf_cb420 : csf_cr420);
+            s->calc_psnrhvs(ref_pic->data[i], ref_pic->stride[i],
+                            dist_pic->data[i], dist_pic->stride[i], 1.0,
+                            ref_pic->bpc, ref_pic->w[i], ref_pic->h[i], 7,
+                            i == 0 ? csf_y : i == 1 ? csf_cb420 : csf_cr420);
 
         err |= vmaf_feature_collector_append(feature_collector,
                                              fex->provided_features[i],
@@ -404,5 +429,6 @@ VmafFeatureExtractor vmaf_fex_psnr_hvs = {
     .name = "psnr_hvs",
     .init = init,
     .extract = extract,
+    .priv_size = sizeof(PsnrHvsState),
     .provided_features = provided_features,
 };
@@ -20,6 +20,70 @@
 
 #include <immintrin.h>
 
+/* w is a multiple of 8, so the last vector of a row may only have 8
+ * samples left. The picture may not be padded, do not read past them. */
+static inline __m128i dwt2_8_load_row(const uint8_t *src, int n)
+{
+    return n >= 16 ? _mm_loadu_si128((const __m128i *)src)
+                   : _mm_loadl_epi64((const __m128i *)src);
+}
+
+static inline void dwt2_8_hp_scalar(const int16_t *tmplo,
+                                    const int16_t *tmphi, int **ind_x,
+                                    const adm_dwt_band_t *dst, int i, int j,
+                                    int dst_stride)
+{
+    const int16_t *filter_lo = dwt2_db2_coeffs_lo;
+    const int16_t *filter_hi = dwt2_db2_coeffs_hi;
+
+    const int16_t shift_HP = 16;
+    const int32_t add_shift_HP = 32768;
+    int32_t accum;
+
+    int j0 = ind_x[0][j];
+    int j1 = ind_x[1][j];
+    int j2 = ind_x[2][j];
+    int j3 = ind_x[3][j];
+
+    int16_t s0 = tmplo[j0];
+    int16_t s1 = tmplo[j1];
+    int16_t s2 = tmplo[j2];
+    int16_t s3 = tmplo[j3];
+
+    accum = 0;
+    accum += (int32_t)filter_lo[0] * s0;
+    accum += (int32_t)filter_lo[1] * s1;
+    accum += (int32_t)filter_lo[2] * s2;
+    accum += (int32_t)filter_lo[3] * s3;
+    dst->band_a[i * dst_stride + j] = (accum + add_shift_HP) >> shift_HP;
+
+    accum = 0;
+    accum += (int32_t)filter_hi[0] * s0;
+    accum += (int32_t)filter_hi[1] * s1;
+    accum += (int32_t)filter_hi[2] * s2;
+    accum += (int32_t)filter_hi[3] * s3;
+    dst->band_v[i * dst_stride + j] = (accum + add_shift_HP) >> shift_HP;
+
+    s0 = tmphi[j0];
+    s1 = tmphi[j1];
+    s2 = tmphi[j2];
+    s3 = tmphi[j3];
+
+    accum = 0;
+    accum += (int32_t)filter_lo[0] * s0;
+    accum += (int32_t)filter_lo[1] * s1;
+    accum += (int32_t)filter_lo[2] * s2;
+    accum += (int32_t)filter_lo[3] * s3;
+    dst->band_h[i * dst_stride + j] = (accum + add_shift_HP) >> shift_HP;
+
+    accum = 0;
+    accum += (int32_t)filter_hi[0] * s0;
+    accum += (int32_t)filter_hi[1] * s1;
+    accum += (int32_t)filter_hi[2] * s2;
+    accum += (int32_t)filter_hi[3] * s3;
+    dst->band_d[i * dst_stride + j] = (accum + add_shift_HP) >> shift_HP;
+}
+
 void adm_dwt2_8_avx2(const uint8_t *src, const adm_dwt_band_t *dst,
                      AdmBuffer *buf, int w, int h, int src_stride,
                      int dst_stride)
@@ -27,14 +91,13 @@ void adm_dwt2_8_avx2(const uint8_t *src, const adm_dwt_band_t *dst,
     const int16_t *filter_lo = dwt2_db2_coeffs_lo;
     const int16_t *filter_hi = dwt2_db2_coeffs_hi;
 
-    const int16_t shift_HP = 16;
-    const int32_t add_shift_HP = 32768;
     int **ind_y = buf->ind_y;
     int **ind_x = buf->ind_x;
 
     int16_t *tmplo = (int16_t *)buf->tmp_ref;
-    int16_t *tmphi = tmplo + w;
-    int32_t accum;
+    /* The vertical pass stores whole vectors, keep tmphi clear of the
+     * last tmplo store. */
+    int16_t *tmphi = tmplo + ((w + 15) & ~15);
 
     __m256i dwt2_db2_coeffs_lo_sum_const = _mm256_set1_epi32(5931776);
     __m256i fl0 =
@@ -59,14 +122,14 @@ void adm_dwt2_8_avx2(const uint8_t *src, const adm_dwt_band_t *dst,
                 _mm256_setzero_si256();
             __m256i s0, s1, s2, s3;
 
-            s0 = _mm256_cvtepu8_epi16(_mm_loadu_si128(
-                (__m128i *)(src + (ind_y[0][i] * src_stride) + j)));
-            s1 = _mm256_cvtepu8_epi16(_mm_loadu_si128(
-                (__m128i *)(src + (ind_y[1][i] * src_stride) + j)));
-            s2 = _mm256_cvtepu8_epi16(_mm_loadu_si128(
-                (__m128i *)(src + (ind_y[2][i] * src_stride) + j)));
-            s3 = _mm256_cvtepu8_epi16(_mm_loadu_si128(
-                (__m128i *)(src + (ind_y[3][i] * src_stride) + j)));
+            s0 = _mm256_cvtepu8_epi16(dwt2_8_load_row(
+                src + (ind_y[0][i] * src_stride) + j, w - j));
+            s1 = _mm256_cvtepu8_epi16(dwt2_8_load_row(
+                src + (ind_y[1][i] * src_stride) + j, w - j));
+            s2 = _mm256_cvtepu8_epi16(dwt2_8_load_row(
+                src + (ind_y[2][i] * src_stride) + j, w - j));
+            s3 = _mm256_cvtepu8_epi16(dwt2_8_load_row(
+                src + (ind_y[3][i] * src_stride) + j, w - j));
 
             __m256i s0lo = _mm256_unpacklo_epi16(s0, s1);
             __m256i s0hi = _mm256_unpackhi_epi16(s0, s1);
@@ -119,50 +182,15 @@ void adm_dwt2_8_avx2(const uint8_t *src, const adm_dwt_band_t *dst,
             // }
         }
 
-        int j0 = ind_x[0][0];
-        int j1 = ind_x[1][0];
-        int j2 = ind_x[2][0];
-        int j3 = ind_x[3][0];
-
-        int16_t s0 = tmplo[j0];
-        int16_t s1 = tmplo[j1];
-        int16_t s2 = tmplo[j2];
-        int16_t s3 = tmplo[j3];
-
-        accum = 0;
-        accum += (int32_t)filter_lo[0] * s0;
-        accum += (int32_t)filter_lo[1] * s1;
-        accum += (int32_t)filter_lo[2] * s2;
-        accum += (int32_t)filter_lo[3] * s3;
-        dst->band_a[i * dst_stride] = (accum + add_shift_HP) >> shift_HP;
-
-        accum = 0;
-        accum += (int32_t)filter_hi[0] * s0;
-        accum += (int32_t)filter_hi[1] * s1;
-        accum += (int32_t)filter_hi[2] * s2;
-        accum += (int32_t)filter_hi[3] * s3;
-        dst->band_v[i * dst_stride] = (accum + add_shift_HP) >> shift_HP;
-
-        s0 = tmphi[j0];
-        s1 = tmphi[j1];
-        s2 = tmphi[j2];
-        s3 = tmphi[j3];
-
-        accum = 0;
-        accum += (int32_t)filter_lo[0] * s0;
-        accum += (int32_t)filter_lo[1] * s1;
-        accum += (int32_t)filter_lo[2] * s2;
-        accum += (int32_t)filter_lo[3] * s3;
-        dst->band_h[i * dst_stride] = (accum + add_shift_HP) >> shift_HP;
-
-        accum = 0;
-        accum += (int32_t)filter_hi[0] * s0;
-        accum += (int32_t)filter_hi[1] * s1;
-        accum += (int32_t)filter_hi[2] * s2;
-        accum += (int32_t)filter_hi[3] * s3;
-        dst->band_d[i * dst_stride] = (accum + add_shift_HP) >> shift_HP;
-
-        for (int j = 1; j < (w + 1) / 2; j = j + 16) {
+        /* The first column and every column whose taps reach past the right
+         * edge are mirrored through ind_x, the rest are contiguous. */
+        const int w_half = (w + 1) / 2;
+        const int j_end = (w - 1) / 2;
+
+        dwt2_8_hp_scalar(tmplo, tmphi, ind_x, dst, i, 0, dst_stride);
+
+        int j = 1;
+        for (; j + 16 <= j_end; j = j + 16) {
             {
                 __m256i accum_mu2_lo, accum_mu2_hi, accum_mu1_lo, accum_mu1_hi;
                 accum_mu2_lo = accum_mu2_hi = accum_mu1_lo = accum_mu1_hi =
@@ -271,5 +299,8 @@ void adm_dwt2_8_avx2(const uint8_t *src, const adm_dwt_band_t *dst,
                     accum_mu1_hi);
             }
         }
+
+        for (; j < w_half; ++j)
+            dwt2_8_hp_scalar(tmplo, tmphi, ind_x, dst, i, j, dst_stride);
     }
 }
@@ -0,0 +1,1359 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <immintrin.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "feature/integer_adm.h"
+#include "feature/x86/adm_avx512.h"
+
+/*
+ * Every kernel here is bit-exact with its scalar counterpart in
+ * integer_adm.c. Row tails are handled with masked loads and stores, so
+ * nothing is read or written outside of the region the scalar code touches.
+ * Columns whose filter taps get mirrored at the frame edge go through small
+ * scalar helpers.
+ */
+
+static inline __mmask8 tail_mask8(int n)
+{
+    return n >= 8 ? 0xff : (1u << n) - 1;
+}
+
+static inline __mmask16 tail_mask16(int n)
+{
+    return n >= 16 ? 0xffff : (1u << n) - 1;
+}
+
+static inline __mmask32 tail_mask32(int n)
+{
+    return n >= 32 ? ~0u : (1u << n) - 1;
+}
+
+static inline __m512i coeff_pair(int16_t c0, int16_t c1)
+{
+    return _mm512_set1_epi32((uint16_t)c0 | ((uint32_t)(uint16_t)c1 << 16));
+}
+
+/*
+ * (int32_t)((a * b + add) >> shift) on 16 lanes, with a and b signed 32-bit
+ * and shift <= 32. Even and odd lanes are widened to 64 bits separately,
+ * the odd results are moved back up by shifting left by (32 - shift).
+ */
+static inline __m512i mul_round_epi32(__m512i a, __m512i b, __m512i add,
+                                      __m128i shift, __m128i shift_hi)
+{
+    const __m512i even =
+        _mm512_add_epi64(_mm512_mul_epi32(a, b), add);
+    const __m512i odd =
+        _mm512_add_epi64(_mm512_mul_epi32(_mm512_srli_epi64(a, 32), b), add);
+    return _mm512_mask_blend_epi32(0xAAAA, _mm512_srl_epi64(even, shift),
+                                   _mm512_sll_epi64(odd, shift_hi));
+}
+
+/* ================= */
+/* dwt2, scale 0     */
+/* ================= */
+
+static inline void dwt2_hp_scalar(const int16_t *tmplo, const int16_t *tmphi,
+                                  const adm_dwt_band_t *dst, int **ind_x,
+                                  int dst_offset, int j)
+{
+    const int16_t *filter_lo = dwt2_db2_coeffs_lo;
+    const int16_t *filter_hi = dwt2_db2_coeffs_hi;
+    const int16_t shift_HP = 16;
+    const int32_t add_shift_HP = 32768;
+
+    const int j0 = ind_x[0][j];
+    const int j1 = ind_x[1][j];
+    const int j2 = ind_x[2][j];
+    const int j3 = ind_x[3][j];
+    int32_t accum;
+
+    accum = (int32_t)filter_lo[0] * tmplo[j0] + (int32_t)filter_lo[1] * tmplo[j1] +
+            (int32_t)filter_lo[2] * tmplo[j2] + (int32_t)filter_lo[3] * tmplo[j3];
+    dst->band_a[dst_offset + j] = (accum + add_shift_HP) >> shift_HP;
+    accum = (int32_t)filter_hi[0] * tmplo[j0] + (int32_t)filter_hi[1] * tmplo[j1] +
+            (int32_t)filter_hi[2] * tmplo[j2] + (int32_t)filter_hi[3] * tmplo[j3];
+    dst->band_v[dst_offset + j] = (accum + add_shift_HP) >> shift_HP;
+    accum = (int32_t)filter_lo[0] * tmphi[j0] + (int32_t)filter_lo[1] * tmphi[j1] +
+            (int32_t)filter_lo[2] * tmphi[j2] + (int32_t)filter_lo[3] * tmphi[j3];
+    dst->band_h[dst_offset + j] = (accum + add_shift_HP) >> shift_HP;
+    accum = (int32_t)filter_hi[0] * tmphi[j0] + (int32_t)filter_hi[1] * tmphi[j1] +
+            (int32_t)filter_hi[2] * tmphi[j2] + (int32_t)filter_hi[3] * tmphi[j3];
+    dst->band_d[dst_offset + j] = (accum + add_shift_HP) >> shift_HP;
+}
+
+static inline __m256i dwt2_hp_16(const int16_t *tmp, int j, __mmask32 m,
+                                 __m512i f01, __m512i f23)
+{
+    const __m512i a = _mm512_maskz_loadu_epi16(m, tmp + 2 * j - 1);
+    const __m512i b = _mm512_maskz_loadu_epi16(m, tmp + 2 * j + 1);
+    __m512i accum = _mm512_add_epi32(_mm512_madd_epi16(a, f01),
+                                     _mm512_madd_epi16(b, f23));
+    accum = _mm512_srai_epi32(_mm512_add_epi32(accum, _mm512_set1_epi32(32768)), 16);
+    return _mm512_cvtepi32_epi16(accum);
+}
+
+/*
+ * Horizontal pass shared by the 8-bit and 16-bit input paths. Output j reads
+ * tmp[2j - 1 .. 2j + 2], which only needs mirroring for j = 0 and for the
+ * last column, everything in between is vectorized.
+ */
+static void dwt2_hp_row(const int16_t *tmplo, const int16_t *tmphi,
+                        const adm_dwt_band_t *dst, int **ind_x, int w,
+                        int dst_offset)
+{
+    const __m512i fl01 = coeff_pair(dwt2_db2_coeffs_lo[0], dwt2_db2_coeffs_lo[1]);
+    const __m512i fl23 = coeff_pair(dwt2_db2_coeffs_lo[2], dwt2_db2_coeffs_lo[3]);
+    const __m512i fh01 = coeff_pair(dwt2_db2_coeffs_hi[0], dwt2_db2_coeffs_hi[1]);
+    const __m512i fh23 = coeff_pair(dwt2_db2_coeffs_hi[2], dwt2_db2_coeffs_hi[3]);
+
+    const int w_half = (w + 1) / 2;
+    const int j_end = (w - 1) / 2; // 2j + 2 <= w - 1 for all j < j_end
+
+    dwt2_hp_scalar(tmplo, tmphi, dst, ind_x, dst_offset, 0);
+
+    for (int j = 1; j < j_end; j += 16) {
+        const int n = j_end - j;
+        const __mmask16 m = tail_mask16(n);
+        const __mmask32 m2 = tail_mask32(2 * n);
+        _mm256_mask_storeu_epi16(dst->band_a + dst_offset + j, m,
+                                 dwt2_hp_16(tmplo, j, m2, fl01, fl23));
+        _mm256_mask_storeu_epi16(dst->band_v + dst_offset + j, m,
+                                 dwt2_hp_16(tmplo, j, m2, fh01, fh23));
+        _mm256_mask_storeu_epi16(dst->band_h + dst_offset + j, m,
+                                 dwt2_hp_16(tmphi, j, m2, fl01, fl23));
+        _mm256_mask_storeu_epi16(dst->band_d + dst_offset + j, m,
+                                 dwt2_hp_16(tmphi, j, m2, fh01, fh23));
+    }
+
+    for (int j = j_end > 1 ? j_end : 1; j < w_half; ++j)
+        dwt2_hp_scalar(tmplo, tmphi, dst, ind_x, dst_offset, j);
+}
+
+void adm_dwt2_8_avx512(const uint8_t *src, const adm_dwt_band_t *dst,
+                       AdmBuffer *buf, int w, int h, int src_stride,
+                       int dst_stride)
+{
+    const __m512i fl01 = coeff_pair(dwt2_db2_coeffs_lo[0], dwt2_db2_coeffs_lo[1]);
+    const __m512i fl23 = coeff_pair(dwt2_db2_coeffs_lo[2], dwt2_db2_coeffs_lo[3]);
+    const __m512i fh01 = coeff_pair(dwt2_db2_coeffs_hi[0], dwt2_db2_coeffs_hi[1]);
+    const __m512i fh23 = coeff_pair(dwt2_db2_coeffs_hi[2], dwt2_db2_coeffs_hi[3]);
+
+    const int32_t add_shift_VP = 128;
+    /* normalizing is done for range from(0 to N) to (-N/2 to N/2) */
+    const __m512i add_lo =
+        _mm512_set1_epi32(add_shift_VP - dwt2_db2_coeffs_lo_sum * add_shift_VP);
+    const __m512i add_hi =
+        _mm512_set1_epi32(add_shift_VP - dwt2_db2_coeffs_hi_sum * add_shift_VP);
+
+    int **ind_y = buf->ind_y;
+    int **ind_x = buf->ind_x;
+
+    int16_t *tmplo = (int16_t *)buf->tmp_ref;
+    int16_t *tmphi = tmplo + w;
+
+    for (int i = 0; i < (h + 1) / 2; ++i) {
+        const uint8_t *src0 = src + ind_y[0][i] * src_stride;
+        const uint8_t *src1 = src + ind_y[1][i] * src_stride;
+        const uint8_t *src2 = src + ind_y[2][i] * src_stride;
+        const uint8_t *src3 = src + ind_y[3][i] * src_stride;
+
+        /* Vertical pass. */
+        for (int j = 0; j < w; j += 32) {
+            const __mmask32 m = tail_mask32(w - j);
+            const __m512i s0 = _mm512_cvtepu8_epi16(_mm256_maskz_loadu_epi8(m, src0 + j));
+            const __m512i s1 = _mm512_cvtepu8_epi16(_mm256_maskz_loadu_epi8(m, src1 + j));
+            const __m512i s2 = _mm512_cvtepu8_epi16(_mm256_maskz_loadu_epi8(m, src2 + j));
+            const __m512i s3 = _mm512_cvtepu8_epi16(_mm256_maskz_loadu_epi8(m, src3 + j));
+
+            const __m512i s01_lo = _mm512_unpacklo_epi16(s0, s1);
+            const __m512i s01_hi = _mm512_unpackhi_epi16(s0, s1);
+            const __m512i s23_lo = _mm512_unpacklo_epi16(s2, s3);
+            const __m512i s23_hi = _mm512_unpackhi_epi16(s2, s3);
+
+            // 8-bit input keeps both passes well inside the int16 range, so
+            // the saturating pack is a plain narrowing here
+            __m512i lo0 = _mm512_add_epi32(_mm512_madd_epi16(s01_lo, fl01),
+                                           _mm512_madd_epi16(s23_lo, fl23));
+            __m512i lo1 = _mm512_add_epi32(_mm512_madd_epi16(s01_hi, fl01),
+                                           _mm512_madd_epi16(s23_hi, fl23));
+            lo0 = _mm512_srai_epi32(_mm512_add_epi32(lo0, add_lo), 8);
+            lo1 = _mm512_srai_epi32(_mm512_add_epi32(lo1, add_lo), 8);
+            _mm512_mask_storeu_epi16(tmplo + j, m, _mm512_packs_epi32(lo0, lo1));
+
+            __m512i hi0 = _mm512_add_epi32(_mm512_madd_epi16(s01_lo, fh01),
+                                           _mm512_madd_epi16(s23_lo, fh23));
+            __m512i hi1 = _mm512_add_epi32(_mm512_madd_epi16(s01_hi, fh01),
+                                           _mm512_madd_epi16(s23_hi, fh23));
+            hi0 = _mm512_srai_epi32(_mm512_add_epi32(hi0, add_hi), 8);
+            hi1 = _mm512_srai_epi32(_mm512_add_epi32(hi1, add_hi), 8);
+            _mm512_mask_storeu_epi16(tmphi + j, m, _mm512_packs_epi32(hi0, hi1));
+        }
+
+        /* Horizontal pass (lo and hi). */
+        dwt2_hp_row(tmplo, tmphi, dst, ind_x, w, i * dst_stride);
+    }
+}
+
+void adm_dwt2_16_avx512(const uint16_t *src, const adm_dwt_band_t *dst,
+                        AdmBuffer *buf, int w, int h, int src_stride,
+                        int dst_stride, int inp_size_bits)
+{
+    const __m512i fl0 = _mm512_set1_epi32(dwt2_db2_coeffs_lo[0]);
+    const __m512i fl1 = _mm512_set1_epi32(dwt2_db2_coeffs_lo[1]);
+    const __m512i fl2 = _mm512_set1_epi32(dwt2_db2_coeffs_lo[2]);
+    const __m512i fl3 = _mm512_set1_epi32(dwt2_db2_coeffs_lo[3]);
+    const __m512i fh0 = _mm512_set1_epi32(dwt2_db2_coeffs_hi[0]);
+    const __m512i fh1 = _mm512_set1_epi32(dwt2_db2_coeffs_hi[1]);
+    const __m512i fh2 = _mm512_set1_epi32(dwt2_db2_coeffs_hi[2]);
+    const __m512i fh3 = _mm512_set1_epi32(dwt2_db2_coeffs_hi[3]);
+
+    const __m128i shift_VP = _mm_cvtsi32_si128(inp_size_bits);
+    const int32_t add_shift_VP = 1 << (inp_size_bits - 1);
+    /* normalizing is done for range from(0 to N) to (-N/2 to N/2) */
+    const __m512i add_lo = _mm512_set1_epi32(
+        (int32_t)((uint32_t)add_shift_VP - (uint32_t)dwt2_db2_coeffs_lo_sum * add_shift_VP));
+    const __m512i add_hi = _mm512_set1_epi32(
+        (int32_t)((uint32_t)add_shift_VP - (uint32_t)dwt2_db2_coeffs_hi_sum * add_shift_VP));
+
+    int **ind_y = buf->ind_y;
+    int **ind_x = buf->ind_x;
+
+    int16_t *tmplo = (int16_t *)buf->tmp_ref;
+    int16_t *tmphi = tmplo + w;
+
+    for (int i = 0; i < (h + 1) / 2; ++i) {
+        const uint16_t *src0 = src + ind_y[0][i] * src_stride;
+        const uint16_t *src1 = src + ind_y[1][i] * src_stride;
+        const uint16_t *src2 = src + ind_y[2][i] * src_stride;
+        const uint16_t *src3 = src + ind_y[3][i] * src_stride;
+
+        /* Vertical pass, in 32-bit lanes since samples may use all 16 bits. */
+        for (int j = 0; j < w; j += 16) {
+            const __mmask16 m = tail_mask16(w - j);
+            const __m512i s0 = _mm512_cvtepu16_epi32(_mm256_maskz_loadu_epi16(m, src0 + j));
+            const __m512i s1 = _mm512_cvtepu16_epi32(_mm256_maskz_loadu_epi16(m, src1 + j));
+            const __m512i s2 = _mm512_cvtepu16_epi32(_mm256_maskz_loadu_epi16(m, src2 + j));
+            const __m512i s3 = _mm512_cvtepu16_epi32(_mm256_maskz_loadu_epi16(m, src3 + j));
+
+            __m512i lo = _mm512_add_epi32(
+                _mm512_add_epi32(_mm512_mullo_epi32(s0, fl0), _mm512_mullo_epi32(s1, fl1)),
+                _mm512_add_epi32(_mm512_mullo_epi32(s2, fl2), _mm512_mullo_epi32(s3, fl3)));
+            lo = _mm512_sra_epi32(_mm512_add_epi32(lo, add_lo), shift_VP);
+            _mm256_mask_storeu_epi16(tmplo + j, m, _mm512_cvtepi32_epi16(lo));
+
+            __m512i hi = _mm512_add_epi32(
+                _mm512_add_epi32(_mm512_mullo_epi32(s0, fh0), _mm512_mullo_epi32(s1, fh1)),
+                _mm512_add_epi32(_mm512_mullo_epi32(s2, fh2), _mm512_mullo_epi32(s3, fh3)));
+            hi = _mm512_sra_epi32(_mm512_add_epi32(hi, add_hi), shift_VP);
+            _mm256_mask_storeu_epi16(tmphi + j, m, _mm512_cvtepi32_epi16(hi));
+        }
+
+        /* Horizontal pass (lo and hi). */
+        dwt2_hp_row(tmplo, tmphi, dst, ind_x, w, i * dst_stride);
+    }
+}
+
+/* ================= */
+/* dwt2, scale 1..3  */
+/* ================= */
+
+typedef struct {
+    int64_t add_VP, add_HP;
+    int shift_VP, shift_HP;
+} S123Round;
+
+static inline __m512i dwt2_s123_vp_16(const int32_t *s0, const int32_t *s1,
+                                      const int32_t *s2, const int32_t *s3,
+                                      __mmask16 m, const __m512i *f,
+                                      __m512i add, __m128i shift)
+{
+    const __m512i v0 = _mm512_maskz_loadu_epi32(m, s0);
+    const __m512i v1 = _mm512_maskz_loadu_epi32(m, s1);
+    const __m512i v2 = _mm512_maskz_loadu_epi32(m, s2);
+    const __m512i v3 = _mm512_maskz_loadu_epi32(m, s3);
+
+    __m512i even = _mm512_add_epi64(
+        _mm512_add_epi64(_mm512_mul_epi32(v0, f[0]), _mm512_mul_epi32(v1, f[1])),
+        _mm512_add_epi64(_mm512_mul_epi32(v2, f[2]), _mm512_mul_epi32(v3, f[3])));
+    __m512i odd = _mm512_add_epi64(
+        _mm512_add_epi64(_mm512_mul_epi32(_mm512_srli_epi64(v0, 32), f[0]),
+                         _mm512_mul_epi32(_mm512_srli_epi64(v1, 32), f[1])),
+        _mm512_add_epi64(_mm512_mul_epi32(_mm512_srli_epi64(v2, 32), f[2]),
+                         _mm512_mul_epi32(_mm512_srli_epi64(v3, 32), f[3])));
+    even = _mm512_sra_epi64(_mm512_add_epi64(even, add), shift);
+    odd = _mm512_sra_epi64(_mm512_add_epi64(odd, add), shift);
+    return _mm512_mask_blend_epi32(0xAAAA, even, _mm512_slli_epi64(odd, 32));
+}
+
+static inline __m256i dwt2_s123_hp_8(const int32_t *tmp, int j, __mmask16 m,
+                                     const __m512i *f, __m512i add,
+                                     __m128i shift)
+{
+    const __m512i a = _mm512_maskz_loadu_epi32(m, tmp + 2 * j - 1);
+    const __m512i b = _mm512_maskz_loadu_epi32(m, tmp + 2 * j + 1);
+    __m512i accum = _mm512_add_epi64(
+        _mm512_add_epi64(_mm512_mul_epi32(a, f[0]),
+                         _mm512_mul_epi32(_mm512_srli_epi64(a, 32), f[1])),
+        _mm512_add_epi64(_mm512_mul_epi32(b, f[2]),
+                         _mm512_mul_epi32(_mm512_srli_epi64(b, 32), f[3])));
+    accum = _mm512_sra_epi64(_mm512_add_epi64(accum, add), shift);
+    return _mm512_cvtepi64_epi32(accum);
+}
+
+static inline void dwt2_s123_hp_scalar(const int32_t *tmplo,
+                                       const int32_t *tmphi,
+                                       const i4_adm_dwt_band_t *dst,
+                                       int **ind_x, int dst_offset, int j,
+                                       const S123Round *r)
+{
+    const int16_t *filter_lo = dwt2_db2_coeffs_lo;
+    const int16_t *filter_hi = dwt2_db2_coeffs_hi;
+
+    const int j0 = ind_x[0][j];
+    const int j1 = ind_x[1][j];
+    const int j2 = ind_x[2][j];
+    const int j3 = ind_x[3][j];
+    int64_t accum;
+
+    accum = (int64_t)filter_lo[0] * tmplo[j0] + (int64_t)filter_lo[1] * tmplo[j1] +
+            (int64_t)filter_lo[2] * tmplo[j2] + (int64_t)filter_lo[3] * tmplo[j3];
+    dst->band_a[dst_offset + j] = (int32_t)((accum + r->add_HP) >> r->shift_HP);
+    accum = (int64_t)filter_hi[0] * tmplo[j0] + (int64_t)filter_hi[1] * tmplo[j1] +
+            (int64_t)filter_hi[2] * tmplo[j2] + (int64_t)filter_hi[3] * tmplo[j3];
+    dst->band_v[dst_offset + j] = (int32_t)((accum + r->add_HP) >> r->shift_HP);
+    accum = (int64_t)filter_lo[0] * tmphi[j0] + (int64_t)filter_lo[1] * tmphi[j1] +
+            (int64_t)filter_lo[2] * tmphi[j2] + (int64_t)filter_lo[3] * tmphi[j3];
+    dst->band_h[dst_offset + j] = (int32_t)((accum + r->add_HP) >> r->shift_HP);
+    accum = (int64_t)filter_hi[0] * tmphi[j0] + (int64_t)filter_hi[1] * tmphi[j1] +
+            (int64_t)filter_hi[2] * tmphi[j2] + (int64_t)filter_hi[3] * tmphi[j3];
+    dst->band_d[dst_offset + j] = (int32_t)((accum + r->add_HP) >> r->shift_HP);
+}
+
+static void dwt2_s123_hp_row(const int32_t *tmplo, const int32_t *tmphi,
+                             const i4_adm_dwt_band_t *dst, int **ind_x, int w,
+                             int dst_offset, const S123Round *r)
+{
+    const __m512i fl[4] = {
+        _mm512_set1_epi64(dwt2_db2_coeffs_lo[0]), _mm512_set1_epi64(dwt2_db2_coeffs_lo[1]),
+        _mm512_set1_epi64(dwt2_db2_coeffs_lo[2]), _mm512_set1_epi64(dwt2_db2_coeffs_lo[3]),
+    };
+    const __m512i fh[4] = {
+        _mm512_set1_epi64(dwt2_db2_coeffs_hi[0]), _mm512_set1_epi64(dwt2_db2_coeffs_hi[1]),
+        _mm512_set1_epi64(dwt2_db2_coeffs_hi[2]), _mm512_set1_epi64(dwt2_db2_coeffs_hi[3]),
+    };
+    const __m512i add = _mm512_set1_epi64(r->add_HP);
+    const __m128i shift = _mm_cvtsi32_si128(r->shift_HP);
+
+    const int w_half = (w + 1) / 2;
+    const int j_end = (w - 1) / 2; // 2j + 2 <= w - 1 for all j < j_end
+
+    dwt2_s123_hp_scalar(tmplo, tmphi, dst, ind_x, dst_offset, 0, r);
+
+    for (int j = 1; j < j_end; j += 8) {
+        const int n = j_end - j;
+        const __mmask8 m = tail_mask8(n);
+        const __mmask16 m2 = tail_mask16(2 * n);
+        _mm256_mask_storeu_epi32(dst->band_a + dst_offset + j, m,
+                                 dwt2_s123_hp_8(tmplo, j, m2, fl, add, shift));
+        _mm256_mask_storeu_epi32(dst->band_v + dst_offset + j, m,
+                                 dwt2_s123_hp_8(tmplo, j, m2, fh, add, shift));
+        _mm256_mask_storeu_epi32(dst->band_h + dst_offset + j, m,
+                                 dwt2_s123_hp_8(tmphi, j, m2, fl, add, shift));
+        _mm256_mask_storeu_epi32(dst->band_d + dst_offset + j, m,
+                                 dwt2_s123_hp_8(tmphi, j, m2, fh, add, shift));
+    }
+
+    for (int j = j_end > 1 ? j_end : 1; j < w_half; ++j)
+        dwt2_s123_hp_scalar(tmplo, tmphi, dst, ind_x, dst_offset, j, r);
+}
+
+void adm_dwt2_s123_combined_avx512(const int32_t *i4_ref_scale,
+                                   const int32_t *i4_curr_dis, AdmBuffer *buf,
+                                   int w, int h, int ref_stride, int dis_stride,
+                                   int dst_stride, int scale)
+{
+    const i4_adm_dwt_band_t *i4_ref_dwt2 = &buf->i4_ref_dwt2;
+    const i4_adm_dwt_band_t *i4_dis_dwt2 = &buf->i4_dis_dwt2;
+    int **ind_y = buf->ind_y;
+    int **ind_x = buf->ind_x;
+
+    const int32_t add_bef_shift_round_VP[3] = { 0, 32768, 32768 };
+    const int32_t add_bef_shift_round_HP[3] = { 16384, 32768, 16384 };
+    const int16_t shift_VerticalPass[3] = { 0, 16, 16 };
+    const int16_t shift_HorizontalPass[3] = { 15, 16, 15 };
+
+    const S123Round r = {
+        .add_VP = add_bef_shift_round_VP[scale - 1],
+        .add_HP = add_bef_shift_round_HP[scale - 1],
+        .shift_VP = shift_VerticalPass[scale - 1],
+        .shift_HP = shift_HorizontalPass[scale - 1],
+    };
+    const __m512i fl[4] = {
+        _mm512_set1_epi64(dwt2_db2_coeffs_lo[0]), _mm512_set1_epi64(dwt2_db2_coeffs_lo[1]),
+        _mm512_set1_epi64(dwt2_db2_coeffs_lo[2]), _mm512_set1_epi64(dwt2_db2_coeffs_lo[3]),
+    };
+    const __m512i fh[4] = {
+        _mm512_set1_epi64(dwt2_db2_coeffs_hi[0]), _mm512_set1_epi64(dwt2_db2_coeffs_hi[1]),
+        _mm512_set1_epi64(dwt2_db2_coeffs_hi[2]), _mm512_set1_epi64(dwt2_db2_coeffs_hi[3]),
+    };
+    const __m512i add_VP = _mm512_set1_epi64(r.add_VP);
+    const __m128i shift_VP = _mm_cvtsi32_si128(r.shift_VP);
+
+    int32_t *tmplo_ref = buf->tmp_ref;
+    int32_t *tmphi_ref = tmplo_ref + w;
+    int32_t *tmplo_dis = tmphi_ref + w;
+    int32_t *tmphi_dis = tmplo_dis + w;
+
+    // the vertical pass of a row completes before its horizontal pass
+    // overwrites band_a, which may alias the source rows of the next scale
+    for (int i = 0; i < (h + 1) / 2; ++i) {
+        const int32_t *ref0 = i4_ref_scale + ind_y[0][i] * ref_stride;
+        const int32_t *ref1 = i4_ref_scale + ind_y[1][i] * ref_stride;
+        const int32_t *ref2 = i4_ref_scale + ind_y[2][i] * ref_stride;
+        const int32_t *ref3 = i4_ref_scale + ind_y[3][i] * ref_stride;
+        const int32_t *dis0 = i4_curr_dis + ind_y[0][i] * dis_stride;
+        const int32_t *dis1 = i4_curr_dis + ind_y[1][i] * dis_stride;
+        const int32_t *dis2 = i4_curr_dis + ind_y[2][i] * dis_stride;
+        const int32_t *dis3 = i4_curr_dis + ind_y[3][i] * dis_stride;
+
+        /* Vertical pass. */
+        for (int j = 0; j < w; j += 16) {
+            const __mmask16 m = tail_mask16(w - j);
+            _mm512_mask_storeu_epi32(tmplo_ref + j, m,
+                dwt2_s123_vp_16(ref0 + j, ref1 + j, ref2 + j, ref3 + j, m, fl,
+                                add_VP, shift_VP));
+            _mm512_mask_storeu_epi32(tmphi_ref + j, m,
+                dwt2_s123_vp_16(ref0 + j, ref1 + j, ref2 + j, ref3 + j, m, fh,
+                                add_VP, shift_VP));
+            _mm512_mask_storeu_epi32(tmplo_dis + j, m,
+                dwt2_s123_vp_16(dis0 + j, dis1 + j, dis2 + j, dis3 + j, m, fl,
+                                add_VP, shift_VP));
+            _mm512_mask_storeu_epi32(tmphi_dis + j, m,
+                dwt2_s123_vp_16(dis0 + j, dis1 + j, dis2 + j, dis3 + j, m, fh,
+                                add_VP, shift_VP));
+        }
+
+        /* Horizontal pass (lo and hi). */
+        dwt2_s123_hp_row(tmplo_ref, tmphi_ref, i4_ref_dwt2, ind_x, w,
+                         i * dst_stride, &r);
+        dwt2_s123_hp_row(tmplo_dis, tmphi_dis, i4_dis_dwt2, ind_x, w,
+                         i * dst_stride, &r);
+    }
+}
+
+/* ================= */
+/* decouple          */
+/* ================= */
+
+static inline int adm_border_left(int w)
+{
+    int left = w * ADM_BORDER_FACTOR - 0.5 - 1; // -1 for filter tap
+    return left < 0 ? 0 : left;
+}
+
+static inline int adm_border_right(int w)
+{
+    int left = w * ADM_BORDER_FACTOR - 0.5 - 1;
+    int right = w - left + 2; // +2 for filter tap
+    return right > w ? w : right;
+}
+
+/*
+ * Lanes hold sign-extended 64-bit values. The angle test is evaluated in
+ * double precision on float-rounded operands, in the same order as the
+ * scalar code. Dividing by 4096 is exact, so it is done as a multiply.
+ */
+static inline __mmask8 decouple_angle_flag(__m512i oh, __m512i ov,
+                                           __m512i th, __m512i tv,
+                                           __m512d cos_1deg_sq)
+{
+    const __m512i ot_dp = _mm512_add_epi64(_mm512_mul_epi32(oh, th),
+                                           _mm512_mul_epi32(ov, tv));
+    const __m512i o_mag_sq = _mm512_add_epi64(_mm512_mul_epi32(oh, oh),
+                                              _mm512_mul_epi32(ov, ov));
+    const __m512i t_mag_sq = _mm512_add_epi64(_mm512_mul_epi32(th, th),
+                                              _mm512_mul_epi32(tv, tv));
+
+    const __m512d inv_4096 = _mm512_set1_pd(1.0 / 4096.0);
+    const __m512d ot = _mm512_mul_pd(_mm512_cvtps_pd(_mm512_cvtepi64_ps(ot_dp)), inv_4096);
+    const __m512d om = _mm512_mul_pd(_mm512_cvtps_pd(_mm512_cvtepi64_ps(o_mag_sq)), inv_4096);
+    const __m512d tm = _mm512_mul_pd(_mm512_cvtps_pd(_mm512_cvtepi64_ps(t_mag_sq)), inv_4096);
+
+    const __mmask8 positive =
+        _mm512_cmp_pd_mask(ot, _mm512_setzero_pd(), _CMP_GE_OQ);
+    return _mm512_mask_cmp_pd_mask(positive, _mm512_mul_pd(ot, ot),
+                                   _mm512_mul_pd(_mm512_mul_pd(cos_1deg_sq, om), tm),
+                                   _CMP_GE_OQ);
+}
+
+/*
+ * div_lookup[32768 + d] holds 2^30 / d truncated towards zero. For
+ * |d| <= 32768 the double quotient is never close enough to an integer for
+ * rounding to change the truncated value, so it is computed on the fly.
+ */
+static inline __m512i div_q30(__m512i d)
+{
+    const __m512d q = _mm512_div_pd(_mm512_set1_pd(1073741824.0),
+                                    _mm512_cvtepi64_pd(d));
+    return _mm512_cvttpd_epi64(q);
+}
+
+static inline __m512i clamp_k(__m512i tmp_k, __m512i o)
+{
+    const __m512i k_max = _mm512_set1_epi64(32768);
+    const __m512i k = _mm512_min_epi64(_mm512_max_epi64(tmp_k, _mm512_setzero_si512()), k_max);
+    return _mm512_mask_mov_epi64(k, _mm512_cmpeq_epi64_mask(o, _mm512_setzero_si512()), k_max);
+}
+
+static inline __m512i decouple_k(__m512i o, __m512i t)
+{
+    const __m512i tmp_k = _mm512_srai_epi64(
+        _mm512_add_epi64(_mm512_mul_epi32(div_q30(o), t), _mm512_set1_epi64(16384)), 15);
+    return clamp_k(tmp_k, o);
+}
+
+static inline __m512i decouple_k_s123(__m512i o, __m512i t)
+{
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i one = _mm512_set1_epi64(1);
+    const __m512i abs_o = _mm512_abs_epi64(o);
+
+    // get_best15_from32(): keep the 15 most significant bits of |o|
+    const __mmask8 large = _mm512_cmpge_epi64_mask(abs_o, _mm512_set1_epi64(32768));
+    const __m512i shift = _mm512_maskz_sub_epi64(large, _mm512_set1_epi64(17 + 32),
+                                                 _mm512_lzcnt_epi64(abs_o));
+    const __m512i round = _mm512_maskz_sllv_epi64(large, one,
+                                                  _mm512_sub_epi64(shift, one));
+    const __m512i msb = _mm512_srlv_epi64(_mm512_add_epi64(abs_o, round), shift);
+
+    __m512i tmp_k = _mm512_mul_epi32(div_q30(msb), t);
+    tmp_k = _mm512_mask_sub_epi64(tmp_k, _mm512_cmplt_epi64_mask(o, zero), zero, tmp_k);
+    tmp_k = _mm512_add_epi64(tmp_k, _mm512_sllv_epi64(_mm512_set1_epi64(1 << 14), shift));
+    tmp_k = _mm512_srav_epi64(tmp_k, _mm512_add_epi64(shift, _mm512_set1_epi64(15)));
+    return clamp_k(tmp_k, o);
+}
+
+/*
+ * Applies the enhancement gain limit. The sign of rst_f is the sign of k * o,
+ * and MIN()/MAX() on doubles behave exactly like vminpd/vmaxpd.
+ */
+static inline __m512i decouple_gain(__m512i rst, __m512i k, __m512i o,
+                                    __m512i t, __mmask8 angle_flag,
+                                    __m512d adm_enhn_gain_limit)
+{
+    const __m512i zero = _mm512_setzero_si512();
+    const __mmask8 flag = _mm512_mask_cmpgt_epi64_mask(angle_flag, k, zero);
+    const __mmask8 positive = _mm512_mask_cmpgt_epi64_mask(flag, o, zero);
+    const __mmask8 negative = _mm512_mask_cmplt_epi64_mask(flag, o, zero);
+
+    const __m512d rst_gain = _mm512_mul_pd(_mm512_cvtepi64_pd(rst), adm_enhn_gain_limit);
+    const __m512d t_d = _mm512_cvtepi64_pd(t);
+    rst = _mm512_mask_mov_epi64(rst, positive,
+                                _mm512_cvttpd_epi64(_mm512_min_pd(rst_gain, t_d)));
+    rst = _mm512_mask_mov_epi64(rst, negative,
+                                _mm512_cvttpd_epi64(_mm512_max_pd(rst_gain, t_d)));
+    return rst;
+}
+
+static inline __m512i rst_from_k(__m512i k, __m512i o)
+{
+    return _mm512_srai_epi64(_mm512_add_epi64(_mm512_mul_epi32(k, o),
+                                              _mm512_set1_epi64(16384)), 15);
+}
+
+void adm_decouple_avx512(AdmBuffer *buf, int w, int h, int stride,
+                         double adm_enhn_gain_limit)
+{
+    const float cos_1deg_sq = cos(1.0 * M_PI / 180.0) * cos(1.0 * M_PI / 180.0);
+    const __m512d cos_1deg_sq_d = _mm512_set1_pd(cos_1deg_sq);
+    const __m512d gain = _mm512_set1_pd(adm_enhn_gain_limit);
+
+    const adm_dwt_band_t *ref = &buf->ref_dwt2;
+    const adm_dwt_band_t *dis = &buf->dis_dwt2;
+    const adm_dwt_band_t *r = &buf->decouple_r;
+    const adm_dwt_band_t *a = &buf->decouple_a;
+
+    const int left = adm_border_left(w);
+    const int top = adm_border_left(h);
+    const int right = adm_border_right(w);
+    const int bottom = adm_border_right(h);
+
+    for (int i = top; i < bottom; ++i) {
+        for (int j = left; j < right; j += 8) {
+            const int off = i * stride + j;
+            const __mmask8 m = tail_mask8(right - j);
+            const __m512i oh = _mm512_cvtepi16_epi64(_mm_maskz_loadu_epi16(m, ref->band_h + off));
+            const __m512i ov = _mm512_cvtepi16_epi64(_mm_maskz_loadu_epi16(m, ref->band_v + off));
+            const __m512i od = _mm512_cvtepi16_epi64(_mm_maskz_loadu_epi16(m, ref->band_d + off));
+            const __m512i th = _mm512_cvtepi16_epi64(_mm_maskz_loadu_epi16(m, dis->band_h + off));
+            const __m512i tv = _mm512_cvtepi16_epi64(_mm_maskz_loadu_epi16(m, dis->band_v + off));
+            const __m512i td = _mm512_cvtepi16_epi64(_mm_maskz_loadu_epi16(m, dis->band_d + off));
+
+            const __mmask8 angle_flag = decouple_angle_flag(oh, ov, th, tv, cos_1deg_sq_d);
+
+            const __m512i kh = decouple_k(oh, th);
+            const __m512i kv = decouple_k(ov, tv);
+            const __m512i kd = decouple_k(od, td);
+
+            const __m512i rst_h = decouple_gain(rst_from_k(kh, oh), kh, oh, th, angle_flag, gain);
+            const __m512i rst_v = decouple_gain(rst_from_k(kv, ov), kv, ov, tv, angle_flag, gain);
+            const __m512i rst_d = decouple_gain(rst_from_k(kd, od), kd, od, td, angle_flag, gain);
+
+            _mm512_mask_cvtepi64_storeu_epi16(r->band_h + off, m, rst_h);
+            _mm512_mask_cvtepi64_storeu_epi16(r->band_v + off, m, rst_v);
+            _mm512_mask_cvtepi64_storeu_epi16(r->band_d + off, m, rst_d);
+
+            _mm512_mask_cvtepi64_storeu_epi16(a->band_h + off, m, _mm512_sub_epi64(th, rst_h));
+            _mm512_mask_cvtepi64_storeu_epi16(a->band_v + off, m, _mm512_sub_epi64(tv, rst_v));
+            _mm512_mask_cvtepi64_storeu_epi16(a->band_d + off, m, _mm512_sub_epi64(td, rst_d));
+        }
+    }
+}
+
+static inline __m512i sext_epi32_epi64(__m512i x)
+{
+    return _mm512_srai_epi64(_mm512_slli_epi64(x, 32), 32);
+}
+
+void adm_decouple_s123_avx512(AdmBuffer *buf, int w, int h, int stride,
+                              double adm_enhn_gain_limit)
+{
+    const float cos_1deg_sq = cos(1.0 * M_PI / 180.0) * cos(1.0 * M_PI / 180.0);
+    const __m512d cos_1deg_sq_d = _mm512_set1_pd(cos_1deg_sq);
+    const __m512d gain = _mm512_set1_pd(adm_enhn_gain_limit);
+
+    const i4_adm_dwt_band_t *ref = &buf->i4_ref_dwt2;
+    const i4_adm_dwt_band_t *dis = &buf->i4_dis_dwt2;
+    const i4_adm_dwt_band_t *r = &buf->i4_decouple_r;
+    const i4_adm_dwt_band_t *a = &buf->i4_decouple_a;
+
+    const int left = adm_border_left(w);
+    const int top = adm_border_left(h);
+    const int right = adm_border_right(w);
+    const int bottom = adm_border_right(h);
+
+    for (int i = top; i < bottom; ++i) {
+        for (int j = left; j < right; j += 8) {
+            const int off = i * stride + j;
+            const __mmask8 m = tail_mask8(right - j);
+            const __m512i oh = _mm512_cvtepi32_epi64(_mm256_maskz_loadu_epi32(m, ref->band_h + off));
+            const __m512i ov = _mm512_cvtepi32_epi64(_mm256_maskz_loadu_epi32(m, ref->band_v + off));
+            const __m512i od = _mm512_cvtepi32_epi64(_mm256_maskz_loadu_epi32(m, ref->band_d + off));
+            const __m512i th = _mm512_cvtepi32_epi64(_mm256_maskz_loadu_epi32(m, dis->band_h + off));
+            const __m512i tv = _mm512_cvtepi32_epi64(_mm256_maskz_loadu_epi32(m, dis->band_v + off));
+            const __m512i td = _mm512_cvtepi32_epi64(_mm256_maskz_loadu_epi32(m, dis->band_d + off));
+
+            const __mmask8 angle_flag = decouple_angle_flag(oh, ov, th, tv, cos_1deg_sq_d);
+
+            const __m512i kh = decouple_k_s123(oh, th);
+            const __m512i kv = decouple_k_s123(ov, tv);
+            const __m512i kd = decouple_k_s123(od, td);
+
+            // rst is stored in an int32_t before the gain is applied
+            const __m512i rst_h = decouple_gain(sext_epi32_epi64(rst_from_k(kh, oh)),
+                                                kh, oh, th, angle_flag, gain);
+            const __m512i rst_v = decouple_gain(sext_epi32_epi64(rst_from_k(kv, ov)),
+                                                kv, ov, tv, angle_flag, gain);
+            const __m512i rst_d = decouple_gain(sext_epi32_epi64(rst_from_k(kd, od)),
+                                                kd, od, td, angle_flag, gain);
+
+            _mm512_mask_cvtepi64_storeu_epi32(r->band_h + off, m, rst_h);
+            _mm512_mask_cvtepi64_storeu_epi32(r->band_v + off, m, rst_v);
+            _mm512_mask_cvtepi64_storeu_epi32(r->band_d + off, m, rst_d);
+
+            _mm512_mask_cvtepi64_storeu_epi32(a->band_h + off, m, _mm512_sub_epi64(th, rst_h));
+            _mm512_mask_cvtepi64_storeu_epi32(a->band_v + off, m, _mm512_sub_epi64(tv, rst_v));
+            _mm512_mask_cvtepi64_storeu_epi32(a->band_d + off, m, _mm512_sub_epi64(td, rst_d));
+        }
+    }
+}
+
+/* ================= */
+/* csf               */
+/* ================= */
+
+static void adm_i_rfactor(uint16_t *i_rfactor, double adm_norm_view_dist,
+                          int adm_ref_display_height)
+{
+    const float factor1 = dwt_quant_step(&dwt_7_9_YCbCr_threshold[0], 0, 1, adm_norm_view_dist, adm_ref_display_height);
+    const float factor2 = dwt_quant_step(&dwt_7_9_YCbCr_threshold[0], 0, 2, adm_norm_view_dist, adm_ref_display_height);
+    const float rfactor1[3] = { 1.0f / factor1, 1.0f / factor1, 1.0f / factor2 };
+
+    if (fabs(adm_norm_view_dist * adm_ref_display_height - DEFAULT_ADM_NORM_VIEW_DIST * DEFAULT_ADM_REF_DISPLAY_HEIGHT) < 1.0e-8) {
+        i_rfactor[0] = 36453;
+        i_rfactor[1] = 36453;
+        i_rfactor[2] = 49417;
+    }
+    else {
+        const double pow2_21 = pow(2, 21);
+        const double pow2_23 = pow(2, 23);
+        i_rfactor[0] = (uint16_t) (rfactor1[0] * pow2_21);
+        i_rfactor[1] = (uint16_t) (rfactor1[1] * pow2_21);
+        i_rfactor[2] = (uint16_t) (rfactor1[2] * pow2_23);
+    }
+}
+
+/*
+ * 1 / Q >= 2^31 would need Q <= 2, while Q >= 2a / A > 2 for every scale and
+ * orientation, so the scale 1..3 factors fit a signed 32-bit multiplier.
+ */
+static void i4_adm_rfactor(uint32_t *rfactor, int scale,
+                           double adm_norm_view_dist, int adm_ref_display_height)
+{
+    const float factor1 = dwt_quant_step(&dwt_7_9_YCbCr_threshold[0], scale, 1, adm_norm_view_dist, adm_ref_display_height);
+    const float factor2 = dwt_quant_step(&dwt_7_9_YCbCr_threshold[0], scale, 2, adm_norm_view_dist, adm_ref_display_height);
+    const float rfactor1[3] = { 1.0f / factor1, 1.0f / factor1, 1.0f / factor2 };
+
+    const double pow2_32 = pow(2, 32);
+    rfactor[0] = (uint32_t)(rfactor1[0] * pow2_32);
+    rfactor[1] = (uint32_t)(rfactor1[1] * pow2_32);
+    rfactor[2] = (uint32_t)(rfactor1[2] * pow2_32);
+}
+
+void adm_csf_avx512(AdmBuffer *buf, int w, int h, int stride,
+                    double adm_norm_view_dist, int adm_ref_display_height)
+{
+    const adm_dwt_band_t *src = &buf->decouple_a;
+    const adm_dwt_band_t *dst = &buf->csf_a;
+    const adm_dwt_band_t *flt = &buf->csf_f;
+
+    const int16_t *src_angles[3] = { src->band_h, src->band_v, src->band_d };
+    int16_t *dst_angles[3] = { dst->band_h, dst->band_v, dst->band_d };
+    int16_t *flt_angles[3] = { flt->band_h, flt->band_v, flt->band_d };
+
+    uint16_t i_rfactor[3];
+    adm_i_rfactor(i_rfactor, adm_norm_view_dist, adm_ref_display_height);
+
+    const uint8_t i_shifts[3] = { 15, 15, 17 };
+    const uint16_t i_shiftsadd[3] = { 16384, 16384, 65535 };
+    const __m512i fix_one_by_30 = _mm512_set1_epi32(4369); //(1/30)*2^17
+    const __m512i add_flt = _mm512_set1_epi32(2048);
+
+    const int left = adm_border_left(w);
+    const int top = adm_border_left(h);
+    const int right = adm_border_right(w);
+    const int bottom = adm_border_right(h);
+
+    for (int theta = 0; theta < 3; ++theta) {
+        const int16_t *src_ptr = src_angles[theta];
+        int16_t *dst_ptr = dst_angles[theta];
+        int16_t *flt_ptr = flt_angles[theta];
+
+        const __m512i rfactor = _mm512_set1_epi32(i_rfactor[theta]);
+        const __m512i add = _mm512_set1_epi32(i_shiftsadd[theta]);
+        const __m128i shift = _mm_cvtsi32_si128(i_shifts[theta]);
+
+        for (int i = top; i < bottom; ++i) {
+            for (int j = left; j < right; j += 16) {
+                const int off = i * stride + j;
+                const __mmask16 m = tail_mask16(right - j);
+                const __m512i s =
+                    _mm512_cvtepi16_epi32(_mm256_maskz_loadu_epi16(m, src_ptr + off));
+                const __m256i dst_val = _mm512_cvtepi32_epi16(
+                    _mm512_sra_epi32(_mm512_add_epi32(_mm512_mullo_epi32(s, rfactor), add), shift));
+                _mm256_mask_storeu_epi16(dst_ptr + off, m, dst_val);
+
+                const __m512i flt_val = _mm512_srai_epi32(_mm512_add_epi32(
+                    _mm512_mullo_epi32(_mm512_abs_epi32(_mm512_cvtepi16_epi32(dst_val)),
+                                       fix_one_by_30), add_flt), 12);
+                _mm256_mask_storeu_epi16(flt_ptr + off, m, _mm512_cvtepi32_epi16(flt_val));
+            }
+        }
+    }
+}
+
+void i4_adm_csf_avx512(AdmBuffer *buf, int scale, int w, int h, int stride,
+                       double adm_norm_view_dist, int adm_ref_display_height)
+{
+    const i4_adm_dwt_band_t *src = &buf->i4_decouple_a;
+    const i4_adm_dwt_band_t *dst = &buf->i4_csf_a;
+    const i4_adm_dwt_band_t *flt = &buf->i4_csf_f;
+
+    const int32_t *src_angles[3] = { src->band_h, src->band_v, src->band_d };
+    int32_t *dst_angles[3] = { dst->band_h, dst->band_v, dst->band_d };
+    int32_t *flt_angles[3] = { flt->band_h, flt->band_v, flt->band_d };
+
+    uint32_t i_rfactor[3];
+    i4_adm_rfactor(i_rfactor, scale, adm_norm_view_dist, adm_ref_display_height);
+
+    const uint32_t FIX_ONE_BY_30 = 143165577;
+    const uint32_t shift_dst[3] = { 28, 28, 28 };
+    const uint32_t shift_flt[3] = { 32, 32, 32 };
+    int32_t add_bef_shift_dst[3], add_bef_shift_flt[3];
+
+    for (unsigned idx = 0; idx < 3; ++idx) {
+        add_bef_shift_dst[idx] = (1u << (shift_dst[idx] - 1));
+        add_bef_shift_flt[idx] = (1u << (shift_flt[idx] - 1));
+    }
+
+    const __m512i add_dst = _mm512_set1_epi64(add_bef_shift_dst[scale - 1]);
+    const __m128i sh_dst = _mm_cvtsi32_si128(shift_dst[scale - 1]);
+    const __m128i sh_dst_hi = _mm_cvtsi32_si128(32 - shift_dst[scale - 1]);
+    const __m512i add_flt = _mm512_set1_epi64(add_bef_shift_flt[scale - 1]);
+    const __m128i sh_flt = _mm_cvtsi32_si128(shift_flt[scale - 1]);
+    const __m128i sh_flt_hi = _mm_cvtsi32_si128(32 - shift_flt[scale - 1]);
+    const __m512i one_by_30 = _mm512_set1_epi64(FIX_ONE_BY_30);
+
+    const int left = adm_border_left(w);
+    const int top = adm_border_left(h);
+    const int right = adm_border_right(w);
+    const int bottom = adm_border_right(h);
+
+    for (int theta = 0; theta < 3; ++theta) {
+        const int32_t *src_ptr = src_angles[theta];
+        int32_t *dst_ptr = dst_angles[theta];
+        int32_t *flt_ptr = flt_angles[theta];
+        const __m512i rfactor = _mm512_set1_epi64(i_rfactor[theta]);
+
+        for (int i = top; i < bottom; ++i) {
+            for (int j = left; j < right; j += 16) {
+                const int off = i * stride + j;
+                const __mmask16 m = tail_mask16(right - j);
+                const __m512i s = _mm512_maskz_loadu_epi32(m, src_ptr + off);
+                const __m512i dst_val =
+                    mul_round_epi32(s, rfactor, add_dst, sh_dst, sh_dst_hi);
+                _mm512_mask_storeu_epi32(dst_ptr + off, m, dst_val);
+                _mm512_mask_storeu_epi32(flt_ptr + off, m,
+                    mul_round_epi32(_mm512_abs_epi32(dst_val), one_by_30,
+                                    add_flt, sh_flt, sh_flt_hi));
+            }
+        }
+    }
+}
+
+/* ================= */
+/* contrast masking  */
+/* ================= */
+
+typedef struct CmRows {
+    int prev, cur, next; // row offsets of the 3x3 threshold neighbourhood
+} CmRows;
+
+typedef struct CmRound {
+    int32_t shift_sub[3];
+    int64_t add_sq[3];
+    int32_t shift_sq[3];
+    int64_t add_cub[3];
+    int32_t shift_cub[3];
+} CmRound;
+
+typedef struct CmFrame {
+    int w, h;
+    int src_stride, csf_a_stride;
+    int first_col, last_col; // whether j = 0 and j = w - 1 are included
+    int start_col, end_col;
+    uint32_t add_shift_inner_accum, shift_inner_accum;
+} CmFrame;
+
+/*
+ * Rows are mirrored at the top edge and clamped at the bottom one, which is
+ * what the ADM_CM_THRESH_S_* macros do.
+ */
+static inline CmRows cm_rows(const CmFrame *f, int i)
+{
+    const CmRows y = {
+        .prev = (i == 0 ? 1 : i - 1) * f->csf_a_stride,
+        .cur = i * f->csf_a_stride,
+        .next = (i == f->h - 1 ? f->h - 1 : i + 1) * f->csf_a_stride,
+    };
+    return y;
+}
+
+static inline int64_t cm_accum_scalar(int32_t x, int32_t thr_sub,
+                                      const CmRound *r, int theta)
+{
+    x = abs(x) - thr_sub;
+    x = x < 0 ? 0 : x;
+    const int32_t x_sq = (int32_t)((((int64_t)x * x) + r->add_sq[theta]) >> r->shift_sq[theta]);
+    return (((int64_t)x_sq * x) + r->add_cub[theta]) >> r->shift_cub[theta];
+}
+
+/* x is clamped to [0, 2^31) so both products are exact in 64 bits. */
+static inline __m512i cm_accum_16(__m512i x, __m512i add_sq, __m128i shift_sq,
+                                  __m512i add_cub, __m128i shift_cub)
+{
+    const __m512i x_odd = _mm512_srli_epi64(x, 32);
+    const __m512i x_sq_even = _mm512_srl_epi64(
+        _mm512_add_epi64(_mm512_mul_epu32(x, x), add_sq), shift_sq);
+    const __m512i x_sq_odd = _mm512_srl_epi64(
+        _mm512_add_epi64(_mm512_mul_epu32(x_odd, x_odd), add_sq), shift_sq);
+    const __m512i val_even = _mm512_sra_epi64(
+        _mm512_add_epi64(_mm512_mul_epi32(x_sq_even, x), add_cub), shift_cub);
+    const __m512i val_odd = _mm512_sra_epi64(
+        _mm512_add_epi64(_mm512_mul_epi32(x_sq_odd, x_odd), add_cub), shift_cub);
+    return _mm512_add_epi64(val_even, val_odd);
+}
+
+static inline void cm_row_finish(int64_t *accum, int64_t *accum_inner,
+                                 const __m512i *accum_vec, const CmFrame *f)
+{
+    //Shift is done based on height
+    for (int theta = 0; theta < 3; ++theta) {
+        accum_inner[theta] += _mm512_reduce_add_epi64(accum_vec[theta]);
+        accum[theta] += (accum_inner[theta] + f->add_shift_inner_accum) >>
+                        f->shift_inner_accum;
+    }
+}
+
+static inline int32_t cm_thresh_scalar(int16_t *const *angles,
+                                       int16_t *const *flt_angles,
+                                       CmRows y, int jl, int j, int jr)
+{
+    int32_t thr = 0;
+    for (int theta = 0; theta < 3; ++theta) {
+        const int16_t *src_ptr = angles[theta];
+        const int16_t *flt_ptr = flt_angles[theta];
+        int32_t sum = 0;
+        sum += flt_ptr[y.prev + jl];
+        sum += flt_ptr[y.prev + j];
+        sum += flt_ptr[y.prev + jr];
+        sum += flt_ptr[y.cur + jl];
+        sum += (int16_t)(((ONE_BY_15 * abs((int32_t) src_ptr[y.cur + j])) + 2048) >> 12);
+        sum += flt_ptr[y.cur + jr];
+        sum += flt_ptr[y.next + jl];
+        sum += flt_ptr[y.next + j];
+        sum += flt_ptr[y.next + jr];
+        thr += sum;
+    }
+    return thr;
+}
+
+static inline void cm_pixel(const adm_dwt_band_t *src, int16_t *const *angles,
+                            int16_t *const *flt_angles, int src_offset,
+                            CmRows y, int jl, int j, int jr,
+                            const uint16_t *i_rfactor, const CmRound *r,
+                            int64_t *accum_inner)
+{
+    const int32_t thr = cm_thresh_scalar(angles, flt_angles, y, jl, j, jr);
+    const int32_t x[3] = {
+        src->band_h[src_offset + j] * i_rfactor[0],
+        src->band_v[src_offset + j] * i_rfactor[1],
+        src->band_d[src_offset + j] * i_rfactor[2],
+    };
+    for (int theta = 0; theta < 3; ++theta)
+        accum_inner[theta] += cm_accum_scalar(x[theta], thr << r->shift_sub[theta], r, theta);
+}
+
+static inline __m512i load_flt_16(const int16_t *p, __mmask16 m)
+{
+    return _mm512_cvtepi16_epi32(_mm256_maskz_loadu_epi16(m, p));
+}
+
+static void cm_row_vec(const adm_dwt_band_t *src, int16_t *const *angles,
+                       int16_t *const *flt_angles, int src_offset, CmRows y,
+                       int start_col, int end_col, const uint16_t *i_rfactor,
+                       const CmRound *r, __m512i *accum_vec)
+{
+    const int16_t *src_angles[3] = { src->band_h, src->band_v, src->band_d };
+    const __m512i one_by_15 = _mm512_set1_epi32(ONE_BY_15);
+    const __m512i add_one_by_15 = _mm512_set1_epi32(2048);
+    const __m512i zero = _mm512_setzero_si512();
+
+    __m512i add_sq[3], add_cub[3];
+    __m128i shift_sq[3], shift_cub[3];
+    for (int theta = 0; theta < 3; ++theta) {
+        add_sq[theta] = _mm512_set1_epi64(r->add_sq[theta]);
+        add_cub[theta] = _mm512_set1_epi64(r->add_cub[theta]);
+        shift_sq[theta] = _mm_cvtsi32_si128(r->shift_sq[theta]);
+        shift_cub[theta] = _mm_cvtsi32_si128(r->shift_cub[theta]);
+    }
+
+    for (int j = start_col; j < end_col; j += 16) {
+        const __mmask16 m = tail_mask16(end_col - j);
+
+        __m512i thr = zero;
+        for (int theta = 0; theta < 3; ++theta) {
+            const int16_t *flt_ptr = flt_angles[theta] + j;
+            __m512i sum = _mm512_add_epi32(
+                _mm512_add_epi32(load_flt_16(flt_ptr + y.prev - 1, m),
+                                 load_flt_16(flt_ptr + y.prev, m)),
+                _mm512_add_epi32(load_flt_16(flt_ptr + y.prev + 1, m),
+                                 load_flt_16(flt_ptr + y.cur - 1, m)));
+            sum = _mm512_add_epi32(sum, _mm512_add_epi32(
+                _mm512_add_epi32(load_flt_16(flt_ptr + y.cur + 1, m),
+                                 load_flt_16(flt_ptr + y.next - 1, m)),
+                _mm512_add_epi32(load_flt_16(flt_ptr + y.next, m),
+                                 load_flt_16(flt_ptr + y.next + 1, m))));
+
+            // (int16_t)((ONE_BY_15 * |a| + 2048) >> 12)
+            const __m512i a = load_flt_16(angles[theta] + y.cur + j, m);
+            __m512i center = _mm512_srai_epi32(_mm512_add_epi32(
+                _mm512_mullo_epi32(_mm512_abs_epi32(a), one_by_15), add_one_by_15), 12);
+            center = _mm512_srai_epi32(_mm512_slli_epi32(center, 16), 16);
+            thr = _mm512_add_epi32(thr, _mm512_add_epi32(sum, center));
+        }
+
+        for (int theta = 0; theta < 3; ++theta) {
+            const __m512i s = load_flt_16(src_angles[theta] + src_offset + j, m);
+            __m512i x = _mm512_abs_epi32(
+                _mm512_mullo_epi32(s, _mm512_set1_epi32(i_rfactor[theta])));
+            x = _mm512_sub_epi32(x, _mm512_sll_epi32(thr,
+                                 _mm_cvtsi32_si128(r->shift_sub[theta])));
+            x = _mm512_maskz_max_epi32(m, x, zero);
+            accum_vec[theta] = _mm512_add_epi64(accum_vec[theta],
+                cm_accum_16(x, add_sq[theta], shift_sq[theta],
+                            add_cub[theta], shift_cub[theta]));
+        }
+    }
+}
+
+
+static void cm_accum_row(const adm_dwt_band_t *src, int16_t *const *angles,
+                         int16_t *const *flt_angles, const uint16_t *i_rfactor,
+                         const CmRound *r, const CmFrame *f, int i,
+                         int64_t *accum)
+{
+    const CmRows y = cm_rows(f, i);
+    const int src_offset = i * f->src_stride;
+    const int w = f->w;
+    int64_t accum_inner[3] = { 0 };
+    __m512i accum_vec[3] = {
+        _mm512_setzero_si512(), _mm512_setzero_si512(), _mm512_setzero_si512(),
+    };
+
+    if (f->first_col)
+        cm_pixel(src, angles, flt_angles, src_offset, y, 1, 0, 1,
+                 i_rfactor, r, accum_inner);
+    cm_row_vec(src, angles, flt_angles, src_offset, y, f->start_col,
+               f->end_col, i_rfactor, r, accum_vec);
+    if (f->last_col)
+        cm_pixel(src, angles, flt_angles, src_offset, y, w - 2, w - 1, w - 1,
+                 i_rfactor, r, accum_inner);
+
+    cm_row_finish(accum, accum_inner, accum_vec, f);
+}
+
+float adm_cm_avx512(AdmBuffer *buf, int w, int h, int src_stride,
+                    int csf_a_stride, double adm_norm_view_dist,
+                    int adm_ref_display_height)
+{
+    const adm_dwt_band_t *src   = &buf->decouple_r;
+    const adm_dwt_band_t *csf_f = &buf->csf_f;
+    const adm_dwt_band_t *csf_a = &buf->csf_a;
+
+    uint16_t i_rfactor[3];
+    adm_i_rfactor(i_rfactor, adm_norm_view_dist, adm_ref_display_height);
+
+    const uint32_t shift_xhcub = (uint32_t)ceil(log2(w) - 4);
+    const uint32_t add_shift_xhcub = (uint32_t)pow(2, (shift_xhcub - 1));
+
+    const uint32_t shift_xvcub = (uint32_t)ceil(log2(w) - 4);
+    const uint32_t add_shift_xvcub = (uint32_t)pow(2, (shift_xvcub - 1));
+
+    const uint32_t shift_xdcub = (uint32_t)ceil(log2(w) - 3);
+    const uint32_t add_shift_xdcub = (uint32_t)pow(2, (shift_xdcub - 1));
+
+    const uint32_t shift_inner_accum = (uint32_t)ceil(log2(h));
+    const uint32_t add_shift_inner_accum = (uint32_t)pow(2, (shift_inner_accum - 1));
+
+    const CmRound r = {
+        .shift_sub = { 10, 10, 12 },
+        .add_sq = { 268435456, 268435456, 536870912 },
+        .shift_sq = { 29, 29, 30 },
+        .add_cub = { add_shift_xhcub, add_shift_xvcub, add_shift_xdcub },
+        .shift_cub = { shift_xhcub, shift_xvcub, shift_xdcub },
+    };
+
+    int16_t *angles[3] = { csf_a->band_h, csf_a->band_v, csf_a->band_d };
+    int16_t *flt_angles[3] = { csf_f->band_h, csf_f->band_v, csf_f->band_d };
+
+    /* The computation of the scales is not required for the regions which lie
+     * outside the frame borders
+     */
+    int left = w * ADM_BORDER_FACTOR - 0.5;
+    int top = h * ADM_BORDER_FACTOR - 0.5;
+    int right = w - left;
+    int bottom = h - top;
+
+    const CmFrame f = {
+        .w = w, .h = h,
+        .src_stride = src_stride, .csf_a_stride = csf_a_stride,
+        .first_col = left <= 0, .last_col = right > (w - 1),
+        .start_col = (left > 1) ? left : 1,
+        .end_col = (right < (w - 1)) ? right : (w - 1),
+        .add_shift_inner_accum = add_shift_inner_accum,
+        .shift_inner_accum = shift_inner_accum,
+    };
+    const int start_row = (top > 1) ? top : 1;
+    const int end_row = (bottom < (h - 1)) ? bottom : (h - 1);
+
+    int64_t accum[3] = { 0 };
+
+    if (top <= 0)
+        cm_accum_row(src, angles, flt_angles, i_rfactor, &r, &f, 0, accum);
+    for (int i = start_row; i < end_row; ++i)
+        cm_accum_row(src, angles, flt_angles, i_rfactor, &r, &f, i, accum);
+    if (bottom > (h - 1))
+        cm_accum_row(src, angles, flt_angles, i_rfactor, &r, &f, h - 1, accum);
+
+    /**
+     * For h and v total shifts pending from last stage is 6 rfactor[0,1] has 21 shifts
+     * => after cubing (6+21)*3=81 after squaring shifted by 29
+     * hence pending is 52-shift's done based on width and height
+     *
+     * For d total shifts pending from last stage is 6 rfactor[2] has 23 shifts
+     * => after cubing (6+23)*3=87 after squaring shifted by 30
+     * hence pending is 57-shift's done based on width and height
+     */
+    float f_accum_h = (float)(accum[0] / pow(2, (52 - shift_xhcub - shift_inner_accum)));
+    float f_accum_v = (float)(accum[1] / pow(2, (52 - shift_xvcub - shift_inner_accum)));
+    float f_accum_d = (float)(accum[2] / pow(2, (57 - shift_xdcub - shift_inner_accum)));
+
+    float num_scale_h = powf(f_accum_h, 1.0f / 3.0f) + powf((bottom - top) *
+                        (right - left) / 32.0f, 1.0f / 3.0f);
+    float num_scale_v = powf(f_accum_v, 1.0f / 3.0f) + powf((bottom - top) *
+                        (right - left) / 32.0f, 1.0f / 3.0f);
+    float num_scale_d = powf(f_accum_d, 1.0f / 3.0f) + powf((bottom - top) *
+                        (right - left) / 32.0f, 1.0f / 3.0f);
+
+    return (num_scale_h + num_scale_v + num_scale_d);
+}
+
+typedef struct I4CmShift {
+    int32_t add_dst, add_flt;
+    uint32_t shift_dst, shift_flt;
+} I4CmShift;
+
+static inline int32_t i4_cm_thresh_scalar(int32_t *const *angles,
+                                          int32_t *const *flt_angles,
+                                          CmRows y, int jl, int j, int jr,
+                                          const I4CmShift *sh)
+{
+    int32_t thr = 0;
+    for (int theta = 0; theta < 3; ++theta) {
+        const int32_t *src_ptr = angles[theta];
+        const int32_t *flt_ptr = flt_angles[theta];
+        int32_t sum = 0;
+        sum += flt_ptr[y.prev + jl];
+        sum += flt_ptr[y.prev + j];
+        sum += flt_ptr[y.prev + jr];
+        sum += flt_ptr[y.cur + jl];
+        sum += (int32_t)((((int64_t)I4_ONE_BY_15 * abs(src_ptr[y.cur + j])) +
+                          sh->add_flt) >> sh->shift_flt);
+        sum += flt_ptr[y.cur + jr];
+        sum += flt_ptr[y.next + jl];
+        sum += flt_ptr[y.next + j];
+        sum += flt_ptr[y.next + jr];
+        thr += sum;
+    }
+    return thr;
+}
+
+static inline void i4_cm_pixel(const i4_adm_dwt_band_t *src,
+                               int32_t *const *angles,
+                               int32_t *const *flt_angles, int src_offset,
+                               CmRows y, int jl, int j, int jr,
+                               const uint32_t *rfactor, const I4CmShift *sh,
+                               const CmRound *r, int64_t *accum_inner)
+{
+    const int32_t thr = i4_cm_thresh_scalar(angles, flt_angles, y, jl, j, jr, sh);
+    const int32_t *src_angles[3] = { src->band_h, src->band_v, src->band_d };
+    for (int theta = 0; theta < 3; ++theta) {
+        const int32_t x = (int32_t)((((int64_t)src_angles[theta][src_offset + j] *
+                                      rfactor[theta]) + sh->add_dst) >> sh->shift_dst);
+        accum_inner[theta] += cm_accum_scalar(x, thr >> r->shift_sub[theta], r, theta);
+    }
+}
+
+static void i4_cm_row_vec(const i4_adm_dwt_band_t *src, int32_t *const *angles,
+                          int32_t *const *flt_angles, int src_offset, CmRows y,
+                          int start_col, int end_col, const uint32_t *rfactor,
+                          const I4CmShift *sh, const CmRound *r,
+                          __m512i *accum_vec)
+{
+    const int32_t *src_angles[3] = { src->band_h, src->band_v, src->band_d };
+    const __m512i zero = _mm512_setzero_si512();
+
+    const __m512i one_by_15 = _mm512_set1_epi64(I4_ONE_BY_15);
+    const __m512i add_flt = _mm512_set1_epi64(sh->add_flt);
+    const __m128i shift_flt = _mm_cvtsi32_si128(sh->shift_flt);
+    const __m128i shift_flt_hi = _mm_cvtsi32_si128(32 - sh->shift_flt);
+    const __m512i add_dst = _mm512_set1_epi64(sh->add_dst);
+    const __m128i shift_dst = _mm_cvtsi32_si128(sh->shift_dst);
+    const __m128i shift_dst_hi = _mm_cvtsi32_si128(32 - sh->shift_dst);
+
+    __m512i rf[3], add_sq[3], add_cub[3];
+    __m128i shift_sq[3], shift_cub[3];
+    for (int theta = 0; theta < 3; ++theta) {
+        rf[theta] = _mm512_set1_epi64(rfactor[theta]);
+        add_sq[theta] = _mm512_set1_epi64(r->add_sq[theta]);
+        add_cub[theta] = _mm512_set1_epi64(r->add_cub[theta]);
+        shift_sq[theta] = _mm_cvtsi32_si128(r->shift_sq[theta]);
+        shift_cub[theta] = _mm_cvtsi32_si128(r->shift_cub[theta]);
+    }
+
+    for (int j = start_col; j < end_col; j += 16) {
+        const __mmask16 m = tail_mask16(end_col - j);
+
+        __m512i thr = zero;
+        for (int theta = 0; theta < 3; ++theta) {
+            const int32_t *flt_ptr = flt_angles[theta] + j;
+            __m512i sum = _mm512_add_epi32(
+                _mm512_add_epi32(_mm512_maskz_loadu_epi32(m, flt_ptr + y.prev - 1),
+                                 _mm512_maskz_loadu_epi32(m, flt_ptr + y.prev)),
+                _mm512_add_epi32(_mm512_maskz_loadu_epi32(m, flt_ptr + y.prev + 1),
+                                 _mm512_maskz_loadu_epi32(m, flt_ptr + y.cur - 1)));
+            sum = _mm512_add_epi32(sum, _mm512_add_epi32(
+                _mm512_add_epi32(_mm512_maskz_loadu_epi32(m, flt_ptr + y.cur + 1),
+                                 _mm512_maskz_loadu_epi32(m, flt_ptr + y.next - 1)),
+                _mm512_add_epi32(_mm512_maskz_loadu_epi32(m, flt_ptr + y.next),
+                                 _mm512_maskz_loadu_epi32(m, flt_ptr + y.next + 1))));
+
+            const __m512i a = _mm512_maskz_loadu_epi32(m, angles[theta] + y.cur + j);
+            const __m512i center = mul_round_epi32(_mm512_abs_epi32(a), one_by_15,
+                                                   add_flt, shift_flt, shift_flt_hi);
+            thr = _mm512_add_epi32(thr, _mm512_add_epi32(sum, center));
+        }
+
+        for (int theta = 0; theta < 3; ++theta) {
+            const __m512i s =
+                _mm512_maskz_loadu_epi32(m, src_angles[theta] + src_offset + j);
+            __m512i x = _mm512_abs_epi32(
+                mul_round_epi32(s, rf[theta], add_dst, shift_dst, shift_dst_hi));
+            x = _mm512_sub_epi32(x, _mm512_sra_epi32(thr,
+                                 _mm_cvtsi32_si128(r->shift_sub[theta])));
+            x = _mm512_maskz_max_epi32(m, x, zero);
+            accum_vec[theta] = _mm512_add_epi64(accum_vec[theta],
+                cm_accum_16(x, add_sq[theta], shift_sq[theta],
+                            add_cub[theta], shift_cub[theta]));
+        }
+    }
+}
+
+static void i4_cm_accum_row(const i4_adm_dwt_band_t *src,
+                            int32_t *const *angles, int32_t *const *flt_angles,
+                            const uint32_t *rfactor, const I4CmShift *sh,
+                            const CmRound *r, const CmFrame *f, int i,
+                            int64_t *accum)
+{
+    const CmRows y = cm_rows(f, i);
+    const int src_offset = i * f->src_stride;
+    const int w = f->w;
+    int64_t accum_inner[3] = { 0 };
+    __m512i accum_vec[3] = {
+        _mm512_setzero_si512(), _mm512_setzero_si512(), _mm512_setzero_si512(),
+    };
+
+    if (f->first_col)
+        i4_cm_pixel(src, angles, flt_angles, src_offset, y, 1, 0, 1,
+                    rfactor, sh, r, accum_inner);
+    i4_cm_row_vec(src, angles, flt_angles, src_offset, y, f->start_col,
+                  f->end_col, rfactor, sh, r, accum_vec);
+    if (f->last_col)
+        i4_cm_pixel(src, angles, flt_angles, src_offset, y, w - 2, w - 1, w - 1,
+                    rfactor, sh, r, accum_inner);
+
+    cm_row_finish(accum, accum_inner, accum_vec, f);
+}
+
+float i4_adm_cm_avx512(AdmBuffer *buf, int w, int h, int src_stride,
+                       int csf_a_stride, int scale, double adm_norm_view_dist,
+                       int adm_ref_display_height)
+{
+    const i4_adm_dwt_band_t *src = &buf->i4_decouple_r;
+    const i4_adm_dwt_band_t *csf_f = &buf->i4_csf_f;
+    const i4_adm_dwt_band_t *csf_a = &buf->i4_csf_a;
+
+    uint32_t rfactor[3];
+    i4_adm_rfactor(rfactor, scale, adm_norm_view_dist, adm_ref_display_height);
+
+    const uint32_t shift_dst[3] = { 28, 28, 28 };
+    const uint32_t shift_flt[3] = { 32, 32, 32 };
+    int32_t add_bef_shift_dst[3], add_bef_shift_flt[3];
+
+    for (unsigned idx = 0; idx < 3; ++idx) {
+        add_bef_shift_dst[idx] = (1u << (shift_dst[idx] - 1));
+        add_bef_shift_flt[idx] = (1u << (shift_flt[idx] - 1));
+    }
+
+    const I4CmShift sh = {
+        .add_dst = add_bef_shift_dst[scale - 1],
+        .add_flt = add_bef_shift_flt[scale - 1],
+        .shift_dst = shift_dst[scale - 1],
+        .shift_flt = shift_flt[scale - 1],
+    };
+
+    uint32_t shift_cub = (uint32_t)ceil(log2(w));
+    uint32_t add_shift_cub = (uint32_t)pow(2, (shift_cub - 1));
+
+    uint32_t shift_inner_accum = (uint32_t)ceil(log2(h));
+    uint32_t add_shift_inner_accum = (uint32_t)pow(2, (shift_inner_accum - 1));
+
+    float final_shift[3] = { pow(2,(45 - shift_cub - shift_inner_accum)),
+                             pow(2,(39 - shift_cub - shift_inner_accum)),
+                             pow(2,(36 - shift_cub - shift_inner_accum)) };
+
+    const CmRound r = {
+        .shift_sub = { 0, 0, 0 },
+        .add_sq = { 536870912, 536870912, 536870912 }, //2^29
+        .shift_sq = { 30, 30, 30 },
+        .add_cub = { add_shift_cub, add_shift_cub, add_shift_cub },
+        .shift_cub = { shift_cub, shift_cub, shift_cub },
+    };
+
+    int32_t *angles[3] = { csf_a->band_h, csf_a->band_v, csf_a->band_d };
+    int32_t *flt_angles[3] = { csf_f->band_h, csf_f->band_v, csf_f->band_d };
+
+    /* The computation of the scales is not required for the regions which lie
+     * outside the frame borders
+     */
+    const int left = w * ADM_BORDER_FACTOR - 0.5;
+    const int top = h * ADM_BORDER_FACTOR - 0.5;
+    const int right = w - left;
+    const int bottom = h - top;
+
+    const CmFrame f = {
+        .w = w, .h = h,
+        .src_stride = src_stride, .csf_a_stride = csf_a_stride,
+        .first_col = left <= 0, .last_col = right > (w - 1),
+        .start_col = (left > 1) ? left : 1,
+        .end_col = (right < (w - 1)) ? right : (w - 1),
+        .add_shift_inner_accum = add_shift_inner_accum,
+        .shift_inner_accum = shift_inner_accum,
+    };
+    const int start_row = (top > 1) ? top : 1;
+    const int end_row = (bottom < (h - 1)) ? bottom : (h - 1);
+
+    int64_t accum[3] = { 0 };
+
+    if (top <= 0)
+        i4_cm_accum_row(src, angles, flt_angles, rfactor, &sh, &r, &f, 0, accum);
+    for (int i = start_row; i < end_row; ++i)
+        i4_cm_accum_row(src, angles, flt_angles, rfactor, &sh, &r, &f, i, accum);
+    if (bottom > (h - 1))
+        i4_cm_accum_row(src, angles, flt_angles, rfactor, &sh, &r, &f, h - 1, accum);
+
+    /**
+     * Converted to floating-point for calculating the final scores
+     * Final shifts is calculated from 3*(shifts_from_previous_stage(i.e src comes from dwt)+32)-total_shifts_done_in_this_function
+     */
+    float f_accum_h = (float)(accum[0] / final_shift[scale - 1]);
+    float f_accum_v = (float)(accum[1] / final_shift[scale - 1]);
+    float f_accum_d = (float)(accum[2] / final_shift[scale - 1]);
+
+    float num_scale_h = powf(f_accum_h, 1.0f / 3.0f) + powf((bottom - top) * (right - left) / 32.0f, 1.0f / 3.0f);
+    float num_scale_v = powf(f_accum_v, 1.0f / 3.0f) + powf((bottom - top) * (right - left) / 32.0f, 1.0f / 3.0f);
+    float num_scale_d = powf(f_accum_d, 1.0f / 3.0f) + powf((bottom - top) * (right - left) / 32.0f, 1.0f / 3.0f);
+
+    return (num_scale_h + num_scale_v + num_scale_d);
+}
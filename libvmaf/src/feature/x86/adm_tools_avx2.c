@@ -0,0 +1,498 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <immintrin.h>
+#include <math.h>
+#include <stddef.h>
+
+#include "mem.h"
+#include "feature/adm_options.h"
+#include "feature/adm_tools.h"
+#include "feature/x86/adm_tools_avx2.h"
+
+/*
+ * These match the scalar code in adm_tools.c bit for bit: the same operations
+ * in the same order, with the double precision steps the scalar code gets
+ * from its double constants and from adm_enhn_gain_limit. Reductions vectorize
+ * the per pixel terms only and keep summing them one at a time.
+ *
+ * Element-wise kernels finish a row with one more vector ending at the last
+ * column, so they need at least 8 columns.
+ */
+
+static inline __m256 abs_ps(__m256 x)
+{
+    return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), x);
+}
+
+// (float)(c * x), with the product in double precision
+static inline __m256 mul_pd_ps(__m256 x, __m256d c)
+{
+    const __m256d lo = _mm256_mul_pd(c, _mm256_cvtps_pd(_mm256_castps256_ps128(x)));
+    const __m256d hi = _mm256_mul_pd(c, _mm256_cvtps_pd(_mm256_extractf128_ps(x, 1)));
+    return _mm256_set_m128(_mm256_cvtpd_ps(hi), _mm256_cvtpd_ps(lo));
+}
+
+// (float)(sum + c * x), with the product and the sum in double precision
+static inline __m256 add_mul_pd_ps(__m256 sum, __m256 x, __m256d c)
+{
+    const __m256d lo =
+        _mm256_add_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(sum)),
+                      _mm256_mul_pd(c, _mm256_cvtps_pd(_mm256_castps256_ps128(x))));
+    const __m256d hi =
+        _mm256_add_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(sum, 1)),
+                      _mm256_mul_pd(c, _mm256_cvtps_pd(_mm256_extractf128_ps(x, 1))));
+    return _mm256_set_m128(_mm256_cvtpd_ps(hi), _mm256_cvtpd_ps(lo));
+}
+
+static inline __m256 cube_ps(__m256 x)
+{
+    return _mm256_mul_ps(_mm256_mul_ps(x, x), x);
+}
+
+static inline __m256 dwt2_tap_ps(const __m256 f[4], __m256 s0, __m256 s1,
+                                 __m256 s2, __m256 s3)
+{
+    __m256 accum = _mm256_setzero_ps();
+    accum = _mm256_add_ps(accum, _mm256_mul_ps(f[0], s0));
+    accum = _mm256_add_ps(accum, _mm256_mul_ps(f[1], s1));
+    accum = _mm256_add_ps(accum, _mm256_mul_ps(f[2], s2));
+    accum = _mm256_add_ps(accum, _mm256_mul_ps(f[3], s3));
+    return accum;
+}
+
+static inline float dwt2_tap_s(const float *f, float s0, float s1, float s2,
+                               float s3)
+{
+    float accum = 0;
+    accum += f[0] * s0;
+    accum += f[1] * s1;
+    accum += f[2] * s2;
+    accum += f[3] * s3;
+    return accum;
+}
+
+// the even and odd elements of the 16 floats in a and b
+static inline void deinterleave_ps(__m256 a, __m256 b, __m256 *even, __m256 *odd)
+{
+    const __m256 e = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    const __m256 o = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+    *even = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(e),
+                                                   _MM_SHUFFLE(3, 1, 2, 0)));
+    *odd = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(o),
+                                                  _MM_SHUFFLE(3, 1, 2, 0)));
+}
+
+static inline void dwt2_v_avx2(const __m256 lo[4], const __m256 hi[4],
+                               const float *s0, const float *s1,
+                               const float *s2, const float *s3,
+                               float *tmplo, float *tmphi, int j)
+{
+    const __m256 a0 = _mm256_loadu_ps(s0 + j);
+    const __m256 a1 = _mm256_loadu_ps(s1 + j);
+    const __m256 a2 = _mm256_loadu_ps(s2 + j);
+    const __m256 a3 = _mm256_loadu_ps(s3 + j);
+    _mm256_storeu_ps(tmplo + j, dwt2_tap_ps(lo, a0, a1, a2, a3));
+    _mm256_storeu_ps(tmphi + j, dwt2_tap_ps(hi, a0, a1, a2, a3));
+}
+
+// outputs j to j + 7, away from the borders: taps 2j - 1 to 2j + 16
+static inline void dwt2_h_avx2(const __m256 lo[4], const __m256 hi[4],
+                               const float *tmplo, const float *tmphi,
+                               const adm_dwt_band_t_s *row, int j)
+{
+    const float *p = tmplo + 2 * j - 1;
+    __m256 s0, s1, s2, s3;
+    deinterleave_ps(_mm256_loadu_ps(p), _mm256_loadu_ps(p + 8), &s0, &s1);
+    deinterleave_ps(_mm256_loadu_ps(p + 2), _mm256_loadu_ps(p + 10), &s2, &s3);
+    _mm256_storeu_ps(row->band_a + j, dwt2_tap_ps(lo, s0, s1, s2, s3));
+    _mm256_storeu_ps(row->band_v + j, dwt2_tap_ps(hi, s0, s1, s2, s3));
+
+    p = tmphi + 2 * j - 1;
+    deinterleave_ps(_mm256_loadu_ps(p), _mm256_loadu_ps(p + 8), &s0, &s1);
+    deinterleave_ps(_mm256_loadu_ps(p + 2), _mm256_loadu_ps(p + 10), &s2, &s3);
+    _mm256_storeu_ps(row->band_h + j, dwt2_tap_ps(lo, s0, s1, s2, s3));
+    _mm256_storeu_ps(row->band_d + j, dwt2_tap_ps(hi, s0, s1, s2, s3));
+}
+
+static inline void dwt2_h_s(const float *filter_lo, const float *filter_hi,
+                            const float *tmplo, const float *tmphi,
+                            int **ind_x, const adm_dwt_band_t_s *row, int j)
+{
+    const int j0 = ind_x[0][j];
+    const int j1 = ind_x[1][j];
+    const int j2 = ind_x[2][j];
+    const int j3 = ind_x[3][j];
+    row->band_a[j] = dwt2_tap_s(filter_lo, tmplo[j0], tmplo[j1], tmplo[j2], tmplo[j3]);
+    row->band_v[j] = dwt2_tap_s(filter_hi, tmplo[j0], tmplo[j1], tmplo[j2], tmplo[j3]);
+    row->band_h[j] = dwt2_tap_s(filter_lo, tmphi[j0], tmphi[j1], tmphi[j2], tmphi[j3]);
+    row->band_d[j] = dwt2_tap_s(filter_hi, tmphi[j0], tmphi[j1], tmphi[j2], tmphi[j3]);
+}
+
+void adm_dwt2_s_avx2(const float *filter_lo, const float *filter_hi,
+                     const float *src, const adm_dwt_band_t_s *dst,
+                     int **ind_y, int **ind_x, int w, int h,
+                     int src_stride, int dst_stride)
+{
+    const int src_px_stride = src_stride / sizeof(float);
+    const int dst_px_stride = dst_stride / sizeof(float);
+    const __m256 lo[4] = {
+        _mm256_set1_ps(filter_lo[0]), _mm256_set1_ps(filter_lo[1]),
+        _mm256_set1_ps(filter_lo[2]), _mm256_set1_ps(filter_lo[3]),
+    };
+    const __m256 hi[4] = {
+        _mm256_set1_ps(filter_hi[0]), _mm256_set1_ps(filter_hi[1]),
+        _mm256_set1_ps(filter_hi[2]), _mm256_set1_ps(filter_hi[3]),
+    };
+
+    // outputs 1 to inner_end - 1 read taps 2j - 1 to 2j + 2 without mirroring
+    const int half_w = (w + 1) / 2;
+    const int inner_end = (w - 1) / 2;
+
+    float *tmplo = aligned_malloc(ALIGN_CEIL(sizeof(float) * w), MAX_ALIGN);
+    float *tmphi = aligned_malloc(ALIGN_CEIL(sizeof(float) * w), MAX_ALIGN);
+
+    for (int i = 0; i < (h + 1) / 2; ++i) {
+        /* Vertical pass. */
+        const float *s0 = src + ind_y[0][i] * src_px_stride;
+        const float *s1 = src + ind_y[1][i] * src_px_stride;
+        const float *s2 = src + ind_y[2][i] * src_px_stride;
+        const float *s3 = src + ind_y[3][i] * src_px_stride;
+
+        for (int j = 0; j < w; j += 8) {
+            if (j + 8 > w)
+                j = w - 8;
+            dwt2_v_avx2(lo, hi, s0, s1, s2, s3, tmplo, tmphi, j);
+        }
+
+        /* Horizontal pass (lo and hi). */
+        const adm_dwt_band_t_s row = {
+            .band_a = dst->band_a + i * dst_px_stride,
+            .band_v = dst->band_v + i * dst_px_stride,
+            .band_h = dst->band_h + i * dst_px_stride,
+            .band_d = dst->band_d + i * dst_px_stride,
+        };
+
+        int j = 1;
+        if (inner_end - j >= 8) {
+            for (; j < inner_end; j += 8) {
+                if (j + 8 > inner_end)
+                    j = inner_end - 8;
+                dwt2_h_avx2(lo, hi, tmplo, tmphi, &row, j);
+            }
+        }
+        dwt2_h_s(filter_lo, filter_hi, tmplo, tmphi, ind_x, &row, 0);
+        for (; j < half_w; ++j)
+            dwt2_h_s(filter_lo, filter_hi, tmplo, tmphi, ind_x, &row, j);
+    }
+
+    aligned_free(tmplo);
+    aligned_free(tmphi);
+}
+
+#ifdef ADM_OPT_RECIP_DIVISION
+static inline __m256 divs_ps(__m256 n, __m256 d)
+{
+    const __m256 xi = _mm256_rcp_ps(d);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 r = _mm256_add_ps(xi, _mm256_mul_ps(xi, _mm256_sub_ps(one, _mm256_mul_ps(d, xi))));
+    return _mm256_mul_ps(n, r);
+}
+#else
+static inline __m256 divs_ps(__m256 n, __m256 d)
+{
+    return _mm256_div_ps(n, d);
+}
+#endif
+
+// the clipped gain k * o, raised to at most adm_enhn_gain_limit * k * o
+// where the angle test passes
+static inline __m256 decouple_rst_avx2(__m256 o, __m256 t, __m256 angle_flag,
+                                       __m256d gain_limit)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 eps = _mm256_set1_ps(1e-30f);
+
+    __m256 k = divs_ps(t, _mm256_add_ps(o, eps));
+    k = _mm256_min_ps(_mm256_set1_ps(1.0f), _mm256_max_ps(zero, k));
+    __m256 rst = _mm256_mul_ps(k, o);
+
+    __m256 m = _mm256_and_ps(angle_flag, _mm256_cmp_ps(rst, zero, _CMP_GT_OQ));
+    rst = _mm256_blendv_ps(rst, _mm256_min_ps(mul_pd_ps(rst, gain_limit), t), m);
+    m = _mm256_and_ps(angle_flag, _mm256_cmp_ps(rst, zero, _CMP_LT_OQ));
+    rst = _mm256_blendv_ps(rst, _mm256_max_ps(mul_pd_ps(rst, gain_limit), t), m);
+    return rst;
+}
+
+static inline void decouple_avx2(const float *ref_h, const float *ref_v,
+                                 const float *ref_d, const float *dis_h,
+                                 const float *dis_v, const float *dis_d,
+                                 float *r_h, float *r_v, float *r_d,
+                                 float *a_h, float *a_v, float *a_d,
+                                 __m256 cos_1deg_sq, __m256d gain_limit, int j)
+{
+    const __m256 oh = _mm256_loadu_ps(ref_h + j);
+    const __m256 ov = _mm256_loadu_ps(ref_v + j);
+    const __m256 od = _mm256_loadu_ps(ref_d + j);
+    const __m256 th = _mm256_loadu_ps(dis_h + j);
+    const __m256 tv = _mm256_loadu_ps(dis_v + j);
+    const __m256 td = _mm256_loadu_ps(dis_d + j);
+
+    const __m256 ot_dp = _mm256_add_ps(_mm256_mul_ps(oh, th), _mm256_mul_ps(ov, tv));
+    const __m256 o_mag_sq = _mm256_add_ps(_mm256_mul_ps(oh, oh), _mm256_mul_ps(ov, ov));
+    const __m256 t_mag_sq = _mm256_add_ps(_mm256_mul_ps(th, th), _mm256_mul_ps(tv, tv));
+    const __m256 angle_flag = _mm256_and_ps(
+        _mm256_cmp_ps(ot_dp, _mm256_setzero_ps(), _CMP_GE_OQ),
+        _mm256_cmp_ps(_mm256_mul_ps(ot_dp, ot_dp),
+                      _mm256_mul_ps(_mm256_mul_ps(cos_1deg_sq, o_mag_sq), t_mag_sq),
+                      _CMP_GE_OQ));
+
+    const __m256 rst_h = decouple_rst_avx2(oh, th, angle_flag, gain_limit);
+    const __m256 rst_v = decouple_rst_avx2(ov, tv, angle_flag, gain_limit);
+    const __m256 rst_d = decouple_rst_avx2(od, td, angle_flag, gain_limit);
+
+    _mm256_storeu_ps(r_h + j, rst_h);
+    _mm256_storeu_ps(r_v + j, rst_v);
+    _mm256_storeu_ps(r_d + j, rst_d);
+    _mm256_storeu_ps(a_h + j, _mm256_sub_ps(th, rst_h));
+    _mm256_storeu_ps(a_v + j, _mm256_sub_ps(tv, rst_v));
+    _mm256_storeu_ps(a_d + j, _mm256_sub_ps(td, rst_d));
+}
+
+void adm_decouple_s_avx2(const adm_dwt_band_t_s *ref, const adm_dwt_band_t_s *dis,
+                         const adm_dwt_band_t_s *r, const adm_dwt_band_t_s *a,
+                         int left, int top, int right, int bottom,
+                         int ref_stride, int dis_stride, int r_stride, int a_stride,
+                         double adm_enhn_gain_limit)
+{
+    const float cos_1deg_sq_s = cos(1.0 * M_PI / 180.0) * cos(1.0 * M_PI / 180.0);
+    const __m256 cos_1deg_sq = _mm256_set1_ps(cos_1deg_sq_s);
+    const __m256d gain_limit = _mm256_set1_pd(adm_enhn_gain_limit);
+
+    const int ref_px_stride = ref_stride / sizeof(float);
+    const int dis_px_stride = dis_stride / sizeof(float);
+    const int r_px_stride = r_stride / sizeof(float);
+    const int a_px_stride = a_stride / sizeof(float);
+
+    for (int i = top; i < bottom; ++i) {
+        const float *ref_h = ref->band_h + i * ref_px_stride;
+        const float *ref_v = ref->band_v + i * ref_px_stride;
+        const float *ref_d = ref->band_d + i * ref_px_stride;
+        const float *dis_h = dis->band_h + i * dis_px_stride;
+        const float *dis_v = dis->band_v + i * dis_px_stride;
+        const float *dis_d = dis->band_d + i * dis_px_stride;
+        float *r_h = r->band_h + i * r_px_stride;
+        float *r_v = r->band_v + i * r_px_stride;
+        float *r_d = r->band_d + i * r_px_stride;
+        float *a_h = a->band_h + i * a_px_stride;
+        float *a_v = a->band_v + i * a_px_stride;
+        float *a_d = a->band_d + i * a_px_stride;
+
+        for (int j = left; j < right; j += 8) {
+            if (j + 8 > right)
+                j = right - 8;
+            decouple_avx2(ref_h, ref_v, ref_d, dis_h, dis_v, dis_d, r_h, r_v, r_d,
+                          a_h, a_v, a_d, cos_1deg_sq, gain_limit, j);
+        }
+    }
+}
+
+void adm_csf_s_avx2(const adm_dwt_band_t_s *src, const adm_dwt_band_t_s *dst,
+                    const adm_dwt_band_t_s *flt, const float rfactor[3],
+                    int left, int top, int right, int bottom,
+                    int src_stride, int dst_stride)
+{
+    const float *src_angles[3] = { src->band_h, src->band_v, src->band_d };
+    float *dst_angles[3] = { dst->band_h, dst->band_v, dst->band_d };
+    float *flt_angles[3] = { flt->band_h, flt->band_v, flt->band_d };
+
+    const int src_px_stride = src_stride / sizeof(float);
+    const int dst_px_stride = dst_stride / sizeof(float);
+    const __m256d one_by_30 = _mm256_set1_pd(FLOAT_ONE_BY_30);
+
+    for (int theta = 0; theta < 3; ++theta) {
+        const __m256 factor = _mm256_set1_ps(rfactor[theta]);
+
+        for (int i = top; i < bottom; ++i) {
+            const float *src_ptr = src_angles[theta] + i * src_px_stride;
+            float *dst_ptr = dst_angles[theta] + i * dst_px_stride;
+            float *flt_ptr = flt_angles[theta] + i * dst_px_stride;
+
+            for (int j = left; j < right; j += 8) {
+                if (j + 8 > right)
+                    j = right - 8;
+                const __m256 dst_val = _mm256_mul_ps(factor, _mm256_loadu_ps(src_ptr + j));
+                _mm256_storeu_ps(dst_ptr + j, dst_val);
+                _mm256_storeu_ps(flt_ptr + j, mul_pd_ps(abs_ps(dst_val), one_by_30));
+            }
+        }
+    }
+}
+
+// the serial float sums of the scalar code, fed 8 terms at a time
+static inline void accum_ps(float *accum, __m256 x)
+{
+    float v[8];
+    _mm256_storeu_ps(v, x);
+    for (int k = 0; k < 8; k++)
+        *accum += v[k];
+}
+
+void adm_csf_den_scale_accum_s_avx2(const adm_dwt_band_t_s *src,
+                                    const float rfactor[3],
+                                    int left, int top, int right, int bottom,
+                                    int src_stride, float accum[3])
+{
+    const int src_px_stride = src_stride / sizeof(float);
+    const __m256 factor_h = _mm256_set1_ps(rfactor[0]);
+    const __m256 factor_v = _mm256_set1_ps(rfactor[1]);
+    const __m256 factor_d = _mm256_set1_ps(rfactor[2]);
+
+    float accum_h = 0, accum_v = 0, accum_d = 0;
+
+    for (int i = top; i < bottom; ++i) {
+        const float *src_h = src->band_h + i * src_px_stride;
+        const float *src_v = src->band_v + i * src_px_stride;
+        const float *src_d = src->band_d + i * src_px_stride;
+        float accum_inner_h = 0, accum_inner_v = 0, accum_inner_d = 0;
+
+        int j;
+        for (j = left; j + 8 <= right; j += 8) {
+            const __m256 h = abs_ps(_mm256_mul_ps(factor_h, _mm256_loadu_ps(src_h + j)));
+            const __m256 v = abs_ps(_mm256_mul_ps(factor_v, _mm256_loadu_ps(src_v + j)));
+            const __m256 d = abs_ps(_mm256_mul_ps(factor_d, _mm256_loadu_ps(src_d + j)));
+            accum_ps(&accum_inner_h, cube_ps(h));
+            accum_ps(&accum_inner_v, cube_ps(v));
+            accum_ps(&accum_inner_d, cube_ps(d));
+        }
+        for (; j < right; ++j) {
+            const float h = fabsf(rfactor[0] * src_h[j]);
+            const float v = fabsf(rfactor[1] * src_v[j]);
+            const float d = fabsf(rfactor[2] * src_d[j]);
+            accum_inner_h += h * h * h;
+            accum_inner_v += v * v * v;
+            accum_inner_d += d * d * d;
+        }
+
+        accum_h += accum_inner_h;
+        accum_v += accum_inner_v;
+        accum_d += accum_inner_d;
+    }
+
+    accum[0] = accum_h;
+    accum[1] = accum_v;
+    accum[2] = accum_d;
+}
+
+void adm_cm_row_s_avx2(const adm_dwt_band_t_s *src, const adm_dwt_band_t_s *csf_f,
+                       const adm_dwt_band_t_s *csf_a, const float rfactor[3],
+                       int i, int start_col, int end_col,
+                       int src_stride, int csf_stride, float accum[3])
+{
+    const float *angles[3] = { csf_a->band_h, csf_a->band_v, csf_a->band_d };
+    const float *flt_angles[3] = { csf_f->band_h, csf_f->band_v, csf_f->band_d };
+
+    const int src_px_stride = src_stride / sizeof(float);
+    const int csf_px_stride = csf_stride / sizeof(float);
+    const float *src_h = src->band_h + i * src_px_stride;
+    const float *src_v = src->band_v + i * src_px_stride;
+    const float *src_d = src->band_d + i * src_px_stride;
+
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 factor_h = _mm256_set1_ps(rfactor[0]);
+    const __m256 factor_v = _mm256_set1_ps(rfactor[1]);
+    const __m256 factor_d = _mm256_set1_ps(rfactor[2]);
+    const __m256d one_by_15 = _mm256_set1_pd(FLOAT_ONE_BY_15);
+    float accum_h = accum[0], accum_v = accum[1], accum_d = accum[2];
+
+    int j;
+    for (j = start_col; j + 8 <= end_col; j += 8) {
+        __m256 thr = zero;
+        for (int theta = 0; theta < 3; ++theta) {
+            const float *src_ptr = angles[theta] + i * csf_px_stride + j;
+            const float *flt_ptr = flt_angles[theta] + (i - 1) * csf_px_stride + j;
+            __m256 sum = zero;
+            sum = _mm256_add_ps(sum, _mm256_loadu_ps(flt_ptr - 1));
+            sum = _mm256_add_ps(sum, _mm256_loadu_ps(flt_ptr));
+            sum = _mm256_add_ps(sum, _mm256_loadu_ps(flt_ptr + 1));
+            flt_ptr += csf_px_stride;
+            sum = _mm256_add_ps(sum, _mm256_loadu_ps(flt_ptr - 1));
+            sum = add_mul_pd_ps(sum, abs_ps(_mm256_loadu_ps(src_ptr)), one_by_15);
+            sum = _mm256_add_ps(sum, _mm256_loadu_ps(flt_ptr + 1));
+            flt_ptr += csf_px_stride;
+            sum = _mm256_add_ps(sum, _mm256_loadu_ps(flt_ptr - 1));
+            sum = _mm256_add_ps(sum, _mm256_loadu_ps(flt_ptr));
+            sum = _mm256_add_ps(sum, _mm256_loadu_ps(flt_ptr + 1));
+            thr = _mm256_add_ps(thr, sum);
+        }
+
+        __m256 xh = _mm256_mul_ps(_mm256_loadu_ps(src_h + j), factor_h);
+        __m256 xv = _mm256_mul_ps(_mm256_loadu_ps(src_v + j), factor_v);
+        __m256 xd = _mm256_mul_ps(_mm256_loadu_ps(src_d + j), factor_d);
+        xh = _mm256_max_ps(zero, _mm256_sub_ps(abs_ps(xh), thr));
+        xv = _mm256_max_ps(zero, _mm256_sub_ps(abs_ps(xv), thr));
+        xd = _mm256_max_ps(zero, _mm256_sub_ps(abs_ps(xd), thr));
+        accum_ps(&accum_h, cube_ps(xh));
+        accum_ps(&accum_v, cube_ps(xv));
+        accum_ps(&accum_d, cube_ps(xd));
+    }
+
+    for (; j < end_col; ++j) {
+        float thr;
+        // w and h are only used at the borders
+        ADM_CM_THRESH_S_I_J(angles, flt_angles, csf_px_stride, &thr, 0, 0, i, j);
+
+        float xh = fabsf(src_h[j] * rfactor[0]) - thr;
+        float xv = fabsf(src_v[j] * rfactor[1]) - thr;
+        float xd = fabsf(src_d[j] * rfactor[2]) - thr;
+        xh = xh < 0.0f ? 0.0f : xh;
+        xv = xv < 0.0f ? 0.0f : xv;
+        xd = xd < 0.0f ? 0.0f : xd;
+        accum_h += xh * xh * xh;
+        accum_v += xv * xv * xv;
+        accum_d += xd * xd * xd;
+    }
+
+    accum[0] = accum_h;
+    accum[1] = accum_v;
+    accum[2] = accum_d;
+}
+
+float adm_sum_cube_accum_s_avx2(const float *x, int left, int top, int right,
+                                int bottom, int stride)
+{
+    const int px_stride = stride / sizeof(float);
+    float accum = 0;
+
+    for (int i = top; i < bottom; ++i) {
+        const float *x_row = x + i * px_stride;
+        float accum_inner = 0;
+
+        int j;
+        for (j = left; j + 8 <= right; j += 8)
+            accum_ps(&accum_inner, cube_ps(abs_ps(_mm256_loadu_ps(x_row + j))));
+        for (; j < right; ++j) {
+            const float val = fabsf(x_row[j]);
+            accum_inner += val * val * val;
+        }
+
+        accum += accum_inner;
+    }
+
+    return accum;
+}
@@ -80,4 +80,86 @@ void get_derivative_data_for_row_avx2(const uint16_t *image_data, uint16_t *deri
             derivative_buffer[col] =  horizontal_derivative && vertical_derivative;
         }
     }
-}
\ No newline at end of file
+}
+
+void anti_dithering_row_avx2(uint16_t *row, const uint16_t *next_row, int width) {
+    int col = 0;
+    for (; col + 16 < width; col += 16) {
+        __m256i sum = _mm256_add_epi16(_mm256_loadu_si256((__m256i*) &row[col]),
+                                       _mm256_loadu_si256((__m256i*) &row[col + 1]));
+        sum = _mm256_add_epi16(sum, _mm256_loadu_si256((__m256i*) &next_row[col]));
+        sum = _mm256_add_epi16(sum, _mm256_loadu_si256((__m256i*) &next_row[col + 1]));
+        _mm256_storeu_si256((__m256i*) &row[col], _mm256_srli_epi16(sum, 2));
+    }
+    for (; col < width - 1; col++) {
+        row[col] = (row[col] + row[col + 1] + next_row[col] + next_row[col + 1]) >> 2;
+    }
+    row[width - 1] = (row[width - 1] + next_row[width - 1]) >> 1;
+}
+
+static inline uint16_t min3(uint16_t a, uint16_t b, uint16_t c) {
+    if (a <= b && a <= c) return a;
+    if (b <= c) return b;
+    return c;
+}
+
+static inline uint16_t mode3(uint16_t a, uint16_t b, uint16_t c) {
+    if (a == b || a == c) return a;
+    if (b == c) return b;
+    return min3(a, b, c);
+}
+
+void mode3_row_avx2(uint16_t *dst, const uint16_t *a, const uint16_t *b, const uint16_t *c, int width) {
+    int col = 0;
+    for (; col + 15 < width; col += 16) {
+        __m256i va = _mm256_loadu_si256((__m256i*) &a[col]);
+        __m256i vb = _mm256_loadu_si256((__m256i*) &b[col]);
+        __m256i vc = _mm256_loadu_si256((__m256i*) &c[col]);
+        // the minimum, unless two of the values agree
+        __m256i result = _mm256_min_epu16(_mm256_min_epu16(va, vb), vc);
+        result = _mm256_blendv_epi8(result, vb, _mm256_cmpeq_epi16(vb, vc));
+        __m256i a_is_mode = _mm256_or_si256(_mm256_cmpeq_epi16(va, vb), _mm256_cmpeq_epi16(va, vc));
+        result = _mm256_blendv_epi8(result, va, a_is_mode);
+        _mm256_storeu_si256((__m256i*) &dst[col], result);
+    }
+    for (; col < width; col++) {
+        dst[col] = mode3(a[col], b[col], c[col]);
+    }
+}
+
+void decimate_row_avx2(uint16_t *dst, const uint16_t *src, int width) {
+    const __m256i even = _mm256_set1_epi32(0xFFFF);
+    int col = 0;
+    // src holds at least 2 * width - 1 values, the last load ends at 2 * col + 31
+    for (; col + 16 < width; col += 16) {
+        __m256i lo = _mm256_and_si256(_mm256_loadu_si256((__m256i*) &src[2 * col]), even);
+        __m256i hi = _mm256_and_si256(_mm256_loadu_si256((__m256i*) &src[2 * col + 16]), even);
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xD8);
+        _mm256_storeu_si256((__m256i*) &dst[col], packed);
+    }
+    for (; col < width; col++) {
+        dst[col] = src[col << 1];
+    }
+}
+
+void spatial_mask_row_avx2(uint16_t *mask_row, const uint16_t *column_sums, int width,
+                           uint16_t window, uint16_t mask_index) {
+    const __m256i index = _mm256_set1_epi16(mask_index);
+    const __m256i ones = _mm256_set1_epi16(1);
+    int col = 0;
+    for (; col + 15 < width; col += 16) {
+        __m256i sum = _mm256_loadu_si256((__m256i*) &column_sums[col]);
+        for (int k = 1; k < window; k++) {
+            sum = _mm256_add_epi16(sum, _mm256_loadu_si256((__m256i*) &column_sums[col + k]));
+        }
+        __m256i not_above = _mm256_cmpeq_epi16(_mm256_min_epu16(sum, index), sum);
+        _mm256_storeu_si256((__m256i*) &mask_row[col], _mm256_andnot_si256(not_above, ones));
+    }
+    for (; col < width; col++) {
+        unsigned sum = 0;
+        for (int k = 0; k < window; k++) {
+            sum += column_sums[col + k];
+        }
+        mask_row[col] = (sum > mask_index);
+    }
+}
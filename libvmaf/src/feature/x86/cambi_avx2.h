@@ -28,4 +28,13 @@ void cambi_decrement_range_avx2(uint16_t *arr, int left, int right);
 
 void get_derivative_data_for_row_avx2(const uint16_t *image_data, uint16_t *derivative_buffer, int width, int height, int row, int stride);
 
+void anti_dithering_row_avx2(uint16_t *row, const uint16_t *next_row, int width);
+
+void mode3_row_avx2(uint16_t *dst, const uint16_t *a, const uint16_t *b, const uint16_t *c, int width);
+
+void decimate_row_avx2(uint16_t *dst, const uint16_t *src, int width);
+
+void spatial_mask_row_avx2(uint16_t *mask_row, const uint16_t *column_sums, int width,
+                           uint16_t window, uint16_t mask_index);
+
 #endif /* X86_AVX2_CAMBI_H_ */
@@ -0,0 +1,113 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <immintrin.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cambi_avx512.h"
+
+static inline __mmask32 tail_mask_32(int n)
+{
+    return n >= 32 ? 0xFFFFFFFFu : (1u << n) - 1;
+}
+
+void cambi_increment_range_avx512(uint16_t *arr, int left, int right)
+{
+    const __m512i one = _mm512_set1_epi16(1);
+    for (int col = left; col < right; col += 32) {
+        const __mmask32 k = tail_mask_32(right - col);
+        const __m512i data = _mm512_maskz_loadu_epi16(k, &arr[col]);
+        _mm512_mask_storeu_epi16(&arr[col], k, _mm512_add_epi16(data, one));
+    }
+}
+
+void cambi_decrement_range_avx512(uint16_t *arr, int left, int right)
+{
+    const __m512i one = _mm512_set1_epi16(1);
+    for (int col = left; col < right; col += 32) {
+        const __mmask32 k = tail_mask_32(right - col);
+        const __m512i data = _mm512_maskz_loadu_epi16(k, &arr[col]);
+        _mm512_mask_storeu_epi16(&arr[col], k, _mm512_sub_epi16(data, one));
+    }
+}
+
+/* Reads histograms[idx] for the lanes in k. The 32-bit gather also touches
+ * histograms[idx + 1], so the histogram buffer carries one spare entry. */
+static inline __m512i gather_histogram(__mmask16 k, __m512i idx,
+                                       const uint16_t *histograms)
+{
+    const __m512i v =
+        _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), k, idx,
+                                    histograms, sizeof(*histograms));
+    return _mm512_and_si512(v, _mm512_set1_epi32(0xFFFF));
+}
+
+/* Same as c_value_pixel(), for 16 columns at a time. */
+void calculate_c_values_row_avx512(float *c_values, const uint16_t *histograms,
+                                   const uint16_t *image, const uint16_t *mask,
+                                   int row, int width, ptrdiff_t stride,
+                                   const uint16_t num_diffs,
+                                   const uint16_t *tvi_for_diff,
+                                   const int *diff_weights,
+                                   const int *all_diffs)
+{
+    const uint16_t *image_row = &image[row * stride];
+    const uint16_t *mask_row = &mask[row * stride];
+    float *c_values_row = &c_values[row * width];
+    const __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7,
+                                            8, 9, 10, 11, 12, 13, 14, 15);
+    const __m512i hist_width = _mm512_set1_epi32(width);
+
+    for (int col = 0; col < width; col += 16) {
+        const __mmask16 in_row = width - col >= 16 ? 0xFFFF : (1u << (width - col)) - 1;
+        const __m256i mask_val = _mm256_maskz_loadu_epi16(in_row, &mask_row[col]);
+        const __mmask16 active = _mm256_test_epi16_mask(mask_val, mask_val);
+        if (!active) continue;
+
+        const __m512i value =
+            _mm512_add_epi32(_mm512_cvtepu16_epi32(_mm256_maskz_loadu_epi16(active, &image_row[col])),
+                             _mm512_set1_epi32(num_diffs));
+        const __m512i idx = _mm512_add_epi32(_mm512_mullo_epi32(value, hist_width),
+                                             _mm512_add_epi32(_mm512_set1_epi32(col), lanes));
+        const __m512i p_0 = gather_histogram(active, idx, histograms);
+        __m512 c_value = _mm512_setzero_ps();
+
+        for (uint16_t d = 0; d < num_diffs; d++) {
+            const __mmask16 k =
+                _mm512_mask_cmple_epu32_mask(active, value, _mm512_set1_epi32(tvi_for_diff[d]));
+            if (!k) continue;
+
+            const __m512i idx_1 =
+                _mm512_add_epi32(idx, _mm512_set1_epi32(all_diffs[num_diffs + d + 1] * width));
+            const __m512i idx_2 =
+                _mm512_add_epi32(idx, _mm512_set1_epi32(all_diffs[num_diffs - d - 1] * width));
+            const __m512i p_1 = gather_histogram(k, idx_1, histograms);
+            const __m512i p_2 = gather_histogram(k, idx_2, histograms);
+            const __m512i p_max = _mm512_max_epu32(p_1, p_2);
+
+            const __m512i num =
+                _mm512_mullo_epi32(_mm512_mullo_epi32(_mm512_set1_epi32(diff_weights[d]), p_0), p_max);
+            const __m512 val = _mm512_div_ps(_mm512_cvtepi32_ps(num),
+                                             _mm512_cvtepi32_ps(_mm512_add_epi32(p_max, p_0)));
+            const __mmask16 greater = _mm512_mask_cmp_ps_mask(k, val, c_value, _CMP_GT_OQ);
+            c_value = _mm512_mask_mov_ps(c_value, greater, val);
+        }
+        _mm512_mask_storeu_ps(&c_values_row[col], active, c_value);
+    }
+}
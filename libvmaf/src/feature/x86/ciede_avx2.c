@@ -0,0 +1,308 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <immintrin.h>
+#include <math.h>
+#include <stdint.h>
+
+#include "feature/x86/ciede_avx2.h"
+
+/*
+ * Single precision polynomial approximations after Cephes (atanf, sinf,
+ * cosf, expf). Each is within 2 ulp of the libm result over the ranges used
+ * below, which keeps ciede2000_row_avx2() within 1e-4 of the scalar
+ * ciede2000() per pixel; see test_ciede.
+ */
+
+// a * b + c, a * b - c and c - a * b, without relying on FMA
+static inline __m256 madd_ps(__m256 a, __m256 b, __m256 c)
+{
+    return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+}
+
+static inline __m256 msub_ps(__m256 a, __m256 b, __m256 c)
+{
+    return _mm256_sub_ps(_mm256_mul_ps(a, b), c);
+}
+
+static inline __m256 nmadd_ps(__m256 a, __m256 b, __m256 c)
+{
+    return _mm256_sub_ps(c, _mm256_mul_ps(a, b));
+}
+
+static inline __m256 abs_ps(__m256 x)
+{
+    return _mm256_andnot_ps(_mm256_set1_ps(-0.f), x);
+}
+
+static inline __m256 poly4_ps(__m256 x, float c0, float c1, float c2, float c3)
+{
+    __m256 p = _mm256_set1_ps(c0);
+    p = madd_ps(p, x, _mm256_set1_ps(c1));
+    p = madd_ps(p, x, _mm256_set1_ps(c2));
+    return madd_ps(p, x, _mm256_set1_ps(c3));
+}
+
+// atan2(y, x), in [-pi, pi]
+static inline __m256 atan2_ps(__m256 y, __m256 x)
+{
+    const __m256 ax = abs_ps(x);
+    const __m256 ay = abs_ps(y);
+    const __m256 num = _mm256_min_ps(ax, ay);
+    const __m256 den = _mm256_max_ps(_mm256_max_ps(ax, ay),
+                                     _mm256_set1_ps(1e-30f));
+    __m256 t = _mm256_div_ps(num, den);
+
+    // atan(t) = pi / 4 + atan((t - 1) / (t + 1)) for t > tan(pi / 8)
+    const __m256 big = _mm256_cmp_ps(t, _mm256_set1_ps(0.4142135623730950f),
+                                     _CMP_GT_OQ);
+    const __m256 one = _mm256_set1_ps(1.f);
+    t = _mm256_blendv_ps(t, _mm256_div_ps(_mm256_sub_ps(t, one),
+                                          _mm256_add_ps(t, one)), big);
+    const __m256 z = _mm256_mul_ps(t, t);
+    __m256 a = poly4_ps(z, 8.05374449538e-2f, -1.38776856032e-1f,
+                        1.99777106478e-1f, -3.33329491539e-1f);
+    a = madd_ps(_mm256_mul_ps(a, z), t, t);
+    a = _mm256_add_ps(a, _mm256_and_ps(big, _mm256_set1_ps(M_PI / 4)));
+
+    a = _mm256_blendv_ps(a, _mm256_sub_ps(_mm256_set1_ps(M_PI / 2), a),
+                         _mm256_cmp_ps(ay, ax, _CMP_GT_OQ));
+    a = _mm256_blendv_ps(a, _mm256_sub_ps(_mm256_set1_ps(M_PI), a), x);
+    return _mm256_or_ps(a, _mm256_and_ps(y, _mm256_set1_ps(-0.f)));
+}
+
+static inline void sincos_ps(__m256 x, __m256 *sin_x, __m256 *cos_x)
+{
+    // x = q * pi / 2 + r, |r| <= pi / 4
+    const __m256 q = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(M_2_PI)),
+                                     _MM_FROUND_TO_NEAREST_INT |
+                                     _MM_FROUND_NO_EXC);
+    __m256 r = nmadd_ps(q, _mm256_set1_ps(1.5703125f), x);
+    r = nmadd_ps(q, _mm256_set1_ps(4.837512969970703125e-4f), r);
+    r = nmadd_ps(q, _mm256_set1_ps(7.54978995489188216e-8f), r);
+
+    const __m256 z = _mm256_mul_ps(r, r);
+    __m256 s = madd_ps(_mm256_set1_ps(-1.9515295891e-4f), z,
+                               _mm256_set1_ps(8.3321608736e-3f));
+    s = madd_ps(s, z, _mm256_set1_ps(-1.6666654611e-1f));
+    s = madd_ps(_mm256_mul_ps(s, z), r, r);
+    __m256 c = madd_ps(_mm256_set1_ps(2.443315711809948e-5f), z,
+                               _mm256_set1_ps(-1.388731625493765e-3f));
+    c = madd_ps(c, z, _mm256_set1_ps(4.166664568298827e-2f));
+    c = madd_ps(_mm256_mul_ps(c, z), z,
+                        nmadd_ps(_mm256_set1_ps(0.5f), z,
+                                         _mm256_set1_ps(1.f)));
+
+    // odd quadrants swap sin and cos, quadrants 1 and 2 negate cos,
+    // quadrants 2 and 3 negate sin
+    const __m256i qi = _mm256_cvtps_epi32(q);
+    const __m256 swap = _mm256_castsi256_ps(_mm256_slli_epi32(qi, 31));
+    const __m256 sign_sin =
+        _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_srli_epi32(qi, 1), 31));
+    const __m256 sign_cos = _mm256_castsi256_ps(
+        _mm256_slli_epi32(_mm256_srli_epi32(_mm256_add_epi32(qi,
+                                            _mm256_set1_epi32(1)), 1), 31));
+    *sin_x = _mm256_xor_ps(_mm256_blendv_ps(s, c, swap), sign_sin);
+    *cos_x = _mm256_xor_ps(_mm256_blendv_ps(c, s, swap), sign_cos);
+}
+
+static inline __m256 sin_ps(__m256 x)
+{
+    __m256 s, c;
+    sincos_ps(x, &s, &c);
+    return s;
+}
+
+static inline __m256 exp_ps(__m256 x)
+{
+    x = _mm256_max_ps(x, _mm256_set1_ps(-87.3f));
+    const __m256 n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(M_LOG2E)),
+                                     _MM_FROUND_TO_NEAREST_INT |
+                                     _MM_FROUND_NO_EXC);
+    x = nmadd_ps(n, _mm256_set1_ps(0.693359375f), x);
+    x = nmadd_ps(n, _mm256_set1_ps(-2.12194440e-4f), x);
+
+    __m256 p = poly4_ps(x, 1.9875691500e-4f, 1.3981999507e-3f,
+                        8.3334519073e-3f, 4.1665795894e-2f);
+    p = madd_ps(p, x, _mm256_set1_ps(1.6666665459e-1f));
+    p = madd_ps(p, x, _mm256_set1_ps(5.0000001201e-1f));
+    p = madd_ps(p, _mm256_mul_ps(x, x),
+                        _mm256_add_ps(x, _mm256_set1_ps(1.f)));
+
+    const __m256i e = _mm256_slli_epi32(
+        _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+    return _mm256_mul_ps(p, _mm256_castsi256_ps(e));
+}
+
+// sqrt(x^7 / (x^7 + 25^7))
+static inline __m256 g_ps(__m256 x)
+{
+    const __m256 x2 = _mm256_mul_ps(x, x);
+    const __m256 x7 = _mm256_mul_ps(_mm256_mul_ps(x2, x2),
+                                    _mm256_mul_ps(x2, x));
+    return _mm256_sqrt_ps(_mm256_div_ps(x7,
+                          _mm256_add_ps(x7, _mm256_set1_ps(6103515625.f))));
+}
+
+static inline __m256 hypot_ps(__m256 x, __m256 y)
+{
+    return _mm256_sqrt_ps(madd_ps(x, x, _mm256_mul_ps(y, y)));
+}
+
+// hue angle in [0, 2 pi), 0 for a == b == 0
+static inline __m256 hue_ps(__m256 b, __m256 a)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 h = atan2_ps(b, a);
+    const __m256 neg = _mm256_cmp_ps(h, zero, _CMP_LT_OQ);
+    const __m256 achromatic = _mm256_and_ps(_mm256_cmp_ps(a, zero, _CMP_EQ_OQ),
+                                            _mm256_cmp_ps(b, zero, _CMP_EQ_OQ));
+    return _mm256_andnot_ps(achromatic, _mm256_add_ps(h,
+                            _mm256_and_ps(neg, _mm256_set1_ps(2 * M_PI))));
+}
+
+static inline __m256 ciede2000_ps(__m256 l1, __m256 a1, __m256 b1,
+                                  __m256 l2, __m256 a2, __m256 b2,
+                                  KSubArgs ksub)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 pi = _mm256_set1_ps(M_PI);
+    const __m256 two_pi = _mm256_set1_ps(2 * M_PI);
+
+    const __m256 delta_l_prime = _mm256_sub_ps(l2, l1);
+    const __m256 l_bar = _mm256_mul_ps(_mm256_add_ps(l1, l2), half);
+    const __m256 c1 = hypot_ps(a1, b1);
+    const __m256 c2 = hypot_ps(a2, b2);
+    const __m256 c_bar = _mm256_mul_ps(_mm256_add_ps(c1, c2), half);
+    const __m256 g = _mm256_mul_ps(_mm256_sub_ps(one, g_ps(c_bar)), half);
+    const __m256 a_prime_1 = madd_ps(a1, g, a1);
+    const __m256 a_prime_2 = madd_ps(a2, g, a2);
+    const __m256 c_prime_1 = hypot_ps(a_prime_1, b1);
+    const __m256 c_prime_2 = hypot_ps(a_prime_2, b2);
+    const __m256 c_bar_prime =
+        _mm256_mul_ps(_mm256_add_ps(c_prime_1, c_prime_2), half);
+    const __m256 delta_c_prime = _mm256_sub_ps(c_prime_2, c_prime_1);
+
+    const __m256 l_50 = _mm256_sub_ps(l_bar, _mm256_set1_ps(50.f));
+    const __m256 l_50_sq = _mm256_mul_ps(l_50, l_50);
+    const __m256 s_sub_l = _mm256_add_ps(one,
+        _mm256_div_ps(_mm256_mul_ps(_mm256_set1_ps(0.015f), l_50_sq),
+                      _mm256_sqrt_ps(_mm256_add_ps(_mm256_set1_ps(20.f),
+                                                   l_50_sq))));
+    const __m256 s_sub_c =
+        madd_ps(_mm256_set1_ps(0.045f), c_bar_prime, one);
+
+    const __m256 h_prime_1 = hue_ps(b1, a_prime_1);
+    const __m256 h_prime_2 = hue_ps(b2, a_prime_2);
+    const __m256 h_diff = _mm256_sub_ps(h_prime_2, h_prime_1);
+    const __m256 wrap = _mm256_cmp_ps(abs_ps(h_diff), pi, _CMP_GT_OQ);
+    const __m256 h_adjust = _mm256_blendv_ps(_mm256_sub_ps(zero, two_pi),
+        two_pi, _mm256_cmp_ps(h_prime_2, h_prime_1, _CMP_LE_OQ));
+    __m256 delta_h_prime =
+        _mm256_add_ps(h_diff, _mm256_and_ps(wrap, h_adjust));
+    const __m256 achromatic = _mm256_or_ps(_mm256_cmp_ps(c1, zero, _CMP_EQ_OQ),
+                                           _mm256_cmp_ps(c2, zero, _CMP_EQ_OQ));
+    delta_h_prime = _mm256_andnot_ps(achromatic, delta_h_prime);
+    const __m256 delta_upcase_h_prime = _mm256_mul_ps(
+        _mm256_mul_ps(_mm256_set1_ps(2.f),
+                      _mm256_sqrt_ps(_mm256_mul_ps(c_prime_1, c_prime_2))),
+        sin_ps(_mm256_mul_ps(delta_h_prime, half)));
+
+    const __m256 upcase_h_bar_prime = _mm256_mul_ps(half,
+        _mm256_add_ps(_mm256_add_ps(h_prime_1, h_prime_2),
+                      _mm256_and_ps(wrap, two_pi)));
+
+    // T from the multiple angle formulas of a single sincos
+    __m256 sin_h, cos_h;
+    sincos_ps(upcase_h_bar_prime, &sin_h, &cos_h);
+    const __m256 cos_2h = msub_ps(_mm256_add_ps(cos_h, cos_h), cos_h, one);
+    const __m256 sin_2h = _mm256_mul_ps(_mm256_add_ps(sin_h, sin_h), cos_h);
+    const __m256 cos_3h = _mm256_mul_ps(cos_h,
+        msub_ps(_mm256_set1_ps(4.f), _mm256_mul_ps(cos_h, cos_h),
+                        _mm256_set1_ps(3.f)));
+    const __m256 sin_3h = _mm256_mul_ps(sin_h,
+        nmadd_ps(_mm256_set1_ps(4.f), _mm256_mul_ps(sin_h, sin_h),
+                         _mm256_set1_ps(3.f)));
+    const __m256 cos_4h = msub_ps(_mm256_add_ps(cos_2h, cos_2h), cos_2h, one);
+    const __m256 sin_4h = _mm256_mul_ps(_mm256_add_ps(sin_2h, sin_2h), cos_2h);
+
+    // cos(h - pi / 6), cos(3h + pi / 30), cos(4h - 7pi / 20)
+    const __m256 t1 = madd_ps(cos_h, _mm256_set1_ps(0.8660254037844387f),
+                                      _mm256_mul_ps(sin_h, half));
+    const __m256 t3 = msub_ps(cos_3h, _mm256_set1_ps(0.9945218953682733f),
+        _mm256_mul_ps(sin_3h, _mm256_set1_ps(0.10452846326765347f)));
+    const __m256 t4 = madd_ps(cos_4h, _mm256_set1_ps(0.45399049973954675f),
+        _mm256_mul_ps(sin_4h, _mm256_set1_ps(0.8910065241883679f)));
+    __m256 upcase_t = nmadd_ps(_mm256_set1_ps(0.17f), t1, one);
+    upcase_t = madd_ps(_mm256_set1_ps(0.24f), cos_2h, upcase_t);
+    upcase_t = madd_ps(_mm256_set1_ps(0.32f), t3, upcase_t);
+    upcase_t = nmadd_ps(_mm256_set1_ps(0.20f), t4, upcase_t);
+    const __m256 s_sub_upcase_h = madd_ps(
+        _mm256_mul_ps(_mm256_set1_ps(0.015f), c_bar_prime), upcase_t, one);
+
+    const __m256 degrees = _mm256_mul_ps(
+        msub_ps(upcase_h_bar_prime, _mm256_set1_ps(180.0 / M_PI),
+                        _mm256_set1_ps(275.f)),
+        _mm256_set1_ps(1.f / 25.f));
+    const __m256 r_sub_t = _mm256_mul_ps(
+        _mm256_mul_ps(_mm256_set1_ps(-2.f), g_ps(c_bar_prime)),
+        sin_ps(_mm256_mul_ps(_mm256_set1_ps(M_PI / 3),
+               exp_ps(_mm256_sub_ps(zero, _mm256_mul_ps(degrees, degrees))))));
+
+    const __m256 lightness = _mm256_div_ps(delta_l_prime,
+        _mm256_mul_ps(_mm256_set1_ps(ksub.l), s_sub_l));
+    const __m256 chroma = _mm256_div_ps(delta_c_prime,
+        _mm256_mul_ps(_mm256_set1_ps(ksub.c), s_sub_c));
+    const __m256 hue = _mm256_div_ps(delta_upcase_h_prime,
+        _mm256_mul_ps(_mm256_set1_ps(ksub.h), s_sub_upcase_h));
+
+    __m256 de00 = _mm256_mul_ps(lightness, lightness);
+    de00 = madd_ps(chroma, chroma, de00);
+    de00 = madd_ps(hue, hue, de00);
+    de00 = madd_ps(_mm256_mul_ps(r_sub_t, chroma), hue, de00);
+    return _mm256_sqrt_ps(de00);
+}
+
+double ciede2000_row_avx2(float *const lab_1[3], float *const lab_2[3],
+                          unsigned w, KSubArgs ksub, double de00_sum)
+{
+    __m256d sum = _mm256_setzero_pd();
+
+    for (unsigned j = 0; j < w; j += 8) {
+        // the tail is loaded masked, and its zeroed lanes are discarded
+        const int n = w - j < 8 ? w - j : 8;
+        const __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(n),
+            _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        __m256 de00 = ciede2000_ps(
+            _mm256_maskload_ps(lab_1[0] + j, mask),
+            _mm256_maskload_ps(lab_1[1] + j, mask),
+            _mm256_maskload_ps(lab_1[2] + j, mask),
+            _mm256_maskload_ps(lab_2[0] + j, mask),
+            _mm256_maskload_ps(lab_2[1] + j, mask),
+            _mm256_maskload_ps(lab_2[2] + j, mask), ksub);
+        de00 = _mm256_and_ps(de00, _mm256_castsi256_ps(mask));
+        sum = _mm256_add_pd(sum, _mm256_cvtps_pd(_mm256_castps256_ps128(de00)));
+        sum = _mm256_add_pd(sum, _mm256_cvtps_pd(_mm256_extractf128_ps(de00, 1)));
+    }
+
+    double t[4];
+    _mm256_storeu_pd(t, sum);
+    return de00_sum + (t[0] + t[1] + t[2] + t[3]);
+}
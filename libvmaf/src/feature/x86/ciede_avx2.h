@@ -0,0 +1,27 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef X86_AVX2_CIEDE_H_
+#define X86_AVX2_CIEDE_H_
+
+#include "feature/ciede.h"
+
+double ciede2000_row_avx2(float *const lab_1[3], float *const lab_2[3],
+                          unsigned w, KSubArgs ksub, double de00_sum);
+
+#endif /* X86_AVX2_CIEDE_H_ */
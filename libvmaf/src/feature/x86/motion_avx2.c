@@ -19,6 +19,7 @@
 #include <immintrin.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdlib.h>
 
 #include "feature/integer_motion.h"
 #include "feature/common/alignment.h"
@@ -132,3 +133,89 @@ void x_convolution_16_avx2(const uint16_t *src, uint16_t *dst, unsigned width,
         }
     }
 }
+
+static inline __m256i abs_diff_epu16(__m256i a, __m256i b)
+{
+    return _mm256_or_si256(_mm256_subs_epu16(a, b), _mm256_subs_epu16(b, a));
+}
+
+/* Adds both 16-bit halves of every 32-bit lane, a row of up to 2^15 vectors
+ * stays below 2^32 per lane. */
+static inline __m256i add_epu16_pairs(__m256i accum, __m256i d)
+{
+    const __m256i lo = _mm256_blend_epi16(d, _mm256_setzero_si256(), 0xAA);
+    return _mm256_add_epi32(accum, _mm256_add_epi32(lo, _mm256_srli_epi32(d, 16)));
+}
+
+static inline uint32_t hsum_epu32(__m256i v)
+{
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v),
+                              _mm256_extracti128_si256(v, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(s);
+}
+
+uint64_t sad_16_avx2(const uint16_t *a, ptrdiff_t a_stride,
+                     const uint16_t *b, ptrdiff_t b_stride,
+                     unsigned w, unsigned h)
+{
+    const unsigned w16 = w & ~15u;
+    uint64_t sad = 0;
+
+    for (unsigned i = 0; i < h; i++) {
+        __m256i sad_row = _mm256_setzero_si256();
+        unsigned j = 0;
+        for (; j < w16; j += 16) {
+            const __m256i va = _mm256_loadu_si256((const __m256i *)(a + j));
+            const __m256i vb = _mm256_loadu_si256((const __m256i *)(b + j));
+            sad_row = add_epu16_pairs(sad_row, abs_diff_epu16(va, vb));
+        }
+
+        // the row sum wraps like the 32-bit inner sum of the C code
+        uint32_t inner_sad = hsum_epu32(sad_row);
+        for (; j < w; j++)
+            inner_sad += abs(a[j] - b[j]);
+        sad += inner_sad;
+
+        a += a_stride;
+        b += b_stride;
+    }
+
+    return sad;
+}
+
+void sad_pair_16_avx2(const uint16_t *a, const uint16_t *b, const uint16_t *c,
+                      ptrdiff_t stride, unsigned w, unsigned h,
+                      uint64_t *sad_b, uint64_t *sad_c)
+{
+    const unsigned w16 = w & ~15u;
+    *sad_b = 0;
+    *sad_c = 0;
+
+    for (unsigned i = 0; i < h; i++) {
+        __m256i sad_row_b = _mm256_setzero_si256();
+        __m256i sad_row_c = _mm256_setzero_si256();
+        unsigned j = 0;
+        for (; j < w16; j += 16) {
+            const __m256i va = _mm256_loadu_si256((const __m256i *)(a + j));
+            const __m256i vb = _mm256_loadu_si256((const __m256i *)(b + j));
+            const __m256i vc = _mm256_loadu_si256((const __m256i *)(c + j));
+            sad_row_b = add_epu16_pairs(sad_row_b, abs_diff_epu16(va, vb));
+            sad_row_c = add_epu16_pairs(sad_row_c, abs_diff_epu16(va, vc));
+        }
+
+        uint32_t inner_sad_b = hsum_epu32(sad_row_b);
+        uint32_t inner_sad_c = hsum_epu32(sad_row_c);
+        for (; j < w; j++) {
+            inner_sad_b += abs(a[j] - b[j]);
+            inner_sad_c += abs(a[j] - c[j]);
+        }
+        *sad_b += inner_sad_b;
+        *sad_c += inner_sad_c;
+
+        a += stride;
+        b += stride;
+        c += stride;
+    }
+}
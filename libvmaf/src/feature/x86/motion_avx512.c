@@ -20,6 +20,7 @@
 #include <math.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "feature/integer_motion.h"
@@ -134,3 +135,85 @@ void x_convolution_16_avx512(const uint16_t *src, uint16_t *dst, unsigned width,
         }
     }
 }
+
+static inline __m512i abs_diff_epu16(__m512i a, __m512i b)
+{
+    return _mm512_or_si512(_mm512_subs_epu16(a, b), _mm512_subs_epu16(b, a));
+}
+
+/* Adds both 16-bit halves of every 32-bit lane, a row of up to 2^15 vectors
+ * stays below 2^32 per lane. */
+static inline __m512i add_epu16_pairs(__m512i accum, __m512i d)
+{
+    const __m512i lo = _mm512_and_si512(d, _mm512_set1_epi32(0xffff));
+    return _mm512_add_epi32(accum, _mm512_add_epi32(lo, _mm512_srli_epi32(d, 16)));
+}
+
+uint64_t sad_16_avx512(const uint16_t *a, ptrdiff_t a_stride,
+                       const uint16_t *b, ptrdiff_t b_stride,
+                       unsigned w, unsigned h)
+{
+    const unsigned w32 = w & ~31u;
+    const __mmask32 tail = (__mmask32)((1ull << (w - w32)) - 1);
+    uint64_t sad = 0;
+
+    for (unsigned i = 0; i < h; i++) {
+        __m512i sad_row = _mm512_setzero_si512();
+        unsigned j = 0;
+        for (; j < w32; j += 32) {
+            const __m512i va = _mm512_loadu_si512(a + j);
+            const __m512i vb = _mm512_loadu_si512(b + j);
+            sad_row = add_epu16_pairs(sad_row, abs_diff_epu16(va, vb));
+        }
+        if (tail) {
+            const __m512i va = _mm512_maskz_loadu_epi16(tail, a + j);
+            const __m512i vb = _mm512_maskz_loadu_epi16(tail, b + j);
+            sad_row = add_epu16_pairs(sad_row, abs_diff_epu16(va, vb));
+        }
+
+        // the row sum wraps like the 32-bit inner sum of the C code
+        sad += (uint32_t) _mm512_reduce_add_epi32(sad_row);
+
+        a += a_stride;
+        b += b_stride;
+    }
+
+    return sad;
+}
+
+void sad_pair_16_avx512(const uint16_t *a, const uint16_t *b, const uint16_t *c,
+                        ptrdiff_t stride, unsigned w, unsigned h,
+                        uint64_t *sad_b, uint64_t *sad_c)
+{
+    const unsigned w32 = w & ~31u;
+    const __mmask32 tail = (__mmask32)((1ull << (w - w32)) - 1);
+    *sad_b = 0;
+    *sad_c = 0;
+
+    for (unsigned i = 0; i < h; i++) {
+        __m512i sad_row_b = _mm512_setzero_si512();
+        __m512i sad_row_c = _mm512_setzero_si512();
+        unsigned j = 0;
+        for (; j < w32; j += 32) {
+            const __m512i va = _mm512_loadu_si512(a + j);
+            const __m512i vb = _mm512_loadu_si512(b + j);
+            const __m512i vc = _mm512_loadu_si512(c + j);
+            sad_row_b = add_epu16_pairs(sad_row_b, abs_diff_epu16(va, vb));
+            sad_row_c = add_epu16_pairs(sad_row_c, abs_diff_epu16(va, vc));
+        }
+        if (tail) {
+            const __m512i va = _mm512_maskz_loadu_epi16(tail, a + j);
+            const __m512i vb = _mm512_maskz_loadu_epi16(tail, b + j);
+            const __m512i vc = _mm512_maskz_loadu_epi16(tail, c + j);
+            sad_row_b = add_epu16_pairs(sad_row_b, abs_diff_epu16(va, vb));
+            sad_row_c = add_epu16_pairs(sad_row_c, abs_diff_epu16(va, vc));
+        }
+
+        *sad_b += (uint32_t) _mm512_reduce_add_epi32(sad_row_b);
+        *sad_c += (uint32_t) _mm512_reduce_add_epi32(sad_row_c);
+
+        a += stride;
+        b += stride;
+        c += stride;
+    }
+}
@@ -19,10 +19,19 @@
 #ifndef X86_AVX512_MOTION_H_
 #define X86_AVX512_MOTION_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
 void x_convolution_16_avx512(const uint16_t *src, uint16_t *dst, unsigned width,
                              unsigned height, ptrdiff_t src_stride,
                              ptrdiff_t dst_stride);
 
+uint64_t sad_16_avx512(const uint16_t *a, ptrdiff_t a_stride,
+                       const uint16_t *b, ptrdiff_t b_stride,
+                       unsigned w, unsigned h);
+
+void sad_pair_16_avx512(const uint16_t *a, const uint16_t *b, const uint16_t *c,
+                        ptrdiff_t stride, unsigned w, unsigned h,
+                        uint64_t *sad_b, uint64_t *sad_c);
+
 #endif /* X86_AVX512_MOTION_H_ */
@@ -0,0 +1,169 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <immintrin.h>
+#include <stddef.h>
+
+#include "feature/ms_ssim.h"
+#include "feature/x86/ms_ssim_avx2.h"
+
+/*
+ * These match the scalar filters in ms_ssim.c bit for bit: every product is
+ * rounded to single precision and then accumulated in double precision, in
+ * the same order. All of them process 8 pixels at a time and may read and
+ * write past the end of a row, into the padding left by ms_ssim_buffer_init().
+ */
+
+// sum += a * k, with the product in single and the sum in double precision
+static inline void madd_pd(__m256d sum[2], __m256 a, __m256 k)
+{
+    const __m256 p = _mm256_mul_ps(a, k);
+    sum[0] = _mm256_add_pd(sum[0], _mm256_cvtps_pd(_mm256_castps256_ps128(p)));
+    sum[1] = _mm256_add_pd(sum[1], _mm256_cvtps_pd(_mm256_extractf128_ps(p, 1)));
+}
+
+static inline __m256 round_ps(const __m256d sum[2])
+{
+    return _mm256_set_m128(_mm256_cvtpd_ps(sum[1]), _mm256_cvtpd_ps(sum[0]));
+}
+
+void ms_ssim_decimate_row_avx2(const float *src, ptrdiff_t stride,
+                               const float *kernel, int w, float *dst)
+{
+    const int r = MS_SSIM_LPF_LEN / 2;
+
+    for (int x = 0; x < w; x += 8) {
+        const float *p = src - r * stride + 2 * x - r;
+        __m256d sum[2] = { _mm256_setzero_pd(), _mm256_setzero_pd() };
+
+        for (int v = 0; v < MS_SSIM_LPF_LEN; v++, p += stride) {
+            const float *k = kernel + v * MS_SSIM_LPF_LEN;
+            for (int u = 0; u < MS_SSIM_LPF_LEN; u += 2) {
+                // taps u and u + 1 are the even and odd pixels at 2x + u
+                const __m256 lo = _mm256_loadu_ps(p + u);
+                const __m256 hi = _mm256_loadu_ps(p + u + 8);
+                const __m256 even = _mm256_castpd_ps(_mm256_permute4x64_pd(
+                    _mm256_castps_pd(_mm256_shuffle_ps(lo, hi, 0x88)), 0xd8));
+                madd_pd(sum, even, _mm256_broadcast_ss(&k[u]));
+                if (u + 1 == MS_SSIM_LPF_LEN) break;
+                const __m256 odd = _mm256_castpd_ps(_mm256_permute4x64_pd(
+                    _mm256_castps_pd(_mm256_shuffle_ps(lo, hi, 0xdd)), 0xd8));
+                madd_pd(sum, odd, _mm256_broadcast_ss(&k[u + 1]));
+            }
+        }
+        _mm256_storeu_ps(dst + x, round_ps(sum));
+    }
+}
+
+void ms_ssim_hfilter_avx2(const float *ref, const float *cmp,
+                          const float *kernel, int w, float *maps,
+                          ptrdiff_t stride)
+{
+    for (int x = 0; x < w; x += 8) {
+        __m256d sum[5][2];
+        for (int i = 0; i < 5; i++)
+            sum[i][0] = sum[i][1] = _mm256_setzero_pd();
+
+        for (int k = 0; k < MS_SSIM_WINDOW_LEN; k++) {
+            const __m256 kk = _mm256_broadcast_ss(&kernel[k]);
+            const __m256 r = _mm256_loadu_ps(ref + x + k);
+            const __m256 c = _mm256_loadu_ps(cmp + x + k);
+            madd_pd(sum[0], r, kk);
+            madd_pd(sum[1], c, kk);
+            madd_pd(sum[2], _mm256_mul_ps(r, r), kk);
+            madd_pd(sum[3], _mm256_mul_ps(c, c), kk);
+            madd_pd(sum[4], _mm256_mul_ps(r, c), kk);
+        }
+        for (int i = 0; i < 5; i++)
+            _mm256_store_ps(maps + i * stride + x, round_ps(sum[i]));
+    }
+}
+
+void ms_ssim_vfilter_terms_avx2(float *const *rows, ptrdiff_t stride,
+                                const float *kernel, int w,
+                                double *l, double *c, double *s)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 C1 = _mm256_set1_ps(MS_SSIM_C1);
+    const __m256 C2 = _mm256_set1_ps(MS_SSIM_C2);
+    const __m256 C3 = _mm256_set1_ps(MS_SSIM_C3);
+    const __m256d C1d = _mm256_set1_pd(MS_SSIM_C1);
+    const __m256d C2d = _mm256_set1_pd(MS_SSIM_C2);
+    const __m256d two = _mm256_set1_pd(2.0);
+
+    for (int x = 0; x < w; x += 8) {
+        __m256d sum[5][2];
+        for (int i = 0; i < 5; i++)
+            sum[i][0] = sum[i][1] = _mm256_setzero_pd();
+
+        for (int k = 0; k < MS_SSIM_WINDOW_LEN; k++) {
+            const __m256 kk = _mm256_broadcast_ss(&kernel[k]);
+            for (int i = 0; i < 5; i++)
+                madd_pd(sum[i], _mm256_load_ps(rows[k] + i * stride + x), kk);
+        }
+
+        const __m256 mu1 = round_ps(sum[0]);
+        const __m256 mu2 = round_ps(sum[1]);
+        const __m256 mu1_sq = _mm256_mul_ps(mu1, mu1);
+        const __m256 mu2_sq = _mm256_mul_ps(mu2, mu2);
+        const __m256 sigma1_sqd =
+            _mm256_max_ps(zero, _mm256_sub_ps(round_ps(sum[2]), mu1_sq));
+        const __m256 sigma2_sqd =
+            _mm256_max_ps(zero, _mm256_sub_ps(round_ps(sum[3]), mu2_sq));
+        const __m256 sigma12 =
+            _mm256_sub_ps(round_ps(sum[4]), _mm256_mul_ps(mu1, mu2));
+        const __m256 sigma1_sigma2 =
+            _mm256_sqrt_ps(_mm256_mul_ps(sigma1_sqd, sigma2_sqd));
+
+        const __m256 l_den = _mm256_add_ps(_mm256_add_ps(mu1_sq, mu2_sq), C1);
+        const __m256 c_den =
+            _mm256_add_ps(_mm256_add_ps(sigma1_sqd, sigma2_sqd), C2);
+        const __m256 clamped_sigma12 = _mm256_andnot_ps(
+            _mm256_and_ps(_mm256_cmp_ps(sigma12, zero, _CMP_LT_OQ),
+                          _mm256_cmp_ps(sigma1_sigma2, zero, _CMP_LE_OQ)),
+            sigma12);
+        const __m256 ss = _mm256_div_ps(_mm256_add_ps(clamped_sigma12, C3),
+                                        _mm256_add_ps(sigma1_sigma2, C3));
+
+        for (int h = 0; h < 2; h++) {
+            const __m256d mu1d = _mm256_cvtps_pd(h ? _mm256_extractf128_ps(mu1, 1)
+                                                   : _mm256_castps256_ps128(mu1));
+            const __m256d mu2d = _mm256_cvtps_pd(h ? _mm256_extractf128_ps(mu2, 1)
+                                                   : _mm256_castps256_ps128(mu2));
+            const __m256d sd = _mm256_cvtps_pd(
+                h ? _mm256_extractf128_ps(sigma1_sigma2, 1)
+                  : _mm256_castps256_ps128(sigma1_sigma2));
+            const __m256d ld = _mm256_cvtps_pd(
+                h ? _mm256_extractf128_ps(l_den, 1)
+                  : _mm256_castps256_ps128(l_den));
+            const __m256d cd = _mm256_cvtps_pd(
+                h ? _mm256_extractf128_ps(c_den, 1)
+                  : _mm256_castps256_ps128(c_den));
+            const __m256d ssd = _mm256_cvtps_pd(
+                h ? _mm256_extractf128_ps(ss, 1)
+                  : _mm256_castps256_ps128(ss));
+
+            const __m256d l_num = _mm256_add_pd(
+                _mm256_mul_pd(_mm256_mul_pd(two, mu1d), mu2d), C1d);
+            const __m256d c_num = _mm256_add_pd(_mm256_mul_pd(two, sd), C2d);
+            _mm256_storeu_pd(l + x + 4 * h, _mm256_div_pd(l_num, ld));
+            _mm256_storeu_pd(c + x + 4 * h, _mm256_div_pd(c_num, cd));
+            _mm256_storeu_pd(s + x + 4 * h, ssd);
+        }
+    }
+}
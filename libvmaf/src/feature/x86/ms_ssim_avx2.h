@@ -0,0 +1,35 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef X86_AVX2_MS_SSIM_H_
+#define X86_AVX2_MS_SSIM_H_
+
+#include <stddef.h>
+
+void ms_ssim_decimate_row_avx2(const float *src, ptrdiff_t stride,
+                               const float *kernel, int w, float *dst);
+
+void ms_ssim_hfilter_avx2(const float *ref, const float *cmp,
+                          const float *kernel, int w, float *maps,
+                          ptrdiff_t stride);
+
+void ms_ssim_vfilter_terms_avx2(float *const *rows, ptrdiff_t stride,
+                                const float *kernel, int w,
+                                double *l, double *c, double *s);
+
+#endif /* X86_AVX2_MS_SSIM_H_ */
@@ -0,0 +1,109 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <immintrin.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "feature/x86/psnr_avx2.h"
+
+static inline uint64_t hadd_epi64(__m256i v)
+{
+    uint64_t t[4];
+    _mm256_storeu_si256((__m256i*)t, v);
+    return t[0] + t[1] + t[2] + t[3];
+}
+
+uint64_t psnr_sse_8_avx2(const uint8_t *ref, ptrdiff_t ref_stride,
+                         const uint8_t *dis, ptrdiff_t dis_stride,
+                         unsigned w, unsigned h)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const unsigned w32 = w & ~31u;
+    __m256i sse = zero;
+    uint64_t sse_tail = 0;
+
+    for (unsigned i = 0; i < h; i++) {
+        // each 32-bit lane takes at most 2 * 2 * 255^2 per iteration
+        __m256i sse_row = zero;
+        unsigned j = 0;
+        for (; j < w32; j += 32) {
+            const __m256i r = _mm256_loadu_si256((const __m256i*)(ref + j));
+            const __m256i d = _mm256_loadu_si256((const __m256i*)(dis + j));
+            const __m256i e_lo = _mm256_sub_epi16(_mm256_unpacklo_epi8(r, zero),
+                                                  _mm256_unpacklo_epi8(d, zero));
+            const __m256i e_hi = _mm256_sub_epi16(_mm256_unpackhi_epi8(r, zero),
+                                                  _mm256_unpackhi_epi8(d, zero));
+            sse_row = _mm256_add_epi32(sse_row, _mm256_madd_epi16(e_lo, e_lo));
+            sse_row = _mm256_add_epi32(sse_row, _mm256_madd_epi16(e_hi, e_hi));
+        }
+        sse = _mm256_add_epi64(sse, _mm256_unpacklo_epi32(sse_row, zero));
+        sse = _mm256_add_epi64(sse, _mm256_unpackhi_epi32(sse_row, zero));
+
+        uint32_t sse_inner = 0;
+        for (; j < w; j++) {
+            const int16_t e = ref[j] - dis[j];
+            sse_inner += e * e;
+        }
+        sse_tail += sse_inner;
+
+        ref += ref_stride;
+        dis += dis_stride;
+    }
+
+    return hadd_epi64(sse) + sse_tail;
+}
+
+uint64_t psnr_sse_16_avx2(const uint16_t *ref, ptrdiff_t ref_stride,
+                          const uint16_t *dis, ptrdiff_t dis_stride,
+                          unsigned w, unsigned h)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const unsigned w16 = w & ~15u;
+    __m256i sse = zero;
+    uint64_t sse_tail = 0;
+
+    for (unsigned i = 0; i < h; i++) {
+        unsigned j = 0;
+        for (; j < w16; j += 16) {
+            const __m256i r = _mm256_loadu_si256((const __m256i*)(ref + j));
+            const __m256i d = _mm256_loadu_si256((const __m256i*)(dis + j));
+            // |r - d| and its 32-bit square, exact up to 16 bpc
+            const __m256i e = _mm256_or_si256(_mm256_subs_epu16(r, d),
+                                              _mm256_subs_epu16(d, r));
+            const __m256i sq_lo = _mm256_mullo_epi16(e, e);
+            const __m256i sq_hi = _mm256_mulhi_epu16(e, e);
+            const __m256i sq0 = _mm256_unpacklo_epi16(sq_lo, sq_hi);
+            const __m256i sq1 = _mm256_unpackhi_epi16(sq_lo, sq_hi);
+            sse = _mm256_add_epi64(sse, _mm256_unpacklo_epi32(sq0, zero));
+            sse = _mm256_add_epi64(sse, _mm256_unpackhi_epi32(sq0, zero));
+            sse = _mm256_add_epi64(sse, _mm256_unpacklo_epi32(sq1, zero));
+            sse = _mm256_add_epi64(sse, _mm256_unpackhi_epi32(sq1, zero));
+        }
+        for (; j < w; j++) {
+            const uint32_t e = abs(ref[j] - dis[j]);
+            sse_tail += e * e;
+        }
+
+        ref += ref_stride / sizeof(*ref);
+        dis += dis_stride / sizeof(*dis);
+    }
+
+    return hadd_epi64(sse) + sse_tail;
+}
@@ -0,0 +1,33 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef X86_AVX2_PSNR_H_
+#define X86_AVX2_PSNR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+uint64_t psnr_sse_8_avx2(const uint8_t *ref, ptrdiff_t ref_stride,
+                         const uint8_t *dis, ptrdiff_t dis_stride,
+                         unsigned w, unsigned h);
+
+uint64_t psnr_sse_16_avx2(const uint16_t *ref, ptrdiff_t ref_stride,
+                          const uint16_t *dis, ptrdiff_t dis_stride,
+                          unsigned w, unsigned h);
+
+#endif /* X86_AVX2_PSNR_H_ */
@@ -0,0 +1,87 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <immintrin.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "feature/x86/psnr_avx512.h"
+
+uint64_t psnr_sse_8_avx512(const uint8_t *ref, ptrdiff_t ref_stride,
+                           const uint8_t *dis, ptrdiff_t dis_stride,
+                           unsigned w, unsigned h)
+{
+    const __m512i zero = _mm512_setzero_si512();
+    __m512i sse = zero;
+
+    for (unsigned i = 0; i < h; i++) {
+        // each 32-bit lane takes at most 2 * 2 * 255^2 per iteration
+        __m512i sse_row = zero;
+        for (unsigned j = 0; j < w; j += 64) {
+            // the tail is loaded masked, zeroed lanes add nothing
+            const __mmask64 m = w - j >= 64 ? ~0ULL : ~0ULL >> (64 - (w - j));
+            const __m512i r = _mm512_maskz_loadu_epi8(m, ref + j);
+            const __m512i d = _mm512_maskz_loadu_epi8(m, dis + j);
+            const __m512i e_lo = _mm512_sub_epi16(_mm512_unpacklo_epi8(r, zero),
+                                                  _mm512_unpacklo_epi8(d, zero));
+            const __m512i e_hi = _mm512_sub_epi16(_mm512_unpackhi_epi8(r, zero),
+                                                  _mm512_unpackhi_epi8(d, zero));
+            sse_row = _mm512_add_epi32(sse_row, _mm512_madd_epi16(e_lo, e_lo));
+            sse_row = _mm512_add_epi32(sse_row, _mm512_madd_epi16(e_hi, e_hi));
+        }
+        sse = _mm512_add_epi64(sse, _mm512_unpacklo_epi32(sse_row, zero));
+        sse = _mm512_add_epi64(sse, _mm512_unpackhi_epi32(sse_row, zero));
+
+        ref += ref_stride;
+        dis += dis_stride;
+    }
+
+    return _mm512_reduce_add_epi64(sse);
+}
+
+uint64_t psnr_sse_16_avx512(const uint16_t *ref, ptrdiff_t ref_stride,
+                            const uint16_t *dis, ptrdiff_t dis_stride,
+                            unsigned w, unsigned h)
+{
+    const __m512i zero = _mm512_setzero_si512();
+    __m512i sse = zero;
+
+    for (unsigned i = 0; i < h; i++) {
+        for (unsigned j = 0; j < w; j += 32) {
+            const __mmask32 m = w - j >= 32 ? ~0U : ~0U >> (32 - (w - j));
+            const __m512i r = _mm512_maskz_loadu_epi16(m, ref + j);
+            const __m512i d = _mm512_maskz_loadu_epi16(m, dis + j);
+            // |r - d| and its 32-bit square, exact up to 16 bpc
+            const __m512i e = _mm512_or_si512(_mm512_subs_epu16(r, d),
+                                              _mm512_subs_epu16(d, r));
+            const __m512i sq_lo = _mm512_mullo_epi16(e, e);
+            const __m512i sq_hi = _mm512_mulhi_epu16(e, e);
+            const __m512i sq0 = _mm512_unpacklo_epi16(sq_lo, sq_hi);
+            const __m512i sq1 = _mm512_unpackhi_epi16(sq_lo, sq_hi);
+            sse = _mm512_add_epi64(sse, _mm512_unpacklo_epi32(sq0, zero));
+            sse = _mm512_add_epi64(sse, _mm512_unpackhi_epi32(sq0, zero));
+            sse = _mm512_add_epi64(sse, _mm512_unpacklo_epi32(sq1, zero));
+            sse = _mm512_add_epi64(sse, _mm512_unpackhi_epi32(sq1, zero));
+        }
+
+        ref += ref_stride / sizeof(*ref);
+        dis += dis_stride / sizeof(*dis);
+    }
+
+    return _mm512_reduce_add_epi64(sse);
+}
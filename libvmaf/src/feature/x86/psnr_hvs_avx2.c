@@ -0,0 +1,376 @@
+/*
+Copyright 2001-2012 Xiph.Org and contributors.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+- Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+- Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <immintrin.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "feature/common/macros.h"
+#include "feature/x86/psnr_hvs_avx2.h"
+
+/*
+ * AVX2 version of calc_psnrhvs() in third_party/xiph/psnr_hvs.c. One 8x8
+ * block is held in eight vectors of eight 32-bit lanes, the DCT runs on all
+ * eight rows or columns at once, and every per coefficient term is computed
+ * with the same single precision operations as the scalar code. The terms
+ * are then summed in the scalar order, so the result is bit-exact.
+ */
+
+#define DCT_RSHIFT1(a) \
+    _mm256_srai_epi32(_mm256_add_epi32(_mm256_srli_epi32(a, 31), a), 1)
+
+#define DCT_MUL(a, c, s) \
+    _mm256_srai_epi32(_mm256_add_epi32( \
+        _mm256_mullo_epi32(a, _mm256_set1_epi32(c)), \
+        _mm256_set1_epi32(1 << ((s) - 1))), s)
+
+static FORCE_INLINE inline void od_bin_fdct8_avx2(__m256i x[8])
+{
+    __m256i t0 = x[0];
+    __m256i t4 = x[1];
+    __m256i t2 = x[2];
+    __m256i t6 = x[3];
+    __m256i t7 = x[4];
+    __m256i t3 = x[5];
+    __m256i t5 = x[6];
+    __m256i t1 = x[7];
+    __m256i t1h, t4h, t6h;
+
+    t1 = _mm256_sub_epi32(t0, t1);
+    t1h = DCT_RSHIFT1(t1);
+    t0 = _mm256_sub_epi32(t0, t1h);
+    t4 = _mm256_add_epi32(t4, t5);
+    t4h = DCT_RSHIFT1(t4);
+    t5 = _mm256_sub_epi32(t5, t4h);
+    t3 = _mm256_sub_epi32(t2, t3);
+    t2 = _mm256_sub_epi32(t2, DCT_RSHIFT1(t3));
+    t6 = _mm256_add_epi32(t6, t7);
+    t6h = DCT_RSHIFT1(t6);
+    t7 = _mm256_sub_epi32(t6h, t7);
+    t0 = _mm256_add_epi32(t0, t6h);
+    t6 = _mm256_sub_epi32(t0, t6);
+    t2 = _mm256_sub_epi32(t4h, t2);
+    t4 = _mm256_sub_epi32(t2, t4);
+    t0 = _mm256_sub_epi32(t0, DCT_MUL(t4, 13573, 15));
+    t4 = _mm256_add_epi32(t4, DCT_MUL(t0, 11585, 14));
+    t0 = _mm256_sub_epi32(t0, DCT_MUL(t4, 13573, 15));
+    t6 = _mm256_sub_epi32(t6, DCT_MUL(t2, 21895, 15));
+    t2 = _mm256_add_epi32(t2, DCT_MUL(t6, 15137, 14));
+    t6 = _mm256_sub_epi32(t6, DCT_MUL(t2, 21895, 15));
+    t3 = _mm256_add_epi32(t3, DCT_MUL(t5, 19195, 15));
+    t5 = _mm256_add_epi32(t5, DCT_MUL(t3, 11585, 14));
+    t3 = _mm256_sub_epi32(t3, DCT_MUL(t5, 7489, 13));
+    t7 = _mm256_sub_epi32(DCT_RSHIFT1(t5), t7);
+    t5 = _mm256_sub_epi32(t5, t7);
+    t3 = _mm256_sub_epi32(t1h, t3);
+    t1 = _mm256_sub_epi32(t1, t3);
+    t7 = _mm256_add_epi32(t7, DCT_MUL(t1, 3227, 15));
+    t1 = _mm256_sub_epi32(t1, DCT_MUL(t7, 6393, 15));
+    t7 = _mm256_add_epi32(t7, DCT_MUL(t1, 3227, 15));
+    t5 = _mm256_add_epi32(t5, DCT_MUL(t3, 2485, 13));
+    t3 = _mm256_sub_epi32(t3, DCT_MUL(t5, 18205, 15));
+    t5 = _mm256_add_epi32(t5, DCT_MUL(t3, 2485, 13));
+
+    x[0] = t0;
+    x[1] = t1;
+    x[2] = t2;
+    x[3] = t3;
+    x[4] = t4;
+    x[5] = t5;
+    x[6] = t6;
+    x[7] = t7;
+}
+
+static inline void transpose_8x8(__m256i r[8])
+{
+    const __m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+    const __m256i t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+    const __m256i t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+    const __m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+    const __m256i t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+    const __m256i t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+    const __m256i t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+    const __m256i t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+    const __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+    const __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+    const __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+    const __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+    const __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+    const __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+    const __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+    const __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+    r[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+    r[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+    r[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+    r[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+    r[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+    r[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+    r[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+    r[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+
+/*
+ * The lanes hold the columns of the block, so each pass transforms all eight
+ * columns, and the block is transposed after each pass like in the scalar
+ * code. Coefficient (i, j) ends up in lane j of x[i].
+ */
+static inline void od_bin_fdct8x8_avx2(__m256i x[8])
+{
+    od_bin_fdct8_avx2(x);
+    transpose_8x8(x);
+    od_bin_fdct8_avx2(x);
+    transpose_8x8(x);
+}
+
+static inline void load_block(__m256i x[8], const unsigned char *p,
+                              int stride, int hbd)
+{
+    for (unsigned i = 0; i < 8; i++, p += stride) {
+        x[i] = hbd ?
+            _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) p)) :
+            _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*) p));
+    }
+}
+
+/*
+ * Stores the terms of the global and of the quadrant variance sums, with the
+ * means computed as in the scalar code.
+ */
+static inline void block_var_terms(const __m256i x[8], float *gvar,
+                                    float *vars)
+{
+    const __m256i top = _mm256_add_epi32(_mm256_add_epi32(x[0], x[1]),
+                                         _mm256_add_epi32(x[2], x[3]));
+    const __m256i bot = _mm256_add_epi32(_mm256_add_epi32(x[4], x[5]),
+                                         _mm256_add_epi32(x[6], x[7]));
+    // lane 0: quadrant 0, 1: quadrant 1, 4: quadrant 2, 5: quadrant 3
+    __m256i sums = _mm256_hadd_epi32(top, bot);
+    sums = _mm256_hadd_epi32(sums, sums);
+
+    // the integer sums are exact in float, and so are the power of 2 divisions
+    int32_t s[8];
+    _mm256_storeu_si256((__m256i*) s, sums);
+    const float gmean = (float) (s[0] + s[1] + s[4] + s[5]) / 64.f;
+    const float means[4] = {
+        (float) s[0] / 16.f, (float) s[1] / 16.f,
+        (float) s[4] / 16.f, (float) s[5] / 16.f,
+    };
+
+    const __m256 gm = _mm256_set1_ps(gmean);
+    const __m256 m_top = _mm256_setr_ps(means[0], means[0], means[0], means[0],
+                                        means[2], means[2], means[2], means[2]);
+    const __m256 m_bot = _mm256_setr_ps(means[1], means[1], means[1], means[1],
+                                        means[3], means[3], means[3], means[3]);
+    for (unsigned i = 0; i < 8; i++) {
+        const __m256 v = _mm256_cvtepi32_ps(x[i]);
+        const __m256 g = _mm256_sub_ps(v, gm);
+        const __m256 d = _mm256_sub_ps(v, i < 4 ? m_top : m_bot);
+        _mm256_storeu_ps(gvar + 8 * i, _mm256_mul_ps(g, g));
+        _mm256_storeu_ps(vars + 8 * i, _mm256_mul_ps(d, d));
+    }
+}
+
+/*
+ * Sums the variance terms of each quadrant in the scalar order, with one
+ * register accumulator per quadrant.
+ */
+static inline void quadrant_sums(const float *terms, float vars[4])
+{
+    float v0 = 0, v1 = 0, v2 = 0, v3 = 0;
+    for (unsigned i = 0; i < 4; i++) {
+        for (unsigned j = 0; j < 4; j++) {
+            v0 += terms[8 * i + j];
+            v2 += terms[8 * i + j + 4];
+        }
+    }
+    for (unsigned i = 4; i < 8; i++) {
+        for (unsigned j = 0; j < 4; j++) {
+            v1 += terms[8 * i + j];
+            v3 += terms[8 * i + j + 4];
+        }
+    }
+    vars[0] = v0;
+    vars[1] = v1;
+    vars[2] = v2;
+    vars[3] = v3;
+}
+
+static inline void block_mask_terms(const __m256i x[8], const float *mask,
+                                    float *terms)
+{
+    for (unsigned i = 0; i < 8; i++) {
+        const __m256 sq = _mm256_cvtepi32_ps(_mm256_mullo_epi32(x[i], x[i]));
+        _mm256_storeu_ps(terms + 8 * i,
+                         _mm256_mul_ps(sq, _mm256_loadu_ps(mask + 8 * i)));
+    }
+    // the DC coefficient does not contribute to the masking
+    terms[0] = 0.f;
+}
+
+static inline void block_err_terms(const __m256i s[8], const __m256i d[8],
+                                   float s_mask, const float *mask,
+                                   const float *csf, float *terms)
+{
+    const __m256 m = _mm256_set1_ps(s_mask);
+    for (unsigned i = 0; i < 8; i++) {
+        const __m256 err =
+            _mm256_cvtepi32_ps(_mm256_abs_epi32(_mm256_sub_epi32(s[i], d[i])));
+        const __m256 thr = _mm256_div_ps(m, _mm256_loadu_ps(mask + 8 * i));
+        __m256 e = _mm256_andnot_ps(_mm256_cmp_ps(err, thr, _CMP_LT_OQ),
+                                    _mm256_sub_ps(err, thr));
+        // the DC coefficient is not masked
+        if (!i)
+            e = _mm256_blend_ps(e, err, 1);
+        const __m256 t = _mm256_mul_ps(e, _mm256_loadu_ps(csf + 8 * i));
+        _mm256_storeu_ps(terms + 8 * i, _mm256_mul_ps(t, t));
+    }
+}
+
+typedef struct PsnrHvsBlock {
+    __m256i dct[8];
+    float gvar_terms[8 * 8];
+    float vars_terms[8 * 8];
+    float mask_terms[8 * 8];
+} PsnrHvsBlock;
+
+static inline void block_terms(PsnrHvsBlock *b, const unsigned char *p,
+                               int stride, int hbd, const float *mask)
+{
+    load_block(b->dct, p, stride, hbd);
+    block_var_terms(b->dct, b->gvar_terms, b->vars_terms);
+    od_bin_fdct8x8_avx2(b->dct);
+    block_mask_terms(b->dct, mask, b->mask_terms);
+}
+
+/*
+ * The part of the scalar code which follows the sums, giving the masking
+ * level of one block of one picture.
+ */
+static inline float block_mask(float gvar, float vars[4], float mask)
+{
+    int i;
+    gvar *= 1 / 63.f * 64;
+    for (i = 0; i < 4; i++)
+        vars[i] *= 1 / 15.f * 16;
+    if (gvar > 0)
+        gvar = (vars[0] + vars[1] + vars[2] + vars[3]) / gvar;
+    return sqrt(mask * gvar) / 32.f;
+}
+
+double calc_psnrhvs_avx2(const unsigned char *_src, int _systride,
+                         const unsigned char *_dst, int _dystride,
+                         double _par, int depth, int _w, int _h, int _step,
+                         float _csf[8][8])
+{
+    float ret;
+    float mask[8][8];
+    float err_terms[2 * 8 * 8] = { 0 };
+    int pixels;
+    int x;
+    int y;
+    int32_t samplemax;
+    const int hbd = depth > 8;
+    (void)_par;
+    ret = pixels = 0;
+
+    for (x = 0; x < 8; x++)
+        for (y = 0; y < 8; y++)
+            mask[x][y] = (_csf[x][y] * 0.3885746225901003) *
+                         (_csf[x][y] * 0.3885746225901003);
+
+    /*
+     Blocks are processed in pairs, so that the sums of both, which are long
+     chains of dependent additions, run side by side. An odd block at the end
+     of a row is paired with itself, and its copy is not counted.
+    */
+    for (y = 0; y < _h - 7; y += _step) {
+        for (x = 0; x < _w - 7; x += 2 * _step) {
+            const int x1 = x + _step < _w - 7 ? x + _step : x;
+            const unsigned char *src = _src + y * _systride;
+            const unsigned char *dst = _dst + y * _dystride;
+            PsnrHvsBlock b[4];
+            float gvar0 = 0, gvar1 = 0, gvar2 = 0, gvar3 = 0;
+            float mask0 = 0, mask1 = 0, mask2 = 0, mask3 = 0;
+            float vars[4][4];
+            float s_mask;
+            float d_mask;
+            int i;
+
+            block_terms(&b[0], src + (x << hbd), _systride, hbd, mask[0]);
+            block_terms(&b[1], dst + (x << hbd), _dystride, hbd, mask[0]);
+            block_terms(&b[2], src + (x1 << hbd), _systride, hbd, mask[0]);
+            block_terms(&b[3], dst + (x1 << hbd), _dystride, hbd, mask[0]);
+
+            /*
+             The error terms of the previous pair are summed here, which keeps
+             the order of the additions to ret but hides their latency. Before
+             the first pair they are all zero.
+            */
+            for (i = 0; i < 64; i++) {
+                gvar0 += b[0].gvar_terms[i];
+                gvar1 += b[1].gvar_terms[i];
+                gvar2 += b[2].gvar_terms[i];
+                gvar3 += b[3].gvar_terms[i];
+                mask0 += b[0].mask_terms[i];
+                mask1 += b[1].mask_terms[i];
+                mask2 += b[2].mask_terms[i];
+                mask3 += b[3].mask_terms[i];
+                ret += err_terms[2 * i];
+                ret += err_terms[2 * i + 1];
+            }
+            for (i = 0; i < 4; i++)
+                quadrant_sums(b[i].vars_terms, vars[i]);
+
+            s_mask = block_mask(gvar0, vars[0], mask0);
+            d_mask = block_mask(gvar1, vars[1], mask1);
+            if (d_mask > s_mask)
+                s_mask = d_mask;
+            block_err_terms(b[0].dct, b[1].dct, s_mask, mask[0], _csf[0],
+                            err_terms);
+            pixels += 64;
+
+            if (x1 == x) {
+                memset(err_terms + 64, 0, 64 * sizeof(*err_terms));
+                continue;
+            }
+            s_mask = block_mask(gvar2, vars[2], mask2);
+            d_mask = block_mask(gvar3, vars[3], mask3);
+            if (d_mask > s_mask)
+                s_mask = d_mask;
+            block_err_terms(b[2].dct, b[3].dct, s_mask, mask[0], _csf[0],
+                            err_terms + 64);
+            pixels += 64;
+        }
+    }
+    for (x = 0; x < 2 * 64; x++)
+        ret += err_terms[x];
+    ret /= pixels;
+    samplemax = (1 << depth) - 1;
+    ret /= samplemax * samplemax;
+    return ret;
+}
@@ -0,0 +1,204 @@
+/*
+Copyright 2001-2012 Xiph.Org and contributors.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+- Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+- Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <immintrin.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "feature/x86/ssim_avx2.h"
+
+#define SSIM_VSUM_CHUNK 256
+
+/*
+ * AVX2 versions of ssim_hmoments() and ssim_vterms() in integer_ssim.c.
+ * The kernel is symmetric, so the two samples at the same distance from the
+ * centre are summed before they are weighted. The horizontal sums are exact
+ * in 32 bits for up to 12 bits per sample, the vertical sums are exact in
+ * double precision, and the terms are computed with the same operations as
+ * the scalar code, so the results are identical.
+ */
+
+static inline __m256d cvt_lo_pd(__m256i x)
+{
+    // exact for values below 2**52
+    const __m256i magic = _mm256_set1_epi64x(0x4330000000000000);
+    const __m256i v = _mm256_cvtepu32_epi64(_mm256_castsi256_si128(x));
+    return _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(v, magic)),
+                         _mm256_castsi256_pd(magic));
+}
+
+static inline __m256d cvt_hi_pd(__m256i x)
+{
+    return cvt_lo_pd(_mm256_permute2x128_si256(x, x, 0x11));
+}
+
+static inline void store_products(uint32_t *prod, ptrdiff_t stride, int x,
+                                  __m256i s, __m256i d)
+{
+    _mm256_storeu_si256((__m256i*)(prod + x), s);
+    _mm256_storeu_si256((__m256i*)(prod + stride + x), d);
+    _mm256_storeu_si256((__m256i*)(prod + 2 * stride + x),
+                        _mm256_mullo_epi32(s, s));
+    _mm256_storeu_si256((__m256i*)(prod + 3 * stride + x),
+                        _mm256_mullo_epi32(s, d));
+    _mm256_storeu_si256((__m256i*)(prod + 4 * stride + x),
+                        _mm256_mullo_epi32(d, d));
+}
+
+void ssim_hmoments_avx2(const unsigned char *src, const unsigned char *dst,
+                        int hbd, int w, const unsigned *kernel, int kernel_sz,
+                        uint32_t *prod, ptrdiff_t prod_stride, double *moments,
+                        ptrdiff_t stride)
+{
+    const int offs = kernel_sz >> 1;
+    uint32_t *p = prod + offs;
+    int x = 0;
+
+    if (hbd) {
+        const uint16_t *src16 = (const uint16_t*) src;
+        const uint16_t *dst16 = (const uint16_t*) dst;
+        for (; x + 8 <= w; x += 8) {
+            const __m256i s = _mm256_cvtepu16_epi32(
+                _mm_loadu_si128((const __m128i*)(src16 + x)));
+            const __m256i d = _mm256_cvtepu16_epi32(
+                _mm_loadu_si128((const __m128i*)(dst16 + x)));
+            store_products(p, prod_stride, x, s, d);
+        }
+        for (; x < w; x++) {
+            const uint32_t s = src16[x], d = dst16[x];
+            p[x] = s;
+            p[prod_stride + x] = d;
+            p[2 * prod_stride + x] = s * s;
+            p[3 * prod_stride + x] = s * d;
+            p[4 * prod_stride + x] = d * d;
+        }
+    } else {
+        for (; x + 8 <= w; x += 8) {
+            const __m256i s = _mm256_cvtepu8_epi32(
+                _mm_loadl_epi64((const __m128i*)(src + x)));
+            const __m256i d = _mm256_cvtepu8_epi32(
+                _mm_loadl_epi64((const __m128i*)(dst + x)));
+            store_products(p, prod_stride, x, s, d);
+        }
+        for (; x < w; x++) {
+            const uint32_t s = src[x], d = dst[x];
+            p[x] = s;
+            p[prod_stride + x] = d;
+            p[2 * prod_stride + x] = s * s;
+            p[3 * prod_stride + x] = s * d;
+            p[4 * prod_stride + x] = d * d;
+        }
+    }
+
+    // the planes are padded, so the last vector may run past w
+    for (int i = 0; i < 5; i++) {
+        const uint32_t *q = prod + i * prod_stride;
+        double *m = moments + i * stride;
+        for (x = 0; x < w; x += 8) {
+            __m256i sum = _mm256_mullo_epi32(
+                _mm256_loadu_si256((const __m256i*)(q + x + offs)),
+                _mm256_set1_epi32(kernel[offs]));
+            for (int k = 0; k < offs; k++) {
+                const __m256i pair = _mm256_add_epi32(
+                    _mm256_loadu_si256((const __m256i*)(q + x + k)),
+                    _mm256_loadu_si256((const __m256i*)
+                                       (q + x + kernel_sz - 1 - k)));
+                sum = _mm256_add_epi32(sum,
+                    _mm256_mullo_epi32(pair, _mm256_set1_epi32(kernel[k])));
+            }
+            _mm256_storeu_pd(m + x, cvt_lo_pd(sum));
+            _mm256_storeu_pd(m + x + 4, cvt_hi_pd(sum));
+        }
+    }
+}
+
+static inline __m256d vsum(double *const *lines, const unsigned *kernel,
+                           int kernel_sz, ptrdiff_t offset)
+{
+    const int offs = kernel_sz >> 1;
+    __m256d sum = _mm256_mul_pd(_mm256_loadu_pd(lines[offs] + offset),
+                                _mm256_set1_pd(kernel[offs]));
+    for (int k = 0; k < offs; k++) {
+        const __m256d pair =
+            _mm256_add_pd(_mm256_loadu_pd(lines[k] + offset),
+                          _mm256_loadu_pd(lines[kernel_sz - 1 - k] + offset));
+        sum = _mm256_add_pd(sum, _mm256_mul_pd(pair,
+                                               _mm256_set1_pd(kernel[k])));
+    }
+    return sum;
+}
+
+void ssim_vterms_avx2(double *const *lines, const unsigned *kernel,
+                      int kernel_sz, ptrdiff_t stride, const double *hw,
+                      double vw, double k1, double k2, int w, double *terms)
+{
+    const __m256d two = _mm256_set1_pd(2.);
+    double sum[5][SSIM_VSUM_CHUNK];
+
+    /*
+     The sums are taken one plane at a time over a chunk of the line, so that
+     few lines are streamed from memory at once.
+     The planes are padded, so the last vector may run past w.
+    */
+    for (int x0 = 0; x0 < w; x0 += SSIM_VSUM_CHUNK) {
+        const int n = w - x0 < SSIM_VSUM_CHUNK ? w - x0 : SSIM_VSUM_CHUNK;
+        for (int i = 0; i < 5; i++) {
+            for (int x = 0; x < n; x += 4) {
+                _mm256_storeu_pd(sum[i] + x,
+                    vsum(lines, kernel, kernel_sz, i * stride + x0 + x));
+            }
+        }
+        for (int x = 0; x < n; x += 4) {
+            const __m256d mux = _mm256_loadu_pd(sum[0] + x);
+            const __m256d muy = _mm256_loadu_pd(sum[1] + x);
+            const __m256d x2 = _mm256_loadu_pd(sum[2] + x);
+            const __m256d xy = _mm256_loadu_pd(sum[3] + x);
+            const __m256d y2 = _mm256_loadu_pd(sum[4] + x);
+
+            const __m256d wv = _mm256_mul_pd(_mm256_loadu_pd(hw + x0 + x),
+                                             _mm256_set1_pd(vw));
+            const __m256d c1 =
+                _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(k1), wv), wv);
+            const __m256d c2 =
+                _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(k2), wv), wv);
+            const __m256d mx2 = _mm256_mul_pd(mux, mux);
+            const __m256d mxy = _mm256_mul_pd(mux, muy);
+            const __m256d my2 = _mm256_mul_pd(muy, muy);
+
+            const __m256d num = _mm256_mul_pd(
+                _mm256_mul_pd(wv, _mm256_add_pd(_mm256_mul_pd(two, mxy), c1)),
+                _mm256_add_pd(c2, _mm256_mul_pd(two,
+                    _mm256_sub_pd(_mm256_mul_pd(xy, wv), mxy))));
+            const __m256d den = _mm256_mul_pd(
+                _mm256_add_pd(_mm256_add_pd(mx2, my2), c1),
+                _mm256_add_pd(_mm256_sub_pd(_mm256_add_pd(
+                    _mm256_sub_pd(_mm256_mul_pd(x2, wv), mx2),
+                    _mm256_mul_pd(y2, wv)), my2), c2));
+            _mm256_storeu_pd(terms + x0 + x, _mm256_div_pd(num, den));
+        }
+    }
+}
@@ -0,0 +1,34 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef X86_AVX2_SSIM_H_
+#define X86_AVX2_SSIM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+void ssim_hmoments_avx2(const unsigned char *src, const unsigned char *dst,
+                        int hbd, int w, const unsigned *kernel, int kernel_sz,
+                        uint32_t *prod, ptrdiff_t prod_stride, double *moments,
+                        ptrdiff_t stride);
+
+void ssim_vterms_avx2(double *const *lines, const unsigned *kernel,
+                      int kernel_sz, ptrdiff_t stride, const double *hw,
+                      double vw, double k1, double k2, int w, double *terms);
+
+#endif /* X86_AVX2_SSIM_H_ */
@@ -126,13 +126,12 @@ void vif_statistic_8_avx2(struct VifPublicState *s, float *num, float *den, unsi
 
     //float equivalent of 2. (2 * 65536)
     static const int32_t sigma_nsq = 65536 << 1;
-    double vif_enhn_gain_limit = s->vif_enhn_gain_limit;
 
-    int64_t accum_num_log = 0;
+    int64_t accum_num_log[VIF_MAX_ENHN_GAIN_LIMITS] = { 0 };
     int64_t accum_den_log = 0;
     int64_t accum_num_non_log = 0;
     int64_t accum_den_non_log = 0;
-    uint16_t *log2_table = s->log2_table;
+    const uint16_t *log2_table = s->log2_table;
 
     // variables used for 16 sample block vif computation
     ALIGNED(32) uint32_t xx[16];
@@ -498,27 +497,9 @@ void vif_statistic_8_avx2(struct VifPublicState *s, float *num, float *den, unsi
                     */
                     accum_den_log += log2_32(log2_table, sigma_nsq + sigma1_sq) - 2048 * 17;
 
-                    if (sigma12 > 0 && sigma2_sq > 0)
-                    {
-                        // num_val = log2f(1.0f + (g * g * sigma1_sq) / (sv_sq + sigma_nsq));
-                        /**
-                        * In floating-point numerator = log2((1.0f + (g * g * sigma1_sq)/(sv_sq + sigma_nsq))
-                        *
-                        * In Fixed-point the above is converted to
-                        * numerator = log2((sv_sq + sigma_nsq)+(g * g * sigma1_sq))- log2(sv_sq + sigma_nsq)
-                        */
-
-                        const double eps = 65536 * 1.0e-10;
-                        double g = sigma12 / (sigma1_sq + eps); // this epsilon can go away
-                        int32_t sv_sq = sigma2_sq - g * sigma12;
-
-                        sv_sq = (uint32_t)(MAX(sv_sq, 0));
-
-                        g = MIN(g, vif_enhn_gain_limit);
-
-                        uint32_t numer1 = (sv_sq + sigma_nsq);
-                        int64_t numer1_tmp = (int64_t)((g * g * sigma1_sq)) + numer1; //numerator
-                        accum_num_log += log2_64(log2_table, numer1_tmp) - log2_64(log2_table, numer1);
+                    if (sigma12 > 0 && sigma2_sq > 0) {
+                        vif_accumulate_num_log(s, accum_num_log,
+                                               sigma1_sq, sigma2_sq, sigma12);
                     }
                 }
                 else {
@@ -529,7 +510,8 @@ void vif_statistic_8_avx2(struct VifPublicState *s, float *num, float *den, unsi
         }
         if ((n << 4) != w) {
             VifResiduals residuals = vif_compute_line_residuals(s, n << 4, w, 0);
-            accum_num_log += residuals.accum_num_log;
+            for (unsigned k = 0; k < s->enhn_gain_limit_cnt; k++)
+                accum_num_log[k] += residuals.accum_num_log[k];
             accum_den_log += residuals.accum_den_log;
             accum_num_non_log += residuals.accum_num_non_log;
             accum_den_non_log += residuals.accum_den_non_log;
@@ -541,7 +523,8 @@ void vif_statistic_8_avx2(struct VifPublicState *s, float *num, float *den, unsi
     //den[0] = accum_den_log / 2048.0 + accum_den_non_log;
 
     //changed calculation to increase performance
-    num[0] = accum_num_log / 2048.0 + (accum_den_non_log - ((accum_num_non_log) / 16384.0) / (65025.0));
+    for (unsigned k = 0; k < s->enhn_gain_limit_cnt; k++)
+        num[k] = accum_num_log[k] / 2048.0 + (accum_den_non_log - ((accum_num_non_log) / 16384.0) / (65025.0));
     den[0] = accum_den_log / 2048.0 + accum_den_non_log;
 
 }
@@ -559,12 +542,11 @@ void vif_statistic_16_avx2(struct VifPublicState *s, float *num, float *den, uns
     //float equivalent of 2. (2 * 65536)
     static const int32_t sigma_nsq = 65536 << 1;
 
-    int64_t accum_num_log = 0;
+    int64_t accum_num_log[VIF_MAX_ENHN_GAIN_LIMITS] = { 0 };
     int64_t accum_den_log = 0;
     int64_t accum_num_non_log = 0;
     int64_t accum_den_non_log = 0;
     const uint16_t *log2_table = s->log2_table;
-    double vif_enhn_gain_limit = s->vif_enhn_gain_limit;
 
     // variables used for 16 sample block vif computation
     ALIGNED(32) uint32_t xx[16];
@@ -1053,24 +1035,8 @@ void vif_statistic_16_avx2(struct VifPublicState *s, float *num, float *den, uns
                     accum_den_log += log2_32(log2_table, sigma_nsq + sigma1_sq) - 2048 * 17;
 
                     if (sigma12 > 0 && sigma2_sq > 0) {
-                        /**
-                        * In floating-point numerator = log2((1.0f + (g * g * sigma1_sq)/(sv_sq + sigma_nsq))
-                        *
-                        * In Fixed-point the above is converted to
-                        * numerator = log2((sv_sq + sigma_nsq)+(g * g * sigma1_sq))- log2(sv_sq + sigma_nsq)
-                        */
-
-                        const double eps = 65536 * 1.0e-10;
-                        double g = sigma12 / (sigma1_sq + eps); // this epsilon can go away
-                        int32_t sv_sq = sigma2_sq - g * sigma12;
-
-                        sv_sq = (uint32_t)(MAX(sv_sq, 0));
-
-                        g = MIN(g, vif_enhn_gain_limit);
-
-                        uint32_t numer1 = (sv_sq + sigma_nsq);
-                        int64_t numer1_tmp = (int64_t)((g * g * sigma1_sq)) + numer1; //numerator
-                        accum_num_log += log2_64(log2_table, numer1_tmp) - log2_64(log2_table, numer1);
+                        vif_accumulate_num_log(s, accum_num_log,
+                                               sigma1_sq, sigma2_sq, sigma12);
                     }
                 }
                 else {
@@ -1084,14 +1050,16 @@ void vif_statistic_16_avx2(struct VifPublicState *s, float *num, float *den, uns
         if ((n << 4) != w) {
             VifResiduals residuals =
                 vif_compute_line_residuals(s, n << 4, w, scale);
-            accum_num_log += residuals.accum_num_log;
+            for (unsigned k = 0; k < s->enhn_gain_limit_cnt; k++)
+                accum_num_log[k] += residuals.accum_num_log[k];
             accum_den_log += residuals.accum_den_log;
             accum_num_non_log += residuals.accum_num_non_log;
             accum_den_non_log += residuals.accum_den_non_log;
         }
     }
 
-    num[0] = accum_num_log / 2048.0 + (accum_den_non_log - ((accum_num_non_log) / 16384.0) / (65025.0));
+    for (unsigned k = 0; k < s->enhn_gain_limit_cnt; k++)
+        num[k] = accum_num_log[k] / 2048.0 + (accum_den_non_log - ((accum_num_non_log) / 16384.0) / (65025.0));
     den[0] = accum_den_log / 2048.0 + accum_den_non_log;
 }
 
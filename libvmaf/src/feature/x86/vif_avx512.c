@@ -66,19 +66,19 @@ decimate_and_pad(VifBuffer buf, unsigned w, unsigned h, int scale)
 }
 
 typedef struct Residuals512 {
-    __m512i maccum_num_log;
+    __m512i maccum_num_log[VIF_MAX_ENHN_GAIN_LIMITS];
     __m512i maccum_den_log;
     __m512i maccum_num_non_log;
     __m512i maccum_den_non_log;
 } Residuals512;
 
 // compute VIF on a 16 pixel block from xx (ref variance), yy (clamped dis variance), xy (ref dis covariance)
-static inline void vif_statistic_avx512(Residuals512 *out, __m512i xx, __m512i xy, __m512i yy, const uint16_t *log2_table, double vif_enhn_gain_limit)
+static inline void vif_statistic_avx512(Residuals512 *out, __m512i xx, __m512i xy, __m512i yy, const VifPublicState *s)
 {
+    const uint16_t *log2_table = s->log2_table;
     //float equivalent of 2. (2 * 65536)
     static const int32_t sigma_nsq = 65536 << 1;
 
-    __m512i maccum_num_log = out->maccum_num_log;
     __m512i maccum_den_log = out->maccum_den_log;
     __m512i maccum_num_non_log = out->maccum_num_non_log;
     __m512i maccum_den_non_log = out->maccum_den_non_log;
@@ -111,7 +111,6 @@ static inline void vif_statistic_avx512(Residuals512 *out, __m512i xx, __m512i x
         __m512d mg = _mm512_div_pd(_mm512_cvtepu64_pd(msigma12), _mm512_add_pd(msigma1_d, _mm512_set1_pd(eps)));
         __m512i msv_sq = _mm512_cvttpd_epi64(_mm512_sub_pd(_mm512_cvtepi64_pd(msigma2), _mm512_mul_pd(mg, _mm512_cvtepi64_pd(msigma12))));
         msv_sq = _mm512_max_epi64(msv_sq, _mm512_setzero_si512());
-        mg = _mm512_min_pd(mg, _mm512_set1_pd(vif_enhn_gain_limit));
 
         __m512i mnumer1 = _mm512_add_epi64(msv_sq, _mm512_set1_epi64(sigma_nsq));
         __m512i mnumer1_lz = _mm512_sub_epi64(_mm512_set1_epi64(48), _mm512_lzcnt_epi64(mnumer1));
@@ -119,15 +118,20 @@ static inline void vif_statistic_avx512(Residuals512 *out, __m512i xx, __m512i x
         __m512i mnumer1_mantissa_log = _mm512_and_si512(_mm512_set1_epi64(0xffff), _mm512_i32gather_epi64(_mm512_cvtusepi64_epi32(mnumer1_mantissa), log2_table, sizeof(*log2_table))); // we took 64 bits, we need 16
         __m512i mnumer1_log = _mm512_add_epi64(mnumer1_mantissa_log, _mm512_slli_epi64(mnumer1_lz, 11));
 
-        __m512i mnumer1_tmp = _mm512_add_epi64(mnumer1, _mm512_cvttpd_epi64(_mm512_mul_pd(_mm512_mul_pd(mg, mg), msigma1_d)));
-        __m512i mnumer1_tmp_lz = _mm512_sub_epi64(_mm512_set1_epi64(48), _mm512_lzcnt_epi64(mnumer1_tmp));
-        __m512i mnumer1_tmp_mantissa = _mm512_srlv_epi64(mnumer1_tmp, mnumer1_tmp_lz);
-        __m512i mnumer1_tmp_mantissa_log = _mm512_and_si512(_mm512_set1_epi64(0xffff), _mm512_i32gather_epi64(_mm512_cvtusepi64_epi32(mnumer1_tmp_mantissa), log2_table, sizeof(*log2_table))); // we took 64 bits, we need 16
-        __m512i mnumer1_tmp_log = _mm512_add_epi64(mnumer1_tmp_mantissa_log, _mm512_slli_epi64(mnumer1_tmp_lz, 11));
+        // only the clamping of g differs between the enhancement gain limits
+        const __mmask8 mnum_mask = (~msigma1_mask) & msigma12_mask & msigma2_mask;
+        for (unsigned k = 0; k < s->enhn_gain_limit_cnt; k++) {
+            __m512d mg_k = _mm512_min_pd(mg, _mm512_set1_pd(s->enhn_gain_limit[k]));
+            __m512i mnumer1_tmp = _mm512_add_epi64(mnumer1, _mm512_cvttpd_epi64(_mm512_mul_pd(_mm512_mul_pd(mg_k, mg_k), msigma1_d)));
+            __m512i mnumer1_tmp_lz = _mm512_sub_epi64(_mm512_set1_epi64(48), _mm512_lzcnt_epi64(mnumer1_tmp));
+            __m512i mnumer1_tmp_mantissa = _mm512_srlv_epi64(mnumer1_tmp, mnumer1_tmp_lz);
+            __m512i mnumer1_tmp_mantissa_log = _mm512_and_si512(_mm512_set1_epi64(0xffff), _mm512_i32gather_epi64(_mm512_cvtusepi64_epi32(mnumer1_tmp_mantissa), log2_table, sizeof(*log2_table))); // we took 64 bits, we need 16
+            __m512i mnumer1_tmp_log = _mm512_add_epi64(mnumer1_tmp_mantissa_log, _mm512_slli_epi64(mnumer1_tmp_lz, 11));
 
-        __m512i mnum_val = _mm512_sub_epi64(mnumer1_tmp_log, mnumer1_log);
+            __m512i mnum_val = _mm512_sub_epi64(mnumer1_tmp_log, mnumer1_log);
 
-        maccum_num_log = _mm512_mask_add_epi64(maccum_num_log, (~msigma1_mask) & msigma12_mask & msigma2_mask, maccum_num_log, mnum_val);
+            out->maccum_num_log[k] = _mm512_mask_add_epi64(out->maccum_num_log[k], mnum_mask, out->maccum_num_log[k], mnum_val);
+        }
         maccum_den_log = _mm512_mask_add_epi64(maccum_den_log, ~msigma1_mask, maccum_den_log, mden_val);
 
         // non log stage
@@ -135,7 +139,6 @@ static inline void vif_statistic_avx512(Residuals512 *out, __m512i xx, __m512i x
         maccum_den_non_log = _mm512_mask_add_epi64(maccum_den_non_log, msigma1_mask, maccum_den_non_log, _mm512_set1_epi64(1));
     }
 
-    out->maccum_num_log = maccum_num_log;
     out->maccum_den_log = maccum_den_log;
     out->maccum_num_non_log = maccum_num_non_log;
     out->maccum_den_non_log = maccum_den_non_log;
@@ -148,8 +151,6 @@ void vif_statistic_8_avx512(struct VifPublicState *s, float *num, float *den, un
     const uint8_t *ref = (uint8_t*)buf.ref;
     const uint8_t *dis = (uint8_t*)buf.dis;
     const unsigned fwidth_half = fwidth >> 1;
-    const uint16_t *log2_table = s->log2_table;
-    double vif_enhn_gain_limit = s->vif_enhn_gain_limit;
 
 #if defined __GNUC__
 #define ALIGNED(x) __attribute__ ((aligned (x)))
@@ -159,7 +160,7 @@ void vif_statistic_8_avx512(struct VifPublicState *s, float *num, float *den, un
 #define ALIGNED(x)
 #endif
 
-    int64_t accum_num_log = 0;
+    int64_t accum_num_log[VIF_MAX_ENHN_GAIN_LIMITS] = { 0 };
     int64_t accum_den_log = 0;
     int64_t accum_num_non_log = 0;
     int64_t accum_den_non_log = 0;
@@ -169,7 +170,8 @@ void vif_statistic_8_avx512(struct VifPublicState *s, float *num, float *den, un
 
     Residuals512 residuals;
     residuals.maccum_den_log = _mm512_setzero_si512();
-    residuals.maccum_num_log = _mm512_setzero_si512();
+    for (unsigned k = 0; k < VIF_MAX_ENHN_GAIN_LIMITS; k++)
+        residuals.maccum_num_log[k] = _mm512_setzero_si512();
     residuals.maccum_den_non_log = _mm512_setzero_si512();
     residuals.maccum_num_non_log = _mm512_setzero_si512();
     for (unsigned i = 0; i < h; ++i)
@@ -364,23 +366,26 @@ void vif_statistic_8_avx512(struct VifPublicState *s, float *num, float *den, un
                 __m512i refdis = _mm512_permutex2var_epi32(refdis_lo, mask2, refdis_hi);
                 xy = _mm512_sub_epi32(refdis, mu1mu2);
             }
-            vif_statistic_avx512(&residuals, xx, xy, yy, log2_table, vif_enhn_gain_limit);
+            vif_statistic_avx512(&residuals, xx, xy, yy, s);
         }
 
         if ((n << 4) != w) {
             VifResiduals residuals = vif_compute_line_residuals(s, n << 4, w, 0);
-            accum_num_log += residuals.accum_num_log;
+            for (unsigned k = 0; k < s->enhn_gain_limit_cnt; k++)
+                accum_num_log[k] += residuals.accum_num_log[k];
             accum_den_log += residuals.accum_den_log;
             accum_num_non_log += residuals.accum_num_non_log;
             accum_den_non_log += residuals.accum_den_non_log;
         }
     }
 
-    accum_num_log += _mm512_reduce_add_epi64(residuals.maccum_num_log);
+    for (unsigned k = 0; k < s->enhn_gain_limit_cnt; k++)
+        accum_num_log[k] += _mm512_reduce_add_epi64(residuals.maccum_num_log[k]);
     accum_den_log += _mm512_reduce_add_epi64(residuals.maccum_den_log);
     accum_num_non_log += _mm512_reduce_add_epi64(residuals.maccum_num_non_log);
     accum_den_non_log += _mm512_reduce_add_epi64(residuals.maccum_den_non_log);
-    num[0] = accum_num_log / 2048.0 + (accum_den_non_log - ((accum_num_non_log) / 16384.0) / (65025.0));
+    for (unsigned k = 0; k < s->enhn_gain_limit_cnt; k++)
+        num[k] = accum_num_log[k] / 2048.0 + (accum_den_non_log - ((accum_num_non_log) / 16384.0) / (65025.0));
     den[0] = accum_den_log / 2048.0 + accum_den_non_log;
 }
 
@@ -393,17 +398,16 @@ void vif_statistic_16_avx512(struct VifPublicState *s, float *num, float *den, u
 
     int32_t add_shift_round_VP, shift_VP;
     int32_t add_shift_round_VP_sq, shift_VP_sq;
-    const uint16_t *log2_table = s->log2_table;
-    double vif_enhn_gain_limit = s->vif_enhn_gain_limit;
     __m512i mask2 = _mm512_set_epi32(30, 28, 26, 24, 22, 20, 18, 16, 14, 12, 10, 8, 6, 4, 2, 0);
 
     Residuals512 residuals;
     residuals.maccum_den_log = _mm512_setzero_si512();
-    residuals.maccum_num_log = _mm512_setzero_si512();
+    for (unsigned k = 0; k < VIF_MAX_ENHN_GAIN_LIMITS; k++)
+        residuals.maccum_num_log[k] = _mm512_setzero_si512();
     residuals.maccum_den_non_log = _mm512_setzero_si512();
     residuals.maccum_num_non_log = _mm512_setzero_si512();
 
-    int64_t accum_num_log = 0;
+    int64_t accum_num_log[VIF_MAX_ENHN_GAIN_LIMITS] = { 0 };
     int64_t accum_den_log = 0;
     int64_t accum_num_non_log = 0;
     int64_t accum_den_non_log = 0;
@@ -718,20 +722,22 @@ void vif_statistic_16_avx512(struct VifPublicState *s, float *num, float *den, u
                 __m512i refdis = _mm512_permutex2var_epi32(refdis_lo, mask2, refdis_hi);
                 xy = _mm512_sub_epi32(refdis, mu1mu2);
             }
-            vif_statistic_avx512(&residuals, xx, xy, yy, log2_table, vif_enhn_gain_limit);
+            vif_statistic_avx512(&residuals, xx, xy, yy, s);
         }
 
         if ((n << 4) != (int)w) {
             VifResiduals residuals =
                 vif_compute_line_residuals(s, n << 4, w, scale);
-            accum_num_log += residuals.accum_num_log;
+            for (unsigned k = 0; k < s->enhn_gain_limit_cnt; k++)
+                accum_num_log[k] += residuals.accum_num_log[k];
             accum_den_log += residuals.accum_den_log;
             accum_num_non_log += residuals.accum_num_non_log;
             accum_den_non_log += residuals.accum_den_non_log;
         }
     }
 
-    accum_num_log += _mm512_reduce_add_epi64(residuals.maccum_num_log);
+    for (unsigned k = 0; k < s->enhn_gain_limit_cnt; k++)
+        accum_num_log[k] += _mm512_reduce_add_epi64(residuals.maccum_num_log[k]);
     accum_den_log += _mm512_reduce_add_epi64(residuals.maccum_den_log);
     accum_num_non_log += _mm512_reduce_add_epi64(residuals.maccum_num_non_log);
     accum_den_non_log += _mm512_reduce_add_epi64(residuals.maccum_den_non_log);
@@ -752,7 +758,8 @@ void vif_statistic_16_avx512(struct VifPublicState *s, float *num, float *den, u
     //den[0] = accum_den_log / 2048.0 + accum_den_non_log;
 
     //changed calculation to increase performance
-    num[0] = accum_num_log / 2048.0 + (accum_den_non_log - ((accum_num_non_log) / 16384.0) / (65025.0));
+    for (unsigned k = 0; k < s->enhn_gain_limit_cnt; k++)
+        num[k] = accum_num_log[k] / 2048.0 + (accum_den_non_log - ((accum_num_non_log) / 16384.0) / (65025.0));
     den[0] = accum_den_log / 2048.0 + accum_den_non_log;
 }
 
@@ -23,6 +23,7 @@
 #include "feature/feature_name.h"
 #include "fex_ctx_vector.h"
 #include "log.h"
+#include "picture.h"
 
 int feature_extractor_vector_init(RegisteredFeatureExtractors *rfe)
 {
@@ -45,6 +46,9 @@ int feature_extractor_vector_append(RegisteredFeatureExtractors *rfe,
     (void) flags;
 
     for (unsigned i = 0; i < rfe->cnt; i++) {
+        if (!vmaf_feature_extractor_context_merge(rfe->fex_ctx[i], fex_ctx))
+            return vmaf_feature_extractor_context_destroy(fex_ctx);
+
         char *feature_a =
             vmaf_feature_name_from_options(rfe->fex_ctx[i]->fex->name,
                     rfe->fex_ctx[i]->fex->options, rfe->fex_ctx[i]->fex->priv);
@@ -92,6 +96,51 @@ int feature_extractor_vector_append(RegisteredFeatureExtractors *rfe,
     return 0;
 }
 
+static bool uses_artifact(VmafFeatureExtractor *fex, const char *artifact)
+{
+    if (!fex->artifacts) return false;
+    for (unsigned i = 0; fex->artifacts[i]; i++) {
+        if (!strcmp(fex->artifacts[i], artifact))
+            return true;
+    }
+    return false;
+}
+
+bool feature_extractor_vector_shares_artifacts(RegisteredFeatureExtractors *rfe)
+{
+    if (!rfe) return false;
+
+    for (unsigned i = 0; i < rfe->cnt; i++) {
+        VmafFeatureExtractor *fex = rfe->fex_ctx[i]->fex;
+        if (!fex->artifacts) continue;
+        for (unsigned j = 0; fex->artifacts[j]; j++) {
+            for (unsigned k = i + 1; k < rfe->cnt; k++) {
+                if (uses_artifact(rfe->fex_ctx[k]->fex, fex->artifacts[j]))
+                    return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+int feature_extractor_vector_declare_artifacts(RegisteredFeatureExtractors *rfe,
+                                               VmafPicture *pic)
+{
+    if (!rfe) return -EINVAL;
+    if (!pic) return -EINVAL;
+
+    int err = vmaf_picture_artifact_cache_init(pic);
+    for (unsigned i = 0; !err && i < rfe->cnt; i++) {
+        VmafFeatureExtractor *fex = rfe->fex_ctx[i]->fex;
+        if (!fex->artifacts) continue;
+        for (unsigned j = 0; !err && fex->artifacts[j]; j++)
+            err = vmaf_picture_artifact_declare(pic, fex->artifacts[j]);
+    }
+
+    return err;
+}
+
 void feature_extractor_vector_destroy(RegisteredFeatureExtractors *rfe)
 {
     if (!rfe) return;
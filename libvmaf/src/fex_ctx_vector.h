@@ -19,6 +19,8 @@
 #ifndef __VMAF_SRC_FEX_CTX_VECTOR_H__
 #define __VMAF_SRC_FEX_CTX_VECTOR_H__
 
+#include <stdbool.h>
+
 #include "feature/feature_extractor.h"
 
 typedef struct {
@@ -32,6 +34,19 @@ int feature_extractor_vector_append(RegisteredFeatureExtractors *rfe,
                                     VmafFeatureExtractorContext *fex_ctx,
                                     uint64_t flags);
 
+/**
+ * Check whether at least two registered feature extractors fetch the same
+ * picture artifact, see VmafFeatureExtractor.artifacts.
+ */
+bool feature_extractor_vector_shares_artifacts(RegisteredFeatureExtractors *rfe);
+
+/**
+ * Attach an artifact cache to `pic` and declare every artifact the
+ * registered feature extractors fetch, once per feature extractor.
+ */
+int feature_extractor_vector_declare_artifacts(RegisteredFeatureExtractors *rfe,
+                                               VmafPicture *pic);
+
 void feature_extractor_vector_destroy(RegisteredFeatureExtractors *rfe);
 
 #endif /* __VMAF_SRC_FEX_CTX_VECTOR_H__ */
@@ -23,6 +23,8 @@
 #include <stdlib.h>
 #include "framesync.h"
 
+#define FRAME_SYNC_INITIAL_DEPTH 8
+
 enum {
     BUF_FREE = 0,
     BUF_ACQUIRED,
@@ -32,195 +34,229 @@ enum {
 
 typedef struct VmafFrameSyncBuf {
     void *frame_data;
+    unsigned data_sz;
     int buf_status;
-    signed long index;
-    struct VmafFrameSyncBuf *next;
+    unsigned index;
+    pthread_cond_t filled;
 } VmafFrameSyncBuf;
 
+/*
+ * The buffer of frame `index` lives in slot `index % depth`, until it is
+ * released. Data buffers stay with their slot and are reused. If a slot is
+ * still taken by another frame, the ring is doubled instead of waiting,
+ * since the data of a frame may never be retrieved. Frames which were in
+ * distinct slots stay in distinct slots when the depth is doubled.
+ */
 typedef struct VmafFrameSyncContext {
-    VmafFrameSyncBuf *buf_que;
-    pthread_mutex_t acquire_lock;
-    pthread_mutex_t retrieve_lock;
-    pthread_cond_t retrieve;
-    unsigned buf_cnt;
+    VmafFrameSyncBuf **buf;
+    unsigned depth;
+    pthread_mutex_t lock;
 } VmafFrameSyncContext;
 
+static VmafFrameSyncBuf *framesync_buf_alloc(void)
+{
+    VmafFrameSyncBuf *buf = malloc(sizeof(*buf));
+    if (!buf) return NULL;
+    memset(buf, 0, sizeof(*buf));
+    buf->buf_status = BUF_FREE;
+    pthread_cond_init(&(buf->filled), NULL);
+    return buf;
+}
+
+static void framesync_buf_free(VmafFrameSyncBuf *buf)
+{
+    pthread_cond_destroy(&(buf->filled));
+    free(buf->frame_data);
+    free(buf);
+}
+
+static int framesync_grow(VmafFrameSyncContext *fs_ctx)
+{
+    const unsigned old_depth = fs_ctx->depth;
+    const unsigned depth = old_depth * 2;
+    VmafFrameSyncBuf **buf = calloc(depth, sizeof(*buf));
+    VmafFrameSyncBuf **new_buf = calloc(old_depth, sizeof(*new_buf));
+    if (!buf || !new_buf) goto fail;
+    for (unsigned i = 0; i < old_depth; i++) {
+        if (!(new_buf[i] = framesync_buf_alloc()))
+            goto fail;
+    }
+
+    // taken buffers move to their new slots, free and new buffers fill the
+    // remaining ones
+    for (unsigned i = 0; i < old_depth; i++) {
+        VmafFrameSyncBuf *b = fs_ctx->buf[i];
+        if (b->buf_status != BUF_FREE)
+            buf[b->index % depth] = b;
+    }
+    for (unsigned i = 0, j = 0, k = 0; i < depth; i++) {
+        if (buf[i]) continue;
+        while (j < old_depth && fs_ctx->buf[j]->buf_status != BUF_FREE) j++;
+        buf[i] = j < old_depth ? fs_ctx->buf[j++] : new_buf[k++];
+    }
+
+    // waiters may have to wait on another slot now
+    for (unsigned i = 0; i < old_depth; i++)
+        pthread_cond_broadcast(&(fs_ctx->buf[i]->filled));
+
+    free(fs_ctx->buf);
+    free(new_buf);
+    fs_ctx->buf = buf;
+    fs_ctx->depth = depth;
+    return 0;
+
+fail:
+    for (unsigned i = 0; new_buf && i < old_depth && new_buf[i]; i++)
+        framesync_buf_free(new_buf[i]);
+    free(new_buf);
+    free(buf);
+    return -ENOMEM;
+}
+
 int vmaf_framesync_init(VmafFrameSyncContext **fs_ctx)
 {
     VmafFrameSyncContext *const ctx = *fs_ctx = malloc(sizeof(VmafFrameSyncContext));
     if (!ctx) return -ENOMEM;
     memset(ctx, 0, sizeof(VmafFrameSyncContext));
-    ctx->buf_cnt = 1;
 
-    pthread_mutex_init(&(ctx->acquire_lock), NULL);
-    pthread_mutex_init(&(ctx->retrieve_lock), NULL);
-    pthread_cond_init(&(ctx->retrieve), NULL);
+    ctx->depth = FRAME_SYNC_INITIAL_DEPTH;
+    ctx->buf = calloc(ctx->depth, sizeof(*ctx->buf));
+    if (!ctx->buf) goto free_ctx;
+    for (unsigned i = 0; i < ctx->depth; i++) {
+        if (!(ctx->buf[i] = framesync_buf_alloc()))
+            goto free_buf;
+    }
 
-    VmafFrameSyncBuf *buf_que = ctx->buf_que = malloc(sizeof(VmafFrameSyncBuf));
+    pthread_mutex_init(&(ctx->lock), NULL);
+    return 0;
 
-    buf_que->frame_data = NULL;
-    buf_que->buf_status = BUF_FREE;
-    buf_que->index = -1;
-    buf_que->next  = NULL;
+free_buf:
+    for (unsigned i = 0; i < ctx->depth && ctx->buf[i]; i++)
+        framesync_buf_free(ctx->buf[i]);
+    free(ctx->buf);
+free_ctx:
+    free(ctx);
+    return -ENOMEM;
+}
 
-    return 0;
+static VmafFrameSyncBuf *framesync_buf(VmafFrameSyncContext *fs_ctx,
+                                       unsigned index, int buf_status)
+{
+    VmafFrameSyncBuf *buf = fs_ctx->buf[index % fs_ctx->depth];
+    if (buf->buf_status != buf_status || buf->index != index)
+        return NULL;
+    return buf;
 }
 
 int vmaf_framesync_acquire_new_buf(VmafFrameSyncContext *fs_ctx, void **data,
                                    unsigned data_sz, unsigned index)
 {
-    VmafFrameSyncBuf *buf_que = fs_ctx->buf_que;
+    if (!fs_ctx) return -EINVAL;
+    if (!data) return -EINVAL;
     *data = NULL;
 
-    pthread_mutex_lock(&(fs_ctx->acquire_lock));
-
-    // traverse until a free buffer is found
-    for (unsigned i = 0; i < fs_ctx->buf_cnt; i++) {
-        if (buf_que->buf_status == BUF_FREE) {
-            buf_que->frame_data = *data = malloc(data_sz);
-            if (!buf_que->frame_data)
-                return -ENOMEM;
-            buf_que->buf_status = BUF_ACQUIRED;
-            buf_que->index = index;
-            break;
+    pthread_mutex_lock(&(fs_ctx->lock));
+    int err = 0;
+
+    VmafFrameSyncBuf *buf;
+    while ((buf = fs_ctx->buf[index % fs_ctx->depth])->buf_status != BUF_FREE) {
+        if (buf->index == index) {
+            err = -EINVAL;
+            goto unlock;
         }
-        // move to next node
-        if (buf_que->next != NULL)
-            buf_que = buf_que->next;
+        err = framesync_grow(fs_ctx);
+        if (err) goto unlock;
     }
 
-    // create a new node if all nodes are occupied in the list and append to the tail
-    if (*data == NULL) {
-        VmafFrameSyncBuf *new_buf_node = malloc(sizeof(VmafFrameSyncBuf));
-        buf_que->next = new_buf_node;
-        new_buf_node->buf_status = BUF_FREE;
-        new_buf_node->index = -1;
-        new_buf_node->next = NULL;
-        fs_ctx->buf_cnt++;
-
-        new_buf_node->frame_data = *data = malloc(data_sz);
-        if (!new_buf_node->frame_data)
-            return -ENOMEM;
-        new_buf_node->buf_status = BUF_ACQUIRED;
-        new_buf_node->index = index;
+    if (buf->data_sz < data_sz) {
+        void *frame_data = malloc(data_sz);
+        if (!frame_data) {
+            err = -ENOMEM;
+            goto unlock;
+        }
+        free(buf->frame_data);
+        buf->frame_data = frame_data;
+        buf->data_sz = data_sz;
     }
+    buf->buf_status = BUF_ACQUIRED;
+    buf->index = index;
+    *data = buf->frame_data;
 
-    pthread_mutex_unlock(&(fs_ctx->acquire_lock));
-
-    return 0;
+unlock:
+    pthread_mutex_unlock(&(fs_ctx->lock));
+    return err;
 }
 
 int vmaf_framesync_submit_filled_data(VmafFrameSyncContext *fs_ctx, void *data,
                                       unsigned index)
 {
-    VmafFrameSyncBuf *buf_que = fs_ctx->buf_que;
-
-    pthread_mutex_lock(&(fs_ctx->retrieve_lock));
+    if (!fs_ctx) return -EINVAL;
 
-    // loop until a matchng buffer is found
-    for (unsigned i = 0; i < fs_ctx->buf_cnt; i++) {
-        if ((buf_que->index == index) && (buf_que->buf_status == BUF_ACQUIRED)) {
-            buf_que->buf_status = BUF_FILLED;
-            if (data != buf_que->frame_data)
-                return -1;
-            break;
-        }
+    pthread_mutex_lock(&(fs_ctx->lock));
+    int err = 0;
 
-        // move to next node
-        if (NULL != buf_que->next)
-            buf_que = buf_que->next;
+    VmafFrameSyncBuf *buf = framesync_buf(fs_ctx, index, BUF_ACQUIRED);
+    if (!buf || data != buf->frame_data) {
+        err = -EINVAL;
+        goto unlock;
     }
+    buf->buf_status = BUF_FILLED;
+    pthread_cond_broadcast(&(buf->filled));
 
-    pthread_cond_broadcast(&(fs_ctx->retrieve));
-    pthread_mutex_unlock(&(fs_ctx->retrieve_lock));
-
-    return 0;
+unlock:
+    pthread_mutex_unlock(&(fs_ctx->lock));
+    return err;
 }
 
 int vmaf_framesync_retrieve_filled_data(VmafFrameSyncContext *fs_ctx,
                                         void **data, unsigned index)
 {
-    *data = NULL;
-
-    while (*data == NULL) {
-        VmafFrameSyncBuf *buf_que = fs_ctx->buf_que;
-        pthread_mutex_lock(&(fs_ctx->retrieve_lock));
-        // loop until a free buffer is found
-        for (unsigned i = 0; i < fs_ctx->buf_cnt; i++) {
-            if ((buf_que->index == index) && (buf_que->buf_status == BUF_FILLED)) {
-                buf_que->buf_status = BUF_RETRIEVED;
-                *data = buf_que->frame_data;
-                break;
-            }
-
-            // move to next node
-            if (NULL != buf_que->next)
-                buf_que = buf_que->next;
-        }
+    if (!fs_ctx) return -EINVAL;
+    if (!data) return -EINVAL;
 
-        if (*data == NULL)
-            pthread_cond_wait(&(fs_ctx->retrieve), &(fs_ctx->retrieve_lock));
+    pthread_mutex_lock(&(fs_ctx->lock));
 
-        pthread_mutex_unlock(&(fs_ctx->retrieve_lock));
+    VmafFrameSyncBuf *buf;
+    while (!(buf = framesync_buf(fs_ctx, index, BUF_FILLED))) {
+        pthread_cond_wait(&(fs_ctx->buf[index % fs_ctx->depth]->filled),
+                          &(fs_ctx->lock));
     }
+    buf->buf_status = BUF_RETRIEVED;
+    *data = buf->frame_data;
 
+    pthread_mutex_unlock(&(fs_ctx->lock));
     return 0;
 }
 
 int vmaf_framesync_release_buf(VmafFrameSyncContext *fs_ctx, void *data,
                                unsigned index)
 {
-    VmafFrameSyncBuf *buf_que = fs_ctx->buf_que;
-
-    pthread_mutex_lock(&(fs_ctx->acquire_lock));
-    // loop until a matching buffer is found
-    for (unsigned i = 0; i < fs_ctx->buf_cnt; i++) {
-        if ((buf_que->index == index) && (buf_que->buf_status == BUF_RETRIEVED)) {
-            if (data != buf_que->frame_data)
-                return -1;
-
-            free(buf_que->frame_data);
-            buf_que->frame_data = NULL;
-            buf_que->buf_status = BUF_FREE;
-            buf_que->index = -1;
-            break;
-        }
+    if (!fs_ctx) return -EINVAL;
+
+    pthread_mutex_lock(&(fs_ctx->lock));
+    int err = 0;
 
-        // move to next node
-        if (NULL != buf_que->next)
-            buf_que = buf_que->next;
+    // the data buffer stays with the slot, for the next frame
+    VmafFrameSyncBuf *buf = framesync_buf(fs_ctx, index, BUF_RETRIEVED);
+    if (!buf || data != buf->frame_data) {
+        err = -EINVAL;
+        goto unlock;
     }
+    buf->buf_status = BUF_FREE;
 
-    pthread_mutex_unlock(&(fs_ctx->acquire_lock));
-    return 0;
+unlock:
+    pthread_mutex_unlock(&(fs_ctx->lock));
+    return err;
 }
 
 int vmaf_framesync_destroy(VmafFrameSyncContext *fs_ctx)
 {
-    VmafFrameSyncBuf *buf_que = fs_ctx->buf_que;
-    VmafFrameSyncBuf *buf_que_tmp;
-
-    pthread_mutex_destroy(&(fs_ctx->acquire_lock));
-    pthread_mutex_destroy(&(fs_ctx->retrieve_lock));
-    pthread_cond_destroy(&(fs_ctx->retrieve));
-
-    //check for any data buffers which are not freed
-    for (unsigned i = 0; i < fs_ctx->buf_cnt; i++) {
-        if (NULL != buf_que->frame_data) {
-            free(buf_que->frame_data);
-            buf_que->frame_data = NULL;
-        }
-
-        // move to next node
-        if (NULL != buf_que->next) {
-            buf_que_tmp = buf_que;
-            buf_que = buf_que->next;
-            free(buf_que_tmp);
-        } else {
-            free(buf_que);
-        }
-    }
+    if (!fs_ctx) return -EINVAL;
 
+    for (unsigned i = 0; i < fs_ctx->depth; i++)
+        framesync_buf_free(fs_ctx->buf[i]);
+    free(fs_ctx->buf);
+    pthread_mutex_destroy(&(fs_ctx->lock));
     free(fs_ctx);
 
     return 0;
@@ -270,6 +270,30 @@ int vmaf_close(VmafContext *vmaf)
     return 0;
 }
 
+int vmaf_set_mem_budget(VmafContext *vmaf, uint64_t mem_budget)
+{
+    if (!vmaf) return -EINVAL;
+    if (!vmaf->fex_ctx_pool) return 0;
+
+    return vmaf_fex_ctx_pool_set_mem_budget(vmaf->fex_ctx_pool,
+                mem_budget > SIZE_MAX ? SIZE_MAX : mem_budget);
+}
+
+int vmaf_share_thread_pool(VmafContext *dst, VmafContext *src)
+{
+    if (!dst) return -EINVAL;
+    if (!src) return -EINVAL;
+    if (!dst->thread_pool || !src->thread_pool) return -EINVAL;
+    if (dst->pic_cnt) return -EINVAL;
+    if (dst->thread_pool == src->thread_pool) return 0;
+
+    int err = vmaf_thread_pool_ref(src->thread_pool);
+    if (err) return err;
+    vmaf_thread_pool_destroy(dst->thread_pool);
+    dst->thread_pool = src->thread_pool;
+    return 0;
+}
+
 int vmaf_import_feature_score(VmafContext *vmaf, const char *feature_name,
                               double value, unsigned index)
 {
@@ -665,6 +689,15 @@ int vmaf_read_pictures(VmafContext *vmaf, VmafPicture *ref, VmafPicture *dist,
     err = validate_pic_params(vmaf, ref, dist);
     if (err) return err;
 
+    RegisteredFeatureExtractors *rfe = &vmaf->registered_feature_extractors;
+    if (feature_extractor_vector_shares_artifacts(rfe)) {
+        // a reference shared by vmaf_read_pictures_multi() is declared there
+        if (!vmaf_picture_artifact_cache_enabled(ref))
+            err = feature_extractor_vector_declare_artifacts(rfe, ref);
+        if (!err) err = feature_extractor_vector_declare_artifacts(rfe, dist);
+        if (err) return err;
+    }
+
 #ifdef HAVE_CUDA
     err = check_ring_buffer(vmaf);
     if (err) return err;
@@ -744,6 +777,70 @@ int vmaf_read_pictures(VmafContext *vmaf, VmafPicture *ref, VmafPicture *dist,
     return err;
 }
 
+int vmaf_read_pictures_multi(VmafContext **vmaf, unsigned cnt,
+                             VmafPicture *ref, VmafPicture *dist,
+                             unsigned index)
+{
+    if (!vmaf) return -EINVAL;
+    if (!cnt) return -EINVAL;
+    if (!ref != !dist) return -EINVAL;
+
+    int err = 0;
+
+    if (!ref && !dist) {
+        for (unsigned i = 0; i < cnt; i++)
+            err |= vmaf_read_pictures(vmaf[i], NULL, NULL, index);
+        return err;
+    }
+
+    for (unsigned i = 0; cnt > 1 && i < cnt; i++) {
+        err = feature_extractor_vector_declare_artifacts(
+                &vmaf[i]->registered_feature_extractors, ref);
+        if (err) return err;
+    }
+
+    unsigned i;
+    for (i = 0; i < cnt; i++) {
+        VmafPicture pic;
+        vmaf_picture_ref(&pic, ref);
+        err = vmaf_read_pictures(vmaf[i], &pic, &dist[i], index);
+        if (err) {
+            vmaf_picture_unref(&pic);
+            vmaf_picture_unref(&dist[i]);
+            break;
+        }
+    }
+
+    while (++i < cnt)
+        vmaf_picture_unref(&dist[i]);
+
+    return err | vmaf_picture_unref(ref);
+}
+
+int vmaf_merge_feature_scores(VmafContext *dst, VmafContext *src,
+                              unsigned index_low, unsigned index_high)
+{
+    if (!dst) return -EINVAL;
+    if (!src) return -EINVAL;
+    if (index_low > index_high) return -EINVAL;
+
+    int err = vmaf_feature_collector_merge(dst->feature_collector,
+                                           src->feature_collector,
+                                           index_low, index_high);
+    if (err) return err;
+
+    if (!dst->pic_params.w) {
+        dst->pic_params.w = src->pic_params.w;
+        dst->pic_params.h = src->pic_params.h;
+        dst->pic_params.pix_fmt = src->pic_params.pix_fmt;
+        dst->pic_params.bpc = src->pic_params.bpc;
+    }
+    if (dst->pic_cnt < index_high + 1)
+        dst->pic_cnt = index_high + 1;
+
+    return 0;
+}
+
 int vmaf_register_metadata_handler(VmafContext *vmaf, VmafMetadataConfiguration cfg)
 {
     if (!vmaf) return -EINVAL;
@@ -22,6 +22,8 @@
 #include <stdlib.h>
 #include "mem.h"
 
+static _Thread_local size_t thread_allocated;
+
 void *aligned_malloc(size_t size, size_t alignment)
 {
 	void *ptr;
@@ -32,8 +34,9 @@ void *aligned_malloc(size_t size, size_t alignment)
     if (posix_memalign(&ptr, alignment, size))
 #endif
 		return 0;
-	else
-		return ptr;
+
+	thread_allocated += size;
+	return ptr;
 }
 
 void aligned_free(void *ptr)
@@ -44,3 +47,8 @@ void aligned_free(void *ptr)
 	free(ptr);
 #endif
 }
+
+size_t aligned_malloc_thread_total(void)
+{
+	return thread_allocated;
+}
@@ -30,4 +30,11 @@ void *aligned_malloc(size_t size, size_t alignment);
 
 void aligned_free(void *ptr);
 
+/**
+ * Total number of bytes allocated with aligned_malloc() by the calling
+ * thread, never decreases. Used to measure what a feature extractor
+ * allocates in init(), where its frame sized buffers are allocated.
+ */
+size_t aligned_malloc_thread_total(void);
+
 #endif /* __VMAF_MEM_H__ */
@@ -17,6 +17,7 @@
  */
 
 #include <errno.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -27,6 +28,27 @@
 
 #define DATA_ALIGN 32
 
+typedef struct VmafPictureArtifact {
+    char *key;
+    size_t size;
+    void *data;
+    int ready;
+    struct VmafPictureArtifact *next;
+} VmafPictureArtifact;
+
+typedef struct VmafPictureArtifactUse {
+    char *key;
+    unsigned cnt;
+    struct VmafPictureArtifactUse *next;
+} VmafPictureArtifactUse;
+
+struct VmafPictureArtifactCache {
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    VmafPictureArtifact *head;
+    VmafPictureArtifactUse *uses;
+};
+
 static int default_release_picture(VmafPicture *pic, void *cookie)
 {
     (void) cookie;
@@ -56,15 +78,10 @@ int vmaf_picture_priv_init(VmafPicture *pic)
     return 0;
 }
 
-int vmaf_picture_alloc(VmafPicture *pic, enum VmafPixelFormat pix_fmt,
-                       unsigned bpc, unsigned w, unsigned h)
+static void picture_set_geometry(VmafPicture *pic,
+                                 enum VmafPixelFormat pix_fmt, unsigned bpc,
+                                 unsigned w, unsigned h)
 {
-    if (!pic) return -EINVAL;
-    if (!pix_fmt) return -EINVAL;
-    if (bpc < 8 || bpc > 16) return -EINVAL;
-
-    int err = 0;
-
     memset(pic, 0, sizeof(*pic));
     pic->pix_fmt = pix_fmt;
     pic->bpc = bpc;
@@ -76,6 +93,18 @@ int vmaf_picture_alloc(VmafPicture *pic, enum VmafPixelFormat pix_fmt,
     pic->h[1] = pic->h[2] = h >> ss_ver;
     if (pic->pix_fmt == VMAF_PIX_FMT_YUV400P)
         pic->w[1] = pic->w[2] = pic->h[1] = pic->h[2] = 0;
+}
+
+int vmaf_picture_alloc(VmafPicture *pic, enum VmafPixelFormat pix_fmt,
+                       unsigned bpc, unsigned w, unsigned h)
+{
+    if (!pic) return -EINVAL;
+    if (!pix_fmt) return -EINVAL;
+    if (bpc < 8 || bpc > 16) return -EINVAL;
+
+    int err = 0;
+
+    picture_set_geometry(pic, pix_fmt, bpc, w, h);
 
     const int aligned_y = (pic->w[0] + DATA_ALIGN - 1) & ~(DATA_ALIGN - 1);
     const int aligned_c = (pic->w[1] + DATA_ALIGN - 1) & ~(DATA_ALIGN - 1);
@@ -112,6 +141,49 @@ fail:
     return -ENOMEM;
 }
 
+int vmaf_picture_wrap(VmafPicture *pic, enum VmafPixelFormat pix_fmt,
+                      unsigned bpc, unsigned w, unsigned h,
+                      void *const data[3], const ptrdiff_t stride[3],
+                      void *cookie,
+                      int (*release_picture)(VmafPicture *pic, void *cookie))
+{
+    if (!pic) return -EINVAL;
+    if (!pix_fmt) return -EINVAL;
+    if (bpc < 8 || bpc > 16) return -EINVAL;
+    if (!w || !h) return -EINVAL;
+    if (!data || !stride) return -EINVAL;
+    if (!release_picture) return -EINVAL;
+
+    VmafPicture tmp;
+    picture_set_geometry(&tmp, pix_fmt, bpc, w, h);
+
+    const int hbd = bpc > 8;
+    const unsigned n_planes = pix_fmt == VMAF_PIX_FMT_YUV400P ? 1 : 3;
+    for (unsigned p = 0; p < n_planes; p++) {
+        if (!data[p]) return -EINVAL;
+        if (stride[p] < ((ptrdiff_t) tmp.w[p] << hbd)) return -EINVAL;
+        // samples are read as uint16_t
+        if (hbd && (((uintptr_t) data[p] | (uintptr_t) stride[p]) & 1))
+            return -EINVAL;
+        tmp.data[p] = data[p];
+        tmp.stride[p] = stride[p];
+    }
+
+    int err = vmaf_picture_priv_init(&tmp);
+    if (err) return -ENOMEM;
+    err = vmaf_picture_set_release_callback(&tmp, cookie, release_picture);
+    if (err) goto free_priv;
+    err = vmaf_ref_init(&tmp.ref);
+    if (err) goto free_priv;
+
+    *pic = tmp;
+    return 0;
+
+free_priv:
+    free(tmp.priv);
+    return -ENOMEM;
+}
+
 int vmaf_picture_ref(VmafPicture *dst, VmafPicture *src) {
     if (!dst || !src) return -EINVAL;
 
@@ -120,16 +192,217 @@ int vmaf_picture_ref(VmafPicture *dst, VmafPicture *src) {
     return 0;
 }
 
+int vmaf_picture_artifact_cache_init(VmafPicture *pic)
+{
+    if (!pic) return -EINVAL;
+    if (!pic->priv) return -EINVAL;
+
+    VmafPicturePrivate *priv = pic->priv;
+    if (priv->artifact_cache) return 0;
+
+    VmafPictureArtifactCache *cache = malloc(sizeof(*cache));
+    if (!cache) return -ENOMEM;
+    memset(cache, 0, sizeof(*cache));
+    pthread_mutex_init(&cache->lock, NULL);
+    pthread_cond_init(&cache->ready, NULL);
+    priv->artifact_cache = cache;
+
+    return 0;
+}
+
+int vmaf_picture_artifact_cache_enabled(VmafPicture *pic)
+{
+    if (!pic || !pic->priv) return 0;
+    VmafPicturePrivate *priv = pic->priv;
+    return !!priv->artifact_cache;
+}
+
+static VmafPictureArtifactUse *artifact_use_find(VmafPictureArtifactCache *cache,
+                                                 const char *key)
+{
+    for (VmafPictureArtifactUse *u = cache->uses; u; u = u->next) {
+        if (!strcmp(u->key, key))
+            return u;
+    }
+    return NULL;
+}
+
+int vmaf_picture_artifact_declare(VmafPicture *pic, const char *key)
+{
+    if (!pic || !pic->priv) return -EINVAL;
+    if (!key) return -EINVAL;
+
+    VmafPicturePrivate *priv = pic->priv;
+    VmafPictureArtifactCache *cache = priv->artifact_cache;
+    if (!cache) return -EINVAL;
+
+    pthread_mutex_lock(&cache->lock);
+
+    VmafPictureArtifactUse *use = artifact_use_find(cache, key);
+    if (!use) {
+        use = malloc(sizeof(*use));
+        if (!use) goto fail;
+        memset(use, 0, sizeof(*use));
+        use->key = malloc(strlen(key) + 1);
+        if (!use->key) goto free_use;
+        strcpy(use->key, key);
+        use->next = cache->uses;
+        cache->uses = use;
+    }
+    use->cnt++;
+
+    pthread_mutex_unlock(&cache->lock);
+    return 0;
+
+free_use:
+    free(use);
+fail:
+    pthread_mutex_unlock(&cache->lock);
+    return -ENOMEM;
+}
+
+int vmaf_picture_artifact_shared(VmafPicture *pic, const char *key)
+{
+    if (!pic || !pic->priv) return 0;
+    if (!key) return 0;
+
+    VmafPicturePrivate *priv = pic->priv;
+    VmafPictureArtifactCache *cache = priv->artifact_cache;
+    if (!cache) return 0;
+
+    pthread_mutex_lock(&cache->lock);
+    VmafPictureArtifactUse *use = artifact_use_find(cache, key);
+    const int shared = use && use->cnt > 1;
+    pthread_mutex_unlock(&cache->lock);
+    return shared;
+}
+
+static void artifact_cache_close(VmafPictureArtifactCache *cache)
+{
+    VmafPictureArtifact *artifact = cache->head;
+    while (artifact) {
+        VmafPictureArtifact *next = artifact->next;
+        aligned_free(artifact->data);
+        free(artifact->key);
+        free(artifact);
+        artifact = next;
+    }
+    VmafPictureArtifactUse *use = cache->uses;
+    while (use) {
+        VmafPictureArtifactUse *next = use->next;
+        free(use->key);
+        free(use);
+        use = next;
+    }
+    pthread_cond_destroy(&cache->ready);
+    pthread_mutex_destroy(&cache->lock);
+    free(cache);
+}
+
+static VmafPictureArtifact *artifact_find(VmafPictureArtifactCache *cache,
+                                          const char *key)
+{
+    for (VmafPictureArtifact *a = cache->head; a; a = a->next) {
+        if (!strcmp(a->key, key))
+            return a;
+    }
+    return NULL;
+}
+
+static void artifact_remove(VmafPictureArtifactCache *cache,
+                            VmafPictureArtifact *artifact)
+{
+    VmafPictureArtifact **a = &cache->head;
+    while (*a != artifact)
+        a = &(*a)->next;
+    *a = artifact->next;
+    aligned_free(artifact->data);
+    free(artifact->key);
+    free(artifact);
+}
+
+int vmaf_picture_artifact_get(VmafPicture *pic, const char *key, size_t size,
+                              int (*produce)(void *data, void *cookie),
+                              void *cookie, const void **data)
+{
+    if (!pic || !pic->priv) return -EINVAL;
+    if (!key) return -EINVAL;
+    if (!size) return -EINVAL;
+    if (!produce) return -EINVAL;
+    if (!data) return -EINVAL;
+
+    VmafPicturePrivate *priv = pic->priv;
+    VmafPictureArtifactCache *cache = priv->artifact_cache;
+    if (!cache) return -EINVAL;
+
+    pthread_mutex_lock(&cache->lock);
+
+    VmafPictureArtifact *artifact;
+    while ((artifact = artifact_find(cache, key)) && !artifact->ready)
+        pthread_cond_wait(&cache->ready, &cache->lock);
+
+    if (artifact) {
+        pthread_mutex_unlock(&cache->lock);
+        if (artifact->size != size) return -EINVAL;
+        *data = artifact->data;
+        return 0;
+    }
+
+    artifact = malloc(sizeof(*artifact));
+    if (!artifact) goto fail;
+    memset(artifact, 0, sizeof(*artifact));
+    artifact->size = size;
+    artifact->key = malloc(strlen(key) + 1);
+    if (!artifact->key) goto free_artifact;
+    strcpy(artifact->key, key);
+    artifact->data = aligned_malloc(size, DATA_ALIGN);
+    if (!artifact->data) goto free_key;
+    artifact->next = cache->head;
+    cache->head = artifact;
+
+    pthread_mutex_unlock(&cache->lock);
+    int err = produce(artifact->data, cookie);
+    pthread_mutex_lock(&cache->lock);
+
+    if (err)
+        artifact_remove(cache, artifact);
+    else
+        artifact->ready = 1;
+    pthread_cond_broadcast(&cache->ready);
+    pthread_mutex_unlock(&cache->lock);
+
+    if (err) return err;
+    *data = artifact->data;
+    return 0;
+
+free_key:
+    free(artifact->key);
+free_artifact:
+    free(artifact);
+fail:
+    pthread_mutex_unlock(&cache->lock);
+    return -ENOMEM;
+}
+
 int vmaf_picture_unref(VmafPicture *pic) {
     if (!pic) return -EINVAL;
     if (!pic->ref) return -EINVAL;
 
     const long old_cnt = vmaf_ref_fetch_decrement(pic->ref);
     if (old_cnt == 1) {
-        const VmafPicturePrivate *priv = pic->priv;
-        priv->release_picture(pic, priv->cookie);
-        free(pic->priv);
-        vmaf_ref_close(pic->ref);
+        VmafPicturePrivate *priv = pic->priv;
+        if (priv->artifact_cache) {
+            artifact_cache_close(priv->artifact_cache);
+            priv->artifact_cache = NULL;
+        }
+        if (priv->pooled) {
+            // priv and ref may be reused as soon as the pool has them back
+            priv->release_picture(pic, priv->cookie);
+        } else {
+            priv->release_picture(pic, priv->cookie);
+            free(pic->priv);
+            vmaf_ref_close(pic->ref);
+        }
     }
     memset(pic, 0, sizeof(*pic));
     return 0;
@@ -19,6 +19,8 @@
 #ifndef __VMAF_SRC_PICTURE_H__
 #define __VMAF_SRC_PICTURE_H__
 
+#include <stdbool.h>
+
 #ifdef HAVE_CUDA
 #include <cuda.h>
 #include "libvmaf/libvmaf_cuda.h"
@@ -31,6 +33,8 @@ enum VmafPictureBufferType {
     VMAF_PICTURE_BUFFER_TYPE_CUDA_DEVICE,
 };
 
+typedef struct VmafPictureArtifactCache VmafPictureArtifactCache;
+
 typedef struct VmafPicturePrivate {
     void *cookie;
     int (*release_picture)(VmafPicture *pic, void *cookie);
@@ -42,6 +46,9 @@ typedef struct VmafPicturePrivate {
     } cuda;
 #endif
     enum VmafPictureBufferType buf_type;
+    VmafPictureArtifactCache *artifact_cache;
+    // owned by a VmafPicturePool, which keeps priv and ref for reuse
+    bool pooled;
 } VmafPicturePrivate;
 
 int vmaf_picture_priv_init(VmafPicture *pic);
@@ -51,4 +58,38 @@ int vmaf_picture_ref(VmafPicture *dst, VmafPicture *src);
 int vmaf_picture_set_release_callback(VmafPicture *pic, void *cookie,
                         int (*release_picture)(VmafPicture *pic, void *cookie));
 
+/**
+ * Attach an artifact cache to a picture which is about to be shared between
+ * several `VmafContext`s. Feature extractors use the cache to compute
+ * intermediates which depend only on this picture (e.g. a blurred or
+ * transformed reference) once, instead of once per context.
+ * The cache, and all artifacts in it, are released with the picture.
+ */
+int vmaf_picture_artifact_cache_init(VmafPicture *pic);
+
+int vmaf_picture_artifact_cache_enabled(VmafPicture *pic);
+
+/**
+ * Declare that one more consumer of `pic` is going to fetch the artifact
+ * named `key`. Consumers are declared before the picture is handed out.
+ */
+int vmaf_picture_artifact_declare(VmafPicture *pic, const char *key);
+
+/**
+ * Check whether more than one consumer declared the artifact named `key`,
+ * i.e. whether fetching it through the cache saves any work. Consumers of
+ * artifacts nobody shares compute them into their own buffers instead.
+ */
+int vmaf_picture_artifact_shared(VmafPicture *pic, const char *key);
+
+/**
+ * Fetch the artifact named `key`, calling `produce` to fill a new buffer of
+ * `size` bytes if it does not exist yet. Concurrent callers asking for the
+ * same `key` block until the first caller has produced it. `key` must
+ * uniquely identify the computation, `size` must match between callers.
+ */
+int vmaf_picture_artifact_get(VmafPicture *pic, const char *key, size_t size,
+                              int (*produce)(void *data, void *cookie),
+                              void *cookie, const void **data);
+
 #endif /* __VMAF_SRC_PICTURE_H__ */
@@ -0,0 +1,137 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "config.h"
+#include "cpu.h"
+#include "picture_import.h"
+#include "libvmaf/picture.h"
+
+#if ARCH_X86
+#include "x86/picture_avx2.h"
+#if HAVE_AVX512
+#include "x86/picture_avx512.h"
+#endif
+#elif ARCH_AARCH64
+#include "arm/picture_neon.h"
+#endif
+
+void picture_import_u8_c(uint16_t *dst, ptrdiff_t dst_stride,
+                         const uint8_t *src, ptrdiff_t src_stride,
+                         unsigned w, unsigned h, unsigned shift)
+{
+    for (unsigned i = 0; i < h; i++) {
+        for (unsigned j = 0; j < w; j++)
+            dst[j] = src[j] << shift;
+        dst += dst_stride / sizeof(*dst);
+        src += src_stride;
+    }
+}
+
+void picture_import_u16_c(uint16_t *dst, ptrdiff_t dst_stride,
+                          const uint16_t *src, ptrdiff_t src_stride,
+                          unsigned w, unsigned h, unsigned shift)
+{
+    for (unsigned i = 0; i < h; i++) {
+        for (unsigned j = 0; j < w; j++)
+            dst[j] = src[j] << shift;
+        dst += dst_stride / sizeof(*dst);
+        src += src_stride / sizeof(*src);
+    }
+}
+
+static void copy_plane(void *dst, ptrdiff_t dst_stride,
+                       const void *src, ptrdiff_t src_stride,
+                       size_t row_sz, unsigned h)
+{
+    if (dst_stride == src_stride) {
+        memcpy(dst, src, dst_stride * (h - 1) + row_sz);
+        return;
+    }
+
+    uint8_t *d = dst;
+    const uint8_t *s = src;
+    for (unsigned i = 0; i < h; i++) {
+        memcpy(d, s, row_sz);
+        d += dst_stride;
+        s += src_stride;
+    }
+}
+
+int vmaf_picture_import_planes(VmafPicture *pic, const void *const data[3],
+                               const ptrdiff_t stride[3], unsigned bpc)
+{
+    if (!pic) return -EINVAL;
+    if (!data || !stride) return -EINVAL;
+    if (bpc < 8 || bpc > pic->bpc) return -EINVAL;
+
+    void (*import_u8)(uint16_t *dst, ptrdiff_t dst_stride,
+                      const uint8_t *src, ptrdiff_t src_stride,
+                      unsigned w, unsigned h, unsigned shift) =
+        picture_import_u8_c;
+    void (*import_u16)(uint16_t *dst, ptrdiff_t dst_stride,
+                       const uint16_t *src, ptrdiff_t src_stride,
+                       unsigned w, unsigned h, unsigned shift) =
+        picture_import_u16_c;
+
+#if ARCH_X86
+    unsigned flags = vmaf_get_cpu_flags();
+    if (flags & VMAF_X86_CPU_FLAG_AVX2) {
+        import_u8 = picture_import_u8_avx2;
+        import_u16 = picture_import_u16_avx2;
+    }
+#if HAVE_AVX512
+    if (flags & VMAF_X86_CPU_FLAG_AVX512) {
+        import_u8 = picture_import_u8_avx512;
+        import_u16 = picture_import_u16_avx512;
+    }
+#endif
+#elif ARCH_AARCH64
+    unsigned flags = vmaf_get_cpu_flags();
+    if (flags & VMAF_ARM_CPU_FLAG_NEON) {
+        import_u8 = picture_import_u8_neon;
+        import_u16 = picture_import_u16_neon;
+    }
+#endif
+
+    const unsigned shift = pic->bpc - bpc;
+    const int src_hbd = bpc > 8;
+    const int dst_hbd = pic->bpc > 8;
+
+    for (unsigned i = 0; i < 3; i++) {
+        if (!pic->data[i] || !pic->w[i] || !pic->h[i]) continue;
+        if (!data[i]) return -EINVAL;
+
+        if (src_hbd == dst_hbd && !shift) {
+            copy_plane(pic->data[i], pic->stride[i], data[i], stride[i],
+                       (size_t) pic->w[i] << dst_hbd, pic->h[i]);
+        } else if (!src_hbd) {
+            import_u8(pic->data[i], pic->stride[i], data[i], stride[i],
+                      pic->w[i], pic->h[i], shift);
+        } else {
+            import_u16(pic->data[i], pic->stride[i], data[i], stride[i],
+                       pic->w[i], pic->h[i], shift);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,185 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem.h"
+#include "picture.h"
+#include "ref.h"
+
+typedef struct VmafPicturePoolEntry {
+    VmafPicture pic;
+    VmafPicturePool *pool;
+    struct VmafPicturePoolEntry *next;
+} VmafPicturePoolEntry;
+
+/*
+ * Released pictures are pushed onto a lock-free stack, since the last
+ * reference is usually dropped by a worker thread. Fetches are serialized
+ * by a mutex: with a single popper, the head of the stack cannot be popped
+ * and pushed again while a pop is in flight, so there is no ABA problem.
+ */
+struct VmafPicturePool {
+    enum VmafPixelFormat pix_fmt;
+    unsigned bpc, w, h;
+    _Atomic(VmafPicturePoolEntry *) free_list;
+    pthread_mutex_t fetch_lock;
+    // one for the owner, and one per picture handed out
+    atomic_int ref_cnt;
+};
+
+static void pool_push(VmafPicturePool *pool, VmafPicturePoolEntry *entry)
+{
+    VmafPicturePoolEntry *head =
+        atomic_load_explicit(&pool->free_list, memory_order_relaxed);
+    do {
+        entry->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(&pool->free_list, &head,
+                                                    entry,
+                                                    memory_order_release,
+                                                    memory_order_relaxed));
+}
+
+static VmafPicturePoolEntry *pool_pop(VmafPicturePool *pool)
+{
+    pthread_mutex_lock(&pool->fetch_lock);
+    VmafPicturePoolEntry *head =
+        atomic_load_explicit(&pool->free_list, memory_order_acquire);
+    while (head &&
+           !atomic_compare_exchange_weak_explicit(&pool->free_list, &head,
+                                                  head->next,
+                                                  memory_order_acquire,
+                                                  memory_order_acquire));
+    pthread_mutex_unlock(&pool->fetch_lock);
+    return head;
+}
+
+static void pool_entry_free(VmafPicturePoolEntry *entry)
+{
+    aligned_free(entry->pic.data[0]);
+    free(entry->pic.priv);
+    vmaf_ref_close(entry->pic.ref);
+    free(entry);
+}
+
+static void pool_unref(VmafPicturePool *pool)
+{
+    if (atomic_fetch_sub(&pool->ref_cnt, 1) != 1)
+        return;
+
+    VmafPicturePoolEntry *entry = atomic_load(&pool->free_list);
+    while (entry) {
+        VmafPicturePoolEntry *next = entry->next;
+        pool_entry_free(entry);
+        entry = next;
+    }
+    pthread_mutex_destroy(&pool->fetch_lock);
+    free(pool);
+}
+
+static int release_pooled_picture(VmafPicture *pic, void *cookie)
+{
+    (void) pic;
+    VmafPicturePoolEntry *entry = cookie;
+    VmafPicturePool *pool = entry->pool;
+
+    // the entry may be fetched again as soon as it is pushed
+    pool_push(pool, entry);
+    pool_unref(pool);
+    return 0;
+}
+
+static int pool_entry_alloc(VmafPicturePool *pool,
+                            VmafPicturePoolEntry **entry)
+{
+    VmafPicturePoolEntry *const e = *entry = malloc(sizeof(*e));
+    if (!e) return -ENOMEM;
+    memset(e, 0, sizeof(*e));
+    e->pool = pool;
+
+    // the samples are only zeroed here, not when the picture is recycled
+    int err = vmaf_picture_alloc(&e->pic, pool->pix_fmt, pool->bpc,
+                                 pool->w, pool->h);
+    if (err) {
+        free(e);
+        return err;
+    }
+    vmaf_picture_set_release_callback(&e->pic, e, release_pooled_picture);
+    VmafPicturePrivate *priv = e->pic.priv;
+    priv->pooled = true;
+
+    return 0;
+}
+
+int vmaf_picture_pool_init(VmafPicturePool **pool,
+                           enum VmafPixelFormat pix_fmt, unsigned bpc,
+                           unsigned w, unsigned h)
+{
+    if (!pool) return -EINVAL;
+    if (!pix_fmt) return -EINVAL;
+    if (bpc < 8 || bpc > 16) return -EINVAL;
+    if (!w || !h) return -EINVAL;
+
+    VmafPicturePool *const p = *pool = malloc(sizeof(*p));
+    if (!p) return -ENOMEM;
+    memset(p, 0, sizeof(*p));
+    p->pix_fmt = pix_fmt;
+    p->bpc = bpc;
+    p->w = w;
+    p->h = h;
+    atomic_init(&p->free_list, NULL);
+    atomic_init(&p->ref_cnt, 1);
+
+    int err = pthread_mutex_init(&p->fetch_lock, NULL);
+    if (err) {
+        free(p);
+        return -ENOMEM;
+    }
+
+    return 0;
+}
+
+int vmaf_picture_pool_fetch(VmafPicturePool *pool, VmafPicture *pic)
+{
+    if (!pool) return -EINVAL;
+    if (!pic) return -EINVAL;
+
+    VmafPicturePoolEntry *entry = pool_pop(pool);
+    if (entry) {
+        vmaf_ref_fetch_increment(entry->pic.ref);
+    } else {
+        int err = pool_entry_alloc(pool, &entry);
+        if (err) return err;
+    }
+
+    atomic_fetch_add(&pool->ref_cnt, 1);
+    *pic = entry->pic;
+    return 0;
+}
+
+int vmaf_picture_pool_close(VmafPicturePool *pool)
+{
+    if (!pool) return -EINVAL;
+
+    pool_unref(pool);
+    return 0;
+}
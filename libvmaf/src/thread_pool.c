@@ -37,6 +37,7 @@ typedef struct VmafTreadPool {
     pthread_cond_t working;
     unsigned n_threads;
     unsigned n_working;
+    unsigned ref_cnt;
     bool stop;
 } VmafThreadPool;
 
@@ -101,6 +102,7 @@ int vmaf_thread_pool_create(VmafThreadPool **pool, unsigned n_threads)
     if (!p) return -ENOMEM;
     memset(p, 0, sizeof(*p));
     p->n_threads = n_threads;
+    p->ref_cnt = 1;
 
     pthread_mutex_init(&(p->queue.lock), NULL);
     pthread_cond_init(&(p->queue.empty), NULL);
@@ -162,11 +164,26 @@ int vmaf_thread_pool_wait(VmafThreadPool *pool)
     pthread_mutex_unlock(&(pool->queue.lock));
     return 0;
 }
+int vmaf_thread_pool_ref(VmafThreadPool *pool)
+{
+    if (!pool) return -EINVAL;
+
+    pthread_mutex_lock(&(pool->queue.lock));
+    pool->ref_cnt++;
+    pthread_mutex_unlock(&(pool->queue.lock));
+    return 0;
+}
+
 int vmaf_thread_pool_destroy(VmafThreadPool *pool)
 {
     if (!pool) return -EINVAL;
     pthread_mutex_lock(&(pool->queue.lock));
 
+    if (--pool->ref_cnt) {
+        pthread_mutex_unlock(&(pool->queue.lock));
+        return 0;
+    }
+
     VmafThreadPoolJob *job = pool->queue.head;
     while (job) {
         VmafThreadPoolJob *next_job = job->next;
@@ -30,6 +30,12 @@ int vmaf_thread_pool_enqueue(VmafThreadPool *pool, void (*func)(void *data),
 
 int vmaf_thread_pool_wait(VmafThreadPool *pool);
 
+/**
+ * Take another reference to `pool`, which is then only destroyed by the
+ * last of the matching calls to `vmaf_thread_pool_destroy()`.
+ */
+int vmaf_thread_pool_ref(VmafThreadPool *pool);
+
 int vmaf_thread_pool_destroy(VmafThreadPool *tpool);
 
 #endif /* __VMAF_THREAD_POOL_H__ */
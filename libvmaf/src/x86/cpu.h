@@ -28,6 +28,8 @@ enum VmafCpuFlags {
     VMAF_X86_CPU_FLAG_AVX512ICL = 1 << 5,
 };
 
+#define VMAF_CPU_FLAG_CNT 6 /* number of VmafCpuFlags */
+
 unsigned vmaf_get_cpu_flags_x86(void);
 
 #endif /* __VMAF_SRC_X86_CPU_H__ */
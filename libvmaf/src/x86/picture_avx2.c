@@ -0,0 +1,68 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <immintrin.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "x86/picture_avx2.h"
+
+void picture_import_u8_avx2(uint16_t *dst, ptrdiff_t dst_stride,
+                            const uint8_t *src, ptrdiff_t src_stride,
+                            unsigned w, unsigned h, unsigned shift)
+{
+    const __m128i count = _mm_cvtsi32_si128(shift);
+    const unsigned w32 = w & ~31u;
+
+    for (unsigned i = 0; i < h; i++) {
+        unsigned j = 0;
+        for (; j < w32; j += 32) {
+            __m256i s = _mm256_loadu_si256((const __m256i*)(src + j));
+            __m256i lo = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(s));
+            __m256i hi = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(s, 1));
+            _mm256_storeu_si256((__m256i*)(dst + j), _mm256_sll_epi16(lo, count));
+            _mm256_storeu_si256((__m256i*)(dst + j + 16), _mm256_sll_epi16(hi, count));
+        }
+        for (; j < w; j++)
+            dst[j] = src[j] << shift;
+        dst += dst_stride / sizeof(*dst);
+        src += src_stride;
+    }
+}
+
+void picture_import_u16_avx2(uint16_t *dst, ptrdiff_t dst_stride,
+                             const uint16_t *src, ptrdiff_t src_stride,
+                             unsigned w, unsigned h, unsigned shift)
+{
+    const __m128i count = _mm_cvtsi32_si128(shift);
+    const unsigned w32 = w & ~31u;
+
+    for (unsigned i = 0; i < h; i++) {
+        unsigned j = 0;
+        for (; j < w32; j += 32) {
+            __m256i s0 = _mm256_loadu_si256((const __m256i*)(src + j));
+            __m256i s1 = _mm256_loadu_si256((const __m256i*)(src + j + 16));
+            _mm256_storeu_si256((__m256i*)(dst + j), _mm256_sll_epi16(s0, count));
+            _mm256_storeu_si256((__m256i*)(dst + j + 16), _mm256_sll_epi16(s1, count));
+        }
+        for (; j < w; j++)
+            dst[j] = src[j] << shift;
+        dst += dst_stride / sizeof(*dst);
+        src += src_stride / sizeof(*src);
+    }
+}
@@ -0,0 +1,68 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <immintrin.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "x86/picture_avx512.h"
+
+void picture_import_u8_avx512(uint16_t *dst, ptrdiff_t dst_stride,
+                              const uint8_t *src, ptrdiff_t src_stride,
+                              unsigned w, unsigned h, unsigned shift)
+{
+    const __m128i count = _mm_cvtsi32_si128(shift);
+    const unsigned w64 = w & ~63u;
+
+    for (unsigned i = 0; i < h; i++) {
+        unsigned j = 0;
+        for (; j < w64; j += 64) {
+            __m512i s = _mm512_loadu_si512((const void*)(src + j));
+            __m512i lo = _mm512_cvtepu8_epi16(_mm512_castsi512_si256(s));
+            __m512i hi = _mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(s, 1));
+            _mm512_storeu_si512((void*)(dst + j), _mm512_sll_epi16(lo, count));
+            _mm512_storeu_si512((void*)(dst + j + 32), _mm512_sll_epi16(hi, count));
+        }
+        for (; j < w; j++)
+            dst[j] = src[j] << shift;
+        dst += dst_stride / sizeof(*dst);
+        src += src_stride;
+    }
+}
+
+void picture_import_u16_avx512(uint16_t *dst, ptrdiff_t dst_stride,
+                               const uint16_t *src, ptrdiff_t src_stride,
+                               unsigned w, unsigned h, unsigned shift)
+{
+    const __m128i count = _mm_cvtsi32_si128(shift);
+    const unsigned w64 = w & ~63u;
+
+    for (unsigned i = 0; i < h; i++) {
+        unsigned j = 0;
+        for (; j < w64; j += 64) {
+            __m512i s0 = _mm512_loadu_si512((const void*)(src + j));
+            __m512i s1 = _mm512_loadu_si512((const void*)(src + j + 32));
+            _mm512_storeu_si512((void*)(dst + j), _mm512_sll_epi16(s0, count));
+            _mm512_storeu_si512((void*)(dst + j + 32), _mm512_sll_epi16(s1, count));
+        }
+        for (; j < w; j++)
+            dst[j] = src[j] << shift;
+        dst += dst_stride / sizeof(*dst);
+        src += src_stride / sizeof(*src);
+    }
+}
@@ -0,0 +1,98 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+/*
+ * Throughput of the PSNR sum of squared errors kernels on a 1080p plane,
+ * for each dispatch level the host supports. Run with
+ * `meson test --benchmark bench_psnr`.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "feature/integer_psnr.c"
+
+enum { w = 1920, h = 1080, iterations = 200 };
+
+static const struct {
+    const char *name;
+    unsigned flags;
+} level[] = {
+    { "c", 0 },
+#if ARCH_X86
+    { "avx2", VMAF_X86_CPU_FLAG_AVX2 },
+#if HAVE_AVX512
+    { "avx512", VMAF_X86_CPU_FLAG_AVX2 | VMAF_X86_CPU_FLAG_AVX512 },
+#endif
+#elif ARCH_AARCH64
+    { "neon", VMAF_ARM_CPU_FLAG_NEON },
+#endif
+};
+
+static double mpix_per_s(clock_t t0, clock_t t1)
+{
+    const double s = (double) (t1 - t0) / CLOCKS_PER_SEC;
+    return s > 0. ? (double) w * h * iterations / s / 1e6 : 0.;
+}
+
+int main(void)
+{
+    uint8_t *ref_8 = malloc(w * h), *dis_8 = malloc(w * h);
+    uint16_t *ref_16 = malloc(w * h * 2), *dis_16 = malloc(w * h * 2);
+    if (!ref_8 || !dis_8 || !ref_16 || !dis_16) return 1;
+
+    for (unsigned i = 0; i < w * h; i++) {
+        ref_8[i] = rand();
+        dis_8[i] = rand();
+        ref_16[i] = rand() & 0x3FF;
+        dis_16[i] = rand() & 0x3FF;
+    }
+
+    vmaf_init_cpu();
+    const unsigned cpu_flags = vmaf_get_cpu_flags();
+
+    printf("%-8s %16s %16s\n", "level", "8-bit MPix/s", "10-bit MPix/s");
+    for (unsigned l = 0; l < sizeof(level) / sizeof(level[0]); l++) {
+        if ((cpu_flags & level[l].flags) != level[l].flags) continue;
+        vmaf_set_cpu_flags_mask(level[l].flags);
+
+        PsnrState s = { 0 };
+        VmafFeatureExtractor fex = { .priv = &s };
+        if (init(&fex, VMAF_PIX_FMT_YUV400P, 10, w, h)) return 1;
+
+        volatile uint64_t sse = 0;
+        clock_t t0 = clock();
+        for (unsigned i = 0; i < iterations; i++)
+            sse += s.sse_8(ref_8, w, dis_8, w, w, h);
+        clock_t t1 = clock();
+        for (unsigned i = 0; i < iterations; i++)
+            sse += s.sse_16(ref_16, w * 2, dis_16, w * 2, w, h);
+        clock_t t2 = clock();
+
+        printf("%-8s %16.1f %16.1f\n", level[l].name,
+               mpix_per_s(t0, t1), mpix_per_s(t1, t2));
+    }
+
+    free(ref_8);
+    free(dis_8);
+    free(ref_16);
+    free(dis_16);
+    return 0;
+}
@@ -16,6 +16,7 @@
  *
  */
 
+#include <stdint.h>
 #include <stdio.h>
 
 // http://www.jera.com/techinfo/jtns/jtn002.html
@@ -39,5 +40,23 @@
         }                                             \
     } while (0)
 
+/*
+ * Next value of the pseudo random sequence test pictures are filled with,
+ * so that every run sees the same noise.
+ */
+static inline uint32_t test_noise(uint32_t x)
+{
+    return x * 1103515245 + 12345;
+}
+
+/*
+ * Loop over every cpu dispatch level, from scalar code (`level` 0) up to all
+ * the instruction sets in cpu.h, with the cpu flags mask set accordingly.
+ * Restore the mask with vmaf_set_cpu_flags_mask(-1) when done.
+ */
+#define for_each_cpu_level(level)                                   \
+    for (unsigned level = 0; level <= VMAF_CPU_FLAG_CNT &&          \
+         (vmaf_set_cpu_flags_mask((1u << level) - 1), 1); level++)
+
 extern int mu_tests_run;
 char *run_tests(void);
@@ -0,0 +1,220 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "test.h"
+#include "feature/adm.h"
+#include "feature/adm_tools.c"
+
+typedef struct AdmScale {
+    float *data;
+    adm_dwt_band_t_s ref, dis, r, a, csf_a, csf_f;
+    float den_scale, num_scale, sum_cube;
+} AdmScale;
+
+static int adm_scale_init(AdmScale *s, size_t buf_sz_one)
+{
+    float *data = s->data = calloc(20, buf_sz_one);
+    if (!data) return -1;
+    const size_t n = buf_sz_one / sizeof(float);
+    adm_dwt_band_t_s *full[] = { &s->ref, &s->dis };
+    adm_dwt_band_t_s *hvd[] = { &s->r, &s->a, &s->csf_a, &s->csf_f };
+    for (unsigned i = 0; i < 2; i++) {
+        full[i]->band_a = data; data += n;
+        full[i]->band_h = data; data += n;
+        full[i]->band_v = data; data += n;
+        full[i]->band_d = data; data += n;
+    }
+    for (unsigned i = 0; i < 4; i++) {
+        hvd[i]->band_a = NULL;
+        hvd[i]->band_h = data; data += n;
+        hvd[i]->band_v = data; data += n;
+        hvd[i]->band_d = data; data += n;
+    }
+    return 0;
+}
+
+// the finest scale of compute_adm(), keeping every intermediate result
+static void adm_scale(AdmScale *s, const float *ref, const float *dis,
+                      int w, int h, int stride, int buf_stride,
+                      int **ind_y, int **ind_x, double border_factor)
+{
+    dwt2_src_indices_filt_s(ind_y, ind_x, w, h);
+    adm_dwt2_s(ref, &s->ref, ind_y, ind_x, w, h, stride, buf_stride);
+    adm_dwt2_s(dis, &s->dis, ind_y, ind_x, w, h, stride, buf_stride);
+
+    w = (w + 1) / 2;
+    h = (h + 1) / 2;
+    adm_decouple_s(&s->ref, &s->dis, &s->r, &s->a, w, h, buf_stride,
+                   buf_stride, buf_stride, buf_stride, border_factor, 100.0);
+    s->den_scale = adm_csf_den_scale_s(&s->ref, h, 0, w, h, buf_stride,
+                                       border_factor, 3.0, 1080, 0);
+    adm_csf_s(&s->a, &s->csf_a, &s->csf_f, h, 0, w, h, buf_stride,
+              buf_stride, border_factor, 3.0, 1080, 0);
+    s->num_scale = adm_cm_s(&s->r, &s->csf_f, &s->csf_a, w, h, buf_stride,
+                            buf_stride, buf_stride, border_factor, 0, 3.0,
+                            1080, 0);
+    s->sum_cube = adm_sum_cube_s(s->ref.band_h, w, h, buf_stride,
+                                 border_factor);
+}
+
+static int close_enough(double x, double expected)
+{
+    return fabs(x - expected) <= 1e-5 * fmax(1.0, fabs(expected));
+}
+
+static int planes_close_enough(const float *x, const float *expected,
+                               size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (!close_enough(x[i], expected[i]))
+            return 0;
+    }
+    return 1;
+}
+
+static void fill(float *ref, float *dis, int w, int h, int stride)
+{
+    uint32_t x = w * h;
+    for (int i = 0; i < h; i++) {
+        for (int j = 0; j < w; j++) {
+            x = test_noise(x);
+            const float r = (float)((x >> 8) & 255) - 128.0f;
+            x = test_noise(x);
+            // mostly attenuated or amplified, with some unrelated areas
+            const float d = (j / 8) % 3 ? r * ((i & 1) ? 0.75f : 1.1f) +
+                                          (float)((x >> 28) & 3) - 1.5f
+                                        : (float)((x >> 8) & 255) - 128.0f;
+            ref[i * stride + j] = r;
+            dis[i * stride + j] = d;
+        }
+    }
+}
+
+static char *test_adm_tools()
+{
+    enum { max_w = 161, max_h = 91 };
+    const int size[][2] = { { 8, 6 }, { 16, 16 }, { 37, 23 }, { max_w, max_h } };
+    const double border_factor[] = { 0.0, 0.1 };
+    const int stride = ALIGN_CEIL(max_w * sizeof(float));
+    const int buf_stride = ALIGN_CEIL(((max_w + 1) / 2) * sizeof(float));
+    const size_t buf_sz_one = (size_t)buf_stride * ((max_h + 1) / 2);
+    const size_t n = buf_sz_one / sizeof(float);
+
+    float *ref = aligned_malloc(stride * max_h, MAX_ALIGN);
+    float *dis = aligned_malloc(stride * max_h, MAX_ALIGN);
+    int *ind_buf = malloc(4 * sizeof(int) * (max_w + max_h));
+    mu_assert("problem during malloc", ref && dis && ind_buf);
+    int *ind_y[4], *ind_x[4];
+    for (unsigned k = 0; k < 4; k++) {
+        ind_y[k] = ind_buf + k * max_h;
+        ind_x[k] = ind_buf + 4 * max_h + k * max_w;
+    }
+
+    vmaf_init_cpu();
+
+    for (unsigned i = 0; i < sizeof(size) / sizeof(size[0]); i++) {
+        const int w = size[i][0], h = size[i][1];
+        fill(ref, dis, w, h, stride / sizeof(float));
+
+        for (unsigned b = 0; b < 2; b++) {
+            AdmScale expected;
+            mu_assert("problem during adm_scale_init",
+                      !adm_scale_init(&expected, buf_sz_one));
+            vmaf_set_cpu_flags_mask(0);
+            adm_scale(&expected, ref, dis, w, h, stride, buf_stride,
+                      ind_y, ind_x, border_factor[b]);
+
+            for_each_cpu_level(level) {
+                AdmScale s;
+                mu_assert("problem during adm_scale_init",
+                          !adm_scale_init(&s, buf_sz_one));
+                adm_scale(&s, ref, dis, w, h, stride, buf_stride,
+                          ind_y, ind_x, border_factor[b]);
+
+                mu_assert("dwt2 should match the scalar code",
+                          planes_close_enough(s.data, expected.data, 8 * n));
+                mu_assert("decouple should match the scalar code",
+                          planes_close_enough(s.r.band_h, expected.r.band_h, 6 * n));
+                mu_assert("csf should match the scalar code",
+                          planes_close_enough(s.csf_a.band_h, expected.csf_a.band_h, 6 * n));
+                mu_assert("csf den scale should match the scalar code",
+                          close_enough(s.den_scale, expected.den_scale));
+                mu_assert("cm should match the scalar code",
+                          close_enough(s.num_scale, expected.num_scale));
+                mu_assert("sum cube should match the scalar code",
+                          close_enough(s.sum_cube, expected.sum_cube));
+                free(s.data);
+            }
+            free(expected.data);
+        }
+    }
+    vmaf_set_cpu_flags_mask(-1);
+
+    aligned_free(ref);
+    aligned_free(dis);
+    free(ind_buf);
+    return NULL;
+}
+
+static char *test_compute_adm()
+{
+    enum { w = 161, h = 91, stride = ALIGN_CEIL(w * sizeof(float)) };
+    float *ref = aligned_malloc(stride * h, MAX_ALIGN);
+    float *dis = aligned_malloc(stride * h, MAX_ALIGN);
+    mu_assert("problem during aligned_malloc", ref && dis);
+    fill(ref, dis, w, h, stride / sizeof(float));
+
+    vmaf_init_cpu();
+    vmaf_set_cpu_flags_mask(0);
+    double score, num, den, scores[8];
+    int err = compute_adm(ref, dis, w, h, stride, stride, &score, &num, &den,
+                          scores, 0.1, 100.0, 3.0, 1080, 0);
+    mu_assert("problem during compute_adm", !err);
+    mu_assert("adm should be less than one for a distorted picture",
+              score > 0.0 && score < 1.0);
+
+    for_each_cpu_level(level) {
+        double s, sn, sd, ss[8];
+        err = compute_adm(ref, dis, w, h, stride, stride, &s, &sn, &sd, ss,
+                          0.1, 100.0, 3.0, 1080, 0);
+        mu_assert("problem during compute_adm", !err);
+        mu_assert("adm should match the scalar code",
+                  close_enough(s, score) && close_enough(sn, num) &&
+                  close_enough(sd, den));
+        for (unsigned k = 0; k < 8; k++) {
+            mu_assert("adm scales should match the scalar code",
+                      close_enough(ss[k], scores[k]));
+        }
+    }
+    vmaf_set_cpu_flags_mask(-1);
+
+    aligned_free(ref);
+    aligned_free(dis);
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_adm_tools);
+    mu_run_test(test_compute_adm);
+    return NULL;
+}
@@ -139,17 +139,19 @@ static int get_sample_image_8x8(VmafPicture *pic, int pic_index)
 /* Preprocessing functions */
 static char *test_anti_dithering_filter()
 {
-    VmafPicture pic, filtered_pic;
+    VmafPicture pic, out_pic, filtered_pic;
 
     int err = 0;
     err |= get_sample_image(&pic, 0);
     err |= get_sample_image(&filtered_pic, 1);
+    err |= vmaf_picture_alloc(&out_pic, VMAF_PIX_FMT_YUV400P, 10, pic.w[0], pic.h[0]);
     mu_assert("test_anti_dithering_filter alloc error", !err);
-    anti_dithering_filter(&pic, pic.w[0], pic.h[0]);
-    bool equal = pic_data_equality(&pic, &filtered_pic);
+    decimate_generic_uint16_and_convert_to_10b(&pic, &out_pic, pic.w[0], pic.h[0], anti_dithering_row);
+    bool equal = pic_data_equality(&out_pic, &filtered_pic);
     mu_assert("anti_dithering_filter output pic wrong", equal);
 
     vmaf_picture_unref(&pic);
+    vmaf_picture_unref(&out_pic);
     vmaf_picture_unref(&filtered_pic);
 
     return NULL;
@@ -167,7 +169,7 @@ static char *test_decimate()
     uint16_t width = pic.w[0]>>1;
     uint16_t height = pic.h[0]>>1;
 
-    decimate(&pic, width, height);
+    decimate(&pic, width, height, decimate_row);
 
     mu_assert("decimate pic wrong pixel value (0,0)", data[0]==1);
     mu_assert("decimate pic wrong pixel value (1,0)", data[1]==0);
@@ -192,7 +194,7 @@ static char *test_decimate_generic()
     mu_assert("test_decimate_generic alloc #2 error", !err);
 
     pic.bpc = 10;
-    decimate_generic_uint16_and_convert_to_10b(&pic, &out_pic, out_pic.w[0], out_pic.h[0]);
+    decimate_generic_uint16_and_convert_to_10b(&pic, &out_pic, out_pic.w[0], out_pic.h[0], NULL);
 
     uint16_t *data = out_pic.data[0];
     ptrdiff_t stride = out_pic.stride[0] >> 1;
@@ -203,7 +205,7 @@ static char *test_decimate_generic()
     mu_assert("decimate generic 10b wrong pixel value (1,1)", data[1+stride]==100);
 
     pic.bpc = 16;
-    decimate_generic_uint16_and_convert_to_10b(&pic, &out_pic, out_pic.w[0], out_pic.h[0]);
+    decimate_generic_uint16_and_convert_to_10b(&pic, &out_pic, out_pic.w[0], out_pic.h[0], NULL);
 
     mu_assert("decimate generic 16b wrong pixel value (0,0)", data[0]==0);
     mu_assert("decimate generic 16b wrong pixel value (0,1)", data[1]==2);
@@ -211,7 +213,7 @@ static char *test_decimate_generic()
     mu_assert("decimate generic 16b wrong pixel value (1,1)", data[1+stride]==2);
 
     pic.bpc = 12;
-    decimate_generic_uint16_and_convert_to_10b(&pic, &out_pic, out_pic.w[0], out_pic.h[0]);
+    decimate_generic_uint16_and_convert_to_10b(&pic, &out_pic, out_pic.w[0], out_pic.h[0], NULL);
 
     mu_assert("decimate generic 12b wrong pixel value (0,0)", data[0]==1);
     mu_assert("decimate generic 12b wrong pixel value (0,1)", data[1]==25);
@@ -219,7 +221,7 @@ static char *test_decimate_generic()
     mu_assert("decimate generic 12b wrong pixel value (1,1)", data[1+stride]==25);
 
     pic.bpc = 9;
-    decimate_generic_9b_and_convert_to_10b(&pic, &out_pic, out_pic.w[0], out_pic.h[0]);
+    decimate_generic_9b_and_convert_to_10b(&pic, &out_pic, out_pic.w[0], out_pic.h[0], NULL);
 
     mu_assert("decimate generic 9b to 10b wrong pixel value (0,0)", data[0]==4);
     mu_assert("decimate generic 9b to 10b wrong pixel value (0,1)", data[1]==200);
@@ -231,7 +233,7 @@ static char *test_decimate_generic()
     mu_assert("test_decimate_generic alloc #3 error", !err);
 
     pic.bpc = 10;
-    decimate_generic_uint16_and_convert_to_10b(&pic, &out_pic_4x4, out_pic_4x4.w[0], out_pic_4x4.h[0]);
+    decimate_generic_uint16_and_convert_to_10b(&pic, &out_pic_4x4, out_pic_4x4.w[0], out_pic_4x4.h[0], NULL);
 
     mu_assert("decimate generic 10b wrong for same dimensions", pic_data_equality(&pic, &out_pic_4x4));
 
@@ -240,7 +242,7 @@ static char *test_decimate_generic()
     mu_assert("test_decimate_generic alloc #4 error", !err);
 
     pic_8b.bpc = 8;
-    decimate_generic_uint8_and_convert_to_10b(&pic_8b, &out_pic, out_pic.w[0], out_pic.h[0]);
+    decimate_generic_uint8_and_convert_to_10b(&pic_8b, &out_pic, out_pic.w[0], out_pic.h[0], NULL);
 
     mu_assert("decimate generic 8b to 10b wrong pixel value (0,0)", data[0]==8);
     mu_assert("decimate generic 8b to 10b wrong pixel value (0,1)", data[1]==400);
@@ -274,12 +276,12 @@ static char *test_filter_mode()
     data[1 * stride + 2] = 1; data[2 * stride + 2] = 1;
     data[1 * stride + 3] = 1; data[3 * stride + 3] = 1;
     memcpy(filtered_data, data, stride * h * sizeof(uint16_t));
-    filter_mode(&filtered_image, w, h, buffer);
+    filter_mode(&filtered_image, w, h, buffer, mode3_row);
     mu_assert("filter_mode: all zeros", data_pic_sum(&filtered_image)==0);
 
     data[3 * stride + 4] = 1;
     memcpy(filtered_data, data, stride * h * sizeof(uint16_t));
-    filter_mode(&filtered_image, w, h, buffer);
+    filter_mode(&filtered_image, w, h, buffer, mode3_row);
 
     mu_assert("filter_mode: one one sum check", data_pic_sum(&filtered_image)==1);
     mu_assert("filter_mode: zero (3,3) check", filtered_data[3 * output_stride + 3]==0);
@@ -288,15 +290,15 @@ static char *test_filter_mode()
     data[0 * stride + 0] = 2;
     data[0 * stride + 1] = 1;
     memcpy(filtered_data, data, stride * h * sizeof(uint16_t));
-    filter_mode(&filtered_image, w, h, buffer);
+    filter_mode(&filtered_image, w, h, buffer, mode3_row);
     mu_assert("filter_mode: two in the corner check", filtered_data[0 * output_stride + 0]==2);
     data[1 * stride + 0] = 1;
     memcpy(filtered_data, data, stride * h * sizeof(uint16_t));
-    filter_mode(&filtered_image, w, h, buffer);
+    filter_mode(&filtered_image, w, h, buffer, mode3_row);
     mu_assert("filter_mode: two in the corner and adjacent one check", filtered_data[0 * output_stride + 1]==1);
     data[2 * stride + 0] = 2;
     memcpy(filtered_data, data, stride * h * sizeof(uint16_t));
-    filter_mode(&filtered_image, w, h, buffer);
+    filter_mode(&filtered_image, w, h, buffer, mode3_row);
     mu_assert("filter_mode: two in corner and edge check", filtered_data[1 * output_stride + 0]==2);
 
     vmaf_picture_unref(&image);
@@ -335,9 +337,8 @@ static char *test_get_spatial_mask_for_index()
     VmafPicture image, mask;
     uint16_t filter_size = 3;
     unsigned width = 4, height = 4;
-    // dp_width = width + 2 * (filter_size >> 2) + 1
-    // dp_height = 2 * (filter_size >> 2) + 2
-    uint32_t mask_dp[7*4];
+    // width + 2 * (filter_size >> 1)
+    uint16_t column_sums[4 + 2];
     int err = 0;
     uint16_t derivative_buffer[4];
 
@@ -347,11 +348,14 @@ static char *test_get_spatial_mask_for_index()
     err |= get_sample_image(&mask, 3);
     mu_assert("test_get_spatial_mask_for_index alloc #2 error", !err);
 
-    get_spatial_mask_for_index(&image, &mask, mask_dp, derivative_buffer, 2, filter_size, width, height, get_derivative_data_for_row);
+    get_spatial_mask_for_index(&image, &mask, column_sums, derivative_buffer, 2, filter_size, width, height,
+                               get_derivative_data_for_row, spatial_mask_row);
     mu_assert("spatial_mask_for_index wrong mask for index=2, image=3", data_pic_sum(&mask)==14);
-    get_spatial_mask_for_index(&image, &mask, mask_dp, derivative_buffer, 1, filter_size, width, height, get_derivative_data_for_row);
+    get_spatial_mask_for_index(&image, &mask, column_sums, derivative_buffer, 1, filter_size, width, height,
+                               get_derivative_data_for_row, spatial_mask_row);
     mu_assert("spatial_mask_for_index wrong mask for index=1, image=3", data_pic_sum(&mask)==16);
-    get_spatial_mask_for_index(&image, &mask, mask_dp, derivative_buffer, 0, filter_size, width, height, get_derivative_data_for_row);
+    get_spatial_mask_for_index(&image, &mask, column_sums, derivative_buffer, 0, filter_size, width, height,
+                               get_derivative_data_for_row, spatial_mask_row);
     mu_assert("spatial_mask_for_index wrong mask for index=0, image=3", data_pic_sum(&mask)==16);
 
     vmaf_picture_unref(&image);
@@ -359,11 +363,14 @@ static char *test_get_spatial_mask_for_index()
     err |= get_sample_image(&image, 4);
     mu_assert("test_get_spatial_mask_for_index alloc #3 error", !err);
 
-    get_spatial_mask_for_index(&image, &mask, mask_dp, derivative_buffer, 3, filter_size, width, height, get_derivative_data_for_row);
+    get_spatial_mask_for_index(&image, &mask, column_sums, derivative_buffer, 3, filter_size, width, height,
+                               get_derivative_data_for_row, spatial_mask_row);
     mu_assert("spatial_mask_for_index wrong mask for index=3, image=4", data_pic_sum(&mask)==0);
-    get_spatial_mask_for_index(&image, &mask, mask_dp, derivative_buffer, 2, filter_size, width, height, get_derivative_data_for_row);
+    get_spatial_mask_for_index(&image, &mask, column_sums, derivative_buffer, 2, filter_size, width, height,
+                               get_derivative_data_for_row, spatial_mask_row);
     mu_assert("spatial_mask_for_index wrong mask for index=2, image=4", data_pic_sum(&mask)==6);
-    get_spatial_mask_for_index(&image, &mask, mask_dp, derivative_buffer, 1, filter_size, width, height, get_derivative_data_for_row);
+    get_spatial_mask_for_index(&image, &mask, column_sums, derivative_buffer, 1, filter_size, width, height,
+                               get_derivative_data_for_row, spatial_mask_row);
     mu_assert("spatial_mask_for_index wrong mask for index=1, image=4", data_pic_sum(&mask)==9);
 
     vmaf_picture_unref(&image);
@@ -397,7 +404,7 @@ static char *test_calculate_c_values()
 
     calculate_c_values(&input, &mask, combined_c_values, histograms, window_size,
                        num_diffs, tvi_for_diff, diff_weights, all_diffs, width, height, 
-                       increment_range, decrement_range);
+                       increment_range, decrement_range, calculate_c_values_row);
 
     for (unsigned i=0; i<16; i++) {
         mu_assert("calculate_c_values error ws=3",
@@ -414,7 +421,7 @@ static char *test_calculate_c_values()
     uint16_t histograms_8x8[8*1032];
     calculate_c_values(&input_8x8, &mask_8x8, combined_c_values_8x8, histograms_8x8,
                        window_size, num_diffs, tvi_for_diff, diff_weights, all_diffs, 8, 8, 
-                       increment_range, decrement_range);
+                       increment_range, decrement_range, calculate_c_values_row);
 
     double sum = 0;
     for (unsigned i = 0; i < 64; i++) {
@@ -430,6 +437,140 @@ static char *test_calculate_c_values()
     return NULL;
 }
 
+static char *test_callbacks_bit_exact()
+{
+    // a noisy ramp across the tvi thresholds, with holes in the mask
+    enum { w = 75, h = 41, num_diffs = 4, window_size = 9 };
+    static float expected_c_values[w * h], c_values[w * h];
+    static uint16_t histograms[w * (1024 + 2 * num_diffs) + 1];
+    uint16_t expected_derivative[w], derivative[w];
+    uint16_t tvi_for_diff[num_diffs] = {178, 305, 432, 559};
+    uint16_t *diffs_to_consider = NULL;
+    int *diff_weights = NULL;
+    int *all_diffs = NULL;
+    VmafPicture image, mask;
+
+    int err = set_contrast_arrays(num_diffs, &diffs_to_consider, &diff_weights, &all_diffs);
+    err |= vmaf_picture_alloc(&image, VMAF_PIX_FMT_YUV400P, 10, w, h);
+    err |= vmaf_picture_alloc(&mask, VMAF_PIX_FMT_YUV400P, 10, w, h);
+    mu_assert("test_callbacks_bit_exact alloc error", !err);
+
+    uint16_t *image_data = image.data[0];
+    uint16_t *mask_data = mask.data[0];
+    const ptrdiff_t stride = image.stride[0] >> 1;
+    uint32_t x = 1;
+    for (unsigned i = 0; i < h; i++) {
+        for (unsigned j = 0; j < w; j++) {
+            x = test_noise(x);
+            image_data[i * stride + j] = 100 + (j * 7 + i) + ((x >> 28) & 3);
+            mask_data[i * stride + j] = (x >> 20) % 5 != 0;
+        }
+    }
+
+    vmaf_init_cpu();
+    vmaf_set_cpu_flags_mask(0);
+    CambiState c = { 0 };
+    init_callbacks(&c);
+    calculate_c_values(&image, &mask, expected_c_values, histograms, window_size,
+                       num_diffs, tvi_for_diff, diff_weights, all_diffs, w, h,
+                       c.inc_range_callback, c.dec_range_callback, c.c_values_row_callback);
+
+    for_each_cpu_level(level) {
+        CambiState s = { 0 };
+        init_callbacks(&s);
+        calculate_c_values(&image, &mask, c_values, histograms, window_size,
+                           num_diffs, tvi_for_diff, diff_weights, all_diffs, w, h,
+                           s.inc_range_callback, s.dec_range_callback, s.c_values_row_callback);
+        mu_assert("c_values should be bit-exact with the scalar code",
+                  !memcmp(c_values, expected_c_values, sizeof(c_values)));
+
+        for (int row = 0; row < h; row++) {
+            c.derivative_callback(image_data, expected_derivative, w, h, row, stride);
+            s.derivative_callback(image_data, derivative, w, h, row, stride);
+            mu_assert("derivatives should be bit-exact with the scalar code",
+                      !memcmp(derivative, expected_derivative, sizeof(derivative)));
+        }
+    }
+    vmaf_set_cpu_flags_mask(-1);
+
+    aligned_free(diffs_to_consider);
+    aligned_free(diff_weights);
+    aligned_free(all_diffs);
+    vmaf_picture_unref(&image);
+    vmaf_picture_unref(&mask);
+
+    return NULL;
+}
+
+static int run_preprocessing(const CambiState *s, const VmafPicture *input, VmafPicture *image,
+                             VmafPicture *mask, uint16_t *column_sums, uint16_t *derivative_buffer,
+                             uint16_t *filter_mode_buffer)
+{
+    const unsigned w = input->w[0], h = input->h[0];
+    int err = cambi_preprocessing(input, image, w, h, 8, s->anti_dithering_callback);
+    if (err) return err;
+    get_spatial_mask(image, mask, column_sums, derivative_buffer, w, h,
+                     s->derivative_callback, s->spatial_mask_row_callback);
+    filter_mode(image, w, h, filter_mode_buffer, s->mode_row_callback);
+    decimate(image, (w + 1) >> 1, (h + 1) >> 1, s->decimate_row_callback);
+    decimate(mask, (w + 1) >> 1, (h + 1) >> 1, s->decimate_row_callback);
+    return 0;
+}
+
+static char *test_preprocessing_callbacks_bit_exact()
+{
+    // flat areas broken by noise, so that the mask and the mode filter have work to do
+    enum { w = 75, h = 41 };
+    uint16_t column_sums[w + 2 * (MASK_FILTER_SIZE >> 1)];
+    uint16_t derivative_buffer[w], filter_mode_buffer[3 * w];
+    VmafPicture input, expected_image, expected_mask, image, mask;
+
+    int err = vmaf_picture_alloc(&input, VMAF_PIX_FMT_YUV400P, 8, w, h);
+    err |= vmaf_picture_alloc(&expected_image, VMAF_PIX_FMT_YUV400P, 10, w, h);
+    err |= vmaf_picture_alloc(&expected_mask, VMAF_PIX_FMT_YUV400P, 10, w, h);
+    err |= vmaf_picture_alloc(&image, VMAF_PIX_FMT_YUV400P, 10, w, h);
+    err |= vmaf_picture_alloc(&mask, VMAF_PIX_FMT_YUV400P, 10, w, h);
+    mu_assert("test_preprocessing_callbacks_bit_exact alloc error", !err);
+
+    uint8_t *input_data = input.data[0];
+    uint32_t x = 1;
+    for (unsigned i = 0; i < h; i++) {
+        for (unsigned j = 0; j < w; j++) {
+            x = test_noise(x);
+            input_data[i * input.stride[0] + j] = 16 + j / 9 + i / 7 + ((x >> 28) == 0) * (x >> 24 & 7);
+        }
+    }
+
+    vmaf_init_cpu();
+    vmaf_set_cpu_flags_mask(0);
+    CambiState c = { 0 };
+    init_callbacks(&c);
+    err = run_preprocessing(&c, &input, &expected_image, &expected_mask, column_sums,
+                            derivative_buffer, filter_mode_buffer);
+    mu_assert("test_preprocessing_callbacks_bit_exact preprocessing error", !err);
+
+    for_each_cpu_level(level) {
+        CambiState s = { 0 };
+        init_callbacks(&s);
+        err = run_preprocessing(&s, &input, &image, &mask, column_sums,
+                                derivative_buffer, filter_mode_buffer);
+        mu_assert("test_preprocessing_callbacks_bit_exact preprocessing error", !err);
+        mu_assert("preprocessed image should be bit-exact with the scalar code",
+                  pic_data_equality(&image, &expected_image));
+        mu_assert("spatial mask should be bit-exact with the scalar code",
+                  pic_data_equality(&mask, &expected_mask));
+    }
+    vmaf_set_cpu_flags_mask(-1);
+
+    vmaf_picture_unref(&input);
+    vmaf_picture_unref(&expected_image);
+    vmaf_picture_unref(&expected_mask);
+    vmaf_picture_unref(&image);
+    vmaf_picture_unref(&mask);
+
+    return NULL;
+}
+
 static char *test_c_value_pixel()
 {
     uint16_t histogram[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
@@ -722,6 +863,8 @@ char *run_tests()
     mu_run_test(test_get_spatial_mask_for_index);
 
     mu_run_test(test_calculate_c_values);
+    mu_run_test(test_callbacks_bit_exact);
+    mu_run_test(test_preprocessing_callbacks_bit_exact);
     mu_run_test(test_c_value_pixel);
     mu_run_test(test_update_range);
 
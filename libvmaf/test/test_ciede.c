@@ -75,11 +75,81 @@ static char *test_ciede4()
     return NULL;
 }
 
+static char *test_lab_lut()
+{
+    static float gamma_lut[GAMMA_LUT_SIZE + 1];
+    static float cbrt_lut[CBRT_LUT_SIZE + 1];
+    gamma_lut_init(gamma_lut);
+    cbrt_lut_init(cbrt_lut);
+
+    for (float c = -0.5f; c < 4.5f; c += 1.f / 4093) {
+        const double expected = rgb_to_xyz_map(c);
+        mu_assert("gamma_map should stay within 2e-7 of the exact mapping",
+                  fabs(gamma_map(gamma_lut, c) - expected) <=
+                  2e-7 * fmax(1., expected));
+    }
+
+    for (float c = 1e-6f; c < 20.f; c *= 1.0001f) {
+        const double expected = xyz_to_lab_map(c);
+        mu_assert("lab_map should stay within 2e-7 of the exact mapping",
+                  fabs(lab_map(cbrt_lut, c) - expected) <= 2e-7 * expected);
+    }
+
+    return NULL;
+}
+
+static char *test_ciede2000_row()
+{
+#if ARCH_X86
+    vmaf_init_cpu();
+    if (!(vmaf_get_cpu_flags() & VMAF_X86_CPU_FLAG_AVX2))
+        return NULL;
+
+    enum { w = 1000 };
+    static float buf[2][3][w];
+    float *lab[2][3];
+    uint32_t seed = 1;
+    for (unsigned i = 0; i < 2; i++) {
+        for (unsigned c = 0; c < 3; c++) {
+            lab[i][c] = buf[i][c];
+            for (unsigned j = 0; j < w; j++) {
+                seed = seed * 1664525 + 1013904223;
+                const float x = (seed >> 8) * (1.f / (1 << 24));
+                buf[i][c][j] = c ? 200.f * x - 100.f : 100.f * x;
+            }
+        }
+    }
+    // identical and achromatic pairs
+    for (unsigned c = 0; c < 3; c++)
+        buf[1][c][0] = buf[0][c][0];
+    buf[0][1][1] = buf[0][2][1] = buf[1][1][1] = buf[1][2][1] = 0.f;
+
+    for (unsigned n = 1; n <= w; n += 37) {
+        for (unsigned j = 0; j < n; j++) {
+            float *lab_1[3] = { &lab[0][0][j], &lab[0][1][j], &lab[0][2][j] };
+            float *lab_2[3] = { &lab[1][0][j], &lab[1][1][j], &lab[1][2][j] };
+            const double expected = ciede2000_row(lab_1, lab_2, 1, default_ksub, 0.);
+            const double de00 = ciede2000_row_avx2(lab_1, lab_2, 1, default_ksub, 0.);
+            mu_assert("ciede2000_row_avx2 should stay within 1e-4 of ciede2000",
+                      fabs(de00 - expected) <= 1e-4);
+        }
+        const double expected = ciede2000_row(lab[0], lab[1], n, default_ksub, 0.);
+        const double de00 = ciede2000_row_avx2(lab[0], lab[1], n, default_ksub, 0.);
+        mu_assert("ciede2000_row_avx2 row sum should match ciede2000",
+                  fabs(de00 - expected) <= 1e-4 * n);
+    }
+#endif
+
+    return NULL;
+}
+
 char *run_tests()
 {
     mu_run_test(test_ciede);
     mu_run_test(test_ciede2);
     mu_run_test(test_ciede3);
     mu_run_test(test_ciede4);
+    mu_run_test(test_lab_lut);
+    mu_run_test(test_ciede2000_row);
     return NULL;
 }
@@ -17,6 +17,8 @@
  */
 
 #include <getopt.h>
+#include <stdio.h>
+#include <string.h>
 
 #include "test.h"
 
@@ -142,6 +144,119 @@ static char *test_nflx_ctc_v1_0()
     return NULL;
 }
 
+static char *test_manifest()
+{
+    char *argv[3] = {"vmaf", "--manifest", "ladder.txt"};
+    int argc = 3;
+    CLISettings settings;
+    optind = 1;
+    cli_parse(argc, argv, &settings);
+    mu_assert("cli_parse: --manifest provided but manifest_path not set",
+              settings.manifest_path && !strcmp(settings.manifest_path, "ladder.txt"));
+    cli_free(&settings);
+
+    FILE *file = tmpfile();
+    mu_assert("cli_parse_manifest: problem creating tmpfile", file);
+    fputs("# ref dist output\n"
+          "ref.y4m dis_0.y4m out_0.xml\n"
+          "\n"
+          "  ref.y4m\tdis_1.y4m\n", file);
+    rewind(file);
+
+    CLIManifest manifest;
+    int err = cli_parse_manifest(file, &manifest);
+    fclose(file);
+    mu_assert("cli_parse_manifest: problem parsing manifest", !err);
+    mu_assert("cli_parse_manifest: number of entries is not 2", manifest.cnt == 2);
+    mu_assert("cli_parse_manifest: bad first entry",
+              !strcmp(manifest.entry[0].path_ref, "ref.y4m") &&
+              !strcmp(manifest.entry[0].path_dist, "dis_0.y4m") &&
+              !strcmp(manifest.entry[0].output_path, "out_0.xml"));
+    mu_assert("cli_parse_manifest: bad second entry",
+              !strcmp(manifest.entry[1].path_ref, "ref.y4m") &&
+              !strcmp(manifest.entry[1].path_dist, "dis_1.y4m") &&
+              !manifest.entry[1].output_path);
+    cli_free_manifest(&manifest);
+
+    file = tmpfile();
+    mu_assert("cli_parse_manifest: problem creating tmpfile", file);
+    fputs("ref.y4m\n", file);
+    rewind(file);
+    err = cli_parse_manifest(file, &manifest);
+    fclose(file);
+    mu_assert("cli_parse_manifest: entry without distorted should fail", err);
+
+    file = tmpfile();
+    mu_assert("cli_parse_manifest: problem creating tmpfile", file);
+    fputs("\"my ref.y4m\" \"dis 0.y4m\"\t\"out 0.xml\"\n", file);
+    rewind(file);
+    err = cli_parse_manifest(file, &manifest);
+    fclose(file);
+    mu_assert("cli_parse_manifest: problem parsing quoted fields", !err);
+    mu_assert("cli_parse_manifest: bad quoted entry",
+              !strcmp(manifest.entry[0].path_ref, "my ref.y4m") &&
+              !strcmp(manifest.entry[0].path_dist, "dis 0.y4m") &&
+              !strcmp(manifest.entry[0].output_path, "out 0.xml"));
+    cli_free_manifest(&manifest);
+
+    file = tmpfile();
+    mu_assert("cli_parse_manifest: problem creating tmpfile", file);
+    fputs("ref.y4m \"dis 0.y4m\n", file);
+    rewind(file);
+    err = cli_parse_manifest(file, &manifest);
+    fclose(file);
+    mu_assert("cli_parse_manifest: unterminated quote should fail", err);
+
+    file = tmpfile();
+    mu_assert("cli_parse_manifest: problem creating tmpfile", file);
+    fputs("ref.y4m ", file);
+    for (unsigned i = 0; i < 5000; i++)
+        fputc('d', file);
+    fputs(".y4m\nref.y4m dis.y4m\n", file);
+    rewind(file);
+    err = cli_parse_manifest(file, &manifest);
+    fclose(file);
+    mu_assert("cli_parse_manifest: overlong line should fail", err);
+
+    return NULL;
+}
+
+static char *test_chunks()
+{
+    char *argv[7] = {"vmaf", "-r", "ref.y4m", "-d", "dis.y4m", "--chunks", "4"};
+    int argc = 7;
+    CLISettings settings;
+    optind = 1;
+    cli_parse(argc, argv, &settings);
+    mu_assert("cli_parse: --chunks provided but chunk_cnt not set",
+              settings.chunk_cnt == 4);
+    cli_free(&settings);
+
+    return NULL;
+}
+
+static char *test_read_ahead()
+{
+    char *argv[5] = {"vmaf", "-r", "-", "-d", "dis.y4m"};
+    int argc = 5;
+    CLISettings settings;
+    optind = 1;
+    cli_parse(argc, argv, &settings);
+    mu_assert("cli_parse: read_ahead should default to CLI_READ_AHEAD_DEFAULT",
+              settings.read_ahead == CLI_READ_AHEAD_DEFAULT);
+    cli_free(&settings);
+
+    char *argv2[7] = {"vmaf", "-r", "-", "-d", "dis.y4m", "--read_ahead", "0"};
+    argc = 7;
+    optind = 1;
+    cli_parse(argc, argv2, &settings);
+    mu_assert("cli_parse: --read_ahead 0 should disable read-ahead",
+              settings.read_ahead == 0);
+    cli_free(&settings);
+
+    return NULL;
+}
+
 char *run_tests()
 {
     mu_run_test(test_aom_ctc_v1_0);
@@ -151,5 +266,8 @@ char *run_tests()
     mu_run_test(test_aom_ctc_v5_0);
     mu_run_test(test_aom_ctc_v6_0);
     mu_run_test(test_nflx_ctc_v1_0);
+    mu_run_test(test_manifest);
+    mu_run_test(test_chunks);
+    mu_run_test(test_read_ahead);
     return NULL;
 }
@@ -0,0 +1,155 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "test.h"
+#include "cpu.h"
+#include "mem.h"
+#include "feature/common/convolution.h"
+#include "feature/vif_tools.h"
+
+enum { FILTER_SRC, FILTER_SQ, FILTER_XY, FILTER_COUNT };
+
+static void filter(int op, const float *f, int fwidth, const float *src1,
+                   const float *src2, float *dst, float *tmp, int w, int h,
+                   int stride)
+{
+    switch (op) {
+    case FILTER_SQ:
+        vif_filter1d_sq_s(f, src1, dst, tmp, w, h, stride, stride, fwidth);
+        break;
+    case FILTER_XY:
+        vif_filter1d_xy_s(f, src1, src2, dst, tmp, w, h, stride, stride,
+                          stride, fwidth);
+        break;
+    default:
+        convolution_f32_c_s(f, fwidth, src1, dst, tmp, w, h,
+                            stride / sizeof(float), stride / sizeof(float));
+        break;
+    }
+}
+
+static int close_enough(const float *x, const float *expected, int w, int h,
+                        int stride)
+{
+    for (int i = 0; i < h; i++) {
+        for (int j = 0; j < w; j++) {
+            const float e = expected[i * stride + j];
+            if (fabsf(x[i * stride + j] - e) > 1e-5f * fmaxf(1.0f, fabsf(e)))
+                return 0;
+        }
+    }
+    return 1;
+}
+
+static int have_simd_convolution(void)
+{
+    const unsigned flags = vmaf_get_cpu_flags();
+#if ARCH_X86
+    return flags & VMAF_X86_CPU_FLAG_AVX2;
+#elif ARCH_AARCH64
+    return flags & VMAF_ARM_CPU_FLAG_NEON;
+#else
+    (void) flags;
+    return 0;
+#endif
+}
+
+static char *test_convolution()
+{
+    enum { max_w = 83, max_h = 41 };
+    const int size[][2] = { { 24, 19 }, { 40, 33 }, { max_w, max_h } };
+    // the widths with unrolled kernels, and one without
+    const float *filters[] = {
+        vif_filter1d_table_s[0][0], vif_filter1d_table_s[0][1],
+        vif_filter1d_table_s[0][2], vif_filter1d_table_s[0][3],
+        vif_filter1d_table_s[3][3],
+    };
+    const int fwidths[] = { 17, 9, 5, 3, 7 };
+    const int stride = ALIGN_CEIL(max_w * sizeof(float));
+    const size_t size_bytes = stride * max_h;
+    float *src1 = aligned_malloc(size_bytes, 32);
+    float *src2 = aligned_malloc(size_bytes, 32);
+    float *expected = aligned_malloc(size_bytes, 32);
+    float *simd = aligned_malloc(size_bytes, 32);
+    float *out = aligned_malloc(size_bytes, 32);
+    float *tmp = aligned_malloc(size_bytes, 32);
+    mu_assert("problem during aligned_malloc",
+              src1 && src2 && expected && simd && out && tmp);
+
+    const int px_stride = stride / sizeof(float);
+    uint32_t x = 1;
+    for (int i = 0; i < max_h * px_stride; i++) {
+        x = test_noise(x);
+        src1[i] = (float) ((x >> 8) & 0xff) - 128;
+        src2[i] = src1[i] + (float) ((int) (x >> 28) - 8);
+    }
+
+    vmaf_init_cpu();
+
+    for (unsigned s = 0; s < sizeof(size) / sizeof(size[0]); s++) {
+        const int w = size[s][0], h = size[s][1];
+
+        for (unsigned k = 0; k < sizeof(fwidths) / sizeof(fwidths[0]); k++) {
+            for (int op = 0; op < FILTER_COUNT; op++) {
+                vmaf_set_cpu_flags_mask(0);
+                filter(op, filters[k], fwidths[k], src1, src2, expected, tmp,
+                       w, h, stride);
+
+                // the SIMD kernels all sum the taps in the same order, so
+                // they agree with each other bit for bit
+                int have_simd = 0;
+                for_each_cpu_level(level) {
+                    memset(out, 0, size_bytes);
+                    filter(op, filters[k], fwidths[k], src1, src2, out, tmp,
+                           w, h, stride);
+                    mu_assert("convolution should match the scalar code",
+                              close_enough(out, expected, w, h, px_stride));
+
+                    if (!have_simd_convolution())
+                        continue;
+                    if (!have_simd) {
+                        memcpy(simd, out, size_bytes);
+                        have_simd = 1;
+                    }
+                    mu_assert("simd convolutions should be bit-exact",
+                              !memcmp(out, simd, size_bytes));
+                }
+            }
+        }
+    }
+    vmaf_set_cpu_flags_mask(-1);
+
+    aligned_free(src1);
+    aligned_free(src2);
+    aligned_free(expected);
+    aligned_free(simd);
+    aligned_free(out);
+    aligned_free(tmp);
+
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_convolution);
+    return NULL;
+}
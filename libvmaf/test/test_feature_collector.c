@@ -241,10 +241,60 @@ static char *test_feature_collector_init_append_get_and_destroy()
     return NULL;
 }
 
+static char *test_feature_collector_merge()
+{
+    int err;
+
+    VmafFeatureCollector *fc_a, *fc_b, *fc;
+    err  = vmaf_feature_collector_init(&fc_a);
+    err |= vmaf_feature_collector_init(&fc_b);
+    err |= vmaf_feature_collector_init(&fc);
+    mu_assert("problem during vmaf_feature_collector_init", !err);
+
+    // two chunks which overlap by one index on either side of the boundary
+    for (unsigned i = 0; i <= 4; i++)
+        err |= vmaf_feature_collector_append(fc_a, "feature", i, i);
+    for (unsigned i = 3; i <= 7; i++)
+        err |= vmaf_feature_collector_append(fc_b, "feature", 10. + i, i);
+    err |= vmaf_feature_collector_append(fc_b, "feature_b", 1., 5);
+    mu_assert("problem during vmaf_feature_collector_append", !err);
+
+    err  = vmaf_feature_collector_merge(fc, fc_a, 0, 3);
+    err |= vmaf_feature_collector_merge(fc, fc_b, 4, 7);
+    mu_assert("problem during vmaf_feature_collector_merge", !err);
+
+    double score;
+    err = vmaf_feature_collector_get_score(fc, "feature", &score, 3);
+    mu_assert("problem during vmaf_feature_collector_get_score", !err);
+    mu_assert("index 3 should be merged from the first chunk", score == 3.);
+    err = vmaf_feature_collector_get_score(fc, "feature", &score, 4);
+    mu_assert("problem during vmaf_feature_collector_get_score", !err);
+    mu_assert("index 4 should be merged from the second chunk", score == 14.);
+    err = vmaf_feature_collector_get_score(fc, "feature_b", &score, 5);
+    mu_assert("problem during vmaf_feature_collector_get_score", !err);
+    mu_assert("unexpected score for feature_b", score == 1.);
+    err = vmaf_feature_collector_get_score(fc, "feature_b", &score, 4);
+    mu_assert("feature_b should not be written at index 4", err);
+
+    err = vmaf_feature_collector_merge(fc, fc_a, 3, 3);
+    mu_assert("merging an index twice should fail", err);
+
+    err = vmaf_feature_collector_set_aggregate(fc_a, "aggregate", 1.);
+    mu_assert("problem during vmaf_feature_collector_set_aggregate", !err);
+    err = vmaf_feature_collector_merge(fc, fc_a, 0, 3);
+    mu_assert("merging aggregates should not be supported", err == -ENOTSUP);
+
+    vmaf_feature_collector_destroy(fc_a);
+    vmaf_feature_collector_destroy(fc_b);
+    vmaf_feature_collector_destroy(fc);
+    return NULL;
+}
+
 char *run_tests()
 {
     mu_run_test(test_feature_vector_init_append_and_destroy);
     mu_run_test(test_feature_collector_init_append_get_and_destroy);
+    mu_run_test(test_feature_collector_merge);
     mu_run_test(test_aggregate_vector_init_append_and_destroy);
     mu_run_test(test_model_mount);
     mu_run_test(test_model_unmount);
@@ -16,16 +16,22 @@
  *
  */
 
+#include <errno.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "config.h"
+#include "cpu.h"
 #include "dict.h"
 #include "feature/feature_extractor.h"
 #include "feature/feature_collector.h"
+#include "feature/feature_name.h"
+#include "mem.h"
 #include "test.h"
 #include "picture.h"
 #include "libvmaf/picture.h"
+#include "feature/picture_copy.h"
 
 static char *test_get_feature_extractor_by_name_and_feature_name()
 {
@@ -84,6 +90,93 @@ static char *test_feature_extractor_context_pool()
     return NULL;
 }
 
+static int use_pooled_context(VmafFeatureExtractorContextPool *pool,
+                               VmafFeatureExtractor *fex,
+                               VmafDictionary *opts_dict)
+{
+    VmafFeatureExtractorContext *fex_ctx;
+    int err = vmaf_fex_ctx_pool_aquire(pool, fex, opts_dict, &fex_ctx);
+    if (err) return err;
+    if (!fex_ctx->is_initialized) {
+        err = vmaf_feature_extractor_context_init(fex_ctx,
+                                                  VMAF_PIX_FMT_YUV420P, 8,
+                                                  64, 64);
+    }
+    return err | vmaf_fex_ctx_pool_release(pool, fex_ctx);
+}
+
+static char *test_feature_extractor_context_pool_budget()
+{
+    int err = 0;
+
+    const unsigned n_threads = 8;
+    VmafFeatureExtractorContextPool *pool;
+    VmafFeatureExtractorContext *fex_ctx[n_threads];
+
+    VmafFeatureExtractor *fex =
+        vmaf_get_feature_extractor_by_name("float_ssim");
+    mu_assert("problem during vmaf_get_feature_extractor_by_name", fex);
+
+    // without a budget, the size of a context is only reported
+    err = vmaf_fex_ctx_pool_create(&pool, n_threads);
+    mu_assert("problem during vmaf_fex_ctx_pool_create", !err);
+    err = use_pooled_context(pool, fex, NULL);
+    mu_assert("problem using a pooled context", !err);
+    const size_t ctx_sz = pool->fex_list[0].ctx_sz;
+    mu_assert("context should hold two 64x64 float pictures",
+              ctx_sz >= 2 * 64 * 64 * sizeof(float));
+    mu_assert("without a budget, every thread should get a context",
+              pool->fex_list[0].limit == n_threads);
+    mu_assert("contexts should be created on demand",
+              pool->fex_list[0].ctx_cnt == 1);
+    err = vmaf_fex_ctx_pool_destroy(pool);
+    mu_assert("problem during vmaf_fex_ctx_pool_destroy", !err);
+
+    // budget for three and a half contexts
+    err = vmaf_fex_ctx_pool_create(&pool, n_threads);
+    mu_assert("problem during vmaf_fex_ctx_pool_create", !err);
+    err = vmaf_fex_ctx_pool_set_mem_budget(pool, 7 * ctx_sz / 2);
+    mu_assert("problem during vmaf_fex_ctx_pool_set_mem_budget", !err);
+    mu_assert("size should be measured when a context is released",
+              !use_pooled_context(pool, fex, NULL) &&
+              pool->fex_list[0].ctx_sz == ctx_sz);
+    mu_assert("three contexts should fit into the budget",
+              pool->fex_list[0].limit == 3);
+    for (unsigned i = 0; i < 3; i++) {
+        err = vmaf_fex_ctx_pool_aquire(pool, fex, NULL, &fex_ctx[i]);
+        mu_assert("problem during vmaf_fex_ctx_pool_aquire", !err);
+    }
+    mu_assert("contexts in use should be distinct",
+              fex_ctx[0] != fex_ctx[1] && fex_ctx[1] != fex_ctx[2] &&
+              fex_ctx[0] != fex_ctx[2]);
+    mu_assert("three contexts should be created",
+              pool->fex_list[0].ctx_cnt == 3);
+    for (unsigned i = 0; i < 3; i++) {
+        err = vmaf_fex_ctx_pool_release(pool, fex_ctx[i]);
+        mu_assert("problem during vmaf_fex_ctx_pool_release", !err);
+    }
+
+    // a second feature extractor of the same size leaves one context each
+    VmafDictionary *opts_dict = NULL;
+    err = vmaf_dictionary_set(&opts_dict, "enable_lcs", "true", 0);
+    mu_assert("problem during vmaf_dictionary_set", !err);
+    err = use_pooled_context(pool, fex, opts_dict);
+    mu_assert("problem using a pooled context", !err);
+    mu_assert("pool should hold two feature extractors", pool->cnt == 2);
+    mu_assert("only one context each should fit into the budget",
+              pool->fex_list[0].limit == 1 && pool->fex_list[1].limit == 1);
+    mu_assert("idle contexts above the limit should be destroyed",
+              pool->fex_list[0].ctx_cnt == 1);
+    err = use_pooled_context(pool, fex, NULL);
+    mu_assert("problem using a pooled context", !err);
+    vmaf_dictionary_free(&opts_dict);
+
+    err = vmaf_fex_ctx_pool_destroy(pool);
+    mu_assert("problem during vmaf_fex_ctx_pool_destroy", !err);
+
+    return NULL;
+}
+
 static char *test_feature_extractor_flush()
 {
     int err = 0;
@@ -184,11 +277,312 @@ static char *test_feature_extractor_initialization_options()
     return NULL;
 }
 
+static char *test_feature_extractor_context_merge()
+{
+    int err = 0;
+
+    VmafFeatureExtractor *fex = vmaf_get_feature_extractor_by_name("vif");
+    mu_assert("problem vmaf_get_feature_extractor_by_name", fex);
+
+    VmafFeatureExtractorContext *fex_ctx, *fex_ctx_neg, *fex_ctx_debug;
+    err = vmaf_feature_extractor_context_create(&fex_ctx, fex, NULL);
+    VmafDictionary *opts_dict = NULL;
+    err |= vmaf_dictionary_set(&opts_dict, "vif_enhn_gain_limit", "1.0", 0);
+    err |= vmaf_feature_extractor_context_create(&fex_ctx_neg, fex, opts_dict);
+    opts_dict = NULL;
+    err |= vmaf_dictionary_set(&opts_dict, "vif_enhn_gain_limit", "1.0", 0);
+    err |= vmaf_dictionary_set(&opts_dict, "debug", "true", 0);
+    err |= vmaf_feature_extractor_context_create(&fex_ctx_debug, fex, opts_dict);
+    mu_assert("problem during vmaf_feature_extractor_context_create", !err);
+
+    err = vmaf_feature_extractor_context_merge(fex_ctx, fex_ctx_debug);
+    mu_assert("contexts with different options should not be merged", err);
+    err = vmaf_feature_extractor_context_merge(fex_ctx, fex_ctx_neg);
+    mu_assert("contexts which only differ in the gain limit should be merged",
+              !err);
+    const VmafDictionaryEntry *entry =
+        vmaf_dictionary_get(&fex_ctx->opts_dict,
+                            "vif_enhn_gain_limit_variants", 0);
+    mu_assert("merged gain limit should be passed as a variant",
+              entry && !strcmp(entry->val, "1"));
+    err = vmaf_feature_extractor_context_merge(fex_ctx, fex_ctx_neg);
+    mu_assert("merging a variant twice should be a no-op", !err);
+    entry = vmaf_dictionary_get(&fex_ctx->opts_dict,
+                                "vif_enhn_gain_limit_variants", 0);
+    mu_assert("merging a variant twice should be a no-op",
+              entry && !strcmp(entry->val, "1"));
+
+    VmafPicture ref, dist;
+    err = vmaf_picture_alloc(&ref, VMAF_PIX_FMT_YUV420P, 8, 64, 48);
+    err |= vmaf_picture_alloc(&dist, VMAF_PIX_FMT_YUV420P, 8, 64, 48);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    uint32_t x = 1;
+    for (unsigned i = 0; i < ref.h[0]; i++) {
+        uint8_t *r = (uint8_t *)ref.data[0] + i * ref.stride[0];
+        uint8_t *d = (uint8_t *)dist.data[0] + i * dist.stride[0];
+        for (unsigned j = 0; j < ref.w[0]; j++) {
+            x = test_noise(x);
+            r[j] = (i * 5 + j * 3) & 0xff;
+            d[j] = (r[j] * 2 + (x >> 28)) & 0xff;
+        }
+    }
+
+    VmafFeatureCollector *vfc, *vfc_neg;
+    err = vmaf_feature_collector_init(&vfc);
+    err |= vmaf_feature_collector_init(&vfc_neg);
+    mu_assert("problem during vmaf_feature_collector_init", !err);
+    err = vmaf_feature_extractor_context_extract(fex_ctx, &ref, NULL, &dist,
+                                                 NULL, 0, vfc);
+    err |= vmaf_feature_extractor_context_extract(fex_ctx_neg, &ref, NULL,
+                                                  &dist, NULL, 0, vfc_neg);
+    mu_assert("problem during vmaf_feature_extractor_context_extract", !err);
+
+    char *name =
+        vmaf_feature_name_from_options("VMAF_integer_feature_vif_scale0_score",
+                                       fex_ctx_neg->fex->options,
+                                       fex_ctx_neg->fex->priv);
+    mu_assert("problem during vmaf_feature_name_from_options", name);
+    double score, score_neg;
+    err = vmaf_feature_collector_get_score(vfc, name, &score, 0);
+    err |= vmaf_feature_collector_get_score(vfc_neg, name, &score_neg, 0);
+    free(name);
+    mu_assert("problem during vmaf_feature_collector_get_score", !err);
+    mu_assert("merged variant should match a separate context",
+              score == score_neg);
+    err = vmaf_feature_collector_get_score(vfc,
+            "VMAF_integer_feature_vif_scale0_score", &score, 0);
+    mu_assert("merged context should still provide the default variant",
+              !err);
+
+    err = vmaf_feature_extractor_context_close(fex_ctx);
+    err |= vmaf_feature_extractor_context_close(fex_ctx_neg);
+    err |= vmaf_feature_extractor_context_destroy(fex_ctx);
+    err |= vmaf_feature_extractor_context_destroy(fex_ctx_neg);
+    err |= vmaf_feature_extractor_context_destroy(fex_ctx_debug);
+    mu_assert("problem during vmaf_feature_extractor_context_destroy", !err);
+
+    vmaf_feature_collector_destroy(vfc);
+    vmaf_feature_collector_destroy(vfc_neg);
+    vmaf_picture_unref(&ref);
+    vmaf_picture_unref(&dist);
+
+    return NULL;
+}
+
+static int produce_nothing(void *data, void *cookie)
+{
+    (void) data;
+    (void) cookie;
+    return -EINVAL;
+}
+
+static char *test_feature_extractor_shared_picture_copy()
+{
+    int err = 0;
+
+    VmafFeatureExtractor *fex_ansnr =
+        vmaf_get_feature_extractor_by_name("float_ansnr");
+    VmafFeatureExtractor *fex_vif =
+        vmaf_get_feature_extractor_by_name("float_vif");
+    mu_assert("problem vmaf_get_feature_extractor_by_name",
+              fex_ansnr && fex_vif);
+
+    VmafFeatureExtractorContext *fex_ctx_ansnr, *fex_ctx_vif;
+    err = vmaf_feature_extractor_context_create(&fex_ctx_ansnr, fex_ansnr, NULL);
+    err |= vmaf_feature_extractor_context_create(&fex_ctx_vif, fex_vif, NULL);
+    mu_assert("problem during vmaf_feature_extractor_context_create", !err);
+
+    VmafPicture ref, dist;
+    err = vmaf_picture_alloc(&ref, VMAF_PIX_FMT_YUV420P, 10, 64, 48);
+    err |= vmaf_picture_alloc(&dist, VMAF_PIX_FMT_YUV420P, 10, 64, 48);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    uint32_t x = 1;
+    for (unsigned i = 0; i < ref.h[0]; i++) {
+        uint16_t *r = (uint16_t *)((uint8_t *)ref.data[0] + i * ref.stride[0]);
+        uint16_t *d = (uint16_t *)((uint8_t *)dist.data[0] + i * dist.stride[0]);
+        for (unsigned j = 0; j < ref.w[0]; j++) {
+            x = test_noise(x);
+            r[j] = (i * 21 + j * 13) & 0x3ff;
+            d[j] = (r[j] + (x >> 27)) & 0x3ff;
+        }
+    }
+
+    VmafFeatureCollector *vfc, *vfc_shared;
+    err = vmaf_feature_collector_init(&vfc);
+    err |= vmaf_feature_collector_init(&vfc_shared);
+    mu_assert("problem during vmaf_feature_collector_init", !err);
+    err = vmaf_feature_extractor_context_extract(fex_ctx_ansnr, &ref, NULL,
+                                                 &dist, NULL, 0, vfc);
+    mu_assert("problem during vmaf_feature_extractor_context_extract", !err);
+
+    // both feature extractors declare the converted pictures
+    err = vmaf_picture_artifact_cache_init(&ref);
+    err |= vmaf_picture_artifact_cache_init(&dist);
+    mu_assert("problem during vmaf_picture_artifact_cache_init", !err);
+    for (unsigned i = 0; i < 2; i++) {
+        err |= vmaf_picture_artifact_declare(&ref, PICTURE_COPY_ARTIFACT(-128));
+        err |= vmaf_picture_artifact_declare(&dist, PICTURE_COPY_ARTIFACT(-128));
+    }
+    mu_assert("problem during vmaf_picture_artifact_declare", !err);
+    err = vmaf_feature_extractor_context_extract(fex_ctx_vif, &ref, NULL,
+                                                 &dist, NULL, 0, vfc_shared);
+    err |= vmaf_feature_extractor_context_extract(fex_ctx_ansnr, &ref, NULL,
+                                                  &dist, NULL, 0, vfc_shared);
+    mu_assert("problem during vmaf_feature_extractor_context_extract", !err);
+
+    const size_t sz = ALIGN_CEIL(ref.w[0] * sizeof(float)) * ref.h[0];
+    const void *shared;
+    err = vmaf_picture_artifact_get(&ref, PICTURE_COPY_ARTIFACT(-128), sz,
+                                    produce_nothing, NULL, &shared);
+    mu_assert("converted reference should be in the artifact cache", !err);
+    err = vmaf_picture_artifact_get(&dist, PICTURE_COPY_ARTIFACT(-128), sz,
+                                    produce_nothing, NULL, &shared);
+    mu_assert("converted distorted should be in the artifact cache", !err);
+
+    double score, score_shared;
+    err = vmaf_feature_collector_get_score(vfc, "float_ansnr", &score, 0);
+    err |= vmaf_feature_collector_get_score(vfc_shared, "float_ansnr",
+                                            &score_shared, 0);
+    mu_assert("problem during vmaf_feature_collector_get_score", !err);
+    mu_assert("shared picture copy should not change the score",
+              score == score_shared);
+
+    err = vmaf_feature_extractor_context_close(fex_ctx_ansnr);
+    err |= vmaf_feature_extractor_context_close(fex_ctx_vif);
+    err |= vmaf_feature_extractor_context_destroy(fex_ctx_ansnr);
+    err |= vmaf_feature_extractor_context_destroy(fex_ctx_vif);
+    mu_assert("problem during vmaf_feature_extractor_context_destroy", !err);
+
+    vmaf_feature_collector_destroy(vfc);
+    vmaf_feature_collector_destroy(vfc_shared);
+    vmaf_picture_unref(&ref);
+    vmaf_picture_unref(&dist);
+
+    return NULL;
+}
+
+static int release_nothing(VmafPicture *pic, void *cookie)
+{
+    (void) pic;
+    (void) cookie;
+    return 0;
+}
+
+static char *extract_wrapped_picture(const char *fex_name,
+                                     const char *feature_name,
+                                     VmafPicture *ref, VmafPicture *dist,
+                                     VmafPicture *ref_wrap,
+                                     VmafPicture *dist_wrap)
+{
+    int err = 0;
+
+    VmafFeatureExtractor *fex = vmaf_get_feature_extractor_by_name(fex_name);
+    mu_assert("problem vmaf_get_feature_extractor_by_name", fex);
+
+    VmafFeatureExtractorContext *fex_ctx;
+    err = vmaf_feature_extractor_context_create(&fex_ctx, fex, NULL);
+    mu_assert("problem during vmaf_feature_extractor_context_create", !err);
+
+    VmafFeatureCollector *vfc;
+    err = vmaf_feature_collector_init(&vfc);
+    mu_assert("problem during vmaf_feature_collector_init", !err);
+    err = vmaf_feature_extractor_context_extract(fex_ctx, ref, NULL, dist,
+                                                 NULL, 0, vfc);
+    err |= vmaf_feature_extractor_context_extract(fex_ctx, ref_wrap, NULL,
+                                                  dist_wrap, NULL, 1, vfc);
+    mu_assert("problem during vmaf_feature_extractor_context_extract", !err);
+
+    double score, score_wrap;
+    err = vmaf_feature_collector_get_score(vfc, feature_name, &score, 0);
+    err |= vmaf_feature_collector_get_score(vfc, feature_name, &score_wrap, 1);
+    mu_assert("problem during vmaf_feature_collector_get_score", !err);
+    mu_assert("wrapped picture should not change the score",
+              score == score_wrap);
+
+    err = vmaf_feature_extractor_context_close(fex_ctx);
+    err |= vmaf_feature_extractor_context_destroy(fex_ctx);
+    mu_assert("problem during vmaf_feature_extractor_context_destroy", !err);
+    vmaf_feature_collector_destroy(vfc);
+
+    return NULL;
+}
+
+static char *test_feature_extractor_wrapped_picture()
+{
+    int err = 0;
+
+    static const struct {
+        const char *fex;
+        const char *feature;
+    } tests[] = {
+        { "vif", "VMAF_integer_feature_vif_scale0_score" },
+        { "adm", "VMAF_integer_feature_adm2_score" },
+        { "psnr", "psnr_y" },
+        { "float_vif", "VMAF_feature_vif_scale0_score" },
+        { "float_ssim", "float_ssim" },
+    };
+
+    /* Tightly packed and misaligned planes, the last row ends the buffer,
+     * and w % 16 == 8 so that vector code has a partial last vector. */
+    enum { w = 72, h = 56 };
+    VmafPicture ref, dist, ref_wrap, dist_wrap;
+    err = vmaf_picture_alloc(&ref, VMAF_PIX_FMT_YUV400P, 8, w, h);
+    err |= vmaf_picture_alloc(&dist, VMAF_PIX_FMT_YUV400P, 8, w, h);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    uint8_t *ref_buf = malloc(w * h + 1);
+    uint8_t *dist_buf = malloc(w * h + 1);
+    mu_assert("problem during malloc", ref_buf && dist_buf);
+    uint32_t x = 1;
+    for (unsigned i = 0; i < h; i++) {
+        uint8_t *r = (uint8_t *)ref.data[0] + i * ref.stride[0];
+        uint8_t *d = (uint8_t *)dist.data[0] + i * dist.stride[0];
+        for (unsigned j = 0; j < w; j++) {
+            x = test_noise(x);
+            r[j] = (i * 5 + j * 3) & 0xff;
+            d[j] = (r[j] * 2 + (x >> 28)) & 0xff;
+        }
+        memcpy(ref_buf + 1 + i * w, r, w);
+        memcpy(dist_buf + 1 + i * w, d, w);
+    }
+    void *ref_data[3] = { ref_buf + 1, NULL, NULL };
+    void *dist_data[3] = { dist_buf + 1, NULL, NULL };
+    const ptrdiff_t stride[3] = { w, 0, 0 };
+    err = vmaf_picture_wrap(&ref_wrap, VMAF_PIX_FMT_YUV400P, 8, w, h,
+                            ref_data, stride, NULL, release_nothing);
+    err |= vmaf_picture_wrap(&dist_wrap, VMAF_PIX_FMT_YUV400P, 8, w, h,
+                             dist_data, stride, NULL, release_nothing);
+    mu_assert("problem during vmaf_picture_wrap", !err);
+
+    vmaf_init_cpu();
+    for_each_cpu_level(level) {
+        for (unsigned t = 0; t < sizeof(tests) / sizeof(tests[0]); t++) {
+            char *msg = extract_wrapped_picture(tests[t].fex, tests[t].feature,
+                                                &ref, &dist, &ref_wrap,
+                                                &dist_wrap);
+            if (msg) return msg;
+        }
+    }
+    vmaf_set_cpu_flags_mask(-1);
+
+    vmaf_picture_unref(&ref);
+    vmaf_picture_unref(&dist);
+    vmaf_picture_unref(&ref_wrap);
+    vmaf_picture_unref(&dist_wrap);
+    free(ref_buf);
+    free(dist_buf);
+
+    return NULL;
+}
+
 char *run_tests()
 {
     mu_run_test(test_get_feature_extractor_by_name_and_feature_name);
     mu_run_test(test_feature_extractor_context_pool);
+    mu_run_test(test_feature_extractor_context_pool_budget);
     mu_run_test(test_feature_extractor_flush);
     mu_run_test(test_feature_extractor_initialization_options);
+    mu_run_test(test_feature_extractor_context_merge);
+    mu_run_test(test_feature_extractor_shared_picture_copy);
+    mu_run_test(test_feature_extractor_wrapped_picture);
     return NULL;
 }
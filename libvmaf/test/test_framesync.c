@@ -143,8 +143,57 @@ static char *test_framesync_create_process_and_destroy()
     return NULL;
 }
 
+static char *test_framesync_ring()
+{
+    int err;
+
+    VmafFrameSyncContext *fs_ctx;
+    err = vmaf_framesync_init(&fs_ctx);
+    mu_assert("problem during vmaf_framesync_init", !err);
+
+    // more frames in flight than the initial depth of the ring
+    const unsigned frame_cnt = 20;
+    uint8_t *buf[20];
+    for (unsigned i = 0; i < frame_cnt; i++) {
+        err = vmaf_framesync_acquire_new_buf(fs_ctx, (void*)&buf[i],
+                                             FRAME_BUF_LEN, i);
+        mu_assert("problem during vmaf_framesync_acquire_new_buf", !err);
+        memset(buf[i], i, FRAME_BUF_LEN);
+        err = vmaf_framesync_submit_filled_data(fs_ctx, buf[i], i);
+        mu_assert("problem during vmaf_framesync_submit_filled_data", !err);
+    }
+    uint8_t *data;
+    err = vmaf_framesync_acquire_new_buf(fs_ctx, (void*)&data,
+                                         FRAME_BUF_LEN, 0);
+    mu_assert("a frame should only be acquired once", err);
+
+    for (unsigned i = 0; i < frame_cnt; i++) {
+        err = vmaf_framesync_retrieve_filled_data(fs_ctx, (void*)&data, i);
+        mu_assert("problem during vmaf_framesync_retrieve_filled_data", !err);
+        mu_assert("retrieved data should be the submitted data",
+                  data == buf[i] && data[0] == i &&
+                  data[FRAME_BUF_LEN - 1] == i);
+        err = vmaf_framesync_release_buf(fs_ctx, data, i);
+        mu_assert("problem during vmaf_framesync_release_buf", !err);
+    }
+    err = vmaf_framesync_release_buf(fs_ctx, buf[0], 0);
+    mu_assert("a frame should only be released once", err);
+
+    // data buffers stay with their slot and are reused
+    err = vmaf_framesync_acquire_new_buf(fs_ctx, (void*)&data,
+                                         FRAME_BUF_LEN, 0);
+    mu_assert("problem during vmaf_framesync_acquire_new_buf", !err);
+    mu_assert("data buffer should be reused", data == buf[0]);
+
+    err = vmaf_framesync_destroy(fs_ctx);
+    mu_assert("problem during vmaf_framesync_destroy", !err);
+
+    return NULL;
+}
+
 char *run_tests()
 {
     mu_run_test(test_framesync_create_process_and_destroy);
+    mu_run_test(test_framesync_ring);
     return NULL;
 }
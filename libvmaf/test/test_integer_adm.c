@@ -0,0 +1,121 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include "test.h"
+#include "feature/integer_adm.c"
+
+static void fill(VmafPicture *ref, VmafPicture *dis, unsigned bpc)
+{
+    const unsigned max = (1 << bpc) - 1;
+    uint32_t x = bpc;
+    for (unsigned i = 0; i < ref->h[0]; i++) {
+        for (unsigned j = 0; j < ref->w[0]; j++) {
+            x = test_noise(x);
+            // a smooth gradient with small errors, and some noisy areas
+            const unsigned r = i < 24 ? ((i * 7 + j * 3) << (bpc - 8)) & max
+                                      : (x >> 8) & max;
+            const unsigned d = j < 40 ? (r ^ (x >> 29)) & max : x & max;
+            if (bpc > 8) {
+                ((uint16_t *)ref->data[0])[i * (ref->stride[0] / 2) + j] = r;
+                ((uint16_t *)dis->data[0])[i * (dis->stride[0] / 2) + j] = d;
+            } else {
+                ((uint8_t *)ref->data[0])[i * ref->stride[0] + j] = r;
+                ((uint8_t *)dis->data[0])[i * dis->stride[0] + j] = d;
+            }
+        }
+    }
+}
+
+static int compute(VmafPicture *ref, VmafPicture *dis, double *score,
+                   double *scores, const double *gain_limit, unsigned cnt)
+{
+    AdmState s = {
+        .adm_enhn_gain_limit = DEFAULT_ADM_ENHN_GAIN_LIMIT,
+        .adm_norm_view_dist = DEFAULT_ADM_NORM_VIEW_DIST,
+        .adm_ref_display_height = DEFAULT_ADM_REF_DISPLAY_HEIGHT,
+    };
+    VmafFeatureExtractor fex = vmaf_fex_integer_adm;
+    fex.priv = &s;
+    int err = init(&fex, VMAF_PIX_FMT_YUV420P, ref->bpc, ref->w[0], ref->h[0]);
+    if (err) return err;
+    double num[ADM_MAX_ENHN_GAIN_LIMITS], den[ADM_MAX_ENHN_GAIN_LIMITS];
+    integer_compute_adm(&s, ref, dis, score, num, den, scores, &s.buf,
+                        gain_limit, cnt, s.adm_norm_view_dist,
+                        s.adm_ref_display_height);
+    return close(&fex);
+}
+
+static char *test_integer_compute_adm()
+{
+    // odd sizes, and widths that are and are not multiples of the vector width
+    const unsigned size[][2] = { { 33, 33 }, { 67, 45 }, { 72, 40 }, { 136, 74 } };
+
+    vmaf_init_cpu();
+
+    for (unsigned bpc = 8; bpc <= 12; bpc += 2) {
+        for (unsigned i = 0; i < sizeof(size) / sizeof(size[0]); i++) {
+            VmafPicture ref, dis;
+            int err = vmaf_picture_alloc(&ref, VMAF_PIX_FMT_YUV420P, bpc,
+                                         size[i][0], size[i][1]);
+            err |= vmaf_picture_alloc(&dis, VMAF_PIX_FMT_YUV420P, bpc,
+                                      size[i][0], size[i][1]);
+            mu_assert("problem during vmaf_picture_alloc", !err);
+            fill(&ref, &dis, bpc);
+
+            const double gain_limit[] = { DEFAULT_ADM_ENHN_GAIN_LIMIT, 1.0 };
+            double expected[2], expected_scores[2 * 8];
+            vmaf_set_cpu_flags_mask(0);
+            err = compute(&ref, &dis, expected, expected_scores, gain_limit, 2);
+            mu_assert("problem during integer_compute_adm", !err);
+
+            // both gain limits in one pass should match two separate passes
+            for (unsigned k = 0; k < 2; k++) {
+                double score, scores[8];
+                err = compute(&ref, &dis, &score, scores, &gain_limit[k], 1);
+                mu_assert("problem during integer_compute_adm", !err);
+                mu_assert("adm variants should match separate passes",
+                          !memcmp(&score, &expected[k], sizeof(score)));
+                mu_assert("adm variants should match separate passes",
+                          !memcmp(scores, &expected_scores[8 * k],
+                                  sizeof(scores)));
+            }
+
+            for_each_cpu_level(level) {
+                double score[2], scores[2 * 8];
+                err = compute(&ref, &dis, score, scores, gain_limit, 2);
+                mu_assert("problem during integer_compute_adm", !err);
+                mu_assert("adm should be bit-exact with the scalar code",
+                          !memcmp(score, expected, sizeof(score)));
+                mu_assert("adm scales should be bit-exact with the scalar code",
+                          !memcmp(scores, expected_scores, sizeof(scores)));
+            }
+
+            vmaf_picture_unref(&ref);
+            vmaf_picture_unref(&dis);
+        }
+    }
+    vmaf_set_cpu_flags_mask(-1);
+
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_integer_compute_adm);
+    return NULL;
+}
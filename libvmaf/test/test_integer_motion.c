@@ -0,0 +1,121 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include "test.h"
+#include "feature/integer_motion.c"
+
+static void fill(VmafPicture *pic, unsigned seed)
+{
+    const unsigned max = (1 << pic->bpc) - 1;
+    uint32_t x = seed;
+    for (unsigned i = 0; i < pic->h[0]; i++) {
+        for (unsigned j = 0; j < pic->w[0]; j++) {
+            x = test_noise(x);
+            const unsigned v = (x >> 8) & max;
+            if (pic->bpc > 8)
+                ((uint16_t *)pic->data[0])[i * (pic->stride[0] / 2) + j] = v;
+            else
+                ((uint8_t *)pic->data[0])[i * pic->stride[0] + j] = v;
+        }
+    }
+}
+
+static int blur_and_sad(VmafPicture *a, VmafPicture *b, VmafPicture *c,
+                        MotionState *s, uint64_t sad[3])
+{
+    VmafFeatureExtractor fex = {
+        .name = "motion", .priv = s, .options = options,
+        .provided_features = provided_features,
+    };
+    int err = init(&fex, VMAF_PIX_FMT_YUV420P, a->bpc, a->w[0], a->h[0]);
+    if (err) return err;
+    blur_ref(s, a, s->blur[0].data[0]);
+    blur_ref(s, b, s->blur[1].data[0]);
+    blur_ref(s, c, s->blur[2].data[0]);
+    const ptrdiff_t stride = s->blur[0].stride[0] / 2;
+    sad[0] = s->sad(s->blur[0].data[0], stride, s->blur[1].data[0], stride,
+                    a->w[0], a->h[0]);
+    s->sad_pair(s->blur[0].data[0], s->blur[1].data[0], s->blur[2].data[0],
+                stride, a->w[0], a->h[0], &sad[1], &sad[2]);
+    return 0;
+}
+
+static char *test_blur_and_sad()
+{
+    // widths around the vector widths of every kernel
+    const unsigned size[][2] = { { 5, 5 }, { 37, 9 }, { 64, 17 }, { 99, 33 } };
+
+    vmaf_init_cpu();
+
+    for (unsigned bpc = 8; bpc <= 16; bpc += bpc == 12 ? 4 : 2) {
+        for (unsigned i = 0; i < sizeof(size) / sizeof(size[0]); i++) {
+            const unsigned w = size[i][0], h = size[i][1];
+            VmafPicture a, b, c;
+            int err = vmaf_picture_alloc(&a, VMAF_PIX_FMT_YUV420P, bpc, w, h);
+            err |= vmaf_picture_alloc(&b, VMAF_PIX_FMT_YUV420P, bpc, w, h);
+            err |= vmaf_picture_alloc(&c, VMAF_PIX_FMT_YUV420P, bpc, w, h);
+            mu_assert("problem during vmaf_picture_alloc", !err);
+            fill(&a, bpc);
+            fill(&b, bpc + 1);
+            fill(&c, bpc + 2);
+
+            MotionState m = { 0 };
+            uint64_t expected[3];
+            vmaf_set_cpu_flags_mask(0);
+            err = blur_and_sad(&a, &b, &c, &m, expected);
+            mu_assert("problem during init", !err);
+            mu_assert("the fused sad should match the single one",
+                      expected[1] == expected[0]);
+
+            for_each_cpu_level(level) {
+                MotionState s = { 0 };
+                uint64_t sad[3];
+                err = blur_and_sad(&a, &b, &c, &s, sad);
+                mu_assert("problem during init", !err);
+                for (unsigned k = 0; k < 3; k++) {
+                    for (unsigned y = 0; y < h; y++) {
+                        const uint16_t *blur = s.blur[k].data[0];
+                        const uint16_t *expected_blur = m.blur[k].data[0];
+                        mu_assert("blur should be bit-exact with the scalar code",
+                                  !memcmp(blur + y * s.blur[k].stride[0] / 2,
+                                          expected_blur + y * m.blur[k].stride[0] / 2,
+                                          w * sizeof(*blur)));
+                    }
+                }
+                mu_assert("sad should be bit-exact with the scalar code",
+                          !memcmp(sad, expected, sizeof(sad)));
+                VmafFeatureExtractor fex = { .priv = &s };
+                close(&fex);
+            }
+            VmafFeatureExtractor fex_m = { .priv = &m };
+            close(&fex_m);
+            vmaf_picture_unref(&a);
+            vmaf_picture_unref(&b);
+            vmaf_picture_unref(&c);
+        }
+    }
+    vmaf_set_cpu_flags_mask(-1);
+
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_blur_and_sad);
+    return NULL;
+}
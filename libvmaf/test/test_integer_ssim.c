@@ -0,0 +1,90 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <math.h>
+
+#include "test.h"
+#include "feature/integer_ssim.c"
+
+static char *test_calc_ssim()
+{
+    enum { w = 67, h = 45, stride = 2 * 72 };
+    static unsigned char ref[stride * h], dis[stride * h];
+    const int size[][2] = { { 1, 1 }, { 3, 2 }, { 9, 9 }, { 17, 5 }, { w, h } };
+
+    vmaf_init_cpu();
+
+    for (int bpc = 8; bpc <= 16; bpc += bpc == 12 ? 4 : 2) {
+        const int hbd = bpc > 8;
+        const unsigned max = (1 << bpc) - 1;
+        uint32_t x = bpc;
+        for (unsigned i = 0; i < h; i++) {
+            for (unsigned j = 0; j < w; j++) {
+                x = test_noise(x);
+                const unsigned r = (x >> 8) & max;
+                // small errors, and some unrelated areas
+                const unsigned d = j < 40 ? (r ^ (x >> 29)) & max : x & max;
+                if (hbd) {
+                    ((uint16_t*) (ref + i * stride))[j] = r;
+                    ((uint16_t*) (dis + i * stride))[j] = d;
+                } else {
+                    ref[i * stride + j] = r;
+                    dis[i * stride + j] = d;
+                }
+            }
+        }
+
+        for (unsigned i = 0; i < sizeof(size) / sizeof(size[0]); i++) {
+            const int sw = size[i][0], sh = size[i][1];
+
+            SsimState c = { 0 };
+            VmafFeatureExtractor fex_c = { .name = "ssim", .priv = &c };
+            vmaf_set_cpu_flags_mask(0);
+            int err = init(&fex_c, VMAF_PIX_FMT_YUV420P, bpc, sw, sh);
+            mu_assert("problem during init", !err);
+            const double expected =
+                calc_ssim(&c, ref, stride, dis, stride, bpc, sw, sh);
+            const double same =
+                calc_ssim(&c, ref, stride, ref, stride, bpc, sw, sh);
+            mu_assert("ssim of a picture with itself should be 1",
+                      fabs(same - 1.) < 1e-12);
+
+            for_each_cpu_level(level) {
+                SsimState s = { 0 };
+                VmafFeatureExtractor fex = { .name = "ssim", .priv = &s };
+                err = init(&fex, VMAF_PIX_FMT_YUV420P, bpc, sw, sh);
+                mu_assert("problem during init", !err);
+                const double score =
+                    calc_ssim(&s, ref, stride, dis, stride, bpc, sw, sh);
+                mu_assert("ssim should be bit-exact with the scalar code",
+                          !memcmp(&score, &expected, sizeof(score)));
+                close(&fex);
+            }
+            close(&fex_c);
+        }
+    }
+    vmaf_set_cpu_flags_mask(-1);
+
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_calc_ssim);
+    return NULL;
+}
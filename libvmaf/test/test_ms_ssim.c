@@ -0,0 +1,95 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <math.h>
+#include <stdint.h>
+
+#include "test.h"
+#include "feature/ms_ssim.c"
+
+static void fill(MsSsimBuffer *buf, const float *ref, const float *dis,
+                 int w, int h)
+{
+    for (int i = 0; i < h; i++) {
+        memcpy(buf->ref[0] + i * buf->stride[0], ref + i * w, w * sizeof(float));
+        memcpy(buf->cmp[0] + i * buf->stride[0], dis + i * w, w * sizeof(float));
+    }
+}
+
+static char *test_compute_ms_ssim()
+{
+    enum { w = 203, h = 181 };
+    static float ref[w * h], dis[w * h];
+    const int size[][2] = { { 176, 176 }, { 177, 191 }, { w, h } };
+
+    uint32_t x = 1;
+    for (unsigned i = 0; i < w * h; i++) {
+        x = test_noise(x);
+        // small errors, and a flat area which is equal in both
+        ref[i] = i % w < 150 ? (x >> 8) & 255 : 128;
+        dis[i] = i % w < 150 ? ref[i] + (int) (x >> 28) - 8 : ref[i];
+    }
+
+    MsSsimBuffer buf;
+    mu_assert("pictures below 176x176 should be rejected",
+              ms_ssim_buffer_init(&buf, 175, 200) == -EINVAL);
+
+    vmaf_init_cpu();
+
+    for (unsigned i = 0; i < sizeof(size) / sizeof(size[0]); i++) {
+        const int sw = size[i][0], sh = size[i][1];
+        double expected, l[5], c[5], s[5];
+        double score, l_[5], c_[5], s_[5];
+
+        vmaf_set_cpu_flags_mask(0);
+        int err = ms_ssim_buffer_init(&buf, sw, sh);
+        mu_assert("problem during ms_ssim_buffer_init", !err);
+        fill(&buf, ref, ref, sw, sh);
+        err = compute_ms_ssim(&buf, &score, l, c, s);
+        mu_assert("problem during compute_ms_ssim", !err);
+        mu_assert("ms_ssim of a picture with itself should be 1",
+                  fabs(score - 1.) < 1e-6);
+        fill(&buf, ref, dis, sw, sh);
+        err = compute_ms_ssim(&buf, &expected, l, c, s);
+        mu_assert("problem during compute_ms_ssim", !err);
+        mu_assert("ms_ssim should be below 1", expected < 1.);
+        ms_ssim_buffer_free(&buf);
+
+        for_each_cpu_level(level) {
+            err = ms_ssim_buffer_init(&buf, sw, sh);
+            mu_assert("problem during ms_ssim_buffer_init", !err);
+            fill(&buf, ref, dis, sw, sh);
+            err = compute_ms_ssim(&buf, &score, l_, c_, s_);
+            mu_assert("problem during compute_ms_ssim", !err);
+            mu_assert("ms_ssim should be bit-exact with the scalar code",
+                      !memcmp(&score, &expected, sizeof(score)) &&
+                      !memcmp(l_, l, sizeof(l)) && !memcmp(c_, c, sizeof(c)) &&
+                      !memcmp(s_, s, sizeof(s)));
+            ms_ssim_buffer_free(&buf);
+        }
+    }
+    vmaf_set_cpu_flags_mask(-1);
+
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_compute_ms_ssim);
+    return NULL;
+}
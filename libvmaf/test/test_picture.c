@@ -16,10 +16,15 @@
  *
  */
 
+#include <errno.h>
+#include <pthread.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "test.h"
+#include "cpu.h"
 #include "picture.h"
+#include "picture_import.h"
 #include "libvmaf/picture.h"
 #include "ref.h"
 
@@ -65,9 +70,326 @@ static char *test_picture_data_alignment()
     return NULL;
 }
 
+static char *test_picture_import_planes()
+{
+    int err;
+    enum { w = 97, h = 33 };
+    uint8_t src_8[w * h];
+    uint16_t src_10[w * h];
+    uint16_t expected[w * h];
+
+    for (unsigned i = 0; i < w * h; i++) {
+        src_8[i] = (i * 7) & 0xFF;
+        src_10[i] = (i * 13) & 0x3FF;
+    }
+
+    vmaf_init_cpu();
+
+    VmafPicture pic;
+    const void *data_8[3] = { src_8, src_8, src_8 };
+    const ptrdiff_t stride_8[3] = { w, w, w };
+    err = vmaf_picture_alloc(&pic, VMAF_PIX_FMT_YUV444P, 10, w, h);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    err = vmaf_picture_import_planes(&pic, data_8, stride_8, 8);
+    mu_assert("problem during vmaf_picture_import_planes", !err);
+    picture_import_u8_c(expected, w * 2, src_8, w, w, h, 2);
+    for (unsigned p = 0; p < 3; p++) {
+        for (unsigned i = 0; i < h; i++) {
+            uint16_t *row = (uint16_t*)pic.data[p] + i * (pic.stride[p] / 2);
+            mu_assert("8-bit to 10-bit import mismatch",
+                      !memcmp(row, &expected[i * w], w * 2));
+        }
+    }
+    err = vmaf_picture_unref(&pic);
+    mu_assert("problem during vmaf_picture_unref", !err);
+
+    const void *data_10[3] = { src_10, src_10, src_10 };
+    const ptrdiff_t stride_10[3] = { w * 2, w * 2, w * 2 };
+    err = vmaf_picture_alloc(&pic, VMAF_PIX_FMT_YUV444P, 12, w, h);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    err = vmaf_picture_import_planes(&pic, data_10, stride_10, 10);
+    mu_assert("problem during vmaf_picture_import_planes", !err);
+    picture_import_u16_c(expected, w * 2, src_10, w * 2, w, h, 2);
+    for (unsigned i = 0; i < h; i++) {
+        uint16_t *row = (uint16_t*)pic.data[0] + i * (pic.stride[0] / 2);
+        mu_assert("10-bit to 12-bit import mismatch",
+                  !memcmp(row, &expected[i * w], w * 2));
+    }
+    err = vmaf_picture_import_planes(&pic, data_10, stride_10, 10 + 4);
+    mu_assert("import with bpc > pic->bpc should fail", err);
+    err = vmaf_picture_unref(&pic);
+    mu_assert("problem during vmaf_picture_unref", !err);
+
+    err = vmaf_picture_alloc(&pic, VMAF_PIX_FMT_YUV444P, 10, w, h);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    err = vmaf_picture_import_planes(&pic, data_10, stride_10, 10);
+    mu_assert("problem during vmaf_picture_import_planes", !err);
+    for (unsigned i = 0; i < h; i++) {
+        uint16_t *row = (uint16_t*)pic.data[2] + i * (pic.stride[2] / 2);
+        mu_assert("10-bit plane copy mismatch",
+                  !memcmp(row, &src_10[i * w], w * 2));
+    }
+    err = vmaf_picture_unref(&pic);
+    mu_assert("problem during vmaf_picture_unref", !err);
+
+    return NULL;
+}
+
+static int release_cnt;
+
+static int release_wrapped(VmafPicture *pic, void *cookie)
+{
+    if (pic->data[0] == cookie)
+        release_cnt++;
+    return 0;
+}
+
+static char *test_picture_wrap()
+{
+    int err;
+    enum { w = 97, h = 33 };
+    uint8_t y[w * h], u[(w / 2) * (h / 2)], v[(w / 2) * (h / 2)];
+    void *data[3] = { y, u, v };
+    const ptrdiff_t stride[3] = { w, w / 2, w / 2 };
+
+    VmafPicture pic_a, pic_b;
+    err = vmaf_picture_wrap(&pic_a, VMAF_PIX_FMT_YUV420P, 8, w, h, data,
+                            stride, y, NULL);
+    mu_assert("wrap without a release callback should fail", err);
+    const ptrdiff_t short_stride[3] = { w - 1, w / 2, w / 2 };
+    err = vmaf_picture_wrap(&pic_a, VMAF_PIX_FMT_YUV420P, 8, w, h, data,
+                            short_stride, y, release_wrapped);
+    mu_assert("wrap with a stride shorter than a row should fail", err);
+    void *odd_data[3] = { y + 1, u, v };
+    const ptrdiff_t stride_16[3] = { 2 * w, w, w };
+    err = vmaf_picture_wrap(&pic_a, VMAF_PIX_FMT_YUV420P, 10, w / 2, h / 2,
+                            odd_data, stride_16, y, release_wrapped);
+    mu_assert("wrap with misaligned 16-bit samples should fail", err);
+
+    release_cnt = 0;
+    err = vmaf_picture_wrap(&pic_a, VMAF_PIX_FMT_YUV420P, 8, w, h, data,
+                            stride, y, release_wrapped);
+    mu_assert("problem during vmaf_picture_wrap", !err);
+    mu_assert("wrapped picture should point to the planes",
+              pic_a.data[0] == y && pic_a.data[1] == u && pic_a.data[2] == v);
+    mu_assert("wrapped picture should keep the strides",
+              pic_a.stride[0] == w && pic_a.stride[1] == w / 2 &&
+              pic_a.stride[2] == w / 2);
+    mu_assert("wrapped picture should have chroma dimensions",
+              pic_a.w[1] == w / 2 && pic_a.h[1] == h / 2);
+    err = vmaf_picture_ref(&pic_b, &pic_a);
+    mu_assert("problem during vmaf_picture_ref", !err);
+    err = vmaf_picture_unref(&pic_a);
+    mu_assert("problem during vmaf_picture_unref", !err);
+    mu_assert("planes should not be released while referenced", !release_cnt);
+    err = vmaf_picture_unref(&pic_b);
+    mu_assert("problem during vmaf_picture_unref", !err);
+    mu_assert("planes should be released once", release_cnt == 1);
+
+    void *gray[3] = { y, NULL, NULL };
+    err = vmaf_picture_wrap(&pic_a, VMAF_PIX_FMT_YUV400P, 8, w, h, gray,
+                            stride, y, release_wrapped);
+    mu_assert("problem during vmaf_picture_wrap", !err);
+    mu_assert("wrapped gray picture should have no chroma",
+              !pic_a.data[1] && !pic_a.w[1]);
+    err = vmaf_picture_unref(&pic_a);
+    mu_assert("problem during vmaf_picture_unref", !err);
+    mu_assert("planes should be released once", release_cnt == 2);
+
+    return NULL;
+}
+
+static void *release_pictures(void *arg)
+{
+    VmafPicture *pic = arg;
+    for (unsigned i = 0; i < 16; i++)
+        vmaf_picture_unref(&pic[i]);
+    return NULL;
+}
+
+static char *test_picture_pool()
+{
+    int err;
+
+    VmafPicturePool *pool;
+    err = vmaf_picture_pool_init(&pool, VMAF_PIX_FMT_YUV420P, 10, 97, 33);
+    mu_assert("problem during vmaf_picture_pool_init", !err);
+
+    VmafPicture pic_a, pic_b, pic_c;
+    err = vmaf_picture_pool_fetch(pool, &pic_a);
+    err |= vmaf_picture_pool_fetch(pool, &pic_b);
+    mu_assert("problem during vmaf_picture_pool_fetch", !err);
+    mu_assert("pictures in use should not share data",
+              pic_a.data[0] != pic_b.data[0]);
+    mu_assert("pool picture should have the pool geometry",
+              pic_a.bpc == 10 && pic_a.w[0] == 97 && pic_a.h[0] == 33 &&
+              pic_a.w[1] == 48 && pic_a.h[1] == 16 && pic_a.stride[0] == 256);
+
+    void *const data = pic_a.data[0];
+    void *const priv = pic_a.priv;
+    VmafRef *const ref = pic_a.ref;
+    memset(data, 0xab, pic_a.stride[0]);
+    err = vmaf_picture_unref(&pic_a);
+    mu_assert("problem during vmaf_picture_unref", !err);
+    err = vmaf_picture_pool_fetch(pool, &pic_c);
+    mu_assert("problem during vmaf_picture_pool_fetch", !err);
+    mu_assert("released picture should be recycled",
+              pic_c.data[0] == data && pic_c.priv == priv && pic_c.ref == ref);
+    mu_assert("recycled picture should have one reference",
+              vmaf_ref_load(pic_c.ref) == 1);
+    mu_assert("recycled picture should not be cleared",
+              ((uint8_t *)pic_c.data[0])[0] == 0xab);
+    err = vmaf_picture_artifact_cache_init(&pic_c);
+    mu_assert("problem during vmaf_picture_artifact_cache_init", !err);
+    err = vmaf_picture_unref(&pic_c);
+    mu_assert("problem during vmaf_picture_unref", !err);
+    err = vmaf_picture_pool_fetch(pool, &pic_c);
+    mu_assert("problem during vmaf_picture_pool_fetch", !err);
+    mu_assert("recycled picture should not have an artifact cache",
+              !vmaf_picture_artifact_cache_enabled(&pic_c));
+    err = vmaf_picture_unref(&pic_c);
+    mu_assert("problem during vmaf_picture_unref", !err);
+
+    // release concurrently, then everything should be recycled
+    enum { n_threads = 4 };
+    VmafPicture pic[n_threads][16];
+    for (unsigned t = 0; t < n_threads; t++) {
+        for (unsigned i = 0; i < 16; i++) {
+            err = vmaf_picture_pool_fetch(pool, &pic[t][i]);
+            mu_assert("problem during vmaf_picture_pool_fetch", !err);
+        }
+    }
+    void *fetched[n_threads * 16];
+    for (unsigned t = 0; t < n_threads; t++) {
+        for (unsigned i = 0; i < 16; i++)
+            fetched[t * 16 + i] = pic[t][i].data[0];
+    }
+    pthread_t thread[n_threads];
+    for (unsigned t = 0; t < n_threads; t++)
+        pthread_create(&thread[t], NULL, release_pictures, pic[t]);
+    for (unsigned t = 0; t < n_threads; t++)
+        pthread_join(thread[t], NULL);
+    for (unsigned t = 0; t < n_threads; t++) {
+        for (unsigned i = 0; i < 16; i++) {
+            err = vmaf_picture_pool_fetch(pool, &pic[t][i]);
+            mu_assert("problem during vmaf_picture_pool_fetch", !err);
+            unsigned found = 0;
+            for (unsigned k = 0; k < n_threads * 16; k++) {
+                if (fetched[k] != pic[t][i].data[0]) continue;
+                fetched[k] = NULL;
+                found++;
+            }
+            mu_assert("released pictures should all be recycled once",
+                      found == 1);
+        }
+    }
+    for (unsigned t = 0; t < n_threads; t++) {
+        for (unsigned i = 0; i < 16; i++)
+            vmaf_picture_unref(&pic[t][i]);
+    }
+
+    // pictures in use outlive the pool
+    err = vmaf_picture_pool_close(pool);
+    mu_assert("problem during vmaf_picture_pool_close", !err);
+    memset(pic_b.data[0], 0, pic_b.stride[0] * pic_b.h[0]);
+    err = vmaf_picture_unref(&pic_b);
+    mu_assert("problem during vmaf_picture_unref", !err);
+
+    return NULL;
+}
+
+static int produce_cnt;
+
+static int produce_artifact(void *data, void *cookie)
+{
+    memset(data, *(int *)cookie, 64);
+    produce_cnt++;
+    return 0;
+}
+
+static int produce_artifact_fail(void *data, void *cookie)
+{
+    (void) data;
+    (void) cookie;
+    return -EIO;
+}
+
+static char *test_picture_artifact_cache()
+{
+    int err;
+
+    VmafPicture pic_a, pic_b;
+    err = vmaf_picture_alloc(&pic_a, VMAF_PIX_FMT_YUV400P, 8, 64, 64);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    mu_assert("artifact cache should be disabled by default",
+              !vmaf_picture_artifact_cache_enabled(&pic_a));
+
+    int val = 0x5a;
+    const void *data;
+    err = vmaf_picture_artifact_get(&pic_a, "key", 64, produce_artifact,
+                                    &val, &data);
+    mu_assert("artifact_get should fail without a cache", err);
+
+    err = vmaf_picture_artifact_cache_init(&pic_a);
+    mu_assert("problem during vmaf_picture_artifact_cache_init", !err);
+    err = vmaf_picture_ref(&pic_b, &pic_a);
+    mu_assert("problem during vmaf_picture_ref", !err);
+    mu_assert("artifact cache should be shared between refs",
+              vmaf_picture_artifact_cache_enabled(&pic_b));
+
+    produce_cnt = 0;
+    const void *data_a, *data_b;
+    err = vmaf_picture_artifact_get(&pic_a, "key", 64, produce_artifact,
+                                    &val, &data_a);
+    mu_assert("problem during vmaf_picture_artifact_get", !err);
+    err = vmaf_picture_artifact_get(&pic_b, "key", 64, produce_artifact,
+                                    &val, &data_b);
+    mu_assert("problem during vmaf_picture_artifact_get", !err);
+    mu_assert("artifact should be produced once", produce_cnt == 1);
+    mu_assert("artifact should be shared", data_a == data_b);
+    mu_assert("artifact has unexpected contents",
+              ((const uint8_t *)data_b)[63] == 0x5a);
+
+    err = vmaf_picture_artifact_get(&pic_b, "key", 32, produce_artifact,
+                                    &val, &data_b);
+    mu_assert("artifact size mismatch should fail", err == -EINVAL);
+
+    err = vmaf_picture_artifact_get(&pic_b, "other", 64,
+                                    produce_artifact_fail, &val, &data_b);
+    mu_assert("produce error should be propagated", err == -EIO);
+    err = vmaf_picture_artifact_get(&pic_b, "other", 64, produce_artifact,
+                                    &val, &data_b);
+    mu_assert("failed artifact should be produced again", !err);
+    mu_assert("artifact should be produced twice", produce_cnt == 2);
+
+    mu_assert("undeclared artifact should not be shared",
+              !vmaf_picture_artifact_shared(&pic_a, "key"));
+    err = vmaf_picture_artifact_declare(&pic_a, "key");
+    mu_assert("problem during vmaf_picture_artifact_declare", !err);
+    mu_assert("artifact declared once should not be shared",
+              !vmaf_picture_artifact_shared(&pic_b, "key"));
+    err = vmaf_picture_artifact_declare(&pic_b, "key");
+    mu_assert("problem during vmaf_picture_artifact_declare", !err);
+    mu_assert("artifact declared twice should be shared",
+              vmaf_picture_artifact_shared(&pic_a, "key"));
+    mu_assert("declarations should be counted per artifact",
+              !vmaf_picture_artifact_shared(&pic_a, "other"));
+
+    err = vmaf_picture_unref(&pic_a);
+    mu_assert("problem during vmaf_picture_unref", !err);
+    err = vmaf_picture_unref(&pic_b);
+    mu_assert("problem during vmaf_picture_unref", !err);
+
+    return NULL;
+}
+
 char *run_tests()
 {
     mu_run_test(test_picture_alloc_ref_and_unref);
     mu_run_test(test_picture_data_alignment);
+    mu_run_test(test_picture_import_planes);
+    mu_run_test(test_picture_wrap);
+    mu_run_test(test_picture_pool);
+    mu_run_test(test_picture_artifact_cache);
     return NULL;
 }
@@ -0,0 +1,115 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <string.h>
+
+#include "test.h"
+#include "mem.h"
+#include "feature/motion_tools.h"
+#include "feature/picture_copy.c"
+
+static char *test_picture_copy()
+{
+    enum { w = 75, h = 21 };
+    const unsigned bpc_list[] = { 8, 10, 12, 16 };
+    const float filter_3[3] = { 0.25f, 0.5f, 0.25f };
+    const ptrdiff_t stride = ALIGN_CEIL(w * sizeof(float));
+    float *expected = aligned_malloc(stride * h, 32);
+    float *ref = aligned_malloc(stride * h, 32);
+    float *blur = aligned_malloc(stride * h, 32);
+    float *out = aligned_malloc(stride * h, 32);
+    float *tmp = aligned_malloc(stride * h, 32);
+    mu_assert("problem during aligned_malloc",
+              expected && ref && blur && out && tmp);
+
+    vmaf_init_cpu();
+
+    for (unsigned b = 0; b < sizeof(bpc_list) / sizeof(bpc_list[0]); b++) {
+        const unsigned bpc = bpc_list[b];
+        VmafPicture pic;
+        int err = vmaf_picture_alloc(&pic, VMAF_PIX_FMT_YUV420P, bpc, w, h);
+        mu_assert("problem during vmaf_picture_alloc", !err);
+
+        const float scaler = bpc == 8 ? 1.0f : (float) (1 << (bpc - 8));
+        uint32_t x = bpc;
+        for (unsigned i = 0; i < h; i++) {
+            for (unsigned j = 0; j < w; j++) {
+                x = test_noise(x);
+                const unsigned v = (x >> 8) & ((1 << bpc) - 1);
+                if (bpc > 8)
+                    ((uint16_t *)((uint8_t *)pic.data[0] + i * pic.stride[0]))[j] = v;
+                else
+                    ((uint8_t *)pic.data[0] + i * pic.stride[0])[j] = v;
+                expected[i * stride / sizeof(float) + j] =
+                    (float) v / scaler - 128;
+            }
+        }
+
+        // scalar reference
+        vmaf_set_cpu_flags_mask(0);
+        picture_copy(ref, stride, &pic, -128, bpc);
+        for (unsigned i = 0; i < h; i++) {
+            mu_assert("picture_copy should divide by the scaler",
+                      !memcmp(ref + i * stride / sizeof(float),
+                              expected + i * stride / sizeof(float),
+                              w * sizeof(float)));
+        }
+
+        for_each_cpu_level(level) {
+            picture_copy(out, stride, &pic, -128, bpc);
+            for (unsigned i = 0; i < h; i++) {
+                mu_assert("picture_copy should be bit-exact with the scalar code",
+                          !memcmp(out + i * stride / sizeof(float),
+                                  expected + i * stride / sizeof(float),
+                                  w * sizeof(float)));
+            }
+
+            for (unsigned f = 0; f < 2; f++) {
+                const float *filter = f ? filter_3 : FILTER_5_s;
+                const int filter_width = f ? 3 : 5;
+                convolution_f32_c_s(filter, filter_width, ref, blur, tmp, w, h,
+                                    stride / sizeof(float),
+                                    stride / sizeof(float));
+                picture_copy_convolution(filter, filter_width, &pic, -128,
+                                         out, tmp, stride);
+                for (unsigned i = 0; i < h; i++) {
+                    mu_assert("fused filter should match picture_copy + filter",
+                              !memcmp(out + i * stride / sizeof(float),
+                                      blur + i * stride / sizeof(float),
+                                      w * sizeof(float)));
+                }
+            }
+        }
+        vmaf_picture_unref(&pic);
+    }
+    vmaf_set_cpu_flags_mask(-1);
+
+    aligned_free(expected);
+    aligned_free(ref);
+    aligned_free(blur);
+    aligned_free(out);
+    aligned_free(tmp);
+
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_picture_copy);
+    return NULL;
+}
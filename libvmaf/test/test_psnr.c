@@ -63,6 +63,7 @@ static char *test_16b_large_diff()
         .enable_mse = 1,
         .enable_apsnr = 0,
         .peak = 65535,
+        .sse_16 = psnr_sse_16,
     };
 
     err |= psnr_hbd(&pic1, &pic2, 0, fc, &psnr_state);
@@ -92,10 +93,48 @@ static char *test_16b_large_diff()
     return NULL;
 }
 
+static char *test_sse_kernels()
+{
+    enum { w = 301, h = 7, stride = 320 };
+    uint8_t ref_8[stride * h], dis_8[stride * h];
+    uint16_t ref_16[stride * h], dis_16[stride * h];
+
+    uint32_t x = 1;
+    for (unsigned i = 0; i < stride * h; i++) {
+        x = test_noise(x);
+        ref_8[i] = x >> 24;
+        dis_8[i] = x >> 16;
+        ref_16[i] = x >> 16;
+        dis_16[i] = i & 1 ? 0 : 65535;
+    }
+
+    vmaf_init_cpu();
+
+    for_each_cpu_level(level) {
+
+        PsnrState s = { 0 };
+        VmafFeatureExtractor fex = { .priv = &s };
+        int err = init(&fex, VMAF_PIX_FMT_YUV420P, 10, w, h);
+        mu_assert("problem during init", !err);
+
+        for (unsigned n = 1; n <= w; n += 6) {
+            mu_assert("8-bit sse mismatch",
+                      s.sse_8(ref_8, stride, dis_8, stride, n, h) ==
+                      psnr_sse_8(ref_8, stride, dis_8, stride, n, h));
+            mu_assert("16-bit sse mismatch",
+                      s.sse_16(ref_16, stride * 2, dis_16, stride * 2, n, h) ==
+                      psnr_sse_16(ref_16, stride * 2, dis_16, stride * 2, n, h));
+        }
+    }
+    vmaf_set_cpu_flags_mask(-1);
+
+    return NULL;
+}
 
 char *run_tests()
 {
     mu_run_test(test_16b_large_diff);
+    mu_run_test(test_sse_kernels);
 
     return NULL;
 }
\ No newline at end of file
@@ -0,0 +1,81 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include "test.h"
+#include "feature/third_party/xiph/psnr_hvs.c"
+
+static char *test_calc_psnrhvs()
+{
+    enum { w = 67, h = 45, stride = 2 * 72 };
+    static unsigned char ref[stride * h], dis[stride * h];
+
+    vmaf_init_cpu();
+
+    for_each_cpu_level(level) {
+
+        PsnrHvsState s = { 0 };
+        VmafFeatureExtractor fex = { .name = "psnr_hvs", .priv = &s };
+        int err = init(&fex, VMAF_PIX_FMT_YUV420P, 8, w, h);
+        mu_assert("problem during init", !err);
+
+        for (int bpc = 8; bpc <= 12; bpc += 2) {
+            const int hbd = bpc > 8;
+            const unsigned max = (1 << bpc) - 1;
+            uint32_t x = bpc;
+            for (unsigned i = 0; i < h; i++) {
+                for (unsigned j = 0; j < w; j++) {
+                    x = test_noise(x);
+                    const unsigned r = (x >> 8) & max;
+                    // small and saturating errors, and some flat areas
+                    const unsigned d = j < 20 ? r : j < 40 ? (r + (x >> 28)) & max :
+                                       (x >> 4) & max;
+                    if (hbd) {
+                        ((uint16_t*) (ref + i * stride))[j] = r;
+                        ((uint16_t*) (dis + i * stride))[j] = d;
+                    } else {
+                        ref[i * stride + j] = r;
+                        dis[i * stride + j] = d;
+                    }
+                }
+            }
+
+            for (unsigned c = 0; c < 3; c++) {
+                float (*csf)[8] = c == 0 ? csf_y : c == 1 ? csf_cb420 : csf_cr420;
+                for (int n = 8; n <= w; n += 5) {
+                    const double expected =
+                        calc_psnrhvs(ref, stride, dis, stride, 1.0, bpc, n, h,
+                                     7, csf);
+                    const double score =
+                        s.calc_psnrhvs(ref, stride, dis, stride, 1.0, bpc, n,
+                                       h, 7, csf);
+                    mu_assert("psnr_hvs should be bit-exact with the scalar code",
+                              !memcmp(&score, &expected, sizeof(score)));
+                }
+            }
+        }
+    }
+    vmaf_set_cpu_flags_mask(-1);
+
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_calc_psnrhvs);
+    return NULL;
+}
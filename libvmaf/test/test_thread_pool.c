@@ -16,6 +16,7 @@
  *
  */
 
+#include <stdatomic.h>
 #include <stdint.h>
 
 #include "test.h"
@@ -77,8 +78,44 @@ static char *test_thread_pool_create_enqueue_wait_and_destroy()
     return NULL;
 }
 
+static atomic_uint count;
+
+static void fn_count(void *data)
+{
+    (void) data;
+    atomic_fetch_add(&count, 1);
+}
+
+static char *test_thread_pool_ref()
+{
+    int err;
+
+    VmafThreadPool *pool;
+    err = vmaf_thread_pool_create(&pool, 2);
+    mu_assert("problem during vmaf_thread_pool_init", !err);
+    err = vmaf_thread_pool_ref(pool);
+    mu_assert("problem during vmaf_thread_pool_ref", !err);
+    err = vmaf_thread_pool_destroy(pool);
+    mu_assert("problem during vmaf_thread_pool_destroy", !err);
+
+    // the pool should still work for the remaining reference
+    count = 0;
+    for (unsigned i = 0; i < 16; i++) {
+        err = vmaf_thread_pool_enqueue(pool, fn_count, NULL, 0);
+        mu_assert("problem during vmaf_thread_pool_enqueue", !err);
+    }
+    err = vmaf_thread_pool_wait(pool);
+    mu_assert("problem during vmaf_thread_pool_wait", !err);
+    mu_assert("every job should have run", count == 16);
+    err = vmaf_thread_pool_destroy(pool);
+    mu_assert("problem during vmaf_thread_pool_destroy", !err);
+
+    return NULL;
+}
+
 char *run_tests()
 {
     mu_run_test(test_thread_pool_create_enqueue_wait_and_destroy);
+    mu_run_test(test_thread_pool_ref);
     return NULL;
 }
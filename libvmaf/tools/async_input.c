@@ -0,0 +1,255 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vidinput.h"
+
+/** Linkage will break without this if using a C++ compiler, and will issue
+ * warnings without this for a C compiler*/
+#if defined(__cplusplus)
+# define OC_EXTERN extern
+#else
+# define OC_EXTERN
+#endif
+
+/*
+ * Read-ahead wrapper around another `video_input`. A reader thread fetches
+ * (and converts) frames from the wrapped input into a ring of frame slots,
+ * so that a stalled producer on one pipe does not stall the consumer, and
+ * a slow consumer does not stall the producers until the ring is full.
+ */
+
+typedef struct async_slot {
+    video_input_ycbcr ycbcr;
+    uint8_t *buf;
+} async_slot;
+
+typedef struct async_input {
+    video_input src;
+    video_input_info info;
+    async_slot *slot;
+    unsigned slot_cnt;
+    unsigned head, cnt;
+    bool holding;
+    bool done, stop;
+    int ret;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty, not_full;
+} async_input;
+
+/*
+ * Only the part of each plane covered by the picture is buffered, at the same
+ * offset from the plane origin as in the wrapped input's frame.
+ */
+static void plane_region(async_input *async, video_input_ycbcr ycbcr,
+                         unsigned p, size_t *offset, size_t *size)
+{
+    const video_input_info *info = &async->info;
+    const int xdec = p && !(info->pixel_fmt & 1);
+    const int ydec = p && !(info->pixel_fmt & 2);
+    const int hbd = info->depth > 8;
+
+    *offset = (size_t) (info->pic_y >> ydec) * ycbcr[p].stride +
+              ((info->pic_x >> xdec) << hbd);
+    *size = (size_t) (info->pic_h >> ydec) * ycbcr[p].stride;
+}
+
+static int slot_alloc(async_input *async, video_input_ycbcr ycbcr)
+{
+    size_t offset[3], size[3], buf_sz = 0;
+    for (unsigned p = 0; p < 3; p++) {
+        plane_region(async, ycbcr, p, &offset[p], &size[p]);
+        buf_sz += offset[p] + size[p];
+    }
+
+    for (unsigned i = 0; i < async->slot_cnt; i++) {
+        uint8_t *buf = async->slot[i].buf = malloc(buf_sz);
+        if (!buf) return -1;
+        for (unsigned p = 0; p < 3; p++) {
+            async->slot[i].ycbcr[p] = ycbcr[p];
+            async->slot[i].ycbcr[p].data = buf;
+            buf += offset[p] + size[p];
+        }
+    }
+
+    return 0;
+}
+
+static void slot_copy(async_input *async, async_slot *slot,
+                      video_input_ycbcr ycbcr)
+{
+    for (unsigned p = 0; p < 3; p++) {
+        size_t offset, size;
+        plane_region(async, ycbcr, p, &offset, &size);
+        memcpy(slot->ycbcr[p].data + offset, ycbcr[p].data + offset, size);
+    }
+}
+
+static void *async_input_reader(void *arg)
+{
+    async_input *async = arg;
+    unsigned tail = 0;
+    int ret;
+
+    for (;;) {
+        pthread_mutex_lock(&async->lock);
+        while (async->cnt == async->slot_cnt && !async->stop)
+            pthread_cond_wait(&async->not_full, &async->lock);
+        const bool stop = async->stop;
+        pthread_mutex_unlock(&async->lock);
+        if (stop) {
+            ret = 0;
+            break;
+        }
+
+        video_input_ycbcr ycbcr;
+        ret = video_input_fetch_frame(&async->src, ycbcr, NULL);
+        if (ret < 1) break;
+
+        if (!async->slot[0].buf && slot_alloc(async, ycbcr)) {
+            fprintf(stderr, "Could not allocate read-ahead buffer.\n");
+            ret = -1;
+            break;
+        }
+        slot_copy(async, &async->slot[tail], ycbcr);
+        tail = (tail + 1) % async->slot_cnt;
+
+        pthread_mutex_lock(&async->lock);
+        async->cnt++;
+        pthread_cond_signal(&async->not_empty);
+        pthread_mutex_unlock(&async->lock);
+    }
+
+    pthread_mutex_lock(&async->lock);
+    async->done = true;
+    async->ret = ret;
+    pthread_cond_signal(&async->not_empty);
+    pthread_mutex_unlock(&async->lock);
+
+    return NULL;
+}
+
+static void async_input_get_info(async_input *async, video_input_info *info)
+{
+    *info = async->info;
+}
+
+static int async_input_fetch_frame(async_input *async, FILE *fin,
+                                   video_input_ycbcr ycbcr, char tag[5])
+{
+    (void) fin;
+
+    pthread_mutex_lock(&async->lock);
+    if (async->holding) {
+        async->head = (async->head + 1) % async->slot_cnt;
+        async->cnt--;
+        async->holding = false;
+        pthread_cond_signal(&async->not_full);
+    }
+    while (!async->cnt && !async->done)
+        pthread_cond_wait(&async->not_empty, &async->lock);
+
+    int ret = async->ret;
+    if (async->cnt) {
+        memcpy(ycbcr, async->slot[async->head].ycbcr, sizeof(video_input_ycbcr));
+        async->holding = true;
+        ret = 1;
+    }
+    pthread_mutex_unlock(&async->lock);
+
+    if (tag != NULL && ret == 1) tag[0] = '\0';
+    return ret;
+}
+
+static void async_input_close(async_input *async)
+{
+    pthread_mutex_lock(&async->lock);
+    async->stop = true;
+    pthread_cond_signal(&async->not_full);
+    pthread_mutex_unlock(&async->lock);
+    pthread_join(async->thread, NULL);
+
+    for (unsigned i = 0; i < async->slot_cnt; i++)
+        free(async->slot[i].buf);
+    free(async->slot);
+    pthread_cond_destroy(&async->not_full);
+    pthread_cond_destroy(&async->not_empty);
+    pthread_mutex_destroy(&async->lock);
+
+    (*async->src.vtbl->close)(async->src.ctx);
+    free(async->src.ctx);
+}
+
+static size_t async_input_frame_size(async_input *async)
+{
+    return (*async->src.vtbl->frame_size)(async->src.ctx);
+}
+
+OC_EXTERN const video_input_vtbl ASYNC_INPUT_VTBL={
+  (raw_input_open_func)NULL,
+  (video_input_open_func)NULL,
+  (video_input_get_info_func)async_input_get_info,
+  (video_input_fetch_frame_func)async_input_fetch_frame,
+  (video_input_close_func)async_input_close,
+  (video_input_frame_size_func)async_input_frame_size
+};
+
+int video_input_read_ahead(video_input *_vid, unsigned _frames)
+{
+    if (!_frames) return -1;
+
+    async_input *async = malloc(sizeof(*async));
+    if (!async) goto fail;
+    memset(async, 0, sizeof(*async));
+
+    /*One slot is held by the consumer while the reader fills the others.*/
+    async->slot_cnt = _frames + 1;
+    async->slot = calloc(async->slot_cnt, sizeof(*async->slot));
+    if (!async->slot) goto free_async;
+
+    async->src = *_vid;
+    video_input_get_info(&async->src, &async->info);
+    pthread_mutex_init(&async->lock, NULL);
+    pthread_cond_init(&async->not_empty, NULL);
+    pthread_cond_init(&async->not_full, NULL);
+
+    if (pthread_create(&async->thread, NULL, async_input_reader, async)) {
+        pthread_cond_destroy(&async->not_full);
+        pthread_cond_destroy(&async->not_empty);
+        pthread_mutex_destroy(&async->lock);
+        goto free_slot;
+    }
+
+    _vid->vtbl = &ASYNC_INPUT_VTBL;
+    _vid->ctx = async;
+    _vid->data_offset = -1;
+    return 0;
+
+free_slot:
+    free(async->slot);
+free_async:
+    free(async);
+fail:
+    fprintf(stderr, "Could not start read-ahead thread.\n");
+    return -1;
+}
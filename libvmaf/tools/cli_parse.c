@@ -29,6 +29,10 @@ enum {
     ARG_FRAME_CNT,
     ARG_FRAME_SKIP_REF,
     ARG_FRAME_SKIP_DIST,
+    ARG_MANIFEST,
+    ARG_CHUNKS,
+    ARG_READ_AHEAD,
+    ARG_MEM_BUDGET,
 };
 
 static const struct option long_opts[] = {
@@ -54,6 +58,10 @@ static const struct option long_opts[] = {
     { "frame_cnt",        1, NULL, ARG_FRAME_CNT },
     { "frame_skip_ref",   1, NULL, ARG_FRAME_SKIP_REF },
     { "frame_skip_dist",  1, NULL, ARG_FRAME_SKIP_DIST },
+    { "manifest",         1, NULL, ARG_MANIFEST },
+    { "chunks",           1, NULL, ARG_CHUNKS },
+    { "read_ahead",       1, NULL, ARG_READ_AHEAD },
+    { "mem_budget",       1, NULL, ARG_MEM_BUDGET },
     { "no_prediction",    0, NULL, 'n' },
     { "version",          0, NULL, 'v' },
     { "quiet",            0, NULL, 'q' },
@@ -70,8 +78,13 @@ static void usage(const char *const app, const char *const reason, ...) {
     }
     fprintf(stderr, "Usage: %s [options]\n\n", app);
     fprintf(stderr, "Supported options:\n"
-            " --reference/-r $path:        path to reference .y4m or .yuv\n"
-            " --distorted/-d $path:        path to distorted .y4m or .yuv\n"
+            " --reference/-r $path:        path to reference .y4m or .yuv,\n"
+            "                              \"-\" for stdin\n"
+            " --distorted/-d $path:        path to distorted .y4m or .yuv,\n"
+            "                              \"-\" for stdin\n"
+            " --manifest $path:            batch of \"$reference $distorted [$output]\"\n"
+            "                              jobs, one per line, paths with spaces\n"
+            "                              in double quotes\n"
             " --width/-w $unsigned:        width\n"
             " --height/-h $unsigned:       height\n"
             " --pixel_format/-p: $string   pixel format (420/422/444)\n"
@@ -93,10 +106,17 @@ static void usage(const char *const app, const char *const reason, ...) {
             " --frame_skip_ref $unsigned:  skip the first N frames in reference\n"
             " --frame_skip_dist $unsigned: skip the first N frames in distorted\n"
             " --subsample: $unsigned       compute scores only every N frames\n"
+            " --chunks $unsigned:          split seekable input into N chunks,\n"
+            "                              scored concurrently\n"
+            " --read_ahead $unsigned:      frames buffered ahead by a reader thread\n"
+            "                              for piped input (default: %d, 0: off)\n"
+            " --mem_budget $unsigned:      MiB of feature extractor buffers,\n"
+            "                              shared by all threads (default: 0, no limit),\n"
+            "                              requires --threads\n"
             " --quiet/-q:                  disable FPS meter when run in a TTY\n"
             " --no_prediction/-n:          no prediction, extract features only\n"
             " --version/-v:                print version and exit\n"
-           );
+           , CLI_READ_AHEAD_DEFAULT);
     exit(1);
 }
 
@@ -259,9 +279,15 @@ static CLIFeatureConfig parse_feature_config(const char *const optarg,
             usage(app, "Problem parsing feature \"%s\","
                        " bad option string \"%s\".\n", feature_cfg.name, key);
         }
+        if (feature_cfg.opt_cnt == CLI_SETTINGS_STATIC_ARRAY_LEN) {
+            usage(app, "A maximum of %d options per feature is supported\n",
+                  CLI_SETTINGS_STATIC_ARRAY_LEN);
+        }
         int err = vmaf_feature_dictionary_set(&feature_cfg.opts_dict, key, val);
         if (err)
             usage(app, "Problem parsing feature \"%s\"\n", optarg);
+        feature_cfg.opt[feature_cfg.opt_cnt].key = key;
+        feature_cfg.opt[feature_cfg.opt_cnt++].val = val;
     }
 
     return feature_cfg;
@@ -404,6 +430,7 @@ void cli_parse(const int argc, char *const *const argv,
                CLISettings *const settings)
 {
     memset(settings, 0, sizeof(*settings));
+    settings->read_ahead = CLI_READ_AHEAD_DEFAULT;
     int o;
 
     while ((o = getopt_long(argc, argv, short_opts, long_opts, NULL)) >= 0) {
@@ -489,6 +516,20 @@ void cli_parse(const int argc, char *const *const argv,
         case ARG_FRAME_SKIP_DIST:
             settings->frame_skip_dist = parse_unsigned(optarg, ARG_FRAME_SKIP_DIST, argv[0]);
             break;
+        case ARG_MANIFEST:
+            settings->manifest_path = optarg;
+            break;
+        case ARG_CHUNKS:
+            settings->chunk_cnt = parse_unsigned(optarg, ARG_CHUNKS, argv[0]);
+            if (!settings->chunk_cnt)
+                error(argv[0], optarg, ARG_CHUNKS, "a positive integer");
+            break;
+        case ARG_READ_AHEAD:
+            settings->read_ahead = parse_unsigned(optarg, ARG_READ_AHEAD, argv[0]);
+            break;
+        case ARG_MEM_BUDGET:
+            settings->mem_budget = parse_unsigned(optarg, ARG_MEM_BUDGET, argv[0]);
+            break;
         case 'n':
             settings->no_prediction = true;
             break;
@@ -505,10 +546,25 @@ void cli_parse(const int argc, char *const *const argv,
 
     if (!settings->output_fmt)
         settings->output_fmt = VMAF_OUTPUT_FORMAT_XML;
-    if (!settings->path_ref)
-        usage(argv[0], "Reference .y4m or .yuv (-r/--reference) is required");
-    if (!settings->path_dist)
-        usage(argv[0], "Distorted .y4m or .yuv (-d/--distorted) is required");
+    if (settings->mem_budget && !settings->thread_cnt)
+        usage(argv[0], "--mem_budget requires --threads, feature extractors "
+                       "only share buffers between threads");
+
+    if (settings->manifest_path) {
+        if (settings->path_ref || settings->path_dist || settings->output_path)
+            usage(argv[0], "--manifest can not be combined with "
+                           "-r/--reference, -d/--distorted or -o/--output");
+        if (settings->chunk_cnt > 1)
+            usage(argv[0], "--manifest can not be combined with --chunks");
+    } else {
+        if (!settings->path_ref)
+            usage(argv[0], "Reference .y4m or .yuv (-r/--reference) is required");
+        if (!settings->path_dist)
+            usage(argv[0], "Distorted .y4m or .yuv (-d/--distorted) is required");
+        if (!strcmp(settings->path_ref, "-") && !strcmp(settings->path_dist, "-"))
+            usage(argv[0], "Only one of -r/--reference and -d/--distorted "
+                           "can be read from stdin");
+    }
     if (settings->use_yuv && !(settings->width && settings->height &&
         settings->pix_fmt && settings->bitdepth))
     {
@@ -551,3 +607,119 @@ void cli_free(CLISettings *settings)
     for (unsigned i = 0; i < settings->feature_cnt; i++)
         free(settings->feature_cfg[i].buf);
 }
+
+/*
+ * Copy the next field of a manifest line into `tok`, or set it to NULL at the
+ * end of the line. Fields are separated by whitespace, or enclosed in double
+ * quotes if they contain any.
+ */
+static int strdup_token(char **line, char **tok)
+{
+    const char *const sep = " \t\r\n";
+    *tok = NULL;
+    *line += strspn(*line, sep);
+    if (!**line) return 0;
+
+    const bool quoted = **line == '"';
+    *line += quoted;
+    const size_t len = quoted ? strcspn(*line, "\"") : strcspn(*line, sep);
+    if (quoted && (*line)[len] != '"') return -1;
+    if (quoted && (*line)[len + 1] && !strchr(sep, (*line)[len + 1]))
+        return -1;
+
+    *tok = malloc(len + 1);
+    if (!*tok) return -1;
+    memcpy(*tok, *line, len);
+    (*tok)[len] = '\0';
+    *line += len + quoted;
+    return 0;
+}
+
+int cli_feature_opts_dict(const CLIFeatureConfig *cfg,
+                          VmafFeatureDictionary **opts_dict)
+{
+    if (!cfg) return -1;
+    if (!opts_dict) return -1;
+
+    *opts_dict = NULL;
+    for (unsigned i = 0; i < cfg->opt_cnt; i++) {
+        int err = vmaf_feature_dictionary_set(opts_dict, cfg->opt[i].key,
+                                              cfg->opt[i].val);
+        if (err) {
+            vmaf_feature_dictionary_free(opts_dict);
+            return err;
+        }
+    }
+    return 0;
+}
+
+int cli_parse_manifest(FILE *file, CLIManifest *manifest)
+{
+    if (!file) return -1;
+    if (!manifest) return -1;
+
+    memset(manifest, 0, sizeof(*manifest));
+    char line[4096];
+
+    for (unsigned n = 1; fgets(line, sizeof(line), file); n++) {
+        if (!strchr(line, '\n') && !feof(file)) {
+            fprintf(stderr, "manifest line %u is longer than %zu bytes\n",
+                    n, sizeof(line) - 2);
+            cli_free_manifest(manifest);
+            return -1;
+        }
+
+        char *l = line;
+        l += strspn(l, " \t");
+        if (*l == '#' || *l == '\n' || *l == '\r' || !*l)
+            continue;
+
+        CLIManifestEntry entry = { 0 };
+        char *extra = NULL;
+        int err = strdup_token(&l, &entry.path_ref);
+        if (!err) err = strdup_token(&l, &entry.path_dist);
+        if (!err) err = strdup_token(&l, &entry.output_path);
+        if (!err) err = strdup_token(&l, &extra);
+
+        if (err || !entry.path_ref || !entry.path_dist || extra) {
+            fprintf(stderr, "manifest line %u is not \"$reference "
+                    "$distorted [$output]\"\n", n);
+            free(entry.path_ref);
+            free(entry.path_dist);
+            free(entry.output_path);
+            free(extra);
+            cli_free_manifest(manifest);
+            return -1;
+        }
+
+        if (manifest->cnt == manifest->capacity) {
+            const unsigned capacity =
+                manifest->capacity ? manifest->capacity * 2 : 8;
+            CLIManifestEntry *e =
+                realloc(manifest->entry, sizeof(*e) * capacity);
+            if (!e) {
+                free(entry.path_ref);
+                free(entry.path_dist);
+                free(entry.output_path);
+                cli_free_manifest(manifest);
+                return -1;
+            }
+            manifest->entry = e;
+            manifest->capacity = capacity;
+        }
+        manifest->entry[manifest->cnt++] = entry;
+    }
+
+    return manifest->cnt ? 0 : -1;
+}
+
+void cli_free_manifest(CLIManifest *manifest)
+{
+    for (unsigned i = 0; i < manifest->cnt; i++) {
+        free(manifest->entry[i].path_ref);
+        free(manifest->entry[i].path_dist);
+        free(manifest->entry[i].output_path);
+    }
+    free(manifest->entry);
+    memset(manifest, 0, sizeof(*manifest));
+}
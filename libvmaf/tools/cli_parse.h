@@ -3,16 +3,22 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 
 #include "libvmaf/libvmaf.h"
 #include "libvmaf/model.h"
 #include "libvmaf/feature.h"
 
 #define CLI_SETTINGS_STATIC_ARRAY_LEN 32
+#define CLI_READ_AHEAD_DEFAULT 8
 
 typedef struct {
     const char *name;
     VmafFeatureDictionary *opts_dict;
+    struct {
+        const char *key, *val;
+    } opt[CLI_SETTINGS_STATIC_ARRAY_LEN];
+    unsigned opt_cnt;
     void *buf;
 } CLIFeatureConfig;
 
@@ -30,6 +36,7 @@ typedef struct {
 
 typedef struct {
     char *path_ref, *path_dist;
+    char *manifest_path;
     unsigned frame_skip_ref;
     unsigned frame_skip_dist;
     unsigned frame_cnt;
@@ -46,6 +53,9 @@ typedef struct {
     enum VmafLogLevel log_level;
     unsigned subsample;
     unsigned thread_cnt;
+    unsigned chunk_cnt;
+    unsigned read_ahead;
+    unsigned mem_budget;
     bool no_prediction;
     bool quiet;
     bool common_bitdepth;
@@ -53,9 +63,27 @@ typedef struct {
     unsigned gpumask;
 } CLISettings;
 
+typedef struct {
+    char *path_ref, *path_dist;
+    char *output_path;
+} CLIManifestEntry;
+
+typedef struct {
+    CLIManifestEntry *entry;
+    unsigned cnt, capacity;
+} CLIManifest;
+
 void cli_parse(const int argc, char *const *const argv,
                CLISettings *const settings);
 
 void cli_free(CLISettings *settings);
 
+/* Build a new copy of the options dictionary of `cfg` in `opts_dict`. */
+int cli_feature_opts_dict(const CLIFeatureConfig *cfg,
+                          VmafFeatureDictionary **opts_dict);
+
+int cli_parse_manifest(FILE *file, CLIManifest *manifest);
+
+void cli_free_manifest(CLIManifest *manifest);
+
 #endif /* __VMAF_CLI_PARSE_H__ */
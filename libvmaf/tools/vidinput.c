@@ -40,6 +40,7 @@ int raw_input_open(video_input *_vid,FILE *_fin,
     _vid->vtbl=&YUV_INPUT_VTBL;
     _vid->ctx=ctx;
     _vid->fin=_fin;
+    _vid->data_offset=ftello(_fin);
     return 0;
   }
   else fprintf(stderr,"Unknown file type.\n");
@@ -52,6 +53,7 @@ int video_input_open(video_input *_vid,FILE *_fin) {
     _vid->vtbl=&Y4M_INPUT_VTBL;
     _vid->ctx=ctx;
     _vid->fin=_fin;
+    _vid->data_offset=ftello(_fin);
     return 0;
   }
   else fprintf(stderr,"Unknown file type.\n");
@@ -67,6 +69,30 @@ int video_input_fetch_frame(video_input *_vid,
   return (*_vid->vtbl->fetch_frame)(_vid->ctx,_vid->fin,_ycbcr,_tag);
 }
 
+int64_t video_input_frame_cnt(video_input *_vid) {
+  size_t  frame_sz;
+  off_t   pos;
+  off_t   end;
+  if (_vid->data_offset<0) return -1;
+  frame_sz=(*_vid->vtbl->frame_size)(_vid->ctx);
+  if (!frame_sz) return -1;
+  pos=ftello(_vid->fin);
+  if (pos<0||fseeko(_vid->fin,0,SEEK_END)) return -1;
+  end=ftello(_vid->fin);
+  if (fseeko(_vid->fin,pos,SEEK_SET)||end<_vid->data_offset) return -1;
+  /*A partial last frame means the frames are not all of the same size.*/
+  if ((end-_vid->data_offset)%frame_sz) return -1;
+  return (end-_vid->data_offset)/frame_sz;
+}
+
+int video_input_seek_frame(video_input *_vid, int64_t _frame) {
+  size_t frame_sz;
+  if (_vid->data_offset<0||_frame<0) return -1;
+  frame_sz=(*_vid->vtbl->frame_size)(_vid->ctx);
+  if (!frame_sz) return -1;
+  return fseeko(_vid->fin,_vid->data_offset+_frame*(off_t)frame_sz,SEEK_SET);
+}
+
 void video_input_close(video_input *_vid) {
   (*_vid->vtbl->close)(_vid->ctx);
   free(_vid->ctx);
@@ -56,6 +56,7 @@ typedef void (*video_input_get_info_func)(void *_ctx,video_input_info *_ti);
 typedef int (*video_input_fetch_frame_func)(void *_ctx,FILE *_fin,
  video_input_ycbcr _ycbcr,char _tag[5]);
 typedef void (*video_input_close_func)(void *_ctx);
+typedef size_t (*video_input_frame_size_func)(void *_ctx);
 typedef void* (*raw_input_open_func)(FILE *_fin,
                                      unsigned width, unsigned height,
                                      int pix_fmt,
@@ -68,12 +69,15 @@ struct video_input_vtbl {
   video_input_get_info_func     get_info;
   video_input_fetch_frame_func  fetch_frame;
   video_input_close_func        close;
+  video_input_frame_size_func   frame_size;
 };
 
 struct video_input {
   const video_input_vtbl *vtbl;
   void                   *ctx;
   FILE                   *fin;
+  /*The file offset of the first frame, or -1 if the input is not seekable.*/
+  int64_t                 data_offset;
 };
 
 int raw_input_open(video_input *_vid, FILE *_fin,
@@ -87,6 +91,18 @@ void video_input_get_info(video_input *_vid, video_input_info *_ti);
 int video_input_fetch_frame(video_input *_vid, video_input_ycbcr _ycbcr,
                             char _tag[5]);
 
+/*Frame access by index assumes every frame has the same size on disk, which
+   holds for raw input and for y4m input without per-frame parameters.
+   video_input_frame_cnt() returns -1 if the input is not seekable, if its
+   first frame header has parameters or if it ends in a partial frame.*/
+int64_t video_input_frame_cnt(video_input *_vid);
+int video_input_seek_frame(video_input *_vid, int64_t _frame);
+
+/*Move reading (and conversion) of _vid onto a dedicated thread, which keeps
+   up to _frames frames ready ahead of the consumer. The input is no longer
+   seekable afterwards.*/
+int video_input_read_ahead(video_input *_vid, unsigned _frames);
+
 typedef enum {
   /** Chroma decimation by 2 in both the X and Y directions (4:2:0).
    *  The Cb and Cr chroma planes are half the width and half the
@@ -1,5 +1,9 @@
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -68,181 +72,342 @@ static int validate_videos(video_input *vid1, video_input *vid2, bool common_bit
     return err_cnt;
 }
 
-static int fetch_picture(video_input *vid, VmafPicture *pic, int depth)
+static int init_picture_pool(video_input *vid, int depth,
+                             VmafPicturePool **pool)
 {
-    int ret;
-    video_input_ycbcr ycbcr;
     video_input_info info;
+    video_input_get_info(vid, &info);
 
-    ret = video_input_fetch_frame(vid, ycbcr, NULL);
-    if (ret < 1) return !ret;
+    int ret = vmaf_picture_pool_init(pool, pix_fmt_map(info.pixel_fmt), depth,
+                                     info.pic_w, info.pic_h);
+    if (ret) {
+        fprintf(stderr, "problem initializing picture pool.\n");
+        *pool = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+static int import_picture(video_input *vid, video_input_ycbcr ycbcr,
+                          VmafPicturePool *pool, VmafPicture *pic)
+{
+    int ret;
+    video_input_info info;
 
     video_input_get_info(vid, &info);
-    ret = vmaf_picture_alloc(pic, pix_fmt_map(info.pixel_fmt), depth,
-                             info.pic_w, info.pic_h);
+    ret = vmaf_picture_pool_fetch(pool, pic);
 
     if (ret) {
         fprintf(stderr, "problem allocating picture.\n");
         return -1;
     }
 
-    if (info.depth == depth) {
-        if (info.depth == 8) {
-            for (unsigned i = 0; i < 3; i++) {
-                int xdec = i&&!(info.pixel_fmt&1);
-                int ydec = i&&!(info.pixel_fmt&2);
-                uint8_t *ycbcr_data = ycbcr[i].data +
-                    (info.pic_y >> ydec) * ycbcr[i].stride +
-                    (info.pic_x >> xdec);
-                uint8_t *pic_data = pic->data[i];
-
-                for (unsigned j = 0; j < pic->h[i]; j++) {
-                    memcpy(pic_data, ycbcr_data, sizeof(*pic_data) * pic->w[i]);
-                    pic_data += pic->stride[i];
-                    ycbcr_data += ycbcr[i].stride;
-                }
-            }
+    const void *data[3];
+    ptrdiff_t stride[3];
+    for (unsigned i = 0; i < 3; i++) {
+        int xdec = i&&!(info.pixel_fmt&1);
+        int ydec = i&&!(info.pixel_fmt&2);
+        int hbd = info.depth > 8;
+        data[i] = ycbcr[i].data +
+            (info.pic_y >> ydec) * ycbcr[i].stride +
+            ((info.pic_x >> xdec) << hbd);
+        stride[i] = ycbcr[i].stride;
+    }
+
+    ret = vmaf_picture_import_planes(pic, data, stride, info.depth);
+    if (ret) {
+        fprintf(stderr, "problem importing picture.\n");
+        vmaf_picture_unref(pic);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int fetch_picture(video_input *vid, VmafPicturePool *pool,
+                         VmafPicture *pic)
+{
+    int ret;
+    video_input_ycbcr ycbcr;
+
+    ret = video_input_fetch_frame(vid, ycbcr, NULL);
+    if (ret < 1) return ret < 0 ? ret : 1;
+
+    return import_picture(vid, ycbcr, pool, pic);
+}
+
+static const char *model_label(const CLIModelConfig *cfg)
+{
+    return cfg->version ? cfg->version : cfg->path;
+}
+
+typedef struct {
+    VmafModel *model[CLI_SETTINGS_STATIC_ARRAY_LEN];
+    bool is_collection[CLI_SETTINGS_STATIC_ARRAY_LEN];
+    VmafModelCollection *model_collection[CLI_SETTINGS_STATIC_ARRAY_LEN];
+    const char *model_collection_label[CLI_SETTINGS_STATIC_ARRAY_LEN];
+    unsigned model_collection_cnt;
+} CLIModels;
+
+static int load_models(CLISettings *c, CLIModels *m)
+{
+    int err = 0;
+    memset(m, 0, sizeof(*m));
+
+    for (unsigned i = 0; i < c->model_cnt; i++) {
+        CLIModelConfig *cfg = &c->model_config[i];
+
+        if (cfg->version) {
+            err = vmaf_model_load(&m->model[i], &cfg->cfg, cfg->version);
         } else {
-            for (unsigned i = 0; i < 3; i++) {
-                int xdec = i&&!(info.pixel_fmt&1);
-                int ydec = i&&!(info.pixel_fmt&2);
-                uint16_t *ycbcr_data = (uint16_t*) ycbcr[i].data +
-                    (info.pic_y >> ydec) * (ycbcr[i].stride / 2) +
-                    (info.pic_x >> xdec);
-                uint16_t *pic_data = pic->data[i];
-
-                for (unsigned j = 0; j < pic->h[i]; j++) {
-                    memcpy(pic_data, ycbcr_data, sizeof(*pic_data) * pic->w[i]);
-                    pic_data += pic->stride[i] / 2;
-                    ycbcr_data += ycbcr[i].stride / 2;
-                }
-            }
+            err = vmaf_model_load_from_path(&m->model[i], &cfg->cfg,
+                                            cfg->path);
         }
-    } else if (depth > 8) {
-        // unequal bit-depth
-        // therefore depth must be > 8 since we do not support depth < 8
-        int left_shift = depth - info.depth;
-        if (info.depth == 8) {
-            for (unsigned i = 0; i < 3; i++) {
-                int xdec = i&&!(info.pixel_fmt&1);
-                int ydec = i&&!(info.pixel_fmt&2);
-                uint8_t *ycbcr_data = ycbcr[i].data +
-                    (info.pic_y >> ydec) * ycbcr[i].stride +
-                    (info.pic_x >> xdec);
-                uint16_t *pic_data = (uint16_t*)pic->data[i];
-
-                for (unsigned j = 0; j < pic->h[i]; j++) {
-                    for (unsigned k = 0; k < pic->w[i]; k++) {
-                        pic_data[k] = ycbcr_data[k] << left_shift;
-                    }
-                    pic_data += pic->stride[i] / 2;
-                    ycbcr_data += ycbcr[i].stride;
-                }
+
+        if (err) {
+            // check for model_collection before failing
+            // this is implicit because the `--model` option could take either
+            // a model or model_collection
+            VmafModelCollection **model_collection =
+                &m->model_collection[m->model_collection_cnt];
+
+            if (cfg->version) {
+                err = vmaf_model_collection_load(&m->model[i],
+                                                 model_collection, &cfg->cfg,
+                                                 cfg->version);
+            } else {
+                err = vmaf_model_collection_load_from_path(&m->model[i],
+                                                           model_collection,
+                                                           &cfg->cfg,
+                                                           cfg->path);
             }
-        } else {
-            for (unsigned i = 0; i < 3; i++) {
-                int xdec = i&&!(info.pixel_fmt&1);
-                int ydec = i&&!(info.pixel_fmt&2);
-                uint16_t *ycbcr_data = (uint16_t*) ycbcr[i].data +
-                    (info.pic_y >> ydec) * (ycbcr[i].stride / 2) +
-                    (info.pic_x >> xdec);
-                uint16_t *pic_data = pic->data[i];
-
-                for (unsigned j = 0; j < pic->h[i]; j++) {
-                    for (unsigned k = 0; k < pic->w[i]; k++) {
-                        pic_data[k] = ycbcr_data[k] << left_shift;
-                    }
-                    pic_data += pic->stride[i] / 2;
-                    ycbcr_data += ycbcr[i].stride / 2;
+
+            if (err) {
+                fprintf(stderr, "problem loading model: %s\n",
+                        model_label(cfg));
+                return -1;
+            }
+
+            m->model_collection_label[m->model_collection_cnt] =
+                model_label(cfg);
+
+            for (unsigned j = 0; j < cfg->overload_cnt; j++) {
+                err = vmaf_model_collection_feature_overload(
+                               m->model[i], model_collection,
+                               cfg->feature_overload[j].name,
+                               cfg->feature_overload[j].opts_dict);
+                if (err) {
+                    fprintf(stderr,
+                            "problem overloading feature extractors from "
+                            "model collection: %s\n", model_label(cfg));
+                    return -1;
                 }
             }
+
+            m->is_collection[i] = true;
+            m->model_collection_cnt++;
+            continue;
+        }
+
+        for (unsigned j = 0; j < cfg->overload_cnt; j++) {
+            err = vmaf_model_feature_overload(m->model[i],
+                               cfg->feature_overload[j].name,
+                               cfg->feature_overload[j].opts_dict);
+            if (err) {
+                fprintf(stderr,
+                        "problem overloading feature extractors from "
+                        "model: %s\n", model_label(cfg));
+                return -1;
+
+            }
         }
-        
-    } else {
-        fprintf(stderr, "expect depth > 8\n");
-        return -1;
     }
 
     return 0;
 }
 
-int main(int argc, char *argv[])
+static void destroy_models(CLISettings *c, CLIModels *m)
+{
+    for (unsigned i = 0; i < c->model_cnt; i++)
+        vmaf_model_destroy(m->model[i]);
+
+    for (unsigned i = 0; i < m->model_collection_cnt; i++)
+        vmaf_model_collection_destroy(m->model_collection[i]);
+}
+
+static int use_features(VmafContext *vmaf, CLISettings *c, CLIModels *m,
+                        bool copy_opts_dict)
 {
     int err = 0;
-    const int istty = isatty(fileno(stderr));
+    unsigned model_collection_idx = 0;
 
-    CLISettings c;
-    cli_parse(argc, argv, &c);
+    for (unsigned i = 0; i < c->model_cnt; i++) {
+        if (m->is_collection[i]) {
+            err = vmaf_use_features_from_model_collection(vmaf,
+                                m->model_collection[model_collection_idx++]);
+            if (err) {
+                fprintf(stderr,
+                        "problem loading feature extractors from "
+                        "model collection: %s\n",
+                        model_label(&c->model_config[i]));
+                return -1;
+            }
+            continue;
+        }
 
-    if (istty && !c.quiet) {
-        fprintf(stderr, "VMAF version %s\n", vmaf_version());
+        err = vmaf_use_features_from_model(vmaf, m->model[i]);
+        if (err) {
+            fprintf(stderr,
+                    "problem loading feature extractors from model: %s\n",
+                    model_label(&c->model_config[i]));
+            return -1;
+        }
     }
 
-    FILE *file_ref = fopen(c.path_ref, "rb");
-    if (!file_ref) {
-        fprintf(stderr, "could not open file: %s\n", c.path_ref);
-        return -1;
+    for (unsigned i = 0; i < c->feature_cnt; i++) {
+        // `vmaf_use_feature()` takes ownership of `opts_dict`,
+        // hand out a copy when the settings are shared between contexts
+        VmafFeatureDictionary *opts_dict = c->feature_cfg[i].opts_dict;
+        if (copy_opts_dict && opts_dict) {
+            err = cli_feature_opts_dict(&c->feature_cfg[i], &opts_dict);
+            if (err) {
+                fprintf(stderr, "problem copying feature options: %s\n",
+                        c->feature_cfg[i].name);
+                return -1;
+            }
+        }
+
+        err = vmaf_use_feature(vmaf, c->feature_cfg[i].name, opts_dict);
+        if (err) {
+            fprintf(stderr, "problem loading feature extractor: %s\n",
+                    c->feature_cfg[i].name);
+            return -1;
+        }
     }
 
-    FILE *file_dist = fopen(c.path_dist, "rb");
-    if (!file_dist) {
-        fprintf(stderr, "could not open file: %s\n", c.path_dist);
+    return 0;
+}
+
+static int open_video(CLISettings *c, const char *path, const char *type,
+                      video_input *vid)
+{
+    int err = 0;
+
+    FILE *file = !strcmp(path, "-") ? stdin : fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "could not open file: %s\n", path);
         return -1;
     }
 
-    video_input vid_ref;
-    if (c.use_yuv) {
-        err = raw_input_open(&vid_ref, file_ref,
-                             c.width, c.height, c.pix_fmt, c.bitdepth);
+    if (c->use_yuv) {
+        err = raw_input_open(vid, file,
+                             c->width, c->height, c->pix_fmt, c->bitdepth);
     } else {
-        err = video_input_open(&vid_ref, file_ref);
+        err = video_input_open(vid, file);
     }
     if (err) {
-        fprintf(stderr, "problem with reference file: %s\n", c.path_ref);
+        fprintf(stderr, "problem with %s file: %s\n", type, path);
+        fclose(file);
         return -1;
     }
 
-    video_input vid_dist;
-    if (c.use_yuv) {
-        err = raw_input_open(&vid_dist, file_dist,
-                             c.width, c.height, c.pix_fmt, c.bitdepth);
-    } else {
-        err = video_input_open(&vid_dist, file_dist);
-    }
-    if (err) {
-        fprintf(stderr, "problem with distorted file: %s\n", c.path_dist);
-        return -1;
+    if (vid->data_offset < 0 && c->read_ahead) {
+        err = video_input_read_ahead(vid, c->read_ahead);
+        if (err) {
+            video_input_close(vid);
+            return -1;
+        }
     }
 
-    err = validate_videos(&vid_ref, &vid_dist, c.common_bitdepth);
+    return 0;
+}
+
+typedef struct {
+    const char *path_dist;
+    const char *output_path;
+    video_input vid;
+    bool opened;
+    int depth;
+    VmafPicturePool *pool_ref, *pool_dist;
+    VmafContext *vmaf;
+    unsigned picture_cnt;
+    bool done;
+    int err; ///< Scoring failed, nothing is reported for this job.
+} CLIJob;
+
+typedef struct {
+    const char *path_ref;
+    CLIJob *job;
+    unsigned job_cnt;
+} CLIJobGroup;
+
+/*
+ * Share of `budget` for the `i`th of `cnt` consumers: an even split with the
+ * remainder going to the first consumers, so the shares add up to `budget`.
+ */
+static unsigned budget_share(unsigned budget, unsigned cnt, unsigned i)
+{
+    return budget / cnt + (i < budget % cnt);
+}
+
+/*
+ * Share of `--mem_budget` in bytes for `n_threads` of the `pool_cnt` pool
+ * threads, split evenly between the `job_cnt` jobs running on them.
+ */
+static uint64_t mem_share(CLISettings *c, unsigned n_threads,
+                          unsigned pool_cnt, unsigned job_cnt)
+{
+    if (!pool_cnt || !job_cnt) return 0;
+    return ((uint64_t) c->mem_budget << 20) * n_threads / pool_cnt / job_cnt;
+}
+
+static int init_job(CLISettings *c, CLIModels *m, video_input *vid_ref,
+                    CLIJob *job, unsigned n_threads, uint64_t mem_budget,
+                    bool copy_opts_dict)
+{
+    int err = open_video(c, job->path_dist, "distorted", &job->vid);
+    if (err) return err;
+    job->opened = true;
+
+    err = validate_videos(vid_ref, &job->vid, c->common_bitdepth);
     if (err) {
         fprintf(stderr, "videos are incompatible, %d %s.\n",
                 err, err == 1 ? "problem" : "problems");
         return -1;
     }
 
-    int common_bitdepth;
-    if (c.use_yuv) {
-        common_bitdepth = c.bitdepth;
+    if (c->use_yuv) {
+        job->depth = c->bitdepth;
     } else {
         video_input_info info1, info2;
-        video_input_get_info(&vid_ref, &info1);
-        video_input_get_info(&vid_dist, &info2);
-        common_bitdepth = info1.depth > info2.depth ? info1.depth : info2.depth;
+        video_input_get_info(vid_ref, &info1);
+        video_input_get_info(&job->vid, &info2);
+        job->depth = info1.depth > info2.depth ? info1.depth : info2.depth;
     }
 
+    err = init_picture_pool(vid_ref, job->depth, &job->pool_ref);
+    err |= init_picture_pool(&job->vid, job->depth, &job->pool_dist);
+    if (err) return -1;
+
     VmafConfiguration cfg = {
         .log_level = VMAF_LOG_LEVEL_INFO,
-        .n_threads = c.thread_cnt,
-        .n_subsample = c.subsample,
-        .cpumask = c.cpumask,
-        .gpumask = c.gpumask,
+        .n_threads = n_threads,
+        .n_subsample = c->subsample,
+        .cpumask = c->cpumask,
+        .gpumask = c->gpumask,
     };
 
-    VmafContext *vmaf;
-    err = vmaf_init(&vmaf, cfg);
+    err = vmaf_init(&job->vmaf, cfg);
     if (err) {
         fprintf(stderr, "problem initializing VMAF context\n");
+        job->vmaf = NULL;
+        return -1;
+    }
+
+    err = vmaf_set_mem_budget(job->vmaf, mem_budget);
+    if (err) {
+        fprintf(stderr, "problem setting memory budget\n");
         return -1;
     }
 
@@ -250,255 +415,716 @@ int main(int argc, char *argv[])
     VmafCudaState *cu_state;
     VmafCudaConfiguration cuda_cfg = { 0 };
     err = vmaf_cuda_state_init(&cu_state, cuda_cfg);
-    err |= vmaf_cuda_import_state(vmaf, cu_state);
+    err |= vmaf_cuda_import_state(job->vmaf, cu_state);
     if (err) {
         fprintf(stderr, "problem during vmaf_cuda_state_init\n");
         return -1;
     }
 #endif
 
-    VmafModel **model;
-    const size_t model_sz = sizeof(*model) * c.model_cnt;
-    model = malloc(model_sz);
-    memset(model, 0, model_sz);
-
-    VmafModelCollection **model_collection;
-    const size_t model_collection_sz =
-        sizeof(*model_collection) * c.model_cnt;
-    model_collection = malloc(model_sz);
-    memset(model_collection, 0, model_collection_sz);
-
-    const char *model_collection_label[c.model_cnt];
-    unsigned model_collection_cnt = 0;
-
-    for (unsigned i = 0; i < c.model_cnt; i++) {
-        if (c.model_config[i].version) {
-            err = vmaf_model_load(&model[i], &c.model_config[i].cfg,
-                                  c.model_config[i].version);
-        } else {
-            err = vmaf_model_load_from_path(&model[i], &c.model_config[i].cfg,
-                                            c.model_config[i].path);
-        }
+    return use_features(job->vmaf, c, m, copy_opts_dict);
+}
 
-        if (err) {
-            // check for model_collection before failing
-            // this is implicit because the `--model` option could take either
-            // a model or model_collection
-            if (c.model_config[i].version) {
-                err = vmaf_model_collection_load(&model[i],
-                                        &model_collection[model_collection_cnt],
-                                        &c.model_config[i].cfg,
-                                        c.model_config[i].version);
-            } else {
-                err = vmaf_model_collection_load_from_path(&model[i],
-                                        &model_collection[model_collection_cnt],
-                                        &c.model_config[i].cfg,
-                                        c.model_config[i].path);
-            }
+static int report_job(CLISettings *c, CLIModels *m, CLIJob *job,
+                      bool istty, bool batch)
+{
+    int err = 0;
+    const unsigned index_high = job->picture_cnt - 1;
 
+    if (!c->no_prediction) {
+        for (unsigned i = 0; i < c->model_cnt; i++) {
+            double vmaf_score;
+            err = vmaf_score_pooled(job->vmaf, m->model[i],
+                                    VMAF_POOL_METHOD_MEAN, &vmaf_score,
+                                    0, index_high);
             if (err) {
-                fprintf(stderr, "problem loading model: %s\n",
-                        c.model_config[i].version ?
-                            c.model_config[i].version : c.model_config[i].path);
+                fprintf(stderr, "problem generating pooled VMAF score\n");
                 return -1;
             }
 
-            model_collection_label[model_collection_cnt] =
-                c.model_config[i].version ?
-                    c.model_config[i].version : c.model_config[i].path;
-
-            for (unsigned j = 0; j < c.model_config[i].overload_cnt; j++) {
-                err = vmaf_model_collection_feature_overload(
-                               model[i],
-                               &model_collection[model_collection_cnt],
-                               c.model_config[i].feature_overload[j].name,
-                               c.model_config[i].feature_overload[j].opts_dict);
-                if (err) {
-                    fprintf(stderr,
-                            "problem overloading feature extractors from "
-                            "model collection: %s\n",
-                            c.model_config[i].version ?
-                            c.model_config[i].version : c.model_config[i].path);
-                    return -1;
-                }
+            if (istty && (!c->quiet || !job->output_path)) {
+                if (batch) fprintf(stderr, "%s: ", job->path_dist);
+                fprintf(stderr, "%s: %f\n",
+                        model_label(&c->model_config[i]), vmaf_score);
             }
+        }
 
-            err = vmaf_use_features_from_model_collection(vmaf,
-                                        model_collection[model_collection_cnt]);
+        for (unsigned i = 0; i < m->model_collection_cnt; i++) {
+            VmafModelCollectionScore score = { 0 };
+            err = vmaf_score_pooled_model_collection(job->vmaf,
+                                                     m->model_collection[i],
+                                                     VMAF_POOL_METHOD_MEAN,
+                                                     &score, 0, index_high);
             if (err) {
-                fprintf(stderr,
-                        "problem loading feature extractors from "
-                        "model collection: %s\n",
-                        c.model_config[i].version ?
-                            c.model_config[i].version : c.model_config[i].path);
+                fprintf(stderr, "problem generating pooled VMAF score\n");
                 return -1;
             }
 
-            model_collection_cnt++;
-            continue;
+            switch (score.type) {
+            case VMAF_MODEL_COLLECTION_SCORE_BOOTSTRAP:
+                if (istty && (!c->quiet || !job->output_path)) {
+                    if (batch) fprintf(stderr, "%s: ", job->path_dist);
+                    fprintf(stderr, "%s: %f, ci.p95: [%f, %f], stddev: %f\n",
+                            m->model_collection_label[i],
+                            score.bootstrap.bagging_score,
+                            score.bootstrap.ci.p95.lo,
+                            score.bootstrap.ci.p95.hi,
+                            score.bootstrap.stddev);
+                }
+                break;
+            default:
+                break;
+            }
         }
+    }
 
-        for (unsigned j = 0; j < c.model_config[i].overload_cnt; j++) {
-            err = vmaf_model_feature_overload(model[i],
-                               c.model_config[i].feature_overload[j].name,
-                               c.model_config[i].feature_overload[j].opts_dict);
-            if (err) {
-                fprintf(stderr,
-                        "problem overloading feature extractors from "
-                        "model: %s\n",
-                        c.model_config[i].version ?
-                            c.model_config[i].version : c.model_config[i].path);
-                return -1;
+    if (job->output_path)
+        err = vmaf_write_output(job->vmaf, job->output_path, c->output_fmt);
 
-            }
-        }
+    return err;
+}
 
-        err = vmaf_use_features_from_model(vmaf, model[i]);
-        if (err) {
-            fprintf(stderr,
-                    "problem loading feature extractors from model: %s\n",
-                     c.model_config[i].version ?
-                         c.model_config[i].version : c.model_config[i].path);
-            return -1;
-        }
+/*
+ * Score all jobs of a group against their common reference. Each reference
+ * frame is read once and imported into every job's `VmafContext`.
+ * The jobs share one pool of `n_threads` threads and split `mem_budget`.
+ */
+static int run_job_group(CLISettings *c, CLIModels *m, CLIJobGroup *group,
+                         unsigned n_threads, uint64_t mem_budget, bool istty,
+                         bool batch)
+{
+    int err = 0;
+    const bool progress = istty && !c->quiet && !batch;
+
+    video_input vid_ref;
+    err = open_video(c, group->path_ref, "reference", &vid_ref);
+    if (err) return err;
+
+    CLIJob **ready = malloc(sizeof(*ready) * group->job_cnt);
+    VmafContext **vmaf = malloc(sizeof(*vmaf) * group->job_cnt);
+    VmafPicture *pic_dist = malloc(sizeof(*pic_dist) * group->job_cnt);
+    if (!ready || !vmaf || !pic_dist) {
+        fprintf(stderr, "problem allocating job group\n");
+        err = -1;
+        goto close;
     }
 
-    for (unsigned i = 0; i < c.feature_cnt; i++) {
-        err = vmaf_use_feature(vmaf, c.feature_cfg[i].name,
-                               c.feature_cfg[i].opts_dict);
+    for (unsigned j = 0; j < group->job_cnt; j++) {
+        err = init_job(c, m, &vid_ref, &group->job[j], n_threads,
+                       mem_budget / group->job_cnt, batch);
+        if (err) goto close;
+        if (!j || !n_threads) continue;
+        err = vmaf_share_thread_pool(group->job[j].vmaf, group->job[0].vmaf);
         if (err) {
-            fprintf(stderr, "problem loading feature extractor: %s\n",
-                    c.feature_cfg[i].name);
-            return -1;
+            fprintf(stderr, "problem sharing threads between jobs\n");
+            goto close;
         }
     }
 
-    VmafPicture pic_ref, pic_dist;
+    video_input_ycbcr ycbcr_ref;
 
-    for (unsigned i = 0; i < c.frame_skip_ref; i++)
-        fetch_picture(&vid_ref, &pic_ref, common_bitdepth);
+    for (unsigned i = 0; i < c->frame_skip_ref; i++)
+        video_input_fetch_frame(&vid_ref, ycbcr_ref, NULL);
 
-    for (unsigned i = 0; i < c.frame_skip_dist; i++)
-        fetch_picture(&vid_dist, &pic_dist, common_bitdepth);
+    for (unsigned j = 0; j < group->job_cnt; j++) {
+        for (unsigned i = 0; i < c->frame_skip_dist; i++) {
+            video_input_ycbcr ycbcr_dist;
+            video_input_fetch_frame(&group->job[j].vid, ycbcr_dist, NULL);
+        }
+    }
 
     float fps = 0.;
     const time_t t0 = clock();
-    unsigned picture_index;
-    for (picture_index = 0 ;; picture_index++) {
+    unsigned active = group->job_cnt;
+    for (unsigned picture_index = 0; active; picture_index++) {
 
-        if (c.frame_cnt && picture_index >= c.frame_cnt)
+        if (c->frame_cnt && picture_index >= c->frame_cnt)
             break;
 
-        VmafPicture pic_ref, pic_dist;
-        int ret1 = fetch_picture(&vid_ref, &pic_ref, common_bitdepth);
-        int ret2 = fetch_picture(&vid_dist, &pic_dist, common_bitdepth);
-
-        if (ret1 && ret2) {
-            break;
-        } else if (ret1 < 0 || ret2 < 0) {
-            fprintf(stderr, "\nproblem while reading pictures\n");
-            break;
-        } else if (ret1) {
-            fprintf(stderr, "\n\"%s\" ended before \"%s\".\n",
-                    c.path_ref, c.path_dist);
-            int err = vmaf_picture_unref(&pic_dist);
-            if (err)
-                fprintf(stderr, "\nproblem during vmaf_picture_unref\n");
-            break;
-        } else if (ret2) {
-            fprintf(stderr, "\n\"%s\" ended before \"%s\".\n",
-                    c.path_dist, c.path_ref);
-            int err = vmaf_picture_unref(&pic_ref);
-            if (err)
-                fprintf(stderr, "\nproblem during vmaf_picture_unref\n");
-            break;
-        }
+        int ret1 = video_input_fetch_frame(&vid_ref, ycbcr_ref, NULL);
+        ret1 = ret1 < 1 ? (ret1 < 0 ? ret1 : 1) : 0;
 
-        if (istty && !c.quiet) {
+        if (progress) {
             if (picture_index > 0 && !(picture_index % 10)) {
                 fps = (picture_index + 1) /
                       (((float)clock() - t0) / CLOCKS_PER_SEC);
             }
+        }
+
+        unsigned ready_cnt = 0;
+        for (unsigned j = 0; j < group->job_cnt; j++) {
+            CLIJob *job = &group->job[j];
+            if (job->done) continue;
+
+            VmafPicture pic;
+            int ret2 = fetch_picture(&job->vid, job->pool_dist, &pic);
+
+            if (ret1 && ret2) {
+                job->done = true;
+            } else if (ret1 < 0 || ret2 < 0) {
+                fprintf(stderr, "\nproblem while reading pictures\n");
+                if (!ret2) vmaf_picture_unref(&pic);
+                job->err = -1;
+                job->done = true;
+            } else if (ret1) {
+                fprintf(stderr, "\n\"%s\" ended before \"%s\".\n",
+                        group->path_ref, job->path_dist);
+                int err = vmaf_picture_unref(&pic);
+                if (err)
+                    fprintf(stderr, "\nproblem during vmaf_picture_unref\n");
+                job->done = true;
+            } else if (ret2) {
+                fprintf(stderr, "\n\"%s\" ended before \"%s\".\n",
+                        job->path_dist, group->path_ref);
+                job->done = true;
+            }
+
+            if (job->done) {
+                active--;
+                continue;
+            }
+
+            ready[ready_cnt] = job;
+            pic_dist[ready_cnt] = pic;
+            ready_cnt++;
+        }
 
+        if (progress && ready_cnt) {
             fprintf(stderr, "\r%d frame%s %s %.2f FPS\033[K",
                     picture_index + 1, picture_index ? "s" : " ",
                     spinner[picture_index % spinner_length], fps);
             fflush(stderr);
         }
 
-        err = vmaf_read_pictures(vmaf, &pic_ref, &pic_dist, picture_index);
+        // the reference is imported once per bitdepth, and shared between
+        // all jobs scoring at that bitdepth
+        for (unsigned j = 0; j < ready_cnt;) {
+            unsigned cnt = 0;
+            for (unsigned k = j; k < ready_cnt; k++) {
+                if (ready[k]->depth != ready[j]->depth) continue;
+                CLIJob *job = ready[k];
+                VmafPicture pic = pic_dist[k];
+                ready[k] = ready[j + cnt];
+                pic_dist[k] = pic_dist[j + cnt];
+                ready[j + cnt] = job;
+                pic_dist[j + cnt] = pic;
+                vmaf[cnt++] = job->vmaf;
+            }
+
+            VmafPicture pic_ref;
+            int err = import_picture(&vid_ref, ycbcr_ref, ready[j]->pool_ref,
+                                     &pic_ref);
+            if (err) {
+                fprintf(stderr, "\nproblem while reading pictures\n");
+                for (unsigned k = j; k < j + cnt; k++)
+                    vmaf_picture_unref(&pic_dist[k]);
+            } else {
+                err = vmaf_read_pictures_multi(vmaf, cnt, &pic_ref,
+                                               &pic_dist[j], picture_index);
+                if (err)
+                    fprintf(stderr, "\nproblem reading pictures\n");
+            }
+
+            for (unsigned k = j; k < j + cnt; k++) {
+                if (err) {
+                    ready[k]->err = err;
+                    ready[k]->done = true;
+                    active--;
+                } else {
+                    ready[k]->picture_cnt = picture_index + 1;
+                }
+            }
+            j += cnt;
+        }
+
+        if (ret1) break;
+    }
+    if (progress)
+        fprintf(stderr, "\n");
+
+    // failed jobs are not reported, the others still are
+    for (unsigned j = 0; j < group->job_cnt; j++) {
+        CLIJob *job = &group->job[j];
+
+        if (!job->err) {
+            job->err = vmaf_read_pictures(job->vmaf, NULL, NULL, 0);
+            if (job->err)
+                fprintf(stderr, "problem flushing context\n");
+        }
+        if (!job->err) {
+            if (batch) flockfile(stderr);
+            job->err = report_job(c, m, job, istty, batch);
+            if (batch) funlockfile(stderr);
+        }
+        if (job->err) {
+            if (batch) fprintf(stderr, "problem scoring: %s\n", job->path_dist);
+            if (!err) err = job->err;
+        }
+    }
+
+close:
+    for (unsigned j = 0; j < group->job_cnt; j++) {
+        if (group->job[j].opened)
+            video_input_close(&group->job[j].vid);
+        if (group->job[j].vmaf)
+            vmaf_close(group->job[j].vmaf);
+        if (group->job[j].pool_ref)
+            vmaf_picture_pool_close(group->job[j].pool_ref);
+        if (group->job[j].pool_dist)
+            vmaf_picture_pool_close(group->job[j].pool_dist);
+    }
+    video_input_close(&vid_ref);
+    free(ready);
+    free(vmaf);
+    free(pic_dist);
+    return err;
+}
+
+typedef struct {
+    CLISettings *c;
+    CLIModels *m;
+    CLIJobGroup *group;
+    unsigned group_cnt;
+    unsigned next_group;
+    unsigned worker_cnt, next_worker;
+    unsigned pool_cnt;
+    bool istty;
+    pthread_mutex_t lock;
+    int err;
+} CLIBatch;
+
+static void *batch_worker(void *arg)
+{
+    CLIBatch *b = arg;
+
+    pthread_mutex_lock(&b->lock);
+    const unsigned w = b->next_worker++;
+    pthread_mutex_unlock(&b->lock);
+    const unsigned n_threads = budget_share(b->pool_cnt, b->worker_cnt, w);
+    const uint64_t mem_budget = mem_share(b->c, n_threads, b->pool_cnt, 1);
+
+    for (;;) {
+        pthread_mutex_lock(&b->lock);
+        const unsigned i = b->next_group++;
+        pthread_mutex_unlock(&b->lock);
+        if (i >= b->group_cnt) break;
+
+        CLIJobGroup *group = &b->group[i];
+        int err = run_job_group(b->c, b->m, group, n_threads, mem_budget,
+                                b->istty, true);
+
+        pthread_mutex_lock(&b->lock);
+        if (err) {
+            fprintf(stderr, "problem scoring jobs for reference: %s\n",
+                    group->path_ref);
+            b->err = err;
+        }
+        pthread_mutex_unlock(&b->lock);
+    }
+
+    return NULL;
+}
+
+/*
+ * Score every job of the manifest with one set of loaded models.
+ * Jobs sharing a reference are grouped so that the reference is read once,
+ * groups are scored concurrently within the `--threads` budget.
+ */
+static int run_manifest(CLISettings *c, CLIModels *m, bool istty)
+{
+    int err = 0;
+
+    FILE *file = fopen(c->manifest_path, "r");
+    if (!file) {
+        fprintf(stderr, "could not open file: %s\n", c->manifest_path);
+        return -1;
+    }
+
+    CLIManifest manifest;
+    err = cli_parse_manifest(file, &manifest);
+    fclose(file);
+    if (err) {
+        fprintf(stderr, "problem parsing manifest: %s\n", c->manifest_path);
+        return -1;
+    }
+
+    CLIJobGroup *group = calloc(manifest.cnt, sizeof(*group));
+    CLIJob *job = calloc(manifest.cnt, sizeof(*job));
+    if (!group || !job) {
+        err = -1;
+        goto free_manifest;
+    }
+
+    unsigned group_cnt = 0;
+    for (unsigned i = 0; i < manifest.cnt; i++) {
+        CLIJobGroup *g = NULL;
+        for (unsigned j = 0; j < group_cnt; j++) {
+            if (!strcmp(group[j].path_ref, manifest.entry[i].path_ref)) {
+                g = &group[j];
+                break;
+            }
+        }
+        if (!g) {
+            g = &group[group_cnt++];
+            g->path_ref = manifest.entry[i].path_ref;
+        }
+        g->job_cnt++;
+    }
+
+    unsigned job_cnt = 0;
+    for (unsigned i = 0; i < group_cnt; i++) {
+        group[i].job = &job[job_cnt];
+        job_cnt += group[i].job_cnt;
+        group[i].job_cnt = 0;
+    }
+
+    for (unsigned i = 0; i < manifest.cnt; i++) {
+        for (unsigned j = 0; j < group_cnt; j++) {
+            if (strcmp(group[j].path_ref, manifest.entry[i].path_ref))
+                continue;
+            CLIJob *jb = &group[j].job[group[j].job_cnt++];
+            jb->path_dist = manifest.entry[i].path_dist;
+            jb->output_path = manifest.entry[i].output_path;
+            break;
+        }
+    }
+
+    // one worker, which reads and imports the pictures of a group, per four
+    // threads; the workers other than the main thread count against
+    // --threads and the rest are split between the workers' thread pools
+    unsigned worker_cnt = (c->thread_cnt + 3) / 4;
+    if (worker_cnt > group_cnt) worker_cnt = group_cnt;
+    if (!worker_cnt) worker_cnt = 1;
+
+    CLIBatch batch = {
+        .c = c,
+        .m = m,
+        .group = group,
+        .group_cnt = group_cnt,
+        .worker_cnt = worker_cnt,
+        .pool_cnt = c->thread_cnt - (worker_cnt - 1),
+        .istty = istty,
+    };
+    pthread_mutex_init(&batch.lock, NULL);
+
+    pthread_t *worker = calloc(worker_cnt, sizeof(*worker));
+    unsigned started = 0;
+    for (; worker && started < worker_cnt - 1; started++) {
+        if (pthread_create(&worker[started], NULL, batch_worker, &batch))
+            break;
+    }
+    batch_worker(&batch);
+    for (unsigned i = 0; i < started; i++)
+        pthread_join(worker[i], NULL);
+    free(worker);
+
+    pthread_mutex_destroy(&batch.lock);
+    err = batch.err;
+
+free_manifest:
+    free(group);
+    free(job);
+    cli_free_manifest(&manifest);
+    return err;
+}
+
+typedef struct CLIChunk {
+    CLISettings *c;
+    video_input vid_ref;
+    bool opened;
+    CLIJob job;
+    unsigned read_low, read_high;
+    unsigned index_low, index_high;
+    int err;
+    struct CLIChunk *next; ///< Scored after this one, on the same thread.
+} CLIChunk;
+
+static int score_chunk(CLIChunk *chunk)
+{
+    CLISettings *c = chunk->c;
+    CLIJob *job = &chunk->job;
+    int err = 0;
+
+    if (video_input_seek_frame(&chunk->vid_ref,
+                               c->frame_skip_ref + chunk->read_low) ||
+        video_input_seek_frame(&job->vid, c->frame_skip_dist + chunk->read_low))
+    {
+        fprintf(stderr, "problem seeking to frame %d\n", chunk->read_low);
+        return -1;
+    }
+
+    for (unsigned i = chunk->read_low; i <= chunk->read_high; i++) {
+        video_input_ycbcr ycbcr_ref, ycbcr_dist;
+        VmafPicture pic_ref, pic_dist;
+
+        if (video_input_fetch_frame(&chunk->vid_ref, ycbcr_ref, NULL) < 1 ||
+            video_input_fetch_frame(&job->vid, ycbcr_dist, NULL) < 1)
+        {
+            fprintf(stderr, "\nproblem while reading pictures\n");
+            err = -1;
+            break;
+        }
+
+        err = import_picture(&chunk->vid_ref, ycbcr_ref, job->pool_ref,
+                             &pic_ref);
+        if (err) break;
+        err = import_picture(&job->vid, ycbcr_dist, job->pool_dist, &pic_dist);
+        if (err) {
+            vmaf_picture_unref(&pic_ref);
+            break;
+        }
+
+        err = vmaf_read_pictures(job->vmaf, &pic_ref, &pic_dist, i);
         if (err) {
             fprintf(stderr, "\nproblem reading pictures\n");
             break;
         }
     }
-    if (istty && !c.quiet)
-        fprintf(stderr, "\n");
 
-    err |= vmaf_read_pictures(vmaf, NULL, NULL, 0);
-    if (err) {
+    int err_flush = vmaf_read_pictures(job->vmaf, NULL, NULL, 0);
+    if (err_flush)
         fprintf(stderr, "problem flushing context\n");
-        return err;
+
+    return err ? err : err_flush;
+}
+
+static void *chunk_worker(void *arg)
+{
+    for (CLIChunk *chunk = arg; chunk; chunk = chunk->next)
+        chunk->err = score_chunk(chunk);
+    return NULL;
+}
+
+/*
+ * Count the frames of `path` after `frame_skip`, or leave `frame_cnt` at -1
+ * and say why if they can not be accessed by index.
+ */
+static int count_frames(CLISettings *c, const char *path, const char *type,
+                        unsigned frame_skip, int64_t *frame_cnt)
+{
+    /* pipes are not even opened, they can only be read once */
+    struct stat st;
+    if (!strcmp(path, "-") || stat(path, &st) || !S_ISREG(st.st_mode)) {
+        fprintf(stderr, "%s input is not seekable, ignoring --chunks\n", type);
+        *frame_cnt = -1;
+        return 0;
     }
 
-    if (!c.no_prediction) {
-        for (unsigned i = 0; i < c.model_cnt; i++) {
-            double vmaf_score;
-            err = vmaf_score_pooled(vmaf, model[i], VMAF_POOL_METHOD_MEAN,
-                                    &vmaf_score, 0, picture_index - 1);
-            if (err) {
-                fprintf(stderr, "problem generating pooled VMAF score\n");
-                return -1;
-            }
+    video_input vid;
+    int err = open_video(c, path, type, &vid);
+    if (err) return err;
 
-            if (istty && (!c.quiet || !c.output_path)) {
-                fprintf(stderr, "%s: %f\n",
-                        c.model_config[i].version ?
-                            c.model_config[i].version : c.model_config[i].path,
-                        vmaf_score);
-            }
+    *frame_cnt = video_input_frame_cnt(&vid);
+    if (*frame_cnt >= 0)
+        *frame_cnt = *frame_cnt > frame_skip ? *frame_cnt - frame_skip : 0;
+    else
+        fprintf(stderr, "%s input has per-frame parameters or a partial last "
+                "frame, ignoring --chunks\n", type);
+
+    video_input_close(&vid);
+    return 0;
+}
+
+/*
+ * Split a seekable pair of inputs into `--chunks` ranges of frames, which are
+ * scored concurrently in their own `VmafContext` and then merged. The chunks
+ * run on up to `--threads` workers, the main thread being one of them, and
+ * the chunks of a worker share a pool of the remaining threads. Each chunk
+ * also reads the frame before and after its range, so that temporal features
+ * (motion, motion2) at chunk boundaries match a sequential run.
+ * Leaves `chunked` false if the inputs can not be split.
+ */
+static int run_chunked(CLISettings *c, CLIModels *m, bool istty, bool *chunked)
+{
+    int err = 0;
+    *chunked = false;
+
+    int64_t frame_cnt_ref, frame_cnt_dist;
+    err = count_frames(c, c->path_ref, "reference", c->frame_skip_ref,
+                       &frame_cnt_ref);
+    if (err || frame_cnt_ref < 0) return err;
+    err = count_frames(c, c->path_dist, "distorted", c->frame_skip_dist,
+                       &frame_cnt_dist);
+    if (err || frame_cnt_dist < 0) return err;
+
+    int64_t frame_cnt =
+        frame_cnt_ref < frame_cnt_dist ? frame_cnt_ref : frame_cnt_dist;
+    if (c->frame_cnt && c->frame_cnt < frame_cnt) {
+        frame_cnt = c->frame_cnt;
+    } else if (frame_cnt_ref != frame_cnt_dist) {
+        const bool ref_first = frame_cnt_ref < frame_cnt_dist;
+        fprintf(stderr, "\"%s\" ended before \"%s\".\n",
+                ref_first ? c->path_ref : c->path_dist,
+                ref_first ? c->path_dist : c->path_ref);
+    }
+    if (frame_cnt > UINT_MAX) frame_cnt = UINT_MAX;
+
+    const unsigned chunk_cnt =
+        c->chunk_cnt < frame_cnt ? c->chunk_cnt : (unsigned) frame_cnt;
+    if (chunk_cnt < 2) return 0;
+    *chunked = true;
+
+    unsigned worker_cnt = c->thread_cnt < chunk_cnt ? c->thread_cnt : chunk_cnt;
+    if (!worker_cnt) worker_cnt = 1;
+    const unsigned pool_cnt = c->thread_cnt - (worker_cnt - 1);
+
+    CLIChunk *chunk = calloc(chunk_cnt, sizeof(*chunk));
+    pthread_t *worker = calloc(worker_cnt, sizeof(*worker));
+    VmafContext *vmaf = NULL;
+    if (!chunk || !worker) {
+        err = -1;
+        goto free_chunks;
+    }
+
+    for (unsigned i = 0; i < chunk_cnt; i++) {
+        CLIChunk *ch = &chunk[i];
+        ch->c = c;
+        ch->index_low = frame_cnt * i / chunk_cnt;
+        ch->index_high = frame_cnt * (i + 1) / chunk_cnt - 1;
+        ch->read_low = ch->index_low ? ch->index_low - 1 : 0;
+        ch->read_high = ch->index_high + (i + 1 < chunk_cnt);
+        ch->job.path_dist = c->path_dist;
+        if (i + worker_cnt < chunk_cnt)
+            ch->next = &chunk[i + worker_cnt];
+
+        // chunk i runs on worker i % worker_cnt, after the worker's others
+        const unsigned w = i % worker_cnt;
+        const unsigned n_threads = budget_share(pool_cnt, worker_cnt, w);
+        const unsigned worker_chunk_cnt =
+            (chunk_cnt - w + worker_cnt - 1) / worker_cnt;
+
+        err = open_video(c, c->path_ref, "reference", &ch->vid_ref);
+        if (err) goto free_chunks;
+        ch->opened = true;
+        err = init_job(c, m, &ch->vid_ref, &ch->job, n_threads,
+                       mem_share(c, n_threads, pool_cnt, worker_chunk_cnt),
+                       true);
+        if (err) goto free_chunks;
+        if (i < worker_cnt || !n_threads) continue;
+        err = vmaf_share_thread_pool(ch->job.vmaf, chunk[w].job.vmaf);
+        if (err) {
+            fprintf(stderr, "problem sharing threads between chunks\n");
+            goto free_chunks;
         }
+    }
 
-        for (unsigned i = 0; i < model_collection_cnt; i++) {
-            VmafModelCollectionScore score = { 0 };
-            err = vmaf_score_pooled_model_collection(vmaf, model_collection[i],
-                                                     VMAF_POOL_METHOD_MEAN, &score,
-                                                     0, picture_index - 1);
-            if (err) {
-                fprintf(stderr, "problem generating pooled VMAF score\n");
-                return -1;
-            }
+    unsigned started = 0;
+    for (; started < worker_cnt - 1; started++) {
+        if (pthread_create(&worker[started], NULL, chunk_worker,
+                           &chunk[started]))
+        {
+            break;
+        }
+    }
+    for (unsigned i = started; i < worker_cnt; i++)
+        chunk_worker(&chunk[i]);
+    for (unsigned i = 0; i < started; i++)
+        pthread_join(worker[i], NULL);
+
+    for (unsigned i = 0; i < chunk_cnt; i++) {
+        if (chunk[i].err) {
+            err = chunk[i].err;
+            goto free_chunks;
+        }
+    }
 
-            switch (score.type) {
-            case VMAF_MODEL_COLLECTION_SCORE_BOOTSTRAP:
-                if (istty && (!c.quiet || !c.output_path)) {
-                    fprintf(stderr, "%s: %f, ci.p95: [%f, %f], stddev: %f\n",
-                            model_collection_label[i],
-                            score.bootstrap.bagging_score, score.bootstrap.ci.p95.lo,
-                            score.bootstrap.ci.p95.hi,
-                            score.bootstrap.stddev);
-                }
-                break;
-            default:
-                break;
-            }
+    VmafConfiguration cfg = {
+        .log_level = VMAF_LOG_LEVEL_INFO,
+        .n_subsample = c->subsample,
+        .cpumask = c->cpumask,
+        .gpumask = c->gpumask,
+    };
+    err = vmaf_init(&vmaf, cfg);
+    if (err) {
+        fprintf(stderr, "problem initializing VMAF context\n");
+        vmaf = NULL;
+        goto free_chunks;
+    }
+
+    for (unsigned i = 0; i < chunk_cnt; i++) {
+        err = vmaf_merge_feature_scores(vmaf, chunk[i].job.vmaf,
+                                        chunk[i].index_low,
+                                        chunk[i].index_high);
+        if (err) {
+            fprintf(stderr, "problem merging chunk %d%s\n", i,
+                    err == -ENOTSUP ? ", aggregate metrics can not be "
+                                      "scored in chunks" : "");
+            goto free_chunks;
         }
     }
 
-    if (c.output_path)
-        vmaf_write_output(vmaf, c.output_path, c.output_fmt);
+    CLIJob merged = {
+        .path_dist = c->path_dist,
+        .output_path = c->output_path,
+        .vmaf = vmaf,
+        .picture_cnt = frame_cnt,
+    };
+    err = report_job(c, m, &merged, istty, false);
+
+free_chunks:
+    for (unsigned i = 0; chunk && i < chunk_cnt; i++) {
+        if (chunk[i].job.opened)
+            video_input_close(&chunk[i].job.vid);
+        if (chunk[i].job.vmaf)
+            vmaf_close(chunk[i].job.vmaf);
+        if (chunk[i].job.pool_ref)
+            vmaf_picture_pool_close(chunk[i].job.pool_ref);
+        if (chunk[i].job.pool_dist)
+            vmaf_picture_pool_close(chunk[i].job.pool_dist);
+        if (chunk[i].opened)
+            video_input_close(&chunk[i].vid_ref);
+    }
+    if (vmaf)
+        vmaf_close(vmaf);
+    free(chunk);
+    free(worker);
+    return err;
+}
 
-    for (unsigned i = 0; i < c.model_cnt; i++)
-        vmaf_model_destroy(model[i]);
-    free(model);
+int main(int argc, char *argv[])
+{
+    int err = 0;
+    const int istty = isatty(fileno(stderr));
 
-    for (unsigned i = 0; i < model_collection_cnt; i++)
-        vmaf_model_collection_destroy(model_collection[i]);
-    free(model_collection);
+    CLISettings c;
+    cli_parse(argc, argv, &c);
 
-    video_input_close(&vid_ref);
-    video_input_close(&vid_dist);
-    vmaf_close(vmaf);
+    if (istty && !c.quiet) {
+        fprintf(stderr, "VMAF version %s\n", vmaf_version());
+    }
+
+    CLIModels m;
+    err = load_models(&c, &m);
+    if (err) return err;
+
+    if (c.manifest_path) {
+        err = run_manifest(&c, &m, istty);
+        for (unsigned i = 0; i < c.feature_cnt; i++)
+            vmaf_feature_dictionary_free(&c.feature_cfg[i].opts_dict);
+    } else {
+        bool chunked = false;
+        if (c.chunk_cnt > 1)
+            err = run_chunked(&c, &m, istty, &chunked);
+
+        if (chunked) {
+            for (unsigned i = 0; i < c.feature_cnt; i++)
+                vmaf_feature_dictionary_free(&c.feature_cfg[i].opts_dict);
+        } else if (!err) {
+            CLIJob job = {
+                .path_dist = c.path_dist,
+                .output_path = c.output_path,
+            };
+            CLIJobGroup group = {
+                .path_ref = c.path_ref,
+                .job = &job,
+                .job_cnt = 1,
+            };
+            err = run_job_group(&c, &m, &group, c.thread_cnt,
+                                (uint64_t) c.mem_budget << 20, istty, false);
+        }
+    }
+
+    destroy_models(&c, &m);
     cli_free(&c);
     return err;
 }
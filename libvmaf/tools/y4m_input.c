@@ -70,6 +70,9 @@ struct y4m_input{
   size_t            aux_buf_sz;
   /*The amount to read into the auxilliary buffer.*/
   size_t            aux_buf_read_sz;
+  /*Whether the first frame header is a bare "FRAME\n", so that every frame
+     can be assumed to have the same size on disk.*/
+  int               bare_frame_hdr;
   y4m_convert_func  convert;
   unsigned char    *dst_buf;
   unsigned char    *aux_buf;
@@ -715,6 +718,23 @@ static y4m_input *y4m_input_open(FILE *_fin){
     free(y4m);
     return NULL;
   }
+  /*Peek at the first frame header, if the input can be rewound.*/
+  y4m->bare_frame_hdr=0;
+  {
+    char  frame[6];
+    off_t pos;
+    pos=ftello(_fin);
+    if(pos>=0){
+      y4m->bare_frame_hdr=fread(frame,1,6,_fin)==6&&!memcmp(frame,"FRAME\n",6);
+      if(fseeko(_fin,pos,SEEK_SET)){
+        fprintf(stderr,"Error rewinding y4m file.\n");
+        free(y4m->dst_buf);
+        free(y4m->aux_buf);
+        free(y4m);
+        return NULL;
+      }
+    }
+  }
   return y4m;
 }
 
@@ -798,6 +818,13 @@ static int y4m_input_fetch_frame(y4m_input *_y4m,FILE *_fin,
   return 1;
 }
 
+/*The size of one frame on disk, or 0 if the first frame header carries
+   parameters, which can differ from frame to frame.*/
+static size_t y4m_input_frame_size(y4m_input *_y4m){
+  if(!_y4m->bare_frame_hdr)return 0;
+  return 6+_y4m->dst_buf_read_sz+_y4m->aux_buf_read_sz;
+}
+
 static void y4m_input_close(y4m_input *_y4m){
   free(_y4m->dst_buf);
   free(_y4m->aux_buf);
@@ -808,5 +835,6 @@ OC_EXTERN const video_input_vtbl Y4M_INPUT_VTBL={
   (video_input_open_func)y4m_input_open,
   (video_input_get_info_func)y4m_input_get_info,
   (video_input_fetch_frame_func)y4m_input_fetch_frame,
-  (video_input_close_func)y4m_input_close
+  (video_input_close_func)y4m_input_close,
+  (video_input_frame_size_func)y4m_input_frame_size
 };
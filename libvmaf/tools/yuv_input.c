@@ -136,6 +136,10 @@ static int yuv_input_fetch_frame(yuv_input *yuv, FILE *fin,
     return 1;
 }
 
+static size_t yuv_input_frame_size(yuv_input *_yuv){
+  return _yuv->dst_buf_sz;
+}
+
 static void yuv_input_close(yuv_input *_yuv){
   free(_yuv->dst_buf);
 }
@@ -145,5 +149,6 @@ OC_EXTERN const video_input_vtbl YUV_INPUT_VTBL={
   (video_input_open_func)NULL,
   (video_input_get_info_func)yuv_input_get_info,
   (video_input_fetch_frame_func)yuv_input_fetch_frame,
-  (video_input_close_func)yuv_input_close
+  (video_input_close_func)yuv_input_close,
+  (video_input_frame_size_func)yuv_input_frame_size
 };